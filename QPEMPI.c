@@ -52,11 +52,6 @@ static inline char* trim(char *s) {
     return s;
 }
 
-// Helper to safely copy strings with truncation
-static inline void safe_copy(char *dst, size_t n, const char *src) {
-    snprintf(dst, n, "%.*s", (int)n - 1, src);
-}
-
 // Helper to map Parser OperatorType to string
 static const char* get_operator_string(OperatorType op) {
     switch (op) {
@@ -137,9 +132,8 @@ static void free_where_clause_list(struct whereClauseS *head) {
     }
 }
 
-// MAJOR TO-DOs: Initialize engine on Rank 0 only and broadcast to others. Currently each rank initializes its own engine which is inefficient for large datasets.
-// Process all queries in one rank (must be serial), then scatter results to other ranks for printing. Currently each rank processes its own queries which may lead to unbalanced workloads.
-// GATHER results from all ranks to Rank 0 for unified output. Currently each rank prints its own results which may be disorganized.
+// Every rank holds one partition of the table and runs every query on it together with the
+// other ranks (the engine calls are collective); results are gathered to Rank 0, which prints them.
 
 int main(int argc, char *argv[]) {
     
@@ -148,8 +142,6 @@ int main(int argc, char *argv[]) {
     int rank, size;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
-    
-    set_rank(rank);
 
     // Start a timer for total runtime statistics
     double totalStart = MPI_Wtime();
@@ -218,7 +210,7 @@ int main(int argc, char *argv[]) {
         token = strtok(NULL, ";");
     }
 
-    // Execute Queries - Distribute across MPI ranks
+    // Execute Queries - Every rank works on its partition of each query
     for (int i = 0; i < query_count; i++) {
         char *query = trim(queries[i]);
         if (!*query) continue;
@@ -240,11 +232,9 @@ int main(int argc, char *argv[]) {
             parseFailed = true;
         }
 
-        bool is_owner = (i % size == rank);
-        bool is_collective = (parsed.command == CMD_INSERT || parsed.command == CMD_DELETE);
-        bool should_execute = is_owner || is_collective;
+        bool is_owner = (rank == 0);  // Rank 0 prints the gathered results
 
-        if (should_execute && num_tokens > 0) {
+        if (num_tokens > 0) {
             
             // Prepare Select Items
             const char *selectItems[parsed.num_columns > 0 ? parsed.num_columns : 1];
@@ -261,16 +251,16 @@ int main(int argc, char *argv[]) {
                 if (parsed.num_values == 12) {
                     record r;
                     r.command_id = strtoull(parsed.insert_values[0], NULL, 10);
-                    safe_copy(r.raw_command, sizeof(r.raw_command), parsed.insert_values[1]);
-                    safe_copy(r.base_command, sizeof(r.base_command), parsed.insert_values[2]);
-                    safe_copy(r.shell_type, sizeof(r.shell_type), parsed.insert_values[3]);
+                    r.raw_command = parsed.insert_values[1];  // Copied into the engine by the insert
+                    r.base_command = parsed.insert_values[2];
+                    r.shell_type = parsed.insert_values[3];
                     r.exit_code = atoi(parsed.insert_values[4]);
-                    safe_copy(r.timestamp, sizeof(r.timestamp), parsed.insert_values[5]);
+                    r.timestamp = parsed.insert_values[5];
                     r.sudo_used = (strcasecmp(parsed.insert_values[6], "true") == 0 || strcmp(parsed.insert_values[6], "1") == 0);
-                    safe_copy(r.working_directory, sizeof(r.working_directory), parsed.insert_values[7]);
+                    r.working_directory = parsed.insert_values[7];
                     r.user_id = atoi(parsed.insert_values[8]);
-                    safe_copy(r.user_name, sizeof(r.user_name), parsed.insert_values[9]);
-                    safe_copy(r.host_name, sizeof(r.host_name), parsed.insert_values[10]);
+                    r.user_name = parsed.insert_values[9];
+                    r.host_name = parsed.insert_values[10];
                     r.risk_level = atoi(parsed.insert_values[11]);
 
                     success = executeQueryInsertMPI(engine, parsed.table, &r);
@@ -291,7 +281,7 @@ int main(int argc, char *argv[]) {
             execTime = MPI_Wtime() - start;
         }
 
-        // Print results (Owner only) - No barriers for performance
+        // Print results (Rank 0 only)
         if (is_owner) {
             printf("Executing Query: %s\n", query);
         
@@ -56,9 +56,12 @@ static inline char* trim(char *s) {
     return s;
 }
 
-// Helper to safely copy strings with truncation (local version)
-static inline void safe_copy(char *dst, size_t n, const char *src) {
-    snprintf(dst, n, "%.*s", (int)n - 1, src);
+// Helper to tell an INSERT or DELETE from a read-only query before the queries are batched
+static bool isMutation(const char *query) {
+    Token tokens[MAX_TOKENS];
+    int num_tokens = tokenize(query, tokens, MAX_TOKENS);
+    return num_tokens > 0 && tokens[0].type == TOKEN_KEYWORD &&
+           (strcmp(tokens[0].value, "INSERT") == 0 || strcmp(tokens[0].value, "DELETE") == 0);
 }
 
 // Helper to map Parser OperatorType to string
@@ -231,107 +234,121 @@ int main(int argc, char *argv[]) {
     }
 
     // Parallel Execution with Ordered Output
-    #pragma omp parallel for ordered schedule(dynamic)
-    for (int i = 0; i < query_count; i++) {
-        char *query = trim(queries[i]);
-        if (!*query) continue;
+    // Each run of SELECTs between two mutations is one batch whose queries run side by side,
+    // sharing the threads with their own scans; an INSERT or DELETE is a batch of its own, so
+    // the queries see the mutations in file order and a mutation gets every thread
+    for (int first = 0; first < query_count; ) {
+        int last = first + 1;
+        if (!isMutation(queries[first])) {
+            while (last < query_count && !isMutation(queries[last])) last++;
+        }
+        int scan_threads;
+        int outer = queryBatchTeamOMP(last - first, num_threads, &scan_threads);
+
+        #pragma omp parallel for ordered schedule(dynamic) num_threads(outer)
+        for (int i = first; i < last; i++) {
+            omp_set_num_threads(scan_threads);
+            char *query = trim(queries[i]);
+            if (!*query) continue;
         
-        // Tokenize each query
-        Token tokens[MAX_TOKENS];
-        int num_tokens = tokenize(query, tokens, MAX_TOKENS);
+            // Tokenize each query
+            Token tokens[MAX_TOKENS];
+            int num_tokens = tokenize(query, tokens, MAX_TOKENS);
         
-        // Parse tokens and instantiate benchmarking variables
-        ParsedSQL parsed;
-        struct resultSetS *result = NULL;
-        bool success = false;
-        double execTime = 0;
-        int rowsAffected = 0;
-        bool parseFailed = false;
-        if (num_tokens > 0) {
-            parsed = parse_tokens(tokens);
+            // Parse tokens and instantiate benchmarking variables
+            ParsedSQL parsed;
+            struct resultSetS *result = NULL;
+            bool success = false;
+            double execTime = 0;
+            int rowsAffected = 0;
+            bool parseFailed = false;
+            if (num_tokens > 0) {
+                parsed = parse_tokens(tokens);
             
-            // Prepare Select Items
-            const char *selectItems[parsed.num_columns > 0 ? parsed.num_columns : 1];
-            int numSelectItems = 0;
-            if (!parsed.select_all) {
-                numSelectItems = parsed.num_columns;
-                for (int k = 0; k < numSelectItems; k++) selectItems[k] = parsed.columns[k];
-            }
+                // Prepare Select Items
+                const char *selectItems[parsed.num_columns > 0 ? parsed.num_columns : 1];
+                int numSelectItems = 0;
+                if (!parsed.select_all) {
+                    numSelectItems = parsed.num_columns;
+                    for (int k = 0; k < numSelectItems; k++) selectItems[k] = parsed.columns[k];
+                }
 
-            double start = omp_get_wtime();  // Start timing for benchmarking
-
-            // Execute based on command type
-            if (parsed.command == CMD_INSERT) {
-                if (parsed.num_values == 12) {
-                    record r;
-                    r.command_id = strtoull(parsed.insert_values[0], NULL, 10);
-                    safe_copy(r.raw_command, sizeof(r.raw_command), parsed.insert_values[1]);
-                    safe_copy(r.base_command, sizeof(r.base_command), parsed.insert_values[2]);
-                    safe_copy(r.shell_type, sizeof(r.shell_type), parsed.insert_values[3]);
-                    r.exit_code = atoi(parsed.insert_values[4]);
-                    safe_copy(r.timestamp, sizeof(r.timestamp), parsed.insert_values[5]);
-                    r.sudo_used = (strcasecmp(parsed.insert_values[6], "true") == 0 || strcmp(parsed.insert_values[6], "1") == 0);
-                    safe_copy(r.working_directory, sizeof(r.working_directory), parsed.insert_values[7]);
-                    r.user_id = atoi(parsed.insert_values[8]);
-                    safe_copy(r.user_name, sizeof(r.user_name), parsed.insert_values[9]);
-                    safe_copy(r.host_name, sizeof(r.host_name), parsed.insert_values[10]);
-                    r.risk_level = atoi(parsed.insert_values[11]);
-
-                    success = executeQueryInsertOMP(engine, parsed.table, &r);
+                double start = omp_get_wtime();  // Start timing for benchmarking
+
+                // Execute based on command type
+                if (parsed.command == CMD_INSERT) {
+                    if (parsed.num_values == 12) {
+                        record r;
+                        r.command_id = strtoull(parsed.insert_values[0], NULL, 10);
+                        r.raw_command = parsed.insert_values[1];  // Copied into the engine by the insert
+                        r.base_command = parsed.insert_values[2];
+                        r.shell_type = parsed.insert_values[3];
+                        r.exit_code = atoi(parsed.insert_values[4]);
+                        r.timestamp = parsed.insert_values[5];
+                        r.sudo_used = (strcasecmp(parsed.insert_values[6], "true") == 0 || strcmp(parsed.insert_values[6], "1") == 0);
+                        r.working_directory = parsed.insert_values[7];
+                        r.user_id = atoi(parsed.insert_values[8]);
+                        r.user_name = parsed.insert_values[9];
+                        r.host_name = parsed.insert_values[10];
+                        r.risk_level = atoi(parsed.insert_values[11]);
+
+                        success = executeQueryInsertOMP(engine, parsed.table, &r);
+                    }
+                } 
+                else if (parsed.command == CMD_DELETE) {
+                    struct whereClauseS *whereClause = convert_conditions(&parsed);
+                    result = executeQueryDeleteOMP(engine, parsed.table, whereClause);
+                    if (result) rowsAffected = result->numRecords;
+                    free_where_clause_list(whereClause);
+                } 
+                else if (parsed.command == CMD_SELECT) {
+                    struct whereClauseS *whereClause = convert_conditions(&parsed);
+                    result = executeQuerySelectOMP(engine, selectItems, numSelectItems, parsed.table, whereClause);
+                    free_where_clause_list(whereClause);
                 }
-            } 
-            else if (parsed.command == CMD_DELETE) {
-                struct whereClauseS *whereClause = convert_conditions(&parsed);
-                result = executeQueryDeleteOMP(engine, parsed.table, whereClause);
-                if (result) rowsAffected = result->numRecords;
-                free_where_clause_list(whereClause);
-            } 
-            else if (parsed.command == CMD_SELECT) {
-                struct whereClauseS *whereClause = convert_conditions(&parsed);
-                result = executeQuerySelectOMP(engine, selectItems, numSelectItems, parsed.table, whereClause);
-                free_where_clause_list(whereClause);
-            }
             
-            execTime = omp_get_wtime() - start;
-        } else {
-            parseFailed = true;
-        }
+                execTime = omp_get_wtime() - start;
+            } else {
+                parseFailed = true;
+            }
 
-        // Print all results in order
-        #pragma omp ordered
-        {
-            printf("Executing Query: %s\n", query);
+            // Print all results in order
+            #pragma omp ordered
+            {
+                printf("Executing Query: %s\n", query);
             
-            if (parseFailed) {
-                printf("Tokenization failed.\n");
-            } else {
-                if (parsed.command == CMD_INSERT) {
-                    if (parsed.num_values != 12) {
-                        printf("Error: INSERT requires exactly 12 values.\n");
-                    } else if (success) {
-                        printf("Insert successful. Execution Time: %.4f seconds\n\n", execTime);
-                    } else {
-                        printf("Insert failed. Execution Time: %.4f seconds\n\n", execTime);
-                    }
-                } else if (parsed.command == CMD_DELETE) {
-                    if (result) {
-                        printf("Delete successful. Rows affected: %d. Execution Time: %.4f seconds\n\n", rowsAffected, execTime);
+                if (parseFailed) {
+                    printf("Tokenization failed.\n");
+                } else {
+                    if (parsed.command == CMD_INSERT) {
+                        if (parsed.num_values != 12) {
+                            printf("Error: INSERT requires exactly 12 values.\n");
+                        } else if (success) {
+                            printf("Insert successful. Execution Time: %.4f seconds\n\n", execTime);
+                        } else {
+                            printf("Insert failed. Execution Time: %.4f seconds\n\n", execTime);
+                        }
+                    } else if (parsed.command == CMD_DELETE) {
+                        if (result) {
+                            printf("Delete successful. Rows affected: %d. Execution Time: %.4f seconds\n\n", rowsAffected, execTime);
+                        } else {
+                            printf("Delete failed. Execution Time: %.4f seconds\n\n", execTime);
+                        }
+                    } else if (parsed.command == CMD_SELECT) {
+                        printTable(NULL, result, ROW_LIMIT);
+                        printf("\n");
+                    } else if (parsed.command == CMD_NONE) {
+                        printf("No command detected.\n");
                     } else {
-                        printf("Delete failed. Execution Time: %.4f seconds\n\n", execTime);
+                        fprintf(stderr, "Unsupported command.\n");
                     }
-                } else if (parsed.command == CMD_SELECT) {
-                    printTable(NULL, result, ROW_LIMIT);
-                    printf("\n");
-                } else if (parsed.command == CMD_NONE) {
-                    printf("No command detected.\n");
-                } else {
-                    fprintf(stderr, "Unsupported command.\n");
                 }
             }
-        }
 
-        // Cleanup (Local)
-        if (result) freeResultSet(result);
+            // Cleanup (Local)
+            if (result) freeResultSet(result);
+        }
+        first = last;
     }
 
     free(buffer);
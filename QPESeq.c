@@ -7,13 +7,50 @@
 #include <time.h>
 #include "../include/executeEngine-serial.h"
 #include "../include/connectEngine.h"
+#include "../include/buildEngine-serial.h"
+#include "../include/snapshot.h"
 // ANSI color codes for pretty printing
 #define CYAN    "\x1b[36m"
 #define YELLOW  "\x1b[33m"
 #define BOLD    "\x1b[1m"
 #define RESET   "\x1b[0m"
 
+/* writeSnapshot: Parses dataFile once and saves its records as a snapshot, which the
+ * engines then map on start instead of parsing the CSV (until the data file changes).
+ */
+static int writeSnapshot(const char *dataFile) {
+    int numRecords = 0;
+    void *recordBlock = NULL;
+    size_t recordBlockBytes = 0;
+    string_heap *strings = stringHeapCreate();
+    record **records = getAllRecordsFromFile(dataFile, &numRecords, &recordBlock, &recordBlockBytes, strings);
+    if (records == NULL) {
+        free(recordBlock);
+        stringHeapDestroy(strings);
+        return EXIT_FAILURE;
+    }
+
+    char *path = snapshotPath(dataFile);
+    bool ok = snapshotSave(dataFile, records, numRecords);
+    if (ok) {
+        printf("Snapshot written: %s (%d records)\n", path, numRecords);
+    } else {
+        fprintf(stderr, "Failed to write snapshot: %s\n", path);
+    }
+
+    free(records);
+    free(recordBlock);  // The records live in the loader's block and their strings in the heap
+    stringHeapDestroy(strings);
+    free(path);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 int main(int argc, char *argv[]) {
+
+    // Snapshot mode: `QPESeq --snapshot [datafile]` writes <datafile>.snap and exits
+    if (argc > 1 && strcmp(argv[1], "--snapshot") == 0) {
+        return writeSnapshot(argc > 2 ? argv[2] : DATA_FILE);
+    }
     
     // Determine data file from CLI args or default
     const char *dataFile = DATA_FILE;
@@ -17,11 +17,6 @@
 typedef struct node node;  // Pull node declaration from serial bplus
 typedef struct record record;  // Pull record declaration from serial bplus
 
-// Helper to safely copy strings with truncation
-static inline void safe_copy(char *dst, size_t n, const char *src) {
-    snprintf(dst, n, "%.*s", (int)n - 1, src);
-}
-
 // Helper to map Parser OperatorType to string
 const char* get_operator_string(OperatorType op) {
     switch (op) {
@@ -160,19 +155,19 @@ void run_test_query(struct engineS *engine, const char *query, int max_rows) {
             // Assign arguments to a record struct
             record r;
             r.command_id = strtoull(parsed.insert_values[0], NULL, 10);
-            safe_copy(r.raw_command, sizeof(r.raw_command), parsed.insert_values[1]);
-            safe_copy(r.base_command, sizeof(r.base_command), parsed.insert_values[2]);
-            safe_copy(r.shell_type, sizeof(r.shell_type), parsed.insert_values[3]);
+            r.raw_command = parsed.insert_values[1];  // Copied into the engine by the insert
+            r.base_command = parsed.insert_values[2];
+            r.shell_type = parsed.insert_values[3];
             r.exit_code = atoi(parsed.insert_values[4]);
-            safe_copy(r.timestamp, sizeof(r.timestamp), parsed.insert_values[5]);
+            r.timestamp = parsed.insert_values[5];
             
             // Handle boolean sudo_used
             r.sudo_used = (strcasecmp(parsed.insert_values[6], "true") == 0 || strcmp(parsed.insert_values[6], "1") == 0);
 
-            safe_copy(r.working_directory, sizeof(r.working_directory), parsed.insert_values[7]);
+            r.working_directory = parsed.insert_values[7];
             r.user_id = atoi(parsed.insert_values[8]);
-            safe_copy(r.user_name, sizeof(r.user_name), parsed.insert_values[9]);
-            safe_copy(r.host_name, sizeof(r.host_name), parsed.insert_values[10]);
+            r.user_name = parsed.insert_values[9];
+            r.host_name = parsed.insert_values[10];
             r.risk_level = atoi(parsed.insert_values[11]);
 
             // Execute Insert
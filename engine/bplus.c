@@ -5,97 +5,151 @@
 
 #include "../include/bplus.h"
 #include "../include/recordSchema.h"  // for compare_key and KEY_T
+#include "../include/postingList.h"   // Row sets for duplicate keys
+#include "../include/nodeArena.h"     // Slab allocator for tree nodes
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 #include <inttypes.h>
-
-// Default order (fanout). Adjust to change branching factor and height.
-#define ORDER 3 // TODO Optimize this (may need to be way higher)
-
-// Function definitions
-int order = ORDER;           // Runtime copy (could allow dynamic tuning).
-node *queue = NULL;          // Head of BFS print queue.
-bool verbose_output = false; // When true, emit pointer addresses for debugging.
-
-int current_rank = -1;
-void set_rank(int rank) {
-    current_rank = rank;
-}
-
-static int get_rank() {
-    return current_rank;
-}
+#include <stdatomic.h>
+#include <sched.h>      // sched_yield while a latch is contended
+#if defined(__SSE2__)
+#include <immintrin.h>  // AVX2 / SSE in-node key search
+#endif
+
+// Breadth-first print queue (local to each printTree call).
+typedef struct {
+    node **items;
+    int head;
+    int tail;
+    int capacity;
+} print_queue;
 
 /* Queue helpers (internal use for breadth-first printing) */
-static void enqueue(node *new_node);
-static node *dequeue(void);
+static void enqueue(print_queue *queue, node *new_node);
+static node *dequeue(print_queue *queue);
 
 /* Internal helpers */
 static void print_key(KEY_T k);
 
+/* Tree handle */
+bptree *bptreeCreate(KeyType key_type, int order);                              // Empty tree with the given order.
+bptree *bptreeCreateWith(KeyType key_type, int order, const bplus_allocator *allocator); // ... with a node allocator.
+void bptreeGetStats(bptree *tree, bplus_stats *stats);                          // Structural counters.
+static void *arenaNodeAlloc(void *ctx, size_t bytes);
+static void arenaNodeRelease(void *ctx, void *block);
+int bptreeDefaultOrder(KeyType key_type);                                       // Cache-line sized default order.
+
+/* Typed key access (KEY_T <-> dense node arrays) */
+static size_t keySize(KeyType key_type);
+static KEY_T loadKey(const bptree *tree, const node *n, int i);
+static void storeKey(const bptree *tree, node *n, int i, KEY_T key);
+static void moveKeys(const bptree *tree, node *dst, int dst_i, const node *src, int src_i, int count);
+static int nodeLowerBound(const bptree *tree, const node *n, KEY_T key);
+static int nodeUpperBound(const bptree *tree, const node *n, KEY_T key);
+static int findKeyInLeaf(const bptree *tree, const node *leaf, KEY_T key);
+
+/* Leaf entry slots (single row or posting list) */
+static bool isPostingSlot(const void *slot);
+static posting_list *slotPosting(void *slot);
+static int slotRows(void *slot, ROW_PTR out[]);
+static int slotRowCount(void *slot);
+static void addRowToSlot(void **slot, ROW_PTR row_ptr);
+static void freeSlot(void *slot);
+
 /* Search / traversal utilities */
-int height(node *const root);                                                   // Returns leaf depth below root.
+int height(bptree *const tree);                                                 // Returns leaf depth below root.
 int pathToLeaves(node *const root, node *child);                                // Distance (#edges) from child to root.
-void printLeaves(node *const root);                                             // Prints leaf keys in sorted order.
-void printTree(node *const root);                                               // Level-order visualization.
-void findAndPrint(node *const root, KEY_T key);                   // Lookup with output.
-void findAndPrintRange(node *const root, KEY_T range1, KEY_T range2, bool verbose); // Range output.
-int findRange(node *const root, KEY_T key_start, KEY_T key_end, bool verbose,
+void printLeaves(bptree *const tree);                                           // Prints leaf keys in sorted order.
+void printTree(bptree *const tree);                                             // Level-order visualization.
+void findAndPrint(bptree *const tree, KEY_T key);                               // Lookup with output.
+void findAndPrintRange(bptree *const tree, KEY_T range1, KEY_T range2, bool verbose); // Range output.
+int findRange(bptree *const tree, KEY_T key_start, KEY_T key_end, bool verbose,
               KEY_T returned_keys[], ROW_PTR returned_pointers[]);              // Range core logic.
-node *findLeaf(node *const root, KEY_T key, bool verbose);                      // Descend to target leaf.
-ROW_PTR find_row(node *root, KEY_T key);                                        // Row lookup.
+node *findLeaf(bptree *const tree, KEY_T key, bool verbose);                    // Descend to target leaf.
+static bool cursorFill(bplus_cursor *cursor);                                   // Refill cursor row buffer.
+static int cursorLeafEnd(const bplus_cursor *cursor, const node *leaf);         // Slot past the upper bound.
+static void cursorInit(bplus_cursor *cursor, bptree *tree, KEY_T key_end, bool end_exclusive, bool unbounded);
+static void cursorOpen(bplus_cursor *cursor, bptree *tree, KEY_T key_start, KEY_T key_end, bool end_exclusive);
+int bptreeSplitRange(bptree *tree, KEY_T key_start, KEY_T key_end, int max_parts, KEY_T cuts[]); // Parallel scan cut points.
 int cut(int length);                                                            // Split helper (ceil(length/2)).
-void destroy_tree(node *root); /* Free entire tree */
+void destroy_tree(bptree *tree); /* Free entire tree */
 
 /* Allocation helpers */
-static node *makeNode(void);
-static node *makeLeaf(void);
+static node *makeNode(bptree *tree);
+static node *makeLeaf(bptree *tree);
+static void freeNode(bptree *tree, node *n);
+static void destroyNodes(bptree *tree, node *n);
+static void freeLeafSlots(bptree *tree);
+
+/* Subtree counts */
+static int nodeRowCount(const node *n);
+static int countBetween(bptree *tree, KEY_T key_start, KEY_T key_end);
+int countRange(bptree *tree, KEY_T key_start, KEY_T key_end);                   // Rows in [start, end], O(log n).
+int countRows(bptree *tree);                                                    // Rows in the whole tree.
 
 /* Insertion helpers */
 static int getLeftIndex(node *parent, node *left);
-static node *insertIntoLeaf(node *leaf, KEY_T key, ROW_PTR row_ptr);
-static node *insertIntoLeafAfterSplitting(node *root, node *leaf, KEY_T key,
-                                          ROW_PTR row_ptr);
-static node *insertIntoNode(node *root, node *parent,
-                            int left_index, KEY_T key, node *right);
-static node *insertIntoNodeAfterSplitting(node *root, node *parent,
-                                          int left_index,
-                                          KEY_T key, node *right);
-static node *insertIntoParent(node *root, node *left, KEY_T key, node *right);
-static node *insertIntoNewRoot(node *left, KEY_T key, node *right);
-static node *startNewTree(KEY_T key, ROW_PTR row_ptr);
-
-node *insert(node *root, KEY_T key, ROW_PTR row_ptr); // Public upsert API.
+static void insertIntoLeaf(bptree *tree, node *leaf, KEY_T key, ROW_PTR row_ptr);
+static void insertIntoLeafAfterSplitting(bptree *tree, node *leaf, KEY_T key,
+                                         ROW_PTR row_ptr);
+static void insertIntoNode(bptree *tree, node *parent, int left_index, KEY_T key, node *right);
+static void insertIntoNodeAfterSplitting(bptree *tree, node *parent,
+                                         int left_index,
+                                         KEY_T key, node *right);
+static void insertIntoParent(bptree *tree, node *left, KEY_T key, node *right);
+static void insertIntoNewRoot(bptree *tree, node *left, KEY_T key, node *right);
+static void startNewTree(bptree *tree, KEY_T key, ROW_PTR row_ptr);
+
+void insert(bptree *tree, KEY_T key, ROW_PTR row_ptr); // Public insert API.
+
+/* Bulk loading helpers */
+static int compareEntries(const void *a, const void *b);
+static int compareRows(const void *a, const void *b);
+static int *bulkNodeSizes(int num_items, int capacity, int minimum, double fill_factor, int *num_nodes);
+static int groupDuplicateKeys(bplus_entry entries[], int num_entries);
+void bulkLoad(bptree *tree, bplus_entry entries[], int num_entries, double fill_factor); // Bottom-up build.
+void bulkLoadSorted(bptree *tree, bplus_entry entries[], int num_entries, double fill_factor); // ... of key-ordered input.
+
+/* Tree images */
+// Range [lo, hi) a node's keys must lie in, handed down by its parent's separators.
+typedef struct {
+    KEY_T lo, hi;
+    bool has_lo, has_hi;
+} image_bounds;
+static void *imageNode(void *nodes, size_t node_bytes, uintptr_t number);
+static bool imageKey(const bptree *tree, const node *n, int i, KEY_T *key);
+static bool imageNodeValid(const bptree *tree, void *nodes, long k, long num_nodes,
+                           const uint32_t *postings, size_t num_postings, int num_rows, image_bounds bounds[]);
+static bool imageCountsValid(const bptree *tree, void *nodes, long num_nodes, const uint32_t *postings);
+bool bptreeImageCreate(bptree *tree, bplus_row_id row_id, void *ctx, bplus_image *image); // Flatten for a file.
+void bptreeImageFree(bplus_image *image);
+bptree *bptreeFromImage(KeyType key_type, int order, size_t node_bytes, void *nodes, long num_nodes,
+                        size_t mapping_bytes, const uint32_t *postings, size_t num_postings,
+                        ROW_PTR rows[], int num_rows);                          // Relocate in place.
 
 /* ==================== Queue helpers ==================== */
 
-static void enqueue(node *new_node) {
-    node *c;
-    if (queue == NULL)
-    {
-        queue = new_node;
-        queue->next = NULL;
-    }
-    else
+static void enqueue(print_queue *queue, node *new_node) {
+    if (queue->tail == queue->capacity)
     {
-        c = queue;
-        while (c->next != NULL)
+        int capacity = queue->capacity ? queue->capacity * 2 : 64;
+        node **items = realloc(queue->items, capacity * sizeof(node *));
+        if (items == NULL)
         {
-            c = c->next;
+            perror("Print queue allocation failed");
+            exit(EXIT_FAILURE);
         }
-        c->next = new_node;
-        new_node->next = NULL;
+        queue->items = items;
+        queue->capacity = capacity;
     }
+    queue->items[queue->tail++] = new_node;
 }
 
-static node *dequeue(void) {
-    node *n = queue;
-    queue = queue->next;
-    n->next = NULL;
-    return n;
+static node *dequeue(print_queue *queue) {
+    return queue->items[queue->head++];
 }
 
 /* ==================== Key printing helper ==================== */
@@ -121,29 +175,619 @@ static void print_key(KEY_T k) {
     }
 }
 
+/* ==================== Typed key kernels ==================== */
+
+/* Strict "less than" for each stored key type. NULL strings sort first, as in compare_key. */
+#define NUMERIC_LESS(a, b) ((a) < (b))
+#define STRING_LESS(a, b) ((a) != (b) && ((a) == NULL || ((b) != NULL && strcmp((a), (b)) < 0)))
+
+/* DEFINE_KEY_KERNELS: Emits binary searches over a dense, sorted TYPE array.
+ * lowerBound_X returns the first index whose key is >= key, upperBound_X the first index > key.
+ */
+#define DEFINE_KEY_KERNELS(SUFFIX, TYPE, LESS)                                 \
+    static inline int lowerBound_##SUFFIX(const TYPE *keys, int n, TYPE key) { \
+        int lo = 0, hi = n;                                                    \
+        while (lo < hi) {                                                      \
+            int mid = (lo + hi) >> 1;                                          \
+            if (LESS(keys[mid], key)) lo = mid + 1;                            \
+            else hi = mid;                                                     \
+        }                                                                      \
+        return lo;                                                             \
+    }                                                                          \
+    static inline int upperBound_##SUFFIX(const TYPE *keys, int n, TYPE key) { \
+        int lo = 0, hi = n;                                                    \
+        while (lo < hi) {                                                      \
+            int mid = (lo + hi) >> 1;                                          \
+            if (LESS(key, keys[mid])) hi = mid;                                \
+            else lo = mid + 1;                                                 \
+        }                                                                      \
+        return lo;                                                             \
+    }
+
+DEFINE_KEY_KERNELS(bool, bool, NUMERIC_LESS)
+DEFINE_KEY_KERNELS(str, const char *, STRING_LESS)
+
+/* ==================== SIMD in-node search ==================== */
+
+/* Integer keys use a hybrid search: binary search narrows [lo, hi) to at most
+ * SIMD_SEARCH_WINDOW keys, then the window is counted with vector compares.
+ * Because the window is sorted, (#keys < key) is the lower bound and
+ * (#keys <= key) the upper bound, so no per-lane branching is needed.
+ * The instruction set is picked at compile time (see SIMD_FLAGS in the makefile);
+ * without AVX2 / SSE4.2 / SSE2 the scalar count is used.
+ */
+#define SIMD_SEARCH_WINDOW 32
+
+/* countLess_i32 / countLessEq_i32: Number of keys[0..n) that are < key (<= key). */
+static inline int countLess_i32(const int32_t *keys, int n, int32_t key) {
+    int i = 0, count = 0;
+#if defined(__AVX2__)
+    __m256i needle = _mm256_set1_epi32(key);
+    for (; i + 8 <= n; i += 8) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)(keys + i));
+        __m256i lt = _mm256_cmpgt_epi32(needle, block);
+        count += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(lt)));
+    }
+#endif
+#if defined(__SSE2__)
+    __m128i needle4 = _mm_set1_epi32(key);
+    for (; i + 4 <= n; i += 4) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(keys + i));
+        __m128i lt = _mm_cmpgt_epi32(needle4, block);
+        count += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(lt)));
+    }
+#endif
+    for (; i < n; i++)
+        count += keys[i] < key;
+    return count;
+}
+
+static inline int countLessEq_i32(const int32_t *keys, int n, int32_t key) {
+    int i = 0, count = 0;
+#if defined(__AVX2__)
+    __m256i needle = _mm256_set1_epi32(key);
+    for (; i + 8 <= n; i += 8) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)(keys + i));
+        __m256i gt = _mm256_cmpgt_epi32(block, needle);
+        count += 8 - __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(gt)));
+    }
+#endif
+#if defined(__SSE2__)
+    __m128i needle4 = _mm_set1_epi32(key);
+    for (; i + 4 <= n; i += 4) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(keys + i));
+        __m128i gt = _mm_cmpgt_epi32(block, needle4);
+        count += 4 - __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(gt)));
+    }
+#endif
+    for (; i < n; i++)
+        count += keys[i] <= key;
+    return count;
+}
+
+/* countLess_u64 / countLessEq_u64: Unsigned 64-bit variants. The vector units only
+ * have signed 64-bit compares, so both sides are flipped by the sign bit first.
+ */
+static inline int countLess_u64(const uint64_t *keys, int n, uint64_t key) {
+    int i = 0, count = 0;
+#if defined(__AVX2__)
+    __m256i bias = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+    __m256i needle = _mm256_xor_si256(_mm256_set1_epi64x((long long)key), bias);
+    for (; i + 4 <= n; i += 4) {
+        __m256i block = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(keys + i)), bias);
+        __m256i lt = _mm256_cmpgt_epi64(needle, block);
+        count += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(lt)));
+    }
+#endif
+#if defined(__SSE4_2__)
+    __m128i bias2 = _mm_set1_epi64x((long long)0x8000000000000000ULL);
+    __m128i needle2 = _mm_xor_si128(_mm_set1_epi64x((long long)key), bias2);
+    for (; i + 2 <= n; i += 2) {
+        __m128i block = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(keys + i)), bias2);
+        __m128i lt = _mm_cmpgt_epi64(needle2, block);
+        count += __builtin_popcount(_mm_movemask_pd(_mm_castsi128_pd(lt)));
+    }
+#endif
+    for (; i < n; i++)
+        count += keys[i] < key;
+    return count;
+}
+
+static inline int countLessEq_u64(const uint64_t *keys, int n, uint64_t key) {
+    int i = 0, count = 0;
+#if defined(__AVX2__)
+    __m256i bias = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+    __m256i needle = _mm256_xor_si256(_mm256_set1_epi64x((long long)key), bias);
+    for (; i + 4 <= n; i += 4) {
+        __m256i block = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(keys + i)), bias);
+        __m256i gt = _mm256_cmpgt_epi64(block, needle);
+        count += 4 - __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(gt)));
+    }
+#endif
+#if defined(__SSE4_2__)
+    __m128i bias2 = _mm_set1_epi64x((long long)0x8000000000000000ULL);
+    __m128i needle2 = _mm_xor_si128(_mm_set1_epi64x((long long)key), bias2);
+    for (; i + 2 <= n; i += 2) {
+        __m128i block = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(keys + i)), bias2);
+        __m128i gt = _mm_cmpgt_epi64(block, needle2);
+        count += 2 - __builtin_popcount(_mm_movemask_pd(_mm_castsi128_pd(gt)));
+    }
+#endif
+    for (; i < n; i++)
+        count += keys[i] <= key;
+    return count;
+}
+
+/* DEFINE_WINDOW_KERNELS: lowerBound_X / upperBound_X for integer keys (same contract as
+ * DEFINE_KEY_KERNELS) built on the countLess_X / countLessEq_X window scans.
+ */
+#define DEFINE_WINDOW_KERNELS(SUFFIX, TYPE)                                    \
+    static inline int lowerBound_##SUFFIX(const TYPE *keys, int n, TYPE key) { \
+        int lo = 0, hi = n;                                                    \
+        while (hi - lo > SIMD_SEARCH_WINDOW) {                                 \
+            int mid = (lo + hi) >> 1;                                          \
+            if (keys[mid] < key) lo = mid + 1;                                 \
+            else hi = mid;                                                     \
+        }                                                                      \
+        return lo + countLess_##SUFFIX(keys + lo, hi - lo, key);               \
+    }                                                                          \
+    static inline int upperBound_##SUFFIX(const TYPE *keys, int n, TYPE key) { \
+        int lo = 0, hi = n;                                                    \
+        while (hi - lo > SIMD_SEARCH_WINDOW) {                                 \
+            int mid = (lo + hi) >> 1;                                          \
+            if (key < keys[mid]) hi = mid;                                     \
+            else lo = mid + 1;                                                 \
+        }                                                                      \
+        return lo + countLessEq_##SUFFIX(keys + lo, hi - lo, key);             \
+    }
+
+DEFINE_WINDOW_KERNELS(i32, int32_t)
+DEFINE_WINDOW_KERNELS(u64, uint64_t)
+
+/* keySize: Bytes one key occupies in a node's key array. */
+static size_t keySize(KeyType key_type) {
+    switch (key_type)
+    {
+    case KEY_UINT64: return sizeof(uint64_t);
+    case KEY_INT:    return sizeof(int32_t);
+    case KEY_BOOL:   return sizeof(bool);
+    case KEY_STRING: return sizeof(const char *);
+    default:
+        fprintf(stderr, "Unknown key type %d for B+ tree\n", (int)key_type);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* loadKey: Widens the i-th stored key of n back into a KEY_T (API boundary only). */
+static KEY_T loadKey(const bptree *tree, const node *n, int i) {
+    KEY_T key;
+    key.type = tree->key_type;
+    switch (tree->key_type)
+    {
+    case KEY_UINT64: key.v.u64 = ((const uint64_t *)n->keys)[i]; break;
+    case KEY_INT:    key.v.i32 = ((const int32_t *)n->keys)[i]; break;
+    case KEY_BOOL:   key.v.b = ((const bool *)n->keys)[i]; break;
+    case KEY_STRING: key.v.str = ((const char *const *)n->keys)[i]; break;
+    }
+    return key;
+}
+
+/* storeKey: Narrows a KEY_T into the i-th slot of n's typed key array. */
+static void storeKey(const bptree *tree, node *n, int i, KEY_T key) {
+    switch (tree->key_type)
+    {
+    case KEY_UINT64: ((uint64_t *)n->keys)[i] = key.v.u64; break;
+    case KEY_INT:    ((int32_t *)n->keys)[i] = key.v.i32; break;
+    case KEY_BOOL:   ((bool *)n->keys)[i] = key.v.b; break;
+    case KEY_STRING: ((const char **)n->keys)[i] = key.v.str; break;
+    }
+}
+
+/* moveKeys: memmove of count keys between (possibly the same) nodes. */
+static void moveKeys(const bptree *tree, node *dst, int dst_i, const node *src, int src_i, int count) {
+    if (count <= 0)
+        return;
+    memmove((char *)dst->keys + (size_t)dst_i * tree->key_size,
+            (const char *)src->keys + (size_t)src_i * tree->key_size,
+            (size_t)count * tree->key_size);
+}
+
+/* nodeLowerBound: First index in n whose key is >= key; one type dispatch per node. */
+static int nodeLowerBound(const bptree *tree, const node *n, KEY_T key) {
+    switch (tree->key_type)
+    {
+    case KEY_UINT64: return lowerBound_u64((const uint64_t *)n->keys, n->num_keys, key.v.u64);
+    case KEY_INT:    return lowerBound_i32((const int32_t *)n->keys, n->num_keys, key.v.i32);
+    case KEY_BOOL:   return lowerBound_bool((const bool *)n->keys, n->num_keys, key.v.b);
+    case KEY_STRING: return lowerBound_str((const char **)n->keys, n->num_keys, key.v.str);
+    }
+    return n->num_keys;
+}
+
+/* nodeUpperBound: First index in n whose key is > key. */
+static int nodeUpperBound(const bptree *tree, const node *n, KEY_T key) {
+    switch (tree->key_type)
+    {
+    case KEY_UINT64: return upperBound_u64((const uint64_t *)n->keys, n->num_keys, key.v.u64);
+    case KEY_INT:    return upperBound_i32((const int32_t *)n->keys, n->num_keys, key.v.i32);
+    case KEY_BOOL:   return upperBound_bool((const bool *)n->keys, n->num_keys, key.v.b);
+    case KEY_STRING: return upperBound_str((const char **)n->keys, n->num_keys, key.v.str);
+    }
+    return n->num_keys;
+}
+
+/* findKeyInLeaf: Index of key in leaf, or -1. Keys are unique, so this is the only slot. */
+static int findKeyInLeaf(const bptree *tree, const node *leaf, KEY_T key) {
+    int i = nodeLowerBound(tree, leaf, key);
+    if (i < leaf->num_keys && compare_key(loadKey(tree, leaf, i), key) == 0)
+        return i;
+    return -1;
+}
+
+/* ==================== Leaf entries ==================== */
+
+/* Each key appears once in the tree. Its leaf slot holds the row pointer directly
+ * while only one row has that key; once a second row arrives the slot switches to
+ * a posting_list tagged with the low pointer bit (row pointers are at least
+ * 2-byte aligned, so the bit is free).
+ */
+#define POSTING_TAG ((uintptr_t)1)
+
+static bool isPostingSlot(const void *slot) {
+    return ((uintptr_t)slot & POSTING_TAG) != 0;
+}
+
+static posting_list *slotPosting(void *slot) {
+    return (posting_list *)((uintptr_t)slot & ~POSTING_TAG);
+}
+
+/* slotRows: Writes the rows behind a slot to out; returns how many. */
+static int slotRows(void *slot, ROW_PTR out[]) {
+    if (isPostingSlot(slot))
+        return postingDecode(slotPosting(slot), out);
+    out[0] = (ROW_PTR)slot;
+    return 1;
+}
+
+static int slotRowCount(void *slot) {
+    return isPostingSlot(slot) ? slotPosting(slot)->num_rows : 1;
+}
+
+/* addRowToSlot: Adds a row to an existing key, promoting a single row to a posting list. */
+static void addRowToSlot(void **slot, ROW_PTR row_ptr) {
+    if (isPostingSlot(*slot)) {
+        postingAdd(slotPosting(*slot), row_ptr);
+        return;
+    }
+    if (*slot == row_ptr)
+        return;
+    posting_list *pl = postingCreate();
+    postingAdd(pl, *slot);
+    postingAdd(pl, row_ptr);
+    *slot = (void *)((uintptr_t)pl | POSTING_TAG);
+}
+
+static void freeSlot(void *slot) {
+    if (isPostingSlot(slot))
+        postingDestroy(slotPosting(slot));
+}
+
+/* ==================== Node latches ==================== */
+
+/* Every node and the tree's root pointer carry a reader-writer spin latch (0 free,
+ * > 0 readers, -1 one writer). Readers latch-couple down the tree: the child is
+ * latched before the parent is let go. Writers do the same with exclusive latches
+ * and drop everything above a node once it is safe, meaning the operation can no
+ * longer split or merge it. Latches are always taken top-down, and siblings only
+ * while their parent is held exclusively; a cursor stepping to the next leaf only
+ * try-latches it and seeks again from the root when that fails, so the waits can
+ * never form a cycle.
+ */
+#define LATCH_WRITER (-1)
+#define LATCH_SPINS_BEFORE_YIELD 64
+#define BPLUS_MAX_HEIGHT 40  // Fanout >= 2 per level, so 2^31 rows fit well below this
+#define SPLIT_RANGE_ATTEMPTS 8  // Latch retries before bptreeSplitRange gives up on splitting
+
+static void latchPause(int *spins) {
+    if (++*spins < LATCH_SPINS_BEFORE_YIELD) {
+#if defined(__SSE2__)
+        _mm_pause();
+#endif
+    } else {
+        sched_yield();
+    }
+}
+
+static bool latchTryShared(atomic_int *latch) {
+    int v = atomic_load_explicit(latch, memory_order_relaxed);
+    while (v >= 0) {
+        if (atomic_compare_exchange_weak_explicit(latch, &v, v + 1,
+                                                  memory_order_acquire, memory_order_relaxed))
+            return true;
+    }
+    return false;
+}
+
+static void latchShared(atomic_int *latch) {
+    int spins = 0;
+    while (!latchTryShared(latch))
+        latchPause(&spins);
+}
+
+static void unlatchShared(atomic_int *latch) {
+    atomic_fetch_sub_explicit(latch, 1, memory_order_release);
+}
+
+static void latchExclusive(atomic_int *latch) {
+    int spins = 0;
+    int expected = 0;
+    while (!atomic_compare_exchange_weak_explicit(latch, &expected, LATCH_WRITER,
+                                                  memory_order_acquire, memory_order_relaxed)) {
+        expected = 0;
+        latchPause(&spins);
+    }
+}
+
+static void unlatchExclusive(atomic_int *latch) {
+    atomic_store_explicit(latch, 0, memory_order_release);
+}
+
+/* descendShared: Latch-couples from the root to the leaf that would hold key and returns
+ * it latched shared (NULL for an empty tree). The caller unlatches the leaf.
+ */
+static node *descendShared(bptree *tree, KEY_T key) {
+    latchShared(&tree->root_latch);
+    node *c = tree->root;
+    if (c == NULL) {
+        unlatchShared(&tree->root_latch);
+        return NULL;
+    }
+    latchShared(&c->latch);
+    unlatchShared(&tree->root_latch);
+    while (!c->is_leaf) {
+        node *child = c->pointers[nodeUpperBound(tree, c, key)];
+        latchShared(&child->latch);
+        unlatchShared(&c->latch);
+        c = child;
+    }
+    return c;
+}
+
+/* Exclusive latches held by one insert or delete: the path below the highest node that
+ * may still change, siblings pulled into a merge, and nodes emptied by merges (freed only
+ * after every latch is dropped).
+ */
+typedef struct {
+    bool root_latched;                   // tree->root_latch held: the root pointer may change
+    node *held[2 * BPLUS_MAX_HEIGHT];
+    int num_held;
+    node *retired[BPLUS_MAX_HEIGHT];
+    int num_retired;
+} write_latches;
+
+/* nodeSafe: True when inserting into / deleting from below n cannot split or merge n. */
+static bool nodeSafe(const bptree *tree, const node *n, bool inserting, bool is_root) {
+    if (inserting)
+        return n->num_keys < tree->order - 1;
+    if (is_root)
+        return n->num_keys > 1;
+    return n->num_keys > (n->is_leaf ? cut(tree->order - 1) : cut(tree->order) - 1);
+}
+
+static void holdLatch(write_latches *w, node *n) {
+    latchExclusive(&n->latch);
+    w->held[w->num_held++] = n;
+}
+
+/* releaseAbove: Drops every latch except the most recent one (n is safe). */
+static void releaseAbove(bptree *tree, write_latches *w) {
+    if (w->root_latched) {
+        unlatchExclusive(&tree->root_latch);
+        w->root_latched = false;
+    }
+    for (int i = 0; i < w->num_held - 1; i++)
+        unlatchExclusive(&w->held[i]->latch);
+    w->held[0] = w->held[w->num_held - 1];
+    w->num_held = 1;
+}
+
+/* releaseWriteLatches: Drops all latches of an insert / delete, then frees retired nodes. */
+static void releaseWriteLatches(bptree *tree, write_latches *w) {
+    for (int i = 0; i < w->num_held; i++)
+        unlatchExclusive(&w->held[i]->latch);
+    if (w->root_latched)
+        unlatchExclusive(&tree->root_latch);
+    for (int i = 0; i < w->num_retired; i++)
+        freeNode(tree, w->retired[i]);
+    w->num_held = 0;
+    w->num_retired = 0;
+    w->root_latched = false;
+}
+
+/* descendExclusive: Latch crabbing from the root to key's leaf. delta is added to the
+ * count of every child on the way, so ancestors released early are already current.
+ * Returns the leaf, or NULL for an empty tree (the root latch is then still held).
+ */
+static node *descendExclusive(bptree *tree, KEY_T key, int delta, bool inserting, write_latches *w) {
+    w->num_held = 0;
+    w->num_retired = 0;
+    latchExclusive(&tree->root_latch);
+    w->root_latched = true;
+
+    node *c = tree->root;
+    if (c == NULL)
+        return NULL;
+    holdLatch(w, c);
+    if (nodeSafe(tree, c, inserting, true))
+        releaseAbove(tree, w);
+
+    while (!c->is_leaf) {
+        int i = nodeUpperBound(tree, c, key);
+        node *child = c->pointers[i];
+        holdLatch(w, child);
+        c->counts[i] += delta;
+        if (nodeSafe(tree, child, inserting, false))
+            releaseAbove(tree, w);
+        c = child;
+    }
+    return c;
+}
+
+/* adjustPathCounts: Adds delta to the counts on key's current path. Takes back the count
+ * applied on the way down when an insert or delete turned out to change nothing.
+ */
+static void adjustPathCounts(bptree *tree, KEY_T key, int delta) {
+    latchShared(&tree->root_latch);
+    node *c = tree->root;
+    if (c == NULL) {
+        unlatchShared(&tree->root_latch);
+        return;
+    }
+    latchExclusive(&c->latch);
+    unlatchShared(&tree->root_latch);
+    while (!c->is_leaf) {
+        int i = nodeUpperBound(tree, c, key);
+        node *child = c->pointers[i];
+        latchExclusive(&child->latch);
+        c->counts[i] += delta;
+        unlatchExclusive(&c->latch);
+        c = child;
+    }
+    unlatchExclusive(&c->latch);
+}
+
+/* ==================== Tree handle ==================== */
+
+/* nodeKeysOffset: Byte offset of the key array inside a node allocation (right after the header). */
+static size_t nodeKeysOffset(void) {
+    size_t align = sizeof(void *);
+    return (sizeof(node) + align - 1) / align * align;
+}
+
+/* nodePointersOffset: Byte offset of the pointer array (after order - 1 keys, pointer aligned). */
+static size_t nodePointersOffset(size_t key_size, int order) {
+    size_t align = sizeof(void *);
+    size_t key_bytes = (size_t)(order - 1) * key_size;
+    return nodeKeysOffset() + (key_bytes + align - 1) / align * align;
+}
+
+/* nodeCountsOffset: Byte offset of the subtree row counts (after order pointers). */
+static size_t nodeCountsOffset(size_t key_size, int order) {
+    return nodePointersOffset(key_size, order) + (size_t)order * sizeof(void *);
+}
+
+/* bptreeDefaultOrder: Largest order whose node (header + typed keys + pointers + counts) fits BPLUS_NODE_BYTES.
+ * Narrow key types therefore get a wider fanout. The BPLUS_ORDER environment variable
+ * overrides the computed value without recompiling.
+ */
+int bptreeDefaultOrder(KeyType key_type) {
+    const char *env = getenv(BPLUS_ORDER_ENV);
+    if (env != NULL && *env != '\0')
+    {
+        int requested = atoi(env);
+        if (requested >= BPLUS_MIN_ORDER && requested <= BPLUS_MAX_ORDER)
+            return requested;
+        fprintf(stderr, "Ignoring %s=%s (must be between %d and %d)\n",
+                BPLUS_ORDER_ENV, env, BPLUS_MIN_ORDER, BPLUS_MAX_ORDER);
+    }
+
+    /* order * (key + pointer + count) - key + header <= node bytes */
+    size_t key_size = keySize(key_type);
+    size_t slot = key_size + sizeof(void *) + sizeof(int);
+    int order = (int)((BPLUS_NODE_BYTES - nodeKeysOffset() + key_size) / slot);
+    if (order < BPLUS_MIN_ORDER) order = BPLUS_MIN_ORDER;
+    if (order > BPLUS_MAX_ORDER) order = BPLUS_MAX_ORDER;
+    return order;
+}
+
+/* Default node allocator: the tree's own slab arena (every block is node_bytes). */
+static void *arenaNodeAlloc(void *ctx, size_t bytes) {
+    (void)bytes;
+    return nodeArenaAlloc(ctx);
+}
+
+static void arenaNodeRelease(void *ctx, void *block) {
+    nodeArenaFree(ctx, block);
+}
+
+/* bptreeCreate: Allocates an empty tree handle and fixes its node layout. */
+bptree *bptreeCreate(KeyType key_type, int order) {
+    return bptreeCreateWith(key_type, order, NULL);
+}
+
+/* bptreeCreateWith: bptreeCreate with nodes drawn from allocator (NULL for a per-tree arena). */
+bptree *bptreeCreateWith(KeyType key_type, int order, const bplus_allocator *allocator) {
+    if (order <= 0)
+        order = bptreeDefaultOrder(key_type);
+    if (order < BPLUS_MIN_ORDER) order = BPLUS_MIN_ORDER;
+    if (order > BPLUS_MAX_ORDER) order = BPLUS_MAX_ORDER;
+
+    bptree *tree = malloc(sizeof(bptree));
+    if (tree == NULL)
+    {
+        perror("Tree creation.");
+        exit(EXIT_FAILURE);
+    }
+    tree->root = NULL;
+    atomic_init(&tree->root_latch, 0);
+    tree->key_type = key_type;
+    tree->key_size = keySize(key_type);
+    tree->order = order;
+
+    /* Header, order - 1 keys, order pointers and order counts in one block, rounded to whole cache lines. */
+    size_t bytes = nodeCountsOffset(tree->key_size, order) + order * sizeof(int);
+    tree->node_bytes = (bytes + BPLUS_CACHE_LINE - 1) / BPLUS_CACHE_LINE * BPLUS_CACHE_LINE;
+
+    if (allocator != NULL)
+    {
+        tree->allocator = *allocator;
+        tree->arena = NULL;
+    }
+    else
+    {
+        tree->arena = nodeArenaCreate(tree->node_bytes, BPLUS_CACHE_LINE);
+        tree->allocator = (bplus_allocator){ arenaNodeAlloc, arenaNodeRelease, tree->arena };
+    }
+    tree->verbose_output = false;
+    atomic_init(&tree->stats.nodes, 0);
+    atomic_init(&tree->stats.splits, 0);
+    atomic_init(&tree->stats.merges, 0);
+    atomic_init(&tree->stats.redistributions, 0);
+    return tree;
+}
+
+/* bptreeGetStats: Snapshot of the structural counters (each read on its own). */
+void bptreeGetStats(bptree *tree, bplus_stats *stats) {
+    stats->nodes = atomic_load_explicit(&tree->stats.nodes, memory_order_relaxed);
+    stats->splits = atomic_load_explicit(&tree->stats.splits, memory_order_relaxed);
+    stats->merges = atomic_load_explicit(&tree->stats.merges, memory_order_relaxed);
+    stats->redistributions = atomic_load_explicit(&tree->stats.redistributions, memory_order_relaxed);
+}
+
 /* ==================== Utility / printing ==================== */
 
 /* printLeaves: Emits sorted keys by traversing leaf linked list. */
-void printLeaves(node *const root) {
-    if (root == NULL)
+void printLeaves(bptree *const tree) {
+    if (tree == NULL || tree->root == NULL)
     {
         printf("Empty tree.\n");
         return;
     }
     int i;
-    node *c = root;
+    int order = tree->order;
+    node *c = tree->root;
     while (!c->is_leaf)
         c = c->pointers[0];
     while (true)
     {
         for (i = 0; i < c->num_keys; i++)
         {
-            if (verbose_output)
+            if (tree->verbose_output)
                 printf("%p ", c->pointers[i]);
-            print_key(c->keys[i]);
+            print_key(loadKey(tree, c, i));
             printf(" ");
         }
-        if (verbose_output)
+        if (tree->verbose_output)
             printf("%p ", c->pointers[order - 1]);
         if (c->pointers[order - 1] != NULL)
         {
@@ -157,10 +801,10 @@ void printLeaves(node *const root) {
 }
 
 /* height: Number of downward edges from root to leaves. */
-int height(node *const root) {
+int height(bptree *const tree) {
     int h = 0;
-    node *c = root;
-    if (c == NULL) return 0;
+    if (tree == NULL || tree->root == NULL) return 0;
+    node *c = tree->root;
     while (!c->is_leaf)
     {
         c = c->pointers[0];
@@ -181,23 +825,24 @@ int pathToLeaves(node *const root, node *child) {
     return length;
 }
 
-/* printTree: Level-order traversal using queue (node->next as linkage). */
-void printTree(node *const root) {
+/* printTree: Level-order traversal using a local queue (nothing shared between calls). */
+void printTree(bptree *const tree) {
     node *n = NULL;
     int i = 0;
     int rank = 0;
     int new_rank = 0;
+    print_queue queue = { NULL, 0, 0, 0 };
 
-    if (root == NULL)
+    if (tree == NULL || tree->root == NULL)
     {
         printf("Empty tree.\n");
         return;
     }
-    queue = NULL;
-    enqueue(root);
-    while (queue != NULL)
+    node *root = tree->root;
+    enqueue(&queue, root);
+    while (queue.head < queue.tail)
     {
-        n = dequeue();
+        n = dequeue(&queue);
         if (n->parent != NULL && n == n->parent->pointers[0])
         {
             new_rank = pathToLeaves(root, n);
@@ -207,35 +852,36 @@ void printTree(node *const root) {
                 printf("\n");
             }
         }
-        if (verbose_output)
+        if (tree->verbose_output)
             printf("(%p)", n);
         for (i = 0; i < n->num_keys; i++)
         {
-            if (verbose_output)
+            if (tree->verbose_output)
                 printf("%p ", n->pointers[i]);
-            print_key(n->keys[i]);
+            print_key(loadKey(tree, n, i));
             printf(" ");
         }
         if (!n->is_leaf)
             for (i = 0; i <= n->num_keys; i++)
-                enqueue(n->pointers[i]);
-        if (verbose_output)
+                enqueue(&queue, n->pointers[i]);
+        if (tree->verbose_output)
         {
             if (n->is_leaf)
-                printf("%p ", n->pointers[order - 1]);
+                printf("%p ", n->pointers[tree->order - 1]);
             else
                 printf("%p ", n->pointers[n->num_keys]);
         }
         printf("| ");
     }
     printf("\n");
+    free(queue.items);
 }
 
 /* ==================== Lookup wrappers ==================== */
 
-void findAndPrint(node *const root, KEY_T key) {
+void findAndPrint(bptree *const tree, KEY_T key) {
     ROW_PTR *rows;
-    int count = find_rows(root, key, &rows);
+    int count = find_rows(tree, key, &rows);
     if (count == 0)
     {
         printf("Row not found under key ");
@@ -253,7 +899,7 @@ void findAndPrint(node *const root, KEY_T key) {
     }
 }
 
-void findAndPrintRange(node *const root, KEY_T key_start, KEY_T key_end, bool verbose) {
+void findAndPrintRange(bptree *const tree, KEY_T key_start, KEY_T key_end, bool verbose) {
     int array_size = 128; // arbitrary upper bound
     KEY_T *returned_keys = malloc(array_size * sizeof(KEY_T));
     ROW_PTR *returned_ptrs = malloc(array_size * sizeof(ROW_PTR));
@@ -262,7 +908,7 @@ void findAndPrintRange(node *const root, KEY_T key_start, KEY_T key_end, bool ve
         exit(EXIT_FAILURE);
     }
 
-    int num_found = findRange(root, key_start, key_end, verbose,
+    int num_found = findRange(tree, key_start, key_end, verbose,
                               returned_keys, returned_ptrs);
     if (!num_found) {
         printf("None found.\n");
@@ -278,51 +924,355 @@ void findAndPrintRange(node *const root, KEY_T key_start, KEY_T key_end, bool ve
     free(returned_ptrs);
 }
 
-/* findRange: Core range scan populating returned arrays; returns count. */
-int findRange(node *const root, KEY_T key_start, KEY_T key_end, bool verbose,
+/* findRange: Core range scan populating returned arrays; returns count.
+ * The arrays must hold every match; streaming callers should use a bplus_cursor instead.
+ */
+int findRange(bptree *const tree, KEY_T key_start, KEY_T key_end, bool verbose,
               KEY_T returned_keys[], ROW_PTR returned_pointers[]) {
-    int i, num_found = 0;
-    node *n = findLeaf(root, key_start, verbose);
-    if (n == NULL)
-        return 0;
+    int num_found = 0;
+    bplus_cursor cursor;
 
-    /* Skip keys less than key_start in the first leaf */
-    for (i = 0; i < n->num_keys &&
-                compare_key(n->keys[i], key_start) < 0;
-         i++)
-        ;
+    if (verbose)
+        findLeaf(tree, key_start, true);  // Print the descent path
 
-    if (i == n->num_keys) {
-        n = n->pointers[order - 1];
-        i = 0;
+    bptreeCursorOpen(&cursor, tree, key_start, key_end);
+    while (bptreeCursorNext(&cursor, &returned_keys[num_found], &returned_pointers[num_found]))
+        num_found++;
+    bptreeCursorClose(&cursor);
+    return num_found;
+}
+
+/* ==================== Range cursor ==================== */
+
+/* cursorFill: Makes sure the row buffer is non-empty, advancing through posting blocks,
+ * key slots and leaves as needed. Returns false once the scan is past key_end.
+ */
+static bool cursorFill(bplus_cursor *cursor) {
+    bptree *tree = cursor->tree;
+
+    while (cursor->row_pos >= cursor->num_rows)
+    {
+        cursor->num_rows = 0;
+        cursor->row_pos = 0;
+
+        /* Case: more blocks left in the posting list of the current key. */
+        if (cursor->posting != NULL && cursor->block < cursor->posting->num_blocks)
+        {
+            cursor->num_rows = postingDecodeBlock(cursor->posting, cursor->block++, cursor->rows);
+            continue;
+        }
+        cursor->posting = NULL;
+
+        if (cursor->leaf == NULL)
+            return false;
+
+        /* Case: leaf finished. A leaf that ends past key_end finishes the scan. */
+        if (cursor->slot >= cursor->slot_end)
+        {
+            node *leaf = cursor->leaf;
+            node *next = leaf->pointers[tree->order - 1];
+            if (cursor->slot_end < leaf->num_keys || next == NULL)
+            {
+                unlatchShared(&leaf->latch);
+                cursor->leaf = NULL;
+                return false;
+            }
+            /* A writer merging next may be waiting on this leaf, so never block here:
+             * when next is busy, let go and find the first key after this leaf again.
+             */
+            if (latchTryShared(&next->latch))
+            {
+                unlatchShared(&leaf->latch);
+                cursor->leaf = next;
+                cursor->slot = 0;
+            }
+            else
+            {
+                KEY_T last = loadKey(tree, leaf, leaf->num_keys - 1);
+                unlatchShared(&leaf->latch);
+                cursor->leaf = descendShared(tree, last);
+                if (cursor->leaf == NULL)
+                    return false;
+                cursor->slot = nodeUpperBound(tree, cursor->leaf, last);
+            }
+            cursor->slot_end = cursorLeafEnd(cursor, cursor->leaf);
+            continue;
+        }
+
+        /* Case: next key in range. */
+        void *slot = cursor->leaf->pointers[cursor->slot];
+        cursor->key = loadKey(tree, cursor->leaf, cursor->slot);
+        cursor->slot++;
+        if (isPostingSlot(slot))
+        {
+            cursor->posting = slotPosting(slot);
+            cursor->block = 0;
+        }
+        else
+        {
+            cursor->rows[0] = (ROW_PTR)slot;
+            cursor->num_rows = 1;
+        }
+    }
+    return true;
+}
+
+/* cursorLeafEnd: First slot of leaf past the cursor's upper bound. */
+static int cursorLeafEnd(const bplus_cursor *cursor, const node *leaf) {
+    if (cursor->unbounded)
+        return leaf->num_keys;
+    if (cursor->end_exclusive)
+        return nodeLowerBound(cursor->tree, leaf, cursor->key_end);
+    return nodeUpperBound(cursor->tree, leaf, cursor->key_end);
+}
+
+/* cursorInit: Empty cursor over tree; the caller positions it on a leaf. */
+static void cursorInit(bplus_cursor *cursor, bptree *tree, KEY_T key_end, bool end_exclusive, bool unbounded) {
+    cursor->tree = tree;
+    cursor->key_end = key_end;
+    cursor->end_exclusive = end_exclusive;
+    cursor->unbounded = unbounded;
+    cursor->posting = NULL;
+    cursor->block = 0;
+    cursor->num_rows = 0;
+    cursor->row_pos = 0;
+    cursor->slot = 0;
+    cursor->slot_end = 0;
+    cursor->leaf = NULL;
+}
+
+/* cursorOpen: Descends once to the leaf holding key_start and keeps it latched shared; nothing is read yet. */
+static void cursorOpen(bplus_cursor *cursor, bptree *tree, KEY_T key_start, KEY_T key_end, bool end_exclusive) {
+    cursorInit(cursor, tree, key_end, end_exclusive, false);
+    if (tree == NULL || key_start.type != tree->key_type || key_end.type != tree->key_type)
+        return;
+    cursor->leaf = descendShared(tree, key_start);
+    if (cursor->leaf == NULL)
+        return;
+    cursor->slot = nodeLowerBound(tree, cursor->leaf, key_start);
+    cursor->slot_end = cursorLeafEnd(cursor, cursor->leaf);
+}
+
+void bptreeCursorOpen(bplus_cursor *cursor, bptree *tree, KEY_T key_start, KEY_T key_end) {
+    cursorOpen(cursor, tree, key_start, key_end, false);
+}
+
+void bptreeCursorOpenBefore(bplus_cursor *cursor, bptree *tree, KEY_T key_start, KEY_T key_stop) {
+    cursorOpen(cursor, tree, key_start, key_stop, true);
+}
+
+void bptreeCursorOpenAll(bplus_cursor *cursor, bptree *tree) {
+    KEY_T none = { .type = tree != NULL ? tree->key_type : KEY_INT };
+    cursorInit(cursor, tree, none, false, true);
+    if (tree == NULL)
+        return;
+
+    // Leftmost leaf, latch-coupled like descendShared
+    latchShared(&tree->root_latch);
+    node *c = tree->root;
+    if (c == NULL) {
+        unlatchShared(&tree->root_latch);
+        return;
     }
+    latchShared(&c->latch);
+    unlatchShared(&tree->root_latch);
+    while (!c->is_leaf) {
+        node *child = c->pointers[0];
+        latchShared(&child->latch);
+        unlatchShared(&c->latch);
+        c = child;
+    }
+    cursor->leaf = c;
+    cursor->slot_end = c->num_keys;
+}
+
+bool bptreeCursorNext(bplus_cursor *cursor, KEY_T *key, ROW_PTR *row) {
+    if (!cursorFill(cursor))
+        return false;
+    if (key != NULL)
+        *key = cursor->key;
+    *row = cursor->rows[cursor->row_pos++];
+    return true;
+}
+
+int bptreeCursorNextBatch(bplus_cursor *cursor, ROW_PTR rows[], int max_rows) {
+    int n = 0;
+    while (n < max_rows && cursorFill(cursor))
+    {
+        int take = cursor->num_rows - cursor->row_pos;
+        if (take > max_rows - n)
+            take = max_rows - n;
+        memcpy(&rows[n], &cursor->rows[cursor->row_pos], take * sizeof(ROW_PTR));
+        cursor->row_pos += take;
+        n += take;
+    }
+    return n;
+}
+
+bool bptreeCursorNextKey(bplus_cursor *cursor, KEY_T *key, int *num_rows) {
+    // Drop what is left of the current key; a posting list is never decoded past its first block
+    cursor->posting = NULL;
+    cursor->row_pos = cursor->num_rows;
+    if (!cursorFill(cursor))
+        return false;
+    *key = cursor->key;
+    *num_rows = cursor->posting != NULL ? cursor->posting->num_rows : 1;
+    cursor->row_pos = cursor->num_rows;
+    return true;
+}
+
+void bptreeCursorClose(bplus_cursor *cursor) {
+    if (cursor->leaf != NULL)
+        unlatchShared(&cursor->leaf->latch);
+    cursor->leaf = NULL;
+    cursor->posting = NULL;
+    cursor->num_rows = 0;
+    cursor->row_pos = 0;
+}
+
+/* ==================== Range splitting ==================== */
+
+/* releaseSharedLevel: Unlatches and frees a level array of splitRangeOnce. */
+static void releaseSharedLevel(node **level, int num_level) {
+    for (int i = 0; i < num_level; i++)
+        unlatchShared(&level[i]->latch);
+    free(level);
+}
+
+/* splitRangeOnce: One latched attempt of bptreeSplitRange. The nodes of a level stay
+ * latched shared while the next level is latched; those are only try-latched (a writer
+ * may hold one while waiting for a sibling we hold), and -1 is returned on contention.
+ */
+static int splitRangeOnce(bptree *tree, KEY_T key_start, KEY_T key_end, int wanted, KEY_T cuts[]) {
+    latchShared(&tree->root_latch);
+    node *root = tree->root;
+    if (root == NULL || root->is_leaf)
+    {
+        unlatchShared(&tree->root_latch);
+        return 0;
+    }
+    latchShared(&root->latch);
+    unlatchShared(&tree->root_latch);
+
+    int num_level = 1;
+    node **level = malloc(sizeof(node *));
+    if (level == NULL)
+    {
+        perror("Range split level.");
+        exit(EXIT_FAILURE);
+    }
+    level[0] = root;
 
-    while (n != NULL)
+    while (true)
     {
-        for (; i < n->num_keys &&
-               compare_key(n->keys[i], key_end) <= 0;
-             i++)
+        /* Separators of this level that fall inside (key_start, key_end]. Nodes in
+         * level are in key order, so the separators come out sorted.
+         */
+        int num_seps = 0;
+        for (int i = 0; i < num_level; i++)
+        {
+            node *n = level[i];
+            num_seps += nodeUpperBound(tree, n, key_end) - nodeUpperBound(tree, n, key_start);
+        }
+
+        bool last_internal = ((node *)level[0]->pointers[0])->is_leaf;
+        if (num_seps >= wanted || last_internal)
+        {
+            int num_cuts = num_seps < wanted ? num_seps : wanted;
+            int seen = 0, next_cut = 0;
+            for (int i = 0; i < num_level && next_cut < num_cuts; i++)
+            {
+                node *n = level[i];
+                int lo = nodeUpperBound(tree, n, key_start);
+                int hi = nodeUpperBound(tree, n, key_end);
+                for (int k = lo; k < hi && next_cut < num_cuts; k++, seen++)
+                {
+                    /* Cut j takes separator ((j + 1) * (num_seps + 1)) / (num_cuts + 1) - 1. */
+                    if (seen == ((next_cut + 1) * (num_seps + 1)) / (num_cuts + 1) - 1)
+                        cuts[next_cut++] = loadKey(tree, n, k);
+                }
+            }
+            releaseSharedLevel(level, num_level);
+            return next_cut;
+        }
+
+        /* Descend: children overlapping the range, in key order. */
+        int num_next = 0;
+        for (int i = 0; i < num_level; i++)
+            num_next += nodeUpperBound(tree, level[i], key_end) - nodeUpperBound(tree, level[i], key_start) + 1;
+        node **next = malloc(num_next * sizeof(node *));
+        if (next == NULL)
         {
-            returned_keys[num_found] = n->keys[i];
-            returned_pointers[num_found] = (ROW_PTR)n->pointers[i];
-            num_found++;
+            perror("Range split level.");
+            exit(EXIT_FAILURE);
         }
-        n = n->pointers[order - 1];
-        i = 0;
+        num_next = 0;
+        for (int i = 0; i < num_level; i++)
+        {
+            node *n = level[i];
+            int lo = nodeUpperBound(tree, n, key_start);
+            int hi = nodeUpperBound(tree, n, key_end);
+            for (int c = lo; c <= hi; c++)
+            {
+                node *child = n->pointers[c];
+                if (!latchTryShared(&child->latch))
+                {
+                    releaseSharedLevel(next, num_next);
+                    releaseSharedLevel(level, num_level);
+                    return -1;
+                }
+                next[num_next++] = child;
+            }
+        }
+        releaseSharedLevel(level, num_level);
+        level = next;
+        num_level = num_next;
     }
-    return num_found;
 }
 
-/* findLeaf: Descends separators to leaf potentially containing key. */
-node *findLeaf(node *const root, KEY_T key, bool verbose) {
-    if (root == NULL)
+/* bptreeSplitRange: Picks up to max_parts - 1 cut keys that divide [key_start, key_end]
+ * into sub-ranges covering roughly equal numbers of leaves, using only internal-node
+ * separators. The nodes overlapping the range are followed level by level until a level
+ * has enough separators inside (key_start, key_end] (or the level above the leaves is
+ * reached), and evenly spaced separators from that level become the cuts.
+ * Sub-range p is [cuts[p - 1], cuts[p]) with key_start / key_end closing the ends.
+ * Returns the number of cuts (0 means the range is too small to split, or writers kept
+ * the nodes busy; the caller then scans it in one piece).
+ */
+int bptreeSplitRange(bptree *tree, KEY_T key_start, KEY_T key_end, int max_parts, KEY_T cuts[]) {
+    if (tree == NULL || max_parts < 2)
+        return 0;
+    if (key_start.type != tree->key_type || key_end.type != tree->key_type ||
+        compare_key(key_start, key_end) > 0)
+        return 0;
+
+    for (int attempt = 0; attempt < SPLIT_RANGE_ATTEMPTS; attempt++)
+    {
+        int num_cuts = splitRangeOnce(tree, key_start, key_end, max_parts - 1, cuts);
+        if (num_cuts >= 0)
+            return num_cuts;
+    }
+    return 0;
+}
+
+/* findLeaf: Descends separators to leaf potentially containing key. Takes no latches
+ * (debugging / single-threaded use); concurrent readers go through descendShared.
+ */
+node *findLeaf(bptree *const tree, KEY_T key, bool verbose) {
+    if (tree == NULL || tree->root == NULL)
     {
         if (verbose)
             printf("Empty tree.\n");
         return NULL;
     }
+    if (key.type != tree->key_type)
+    {
+        if (verbose)
+            printf("Key type does not match the tree.\n");
+        return NULL;
+    }
     int i = 0;
-    node *c = root;
+    node *c = tree->root;
     while (!c->is_leaf)
     {
         if (verbose)
@@ -330,16 +1280,14 @@ node *findLeaf(node *const root, KEY_T key, bool verbose) {
             printf("[");
             for (i = 0; i < c->num_keys; i++)
             {
-                print_key(c->keys[i]);
+                print_key(loadKey(tree, c, i));
                 if (i != c->num_keys - 1) printf(" ");
             }
             printf("] ");
         }
-        i = 0;
-        // Modified for duplicates: use > instead of >= to go to the leftmost child
-        while (i < c->num_keys &&
-               compare_key(key, c->keys[i]) > 0)
-            i++;
+        // Keys are unique and a separator is the smallest key of its right subtree,
+        // so follow the child after the last separator <= key
+        i = nodeUpperBound(tree, c, key);
         if (verbose)
             printf("%d ->\n", i);
         c = (node *)c->pointers[i];
@@ -349,7 +1297,7 @@ node *findLeaf(node *const root, KEY_T key, bool verbose) {
         printf("Leaf [");
         for (i = 0; i < c->num_keys; i++)
         {
-            print_key(c->keys[i]);
+            print_key(loadKey(tree, c, i));
             if (i != c->num_keys - 1) printf(" ");
         }
         printf("] ->\n");
@@ -357,56 +1305,27 @@ node *findLeaf(node *const root, KEY_T key, bool verbose) {
     return c;
 }
 
-/* find_rows: returns the number of rows found and populates results array. */
-int find_rows(node *root, KEY_T key, ROW_PTR **results) {
-    if (root == NULL) {
-        *results = NULL;
+/* find_rows: returns the number of rows found and populates results array (NULL when none). */
+int find_rows(bptree *tree, KEY_T key, ROW_PTR **results) {
+    *results = NULL;
+    if (tree == NULL || key.type != tree->key_type)
         return 0;
-    }
-
-    node *leaf = findLeaf(root, key, false);
-    if (leaf == NULL) {
-        *results = NULL;
+    node *leaf = descendShared(tree, key);
+    if (leaf == NULL)
         return 0;
-    }
 
+    // One slot per key: either the row itself or its posting list
     int count = 0;
-    int capacity = 10;
-    *results = malloc(capacity * sizeof(ROW_PTR));
-    if (*results == NULL) {
-        perror("Failed to allocate memory for results");
-        exit(EXIT_FAILURE);
-    }
-    
-    // Find the first occurrence in the leaf
-    int i = 0;
-    while (i < leaf->num_keys && compare_key(leaf->keys[i], key) < 0)
-        i++;
-
-    // Traverse keys in this leaf and subsequent leaves
-    while (leaf != NULL) {
-        for (; i < leaf->num_keys; i++) {
-            if (compare_key(leaf->keys[i], key) == 0) {
-                if (count >= capacity) {
-                    capacity *= 2;
-                    ROW_PTR *temp = realloc(*results, capacity * sizeof(ROW_PTR));
-                    if (temp == NULL) {
-                        perror("Failed to reallocate memory for results");
-                        free(*results);
-                        exit(EXIT_FAILURE);
-                    }
-                    *results = temp;
-                }
-                (*results)[count++] = (ROW_PTR)leaf->pointers[i];
-            } else if (compare_key(leaf->keys[i], key) > 0) {
-                // Since keys are sorted, we can stop if we see a greater key
-                return count;
-            }
+    int i = findKeyInLeaf(tree, leaf, key);
+    if (i >= 0) {
+        *results = malloc(slotRowCount(leaf->pointers[i]) * sizeof(ROW_PTR));
+        if (*results == NULL) {
+            perror("Failed to allocate memory for results");
+            exit(EXIT_FAILURE);
         }
-        // Move to next leaf
-        leaf = leaf->pointers[order - 1];
-        i = 0;
+        count = slotRows(leaf->pointers[i], *results);
     }
+    unlatchShared(&leaf->latch);
     return count;
 }
 
@@ -420,44 +1339,40 @@ int cut(int length) {
 
 /* ==================== Node allocation ==================== */
 
-static node *makeNode(void) {
-    node *new_node;
-    new_node = malloc(sizeof(node));
+/* makeNode: One cache-line aligned block holding the header, typed key, pointer and count arrays. */
+static node *makeNode(bptree *tree) {
+    node *new_node = tree->allocator.alloc(tree->allocator.ctx, tree->node_bytes);
     if (new_node == NULL)
     {
         perror("Node creation.");
         exit(EXIT_FAILURE);
     }
-    new_node->keys = calloc((order - 1), sizeof(KEY_T));
-    if (new_node->keys == NULL)
-    {
-        perror("New node keys array.");
-        exit(EXIT_FAILURE);
-    }
-    new_node->pointers = calloc(order, sizeof(void *));
-    if (new_node->pointers == NULL)
-    {
-        perror("New node pointers array.");
-        exit(EXIT_FAILURE);
-    }
+    memset(new_node, 0, tree->node_bytes);
+    new_node->keys = (char *)new_node + nodeKeysOffset();
+    new_node->pointers = (void **)((char *)new_node + nodePointersOffset(tree->key_size, tree->order));
+    new_node->counts = (int *)((char *)new_node + nodeCountsOffset(tree->key_size, tree->order));
     new_node->is_leaf = false;
     new_node->num_keys = 0;
     new_node->parent = NULL;
-    new_node->next = NULL;
+    atomic_init(&new_node->latch, 0);
+    atomic_fetch_add_explicit(&tree->stats.nodes, 1, memory_order_relaxed);
     return new_node;
 }
 
-static node *makeLeaf(void) {
-    node *leaf = makeNode();
+static node *makeLeaf(bptree *tree) {
+    node *leaf = makeNode(tree);
     leaf->is_leaf = true;
     return leaf;
 }
 
+/* freeNode: Keys and pointers live inside the node block, so one free releases everything. */
+static void freeNode(bptree *tree, node *n) {
+    tree->allocator.release(tree->allocator.ctx, n);
+    atomic_fetch_sub_explicit(&tree->stats.nodes, 1, memory_order_relaxed);
+}
+
 /* getLeftIndex: Finds child's index in parent->pointers. */
 static int getLeftIndex(node *parent, node *left) {
-    int rank = get_rank();
-    // printf("[Rank %d] DEBUG: getLeftIndex called. parent=%p, left=%p\n", rank, (void*)parent, (void*)left);
-    // fflush(stdout);
     int left_index = 0;
     while (left_index <= parent->num_keys &&
            parent->pointers[left_index] != left)
@@ -465,89 +1380,150 @@ static int getLeftIndex(node *parent, node *left) {
     return left_index;
 }
 
-/* ==================== Leaf insertion ==================== */
-
-/* insertIntoLeaf: Inserts key / row_ptr into non-full leaf maintaining order. */
-static node *insertIntoLeaf(node *leaf, KEY_T key, ROW_PTR row_ptr) {
-    fflush(stdout);
-    int i, insertion_point = 0;
-
-    while (insertion_point < leaf->num_keys &&
-           compare_key(leaf->keys[insertion_point], key) < 0)
-        insertion_point++;
+/* ==================== Subtree counts ==================== */
 
-    fflush(stdout);
+/* Every internal node keeps, next to each child pointer, the number of rows stored
+ * under that child (posting-list rows included). Writers add their row to each count
+ * on the way down (descendExclusive); splits, merges and redistributions recompute
+ * the entries of the nodes they reshape. Ranks and range sizes then come from one
+ * root-to-leaf descent instead of a leaf scan.
+ */
 
-    for (i = leaf->num_keys; i > insertion_point; i--) {
-        leaf->keys[i] = leaf->keys[i - 1];
-        leaf->pointers[i] = leaf->pointers[i - 1];
+/* nodeRowCount: Rows stored under n. */
+static int nodeRowCount(const node *n) {
+    int total = 0;
+    if (n->is_leaf) {
+        for (int i = 0; i < n->num_keys; i++)
+            total += slotRowCount(n->pointers[i]);
+    } else {
+        for (int i = 0; i <= n->num_keys; i++)
+            total += n->counts[i];
     }
-    leaf->keys[insertion_point] = key;
-    leaf->pointers[insertion_point] = row_ptr;
-    leaf->num_keys++;
-    fflush(stdout);
-    return leaf;
+    return total;
 }
 
-/* insertIntoLeafAfterSplitting: Splits full leaf and promotes first key of new leaf. */
-static node *insertIntoLeafAfterSplitting(node *root, node *leaf, KEY_T key, ROW_PTR row_ptr) {
-    
-    if (leaf->keys == NULL) {
-        fflush(stdout);
-        exit(EXIT_FAILURE);
+/* countBetween: Rows with key_start <= key <= key_end, i.e. rows <= key_end minus rows < key_start.
+ * Both boundary paths are latched together, level by level, so a concurrent writer cannot
+ * move rows across one boundary between the two reads.
+ */
+static int countBetween(bptree *tree, KEY_T key_start, KEY_T key_end) {
+    int total = 0;
+    latchShared(&tree->root_latch);
+    node *lo = tree->root;
+    if (lo == NULL)
+    {
+        unlatchShared(&tree->root_latch);
+        return 0;
     }
-
-    node *new_leaf = makeLeaf();
-    fflush(stdout);
-
-    KEY_T *temp_keys = malloc(order * sizeof(KEY_T));
-    void **temp_pointers = malloc(order * sizeof(void *));
-    if (!temp_keys || !temp_pointers) {
-        perror("Temporary arrays allocation failed");
-        exit(EXIT_FAILURE);
+    latchShared(&lo->latch);
+    unlatchShared(&tree->root_latch);
+    node *hi = lo;
+    while (!lo->is_leaf)
+    {
+        // Same routing as findLeaf; everything left of the chosen child is below the key
+        int i = nodeUpperBound(tree, lo, key_start);
+        int j = nodeUpperBound(tree, hi, key_end);
+        for (int k = 0; k < j; k++)
+            total += hi->counts[k];
+        for (int k = 0; k < i; k++)
+            total -= lo->counts[k];
+        node *lo_child = (node *)lo->pointers[i];
+        node *hi_child = (node *)hi->pointers[j];
+        latchShared(&lo_child->latch);  // Left to right, like every other same-level latch
+        if (hi_child != lo_child)
+            latchShared(&hi_child->latch);
+        unlatchShared(&lo->latch);
+        if (hi != lo)
+            unlatchShared(&hi->latch);
+        lo = lo_child;
+        hi = hi_child;
     }
-    fflush(stdout);
+    int end = nodeUpperBound(tree, hi, key_end);
+    int start = nodeLowerBound(tree, lo, key_start);
+    for (int k = 0; k < end; k++)
+        total += slotRowCount(hi->pointers[k]);
+    for (int k = 0; k < start; k++)
+        total -= slotRowCount(lo->pointers[k]);
+    unlatchShared(&lo->latch);
+    if (hi != lo)
+        unlatchShared(&hi->latch);
+    return total;
+}
 
-    int insertion_index = 0;
-    while (insertion_index < order - 1) {
-        fflush(stdout);
-        if (compare_key(leaf->keys[insertion_index], key) >= 0)
-            break;
-        insertion_index++;
-    }
-    fflush(stdout);
+/* countRange: Rows with key_start <= key <= key_end in O(log n) (0 for an empty or mistyped range). */
+int countRange(bptree *tree, KEY_T key_start, KEY_T key_end) {
+    if (tree == NULL)
+        return 0;
+    if (key_start.type != tree->key_type || key_end.type != tree->key_type)
+        return 0;
+    if (compare_key(key_start, key_end) > 0)
+        return 0;
+    return countBetween(tree, key_start, key_end);
+}
 
-    int i, j;
-    for (i = 0, j = 0; i < leaf->num_keys; i++, j++) {
-        if (j == insertion_index)
-            j++;
-        temp_keys[j] = leaf->keys[i];
-        temp_pointers[j] = leaf->pointers[i];
+/* countRows: Total rows indexed by the tree. */
+int countRows(bptree *tree) {
+    if (tree == NULL)
+        return 0;
+    latchShared(&tree->root_latch);
+    node *root = tree->root;
+    if (root == NULL)
+    {
+        unlatchShared(&tree->root_latch);
+        return 0;
     }
+    latchShared(&root->latch);
+    unlatchShared(&tree->root_latch);
+    int total = nodeRowCount(root);
+    unlatchShared(&root->latch);
+    return total;
+}
 
-    temp_keys[insertion_index] = key;
-    temp_pointers[insertion_index] = row_ptr;
+/* ==================== Leaf insertion ==================== */
 
-    fflush(stdout);
+/* insertIntoLeaf: Inserts key / row_ptr into non-full leaf maintaining order. */
+static void insertIntoLeaf(bptree *tree, node *leaf, KEY_T key, ROW_PTR row_ptr) {
+    int insertion_point = nodeLowerBound(tree, leaf, key);
+    int tail = leaf->num_keys - insertion_point;
+
+    moveKeys(tree, leaf, insertion_point + 1, leaf, insertion_point, tail);
+    memmove(&leaf->pointers[insertion_point + 1], &leaf->pointers[insertion_point],
+            tail * sizeof(void *));
+    storeKey(tree, leaf, insertion_point, key);
+    leaf->pointers[insertion_point] = row_ptr;
+    leaf->num_keys++;
+}
 
-    leaf->num_keys = 0;
+/* insertIntoLeafAfterSplitting: Splits full leaf and promotes first key of new leaf. */
+static void insertIntoLeafAfterSplitting(bptree *tree, node *leaf, KEY_T key, ROW_PTR row_ptr) {
+    int order = tree->order;
+    int i;
+    node *new_leaf = makeLeaf(tree);
+    atomic_fetch_add_explicit(&tree->stats.splits, 1, memory_order_relaxed);
 
+    int insertion_index = nodeLowerBound(tree, leaf, key);
     int split = cut(order - 1);
 
-    for (i = 0; i < split; i++) {
-        leaf->keys[i] = temp_keys[i];
-        leaf->pointers[i] = temp_pointers[i];
-        leaf->num_keys++;
-    }
-
-    for (i = split, j = 0; i < order; i++, j++) {
-        new_leaf->keys[j] = temp_keys[i];
-        new_leaf->pointers[j] = temp_pointers[i];
-        new_leaf->num_keys++;
+    /* The order entries (old + new) split as [0, split) stay and [split, order) move.
+     * Fill the new leaf first so the old leaf can then be finished in place.
+     */
+    for (i = split; i < order; i++)
+    {
+        int j = i - split;
+        if (i == insertion_index) {
+            storeKey(tree, new_leaf, j, key);
+            new_leaf->pointers[j] = row_ptr;
+        } else {
+            int src = i < insertion_index ? i : i - 1;
+            moveKeys(tree, new_leaf, j, leaf, src, 1);
+            new_leaf->pointers[j] = leaf->pointers[src];
+        }
     }
+    new_leaf->num_keys = order - split;
 
-    free(temp_keys);
-    free(temp_pointers);
+    leaf->num_keys = insertion_index < split ? split - 1 : split;
+    if (insertion_index < split)
+        insertIntoLeaf(tree, leaf, key, row_ptr);
 
     new_leaf->pointers[order - 1] = leaf->pointers[order - 1];
     leaf->pointers[order - 1] = new_leaf;
@@ -558,103 +1534,127 @@ static node *insertIntoLeafAfterSplitting(node *root, node *leaf, KEY_T key, ROW
         new_leaf->pointers[i] = NULL;
 
     new_leaf->parent = leaf->parent;
-    KEY_T new_key = new_leaf->keys[0];
-
-    fflush(stdout);
+    KEY_T new_key = loadKey(tree, new_leaf, 0);
 
-    return insertIntoParent(root, leaf, new_key, new_leaf);
+    insertIntoParent(tree, leaf, new_key, new_leaf);
 }
 
-/* destroy_tree: Frees all nodes and arrays used by the B+ tree. */
-void destroy_tree(node *root) {
-    if (root == NULL) return;
+/* destroyNodes: Frees a subtree bottom-up. */
+static void destroyNodes(bptree *tree, node *n) {
+    if (n == NULL) return;
 
-    if (!root->is_leaf) {
-        for (int i = 0; i <= root->num_keys; i++) {
-            if (root->pointers[i] != NULL)
-                destroy_tree((node *)root->pointers[i]);
+    if (!n->is_leaf) {
+        for (int i = 0; i <= n->num_keys; i++) {
+            if (n->pointers[i] != NULL)
+                destroyNodes(tree, (node *)n->pointers[i]);
         }
+    } else {
+        for (int i = 0; i < n->num_keys; i++)
+            freeSlot(n->pointers[i]);
     }
+    freeNode(tree, n);
+}
 
-    /* Free this node's arrays and node */
-    if (root->keys) free(root->keys);
-    if (root->pointers) free(root->pointers);
-    free(root);
+/* freeLeafSlots: Frees the posting lists of every leaf, walking the leaf chain. */
+static void freeLeafSlots(bptree *tree) {
+    node *c = tree->root;
+    if (c == NULL) return;
+    while (!c->is_leaf)
+        c = c->pointers[0];
+    while (c != NULL) {
+        for (int i = 0; i < c->num_keys; i++)
+            freeSlot(c->pointers[i]);
+        c = c->pointers[tree->order - 1];
+    }
+}
+
+/* destroy_tree: Frees all nodes used by the B+ tree and the tree handle. */
+void destroy_tree(bptree *tree) {
+    if (tree == NULL) return;
+    if (tree->arena != NULL) {
+        // Nodes go away with their slabs; only the posting lists hang off the leaves
+        freeLeafSlots(tree);
+        nodeArenaDestroy(tree->arena);
+    } else {
+        destroyNodes(tree, tree->root);
+    }
+    free(tree);
 }
 
 /* ==================== Internal node insertion ==================== */
 
-static node *insertIntoNode(node *root, node *n,
-                            int left_index, KEY_T key, node *right) {
-    int i;
+static void insertIntoNode(bptree *tree, node *n, int left_index, KEY_T key, node *right) {
+    int tail = n->num_keys - left_index;
 
-    for (i = n->num_keys; i > left_index; i--)
-    {
-        n->pointers[i + 1] = n->pointers[i];
-        n->keys[i] = n->keys[i - 1];
-    }
+    memmove(&n->pointers[left_index + 2], &n->pointers[left_index + 1], tail * sizeof(void *));
+    memmove(&n->counts[left_index + 2], &n->counts[left_index + 1], tail * sizeof(int));
+    moveKeys(tree, n, left_index + 1, n, left_index, tail);
     n->pointers[left_index + 1] = right;
-    n->keys[left_index] = key;
+    n->counts[left_index] = nodeRowCount(n->pointers[left_index]);
+    n->counts[left_index + 1] = nodeRowCount(right);
+    storeKey(tree, n, left_index, key);
     n->num_keys++;
-    return root;
 }
 
-static node *insertIntoNodeAfterSplitting(node *root, node *old_node, int left_index,
-                                          KEY_T key, node *right) {
-    int i, j, split;
+static void insertIntoNodeAfterSplitting(bptree *tree, node *old_node, int left_index,
+                                         KEY_T key, node *right) {
+    int i, split;
+    int order = tree->order;
     KEY_T k_prime;
     node *new_node, *child;
-    KEY_T *temp_keys;
-    node **temp_pointers;
-
-    temp_pointers = malloc((order + 1) * sizeof(node *));
-    if (temp_pointers == NULL)
-    {
-        exit(EXIT_FAILURE);
-    }
-    temp_keys = malloc(order * sizeof(KEY_T));
-    if (temp_keys == NULL)
+    node temp;  // Scratch header over the overfull key / pointer arrays
+    void **temp_pointers;
+    void *temp_keys;
+    int *temp_counts;
+
+    atomic_fetch_add_explicit(&tree->stats.splits, 1, memory_order_relaxed);
+    temp_pointers = malloc((order + 1) * sizeof(void *));
+    temp_keys = malloc((size_t)order * tree->key_size);
+    temp_counts = malloc((order + 1) * sizeof(int));
+    if (temp_pointers == NULL || temp_keys == NULL || temp_counts == NULL)
     {
+        perror("Temporary arrays allocation failed");
         exit(EXIT_FAILURE);
     }
+    temp.keys = temp_keys;
+    temp.pointers = temp_pointers;
 
-    for (i = 0, j = 0; i < old_node->num_keys + 1; i++, j++)
-    {
-        if (j == left_index + 1)
-            j++;
-        temp_pointers[j] = old_node->pointers[i];
-    }
-
-    for (i = 0, j = 0; i < old_node->num_keys; i++, j++)
-    {
-        if (j == left_index)
-            j++;
-        temp_keys[j] = old_node->keys[i];
-    }
-
+    /* Overfull node: order keys and order + 1 pointers with the new entry spliced in. */
+    memcpy(temp_pointers, old_node->pointers, (left_index + 1) * sizeof(void *));
     temp_pointers[left_index + 1] = right;
-    temp_keys[left_index] = key;
+    memcpy(&temp_pointers[left_index + 2], &old_node->pointers[left_index + 1],
+           (old_node->num_keys - left_index) * sizeof(void *));
+    memcpy(temp_counts, old_node->counts, (left_index + 1) * sizeof(int));
+    temp_counts[left_index] = nodeRowCount(old_node->pointers[left_index]);
+    temp_counts[left_index + 1] = nodeRowCount(right);
+    memcpy(&temp_counts[left_index + 2], &old_node->counts[left_index + 1],
+           (old_node->num_keys - left_index) * sizeof(int));
+
+    moveKeys(tree, &temp, 0, old_node, 0, left_index);
+    storeKey(tree, &temp, left_index, key);
+    moveKeys(tree, &temp, left_index + 1, old_node, left_index, old_node->num_keys - left_index);
 
     split = cut(order);
-    new_node = makeNode();
-    old_node->num_keys = 0;
-    for (i = 0; i < split - 1; i++)
-    {
-        old_node->pointers[i] = temp_pointers[i];
-        old_node->keys[i] = temp_keys[i];
-        old_node->num_keys++;
-    }
-    old_node->pointers[i] = temp_pointers[i];
-    k_prime = temp_keys[split - 1];
-    for (++i, j = 0; i < order; i++, j++)
-    {
-        new_node->pointers[j] = temp_pointers[i];
-        new_node->keys[j] = temp_keys[i];
-        new_node->num_keys++;
-    }
-    new_node->pointers[j] = temp_pointers[i];
+    new_node = makeNode(tree);
+
+    /* Left half keeps keys [0, split - 1) and pointers [0, split). */
+    moveKeys(tree, old_node, 0, &temp, 0, split - 1);
+    memcpy(old_node->pointers, temp_pointers, split * sizeof(void *));
+    memcpy(old_node->counts, temp_counts, split * sizeof(int));
+    old_node->num_keys = split - 1;
+    for (i = split; i < order; i++)
+        old_node->pointers[i] = NULL;
+
+    /* Key split - 1 moves up; right half gets keys [split, order) and pointers [split, order]. */
+    k_prime = loadKey(tree, &temp, split - 1);
+    moveKeys(tree, new_node, 0, &temp, split, order - split);
+    memcpy(new_node->pointers, &temp_pointers[split], (order + 1 - split) * sizeof(void *));
+    memcpy(new_node->counts, &temp_counts[split], (order + 1 - split) * sizeof(int));
+    new_node->num_keys = order - split;
+
     free(temp_pointers);
     free(temp_keys);
+    free(temp_counts);
     new_node->parent = old_node->parent;
     for (i = 0; i <= new_node->num_keys; i++)
     {
@@ -662,122 +1662,338 @@ static node *insertIntoNodeAfterSplitting(node *root, node *old_node, int left_i
         child->parent = new_node;
     }
 
-    return insertIntoParent(root, old_node, k_prime, new_node);
+    insertIntoParent(tree, old_node, k_prime, new_node);
 }
 
 /* insertIntoParent: Chooses between simple insert, split, or new root creation. */
-static node *insertIntoParent(node *root, node *left, KEY_T key, node *right) {
-    
+static void insertIntoParent(bptree *tree, node *left, KEY_T key, node *right) {
     int left_index;
     node *parent;
 
     parent = left->parent;
-    fflush(stdout);
 
     if (parent == NULL) {
-        fflush(stdout);
-        return insertIntoNewRoot(left, key, right);
+        insertIntoNewRoot(tree, left, key, right);
+        return;
     }
 
-    fflush(stdout);
     left_index = getLeftIndex(parent, left);
-    fflush(stdout);
 
-    if (parent->num_keys < order - 1) {
-        fflush(stdout);
-        return insertIntoNode(root, parent, left_index, key, right);
+    if (parent->num_keys < tree->order - 1) {
+        insertIntoNode(tree, parent, left_index, key, right);
+        return;
     }
 
-    fflush(stdout);
-    return insertIntoNodeAfterSplitting(root, parent, left_index, key, right);
+    insertIntoNodeAfterSplitting(tree, parent, left_index, key, right);
 }
 
 /* insertIntoNewRoot: Builds new root after old root splits. */
-static node *insertIntoNewRoot(node *left, KEY_T key, node *right) {
-    
-    node *root = makeNode();
-    root->keys[0] = key;
+static void insertIntoNewRoot(bptree *tree, node *left, KEY_T key, node *right) {
+    node *root = makeNode(tree);
+    storeKey(tree, root, 0, key);
     root->pointers[0] = left;
     root->pointers[1] = right;
+    root->counts[0] = nodeRowCount(left);
+    root->counts[1] = nodeRowCount(right);
     root->num_keys = 1;
     root->parent = NULL;
     left->parent = root;
     right->parent = root;
-    fflush(stdout);
-    return root;
+    tree->root = root;
 }
 
 /* startNewTree: Initializes first leaf (root) with single key / row_ptr. */
-static node *startNewTree(KEY_T key, ROW_PTR row_ptr) {
-    node *root = makeLeaf();
-    root->keys[0] = key;
+static void startNewTree(bptree *tree, KEY_T key, ROW_PTR row_ptr) {
+    node *root = makeLeaf(tree);
+    storeKey(tree, root, 0, key);
     root->pointers[0] = row_ptr;
-    root->pointers[order - 1] = NULL;
+    root->pointers[tree->order - 1] = NULL;
     root->parent = NULL;
     root->num_keys = 1;
-    return root;
+    tree->root = root;
 }
 
-/* ==================== Public insert (upsert) ==================== */
+/* ==================== Public insert ==================== */
 
-node *insert(node *root, KEY_T key, ROW_PTR row_ptr) {
-    fflush(stdout);
-    if (root == NULL)
-        return startNewTree(key, row_ptr);
+void insert(bptree *tree, KEY_T key, ROW_PTR row_ptr) {
+    if (key.type != tree->key_type) {
+        fprintf(stderr, "B+ tree insert: key type %d does not match tree type %d\n",
+                (int)key.type, (int)tree->key_type);
+        return;
+    }
 
-    node *leaf = findLeaf(root, key, false);
-    fflush(stdout);
+    if ((uintptr_t)row_ptr & POSTING_TAG) {
+        fprintf(stderr, "B+ tree insert: row pointer %p is not 2-byte aligned\n", row_ptr);
+        return;
+    }
 
-    /* Duplicates allowed: removed upsert check */
+    write_latches w;
+    node *leaf = descendExclusive(tree, key, 1, true, &w);
+    if (leaf == NULL) {
+        startNewTree(tree, key, row_ptr);
+        releaseWriteLatches(tree, &w);
+        return;
+    }
 
-    /* Key not present or duplicate: insert new entry */
-    if (leaf->num_keys < order - 1) {
-        insertIntoLeaf(leaf, key, row_ptr);
-        return root;
+    /* Case: key already present. The row joins its slot; the tree shape is unchanged. */
+    int existing = findKeyInLeaf(tree, leaf, key);
+    if (existing >= 0) {
+        int before = slotRowCount(leaf->pointers[existing]);
+        addRowToSlot(&leaf->pointers[existing], row_ptr);
+        bool added = slotRowCount(leaf->pointers[existing]) > before;
+        releaseWriteLatches(tree, &w);
+        if (!added)
+            adjustPathCounts(tree, key, -1);  // Row was already there
+        return;
     }
 
-    return insertIntoLeafAfterSplitting(root, leaf, key, row_ptr);
+    /* Case: new key. Splits only touch nodes that are still latched, and recompute
+     * the counts of the halves they create. */
+    if (leaf->num_keys < tree->order - 1)
+        insertIntoLeaf(tree, leaf, key, row_ptr);
+    else
+        insertIntoLeafAfterSplitting(tree, leaf, key, row_ptr);
+    releaseWriteLatches(tree, &w);
 }
 
-/* ==================== Deletion ==================== */
+/* ==================== Bulk loading ==================== */
 
-static node *adjustRoot(node *root);
-static node *coalesceNodes(node *root, node *n, node *neighbor, int neighbor_index, KEY_T k_prime);
-static node *redistributeNodes(node *root, node *n, node *neighbor, int neighbor_index, int k_prime_index, KEY_T k_prime);
-static node *deleteEntry(node *root, node *n, KEY_T key, void *pointer);
-static node *removeEntryFromNode(node *n, KEY_T key, node *pointer);
-static int getNeighborIndex(node *n);
+/* compareRows: Orders row pointers by address (posting list order). */
+static int compareRows(const void *a, const void *b) {
+    uintptr_t ra = (uintptr_t)*(const ROW_PTR *)a;
+    uintptr_t rb = (uintptr_t)*(const ROW_PTR *)b;
+    return (ra > rb) - (ra < rb);
+}
 
-/* removeEntryFromNode: Removes key and pointer from node. */
-static node *removeEntryFromNode(node *n, KEY_T key, node *pointer) {
-    int i, num_pointers;
+/* compareEntries: Orders entries by key, breaking ties by row pointer so duplicates stay deterministic. */
+static int compareEntries(const void *a, const void *b) {
+    const bplus_entry *ea = (const bplus_entry *)a;
+    const bplus_entry *eb = (const bplus_entry *)b;
+    int cmp = compare_key(ea->key, eb->key);
+    if (cmp != 0)
+        return cmp;
+    uintptr_t ra = (uintptr_t)ea->row_ptr;
+    uintptr_t rb = (uintptr_t)eb->row_ptr;
+    return (ra > rb) - (ra < rb);
+}
 
-    // Remove the key and shift other keys to the left
-    i = 0;
-    while (i < n->num_keys && compare_key(n->keys[i], key) != 0)
-        i++;
-    
-    if (i == n->num_keys) {
-        printf("Error: Key not found in node during deletion.\n");
-        return n;
+/* bulkNodeSizes: Splits num_items across nodes packed to fill_factor of capacity.
+ * Every node keeps at least `minimum` items (except a lone root) so the deletion
+ * invariants hold exactly as if the tree had been built by insert().
+ */
+static int *bulkNodeSizes(int num_items, int capacity, int minimum, double fill_factor, int *num_nodes) {
+    int per_node = (int)(capacity * fill_factor);
+    if (per_node < minimum) per_node = minimum;
+    if (per_node > capacity) per_node = capacity;
+    if (per_node < 1) per_node = 1;
+
+    int count = (num_items + per_node - 1) / per_node;
+    int *sizes = malloc(count * sizeof(int));
+    if (sizes == NULL)
+    {
+        perror("Bulk load node sizes.");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < count; i++)
+        sizes[i] = per_node;
+    sizes[count - 1] = num_items - (count - 1) * per_node;
+
+    /* Case: last node underfull. Merge it into its left neighbor if that fits,
+     * otherwise split the pair evenly (both halves are then >= minimum).
+     */
+    if (count > 1 && sizes[count - 1] < minimum)
+    {
+        int combined = sizes[count - 2] + sizes[count - 1];
+        if (combined <= capacity)
+        {
+            sizes[count - 2] = combined;
+            count--;
+        }
+        else
+        {
+            sizes[count - 2] = combined - combined / 2;
+            sizes[count - 1] = combined / 2;
+        }
     }
 
-    for (++i; i < n->num_keys; i++)
-        n->keys[i - 1] = n->keys[i];
+    *num_nodes = count;
+    return sizes;
+}
 
-    // Remove the pointer and shift other pointers to the left
+/* groupDuplicateKeys: Collapses each run of equal keys in sorted entries into one entry
+ * whose row_ptr is the leaf slot (the row itself, or a tagged posting list built from
+ * the run's rows, put in address order unless compareEntries already did). Returns the
+ * number of distinct keys.
+ */
+static int groupDuplicateKeys(bplus_entry entries[], int num_entries) {
+    ROW_PTR *run = NULL;
+    int unique = 0;
+    int g = 0;
+
+    while (g < num_entries)
+    {
+        int h = g + 1;
+        while (h < num_entries && compare_key(entries[h].key, entries[g].key) == 0)
+            h++;
+
+        void *slot = entries[g].row_ptr;
+        if (h - g > 1)
+        {
+            if (run == NULL)
+            {
+                run = malloc(num_entries * sizeof(ROW_PTR));
+                if (run == NULL)
+                {
+                    perror("Bulk load posting run.");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            bool sorted = true;
+            for (int r = g; r < h; r++)
+            {
+                run[r - g] = entries[r].row_ptr;
+                if (r > g && (uintptr_t)run[r - g] < (uintptr_t)run[r - g - 1])
+                    sorted = false;
+            }
+            if (!sorted)  // Presorted input only orders keys; posting lists need address order
+                qsort(run, h - g, sizeof(ROW_PTR), compareRows);
+            posting_list *pl = postingFromSorted(run, h - g);
+            if (pl->num_rows == 1)
+                postingDestroy(pl);  // The run listed a single row several times
+            else
+                slot = (void *)((uintptr_t)pl | POSTING_TAG);
+        }
+
+        entries[unique].key = entries[g].key;
+        entries[unique].row_ptr = slot;
+        unique++;
+        g = h;
+    }
+
+    free(run);
+    return unique;
+}
+
+/* bulkLoad: Sorts entries once, folds duplicate keys into posting lists, then packs
+ * leaves and each internal level left to right. Any existing contents of the tree are discarded.
+ */
+void bulkLoad(bptree *tree, bplus_entry entries[], int num_entries, double fill_factor) {
+    if (entries != NULL && num_entries > 0)
+        qsort(entries, num_entries, sizeof(bplus_entry), compareEntries);
+    bulkLoadSorted(tree, entries, num_entries, fill_factor);
+}
+
+/* bulkLoadSorted: bulkLoad without the sort, for input already in key order (e.g. a saved index). */
+void bulkLoadSorted(bptree *tree, bplus_entry entries[], int num_entries, double fill_factor) {
+    destroyNodes(tree, tree->root);
+    tree->root = NULL;
+    if (entries == NULL || num_entries <= 0)
+        return;
+    int order = tree->order;
+    if (fill_factor <= 0.0 || fill_factor > 1.0)
+        fill_factor = BULK_FILL_FACTOR;
+
+    num_entries = groupDuplicateKeys(entries, num_entries);
+
+    /* Leaf level: nodes plus the smallest key under each (used as parent separators). */
+    int num_nodes;
+    int *sizes = bulkNodeSizes(num_entries, order - 1, cut(order - 1), fill_factor, &num_nodes);
+    node **level = malloc(num_nodes * sizeof(node *));
+    KEY_T *low_keys = malloc(num_nodes * sizeof(KEY_T));
+    if (level == NULL || low_keys == NULL)
+    {
+        perror("Bulk load level arrays.");
+        exit(EXIT_FAILURE);
+    }
+
+    int e = 0;
+    for (int i = 0; i < num_nodes; i++)
+    {
+        node *leaf = makeLeaf(tree);
+        for (int j = 0; j < sizes[i]; j++, e++)
+        {
+            storeKey(tree, leaf, j, entries[e].key);
+            leaf->pointers[j] = entries[e].row_ptr;
+        }
+        leaf->num_keys = sizes[i];
+        if (i > 0)
+            level[i - 1]->pointers[order - 1] = leaf;
+        level[i] = leaf;
+        low_keys[i] = loadKey(tree, leaf, 0);
+    }
+    free(sizes);
+
+    /* Internal levels: group children until a single root remains. */
+    while (num_nodes > 1)
+    {
+        int num_parents;
+        sizes = bulkNodeSizes(num_nodes, order, cut(order), fill_factor, &num_parents);
+
+        int c = 0;
+        for (int i = 0; i < num_parents; i++)
+        {
+            node *parent = makeNode(tree);
+            KEY_T parent_low = low_keys[c];
+            for (int j = 0; j < sizes[i]; j++, c++)
+            {
+                parent->pointers[j] = level[c];
+                parent->counts[j] = nodeRowCount(level[c]);
+                level[c]->parent = parent;
+                if (j > 0)
+                    storeKey(tree, parent, j - 1, low_keys[c]);
+            }
+            parent->num_keys = sizes[i] - 1;
+
+            /* Parents are written over the front of the arrays; c never trails i. */
+            level[i] = parent;
+            low_keys[i] = parent_low;
+        }
+        free(sizes);
+        num_nodes = num_parents;
+    }
+
+    tree->root = level[0];
+    tree->root->parent = NULL;
+    free(level);
+    free(low_keys);
+}
+
+/* ==================== Deletion ==================== */
+
+static void adjustRoot(bptree *tree, write_latches *w);
+static void coalesceNodes(bptree *tree, write_latches *w, node *n, node *neighbor, int neighbor_index, int k_prime_index);
+static void redistributeNodes(bptree *tree, node *n, node *neighbor, int neighbor_index, int k_prime_index);
+static void deleteEntry(bptree *tree, write_latches *w, node *n, void *pointer);
+static node *removeEntryFromNode(bptree *tree, node *n, void *pointer);
+static int getNeighborIndex(node *n);
+
+/* removeEntryFromNode: Removes pointer and its key from node.
+ * In a leaf the key at the pointer's index goes with it; in an internal node
+ * it is the separator to the left of the child pointer.
+ */
+static node *removeEntryFromNode(bptree *tree, node *n, void *pointer) {
+    int i, num_pointers;
+    int order = tree->order;
+
+    // Locate the pointer being removed
     num_pointers = n->is_leaf ? n->num_keys : n->num_keys + 1;
     i = 0;
     while (i < num_pointers && n->pointers[i] != pointer)
         i++;
-    
+
     if (i == num_pointers) {
         printf("Error: Pointer not found in node during deletion.\n");
         return n;
     }
 
-    for (++i; i < num_pointers; i++)
-        n->pointers[i - 1] = n->pointers[i];
+    // Remove the key and shift other keys to the left
+    int key_index = n->is_leaf ? i : i - 1;
+    moveKeys(tree, n, key_index, n, key_index + 1, n->num_keys - key_index - 1);
+
+    // Remove the pointer and shift other pointers to the left
+    memmove(&n->pointers[i], &n->pointers[i + 1], (num_pointers - i - 1) * sizeof(void *));
+    if (!n->is_leaf)
+        memmove(&n->counts[i], &n->counts[i + 1], (num_pointers - i - 1) * sizeof(int));
 
     n->num_keys--;
 
@@ -793,13 +2009,14 @@ static node *removeEntryFromNode(node *n, KEY_T key, node *pointer) {
     return n;
 }
 
-/* adjustRoot: Handles case where root has become empty. */
-static node *adjustRoot(node *root) {
+/* adjustRoot: Handles case where root has become empty (the root latch is held). */
+static void adjustRoot(bptree *tree, write_latches *w) {
+    node *root = tree->root;
     node *new_root;
 
     /* Case: nonempty root. */
     if (root->num_keys > 0)
-        return root;
+        return;
 
     /* Case: empty root. */
 
@@ -812,18 +2029,17 @@ static node *adjustRoot(node *root) {
     else
         new_root = NULL;
 
-    free(root->keys);
-    free(root->pointers);
-    free(root);
-
-    return new_root;
+    w->retired[w->num_retired++] = root;
+    tree->root = new_root;
 }
 
 /* coalesceNodes: Merges a node that has become too small with a neighbor. */
-static node *coalesceNodes(node *root, node *n, node *neighbor, int neighbor_index, KEY_T k_prime) {
-    int i, j, neighbor_insertion_index, n_end;
+static void coalesceNodes(bptree *tree, write_latches *w, node *n, node *neighbor, int neighbor_index, int k_prime_index) {
+    int i, neighbor_insertion_index;
     node *tmp;
 
+    atomic_fetch_add_explicit(&tree->stats.merges, 1, memory_order_relaxed);
+
     /* Swap neighbor with node if node is on the extreme left and neighbor is to its right. */
     if (neighbor_index == -1) {
         tmp = n;
@@ -843,20 +2059,15 @@ static node *coalesceNodes(node *root, node *n, node *neighbor, int neighbor_ind
     if (!n->is_leaf) {
 
         /* Append k_prime. */
-        neighbor->keys[neighbor_insertion_index] = k_prime;
-        neighbor->num_keys++;
-
-        n_end = n->num_keys;
-
-        for (i = neighbor_insertion_index + 1, j = 0; j < n_end; i++, j++) {
-            neighbor->keys[i] = n->keys[j];
-            neighbor->pointers[i] = n->pointers[j];
-            neighbor->num_keys++;
-            n->num_keys--;
-        }
+        moveKeys(tree, neighbor, neighbor_insertion_index, n->parent, k_prime_index, 1);
 
-        /* The number of pointers is always one more than the number of keys. */
-        neighbor->pointers[i] = n->pointers[j];
+        moveKeys(tree, neighbor, neighbor_insertion_index + 1, n, 0, n->num_keys);
+        memcpy(&neighbor->pointers[neighbor_insertion_index + 1], n->pointers,
+               (n->num_keys + 1) * sizeof(void *));
+        memcpy(&neighbor->counts[neighbor_insertion_index + 1], n->counts,
+               (n->num_keys + 1) * sizeof(int));
+        neighbor->num_keys += n->num_keys + 1;
+        n->num_keys = 0;
 
         /* All children must now point up to the same parent. */
         for (i = 0; i < neighbor->num_keys + 1; i++) {
@@ -869,49 +2080,49 @@ static node *coalesceNodes(node *root, node *n, node *neighbor, int neighbor_ind
      * Append all pointers and keys from the neighbor.
      */
     else {
-        for (i = neighbor_insertion_index, j = 0; j < n->num_keys; i++, j++) {
-            neighbor->keys[i] = n->keys[j];
-            neighbor->pointers[i] = n->pointers[j];
-            neighbor->num_keys++;
-        }
-        neighbor->pointers[order - 1] = n->pointers[order - 1];
+        moveKeys(tree, neighbor, neighbor_insertion_index, n, 0, n->num_keys);
+        memcpy(&neighbor->pointers[neighbor_insertion_index], n->pointers,
+               n->num_keys * sizeof(void *));
+        neighbor->num_keys += n->num_keys;
+        neighbor->pointers[tree->order - 1] = n->pointers[tree->order - 1];
     }
 
-    root = deleteEntry(root, n->parent, k_prime, n);
-    free(n->keys);
-    free(n->pointers);
-    free(n);
-    return root;
+    neighbor->parent->counts[getLeftIndex(neighbor->parent, neighbor)] = nodeRowCount(neighbor);
+    deleteEntry(tree, w, n->parent, n);
+    w->retired[w->num_retired++] = n;  // Still latched; freed once the latches are dropped
 }
 
 /* redistributeNodes: Redistributes entries between two nodes when one has become too small. */
-static node *redistributeNodes(node *root, node *n, node *neighbor, int neighbor_index,
-                               int k_prime_index, KEY_T k_prime) {
+static void redistributeNodes(bptree *tree, node *n, node *neighbor, int neighbor_index,
+                              int k_prime_index) {
     int i;
     node *tmp;
 
+    atomic_fetch_add_explicit(&tree->stats.redistributions, 1, memory_order_relaxed);
+
     /* Case: n has a neighbor to the left.
      * Pull the neighbor's last key-pointer pair over from the neighbor's right end to n's left end.
      */
     if (neighbor_index != -1) {
         if (!n->is_leaf)
             n->pointers[n->num_keys + 1] = n->pointers[n->num_keys];
-        for (i = n->num_keys; i > 0; i--) {
-            n->keys[i] = n->keys[i - 1];
+        moveKeys(tree, n, 1, n, 0, n->num_keys);
+        for (i = n->num_keys; i > 0; i--)
             n->pointers[i] = n->pointers[i - 1];
-        }
         if (!n->is_leaf) {
             n->pointers[0] = neighbor->pointers[neighbor->num_keys];
+            memmove(&n->counts[1], &n->counts[0], (n->num_keys + 1) * sizeof(int));
+            n->counts[0] = neighbor->counts[neighbor->num_keys];
             tmp = (node *)n->pointers[0];
             tmp->parent = n;
             neighbor->pointers[neighbor->num_keys] = NULL;
-            n->keys[0] = k_prime;
-            n->parent->keys[k_prime_index] = neighbor->keys[neighbor->num_keys - 1];
+            moveKeys(tree, n, 0, n->parent, k_prime_index, 1);
+            moveKeys(tree, n->parent, k_prime_index, neighbor, neighbor->num_keys - 1, 1);
         } else {
             n->pointers[0] = neighbor->pointers[neighbor->num_keys - 1];
             neighbor->pointers[neighbor->num_keys - 1] = NULL;
-            n->keys[0] = neighbor->keys[neighbor->num_keys - 1];
-            n->parent->keys[k_prime_index] = n->keys[0];
+            moveKeys(tree, n, 0, neighbor, neighbor->num_keys - 1, 1);
+            moveKeys(tree, n->parent, k_prime_index, n, 0, 1);
         }
     }
 
@@ -921,20 +2132,21 @@ static node *redistributeNodes(node *root, node *n, node *neighbor, int neighbor
      */
     else {
         if (n->is_leaf) {
-            n->keys[n->num_keys] = neighbor->keys[0];
+            moveKeys(tree, n, n->num_keys, neighbor, 0, 1);
             n->pointers[n->num_keys] = neighbor->pointers[0];
-            n->parent->keys[k_prime_index] = neighbor->keys[1];
+            moveKeys(tree, n->parent, k_prime_index, neighbor, 1, 1);
         } else {
-            n->keys[n->num_keys] = k_prime;
+            moveKeys(tree, n, n->num_keys, n->parent, k_prime_index, 1);
             n->pointers[n->num_keys + 1] = neighbor->pointers[0];
+            n->counts[n->num_keys + 1] = neighbor->counts[0];
+            memmove(&neighbor->counts[0], &neighbor->counts[1], neighbor->num_keys * sizeof(int));
             tmp = (node *)n->pointers[n->num_keys + 1];
             tmp->parent = n;
-            n->parent->keys[k_prime_index] = neighbor->keys[0];
+            moveKeys(tree, n->parent, k_prime_index, neighbor, 0, 1);
         }
-        for (i = 0; i < neighbor->num_keys - 1; i++) {
-            neighbor->keys[i] = neighbor->keys[i + 1];
+        moveKeys(tree, neighbor, 0, neighbor, 1, neighbor->num_keys - 1);
+        for (i = 0; i < neighbor->num_keys - 1; i++)
             neighbor->pointers[i] = neighbor->pointers[i + 1];
-        }
         if (!n->is_leaf)
             neighbor->pointers[i] = neighbor->pointers[i + 1];
     }
@@ -942,7 +2154,8 @@ static node *redistributeNodes(node *root, node *n, node *neighbor, int neighbor
     n->num_keys++;
     neighbor->num_keys--;
 
-    return root;
+    n->parent->counts[getLeftIndex(n->parent, n)] = nodeRowCount(n);
+    n->parent->counts[getLeftIndex(n->parent, neighbor)] = nodeRowCount(neighbor);
 }
 
 /* getNeighborIndex: Gets the index of a node's nearest neighbor (left or right) in the parent. */
@@ -961,25 +2174,17 @@ static int getNeighborIndex(node *n) {
     exit(EXIT_FAILURE);
 }
 
-/* deleteEntry: Deletes a key and its associated pointer from a node. */
-static node *deleteEntry(node *root, node *n, KEY_T key, void *pointer) {
+/* deleteEntry: Deletes a pointer (and its key) from a node, rebalancing on underflow. */
+static void deleteEntry(bptree *tree, write_latches *w, node *n, void *pointer) {
+    int order = tree->order;
     int min_keys;
     node *neighbor;
     int neighbor_index;
     int k_prime_index;
-    KEY_T k_prime;
     int capacity;
 
     // Remove key and pointer from node.
-    n = removeEntryFromNode(n, key, pointer);
-
-    /* Case:  deletion from the root. */
-    if (n == root)
-        return adjustRoot(root);
-
-    /* Case:  deletion from a node below the root.
-     * (Rest of function body.)
-     */
+    n = removeEntryFromNode(tree, n, pointer);
 
     /* Determine minimum allowable size of node,
      * to be preserved after deletion.
@@ -987,10 +2192,24 @@ static node *deleteEntry(node *root, node *n, KEY_T key, void *pointer) {
     min_keys = n->is_leaf ? cut(order - 1) : cut(order) - 1;
 
     /* Case:  node stays at or above minimum.
-     * (The simple case.)
+     * (The simple case. A safe node returns here, before its parent, which is no
+     * longer latched, is looked at.)
      */
     if (n->num_keys >= min_keys)
-        return root;
+        return;
+
+    /* Case:  deletion from the root. Only an emptied root changes the tree, and an
+     * empty root is never safe, so the root latch is still held here.
+     */
+    if (n->parent == NULL) {
+        if (n->num_keys == 0)
+            adjustRoot(tree, w);
+        return;
+    }
+
+    /* Case:  deletion from a node below the root.
+     * (Rest of function body.)
+     */
 
     /* Case:  node falls below minimum.
      * Either coalescence or redistribution is needed.
@@ -998,54 +2217,478 @@ static node *deleteEntry(node *root, node *n, KEY_T key, void *pointer) {
 
     /* Find the appropriate neighbor node with which
      * to coalesce.
-     * Also find the key (k_prime) in the parent
-     * between the pointer to node n and the pointer
-     * to the neighbor.
+     * Also find the index of the key (k_prime) in the
+     * parent between the pointer to node n and the
+     * pointer to the neighbor.
      */
     neighbor_index = getNeighborIndex(n);
     k_prime_index = neighbor_index == -1 ? 0 : neighbor_index;
-    k_prime = n->parent->keys[k_prime_index];
     neighbor = neighbor_index == -1 ? n->parent->pointers[1] : n->parent->pointers[neighbor_index];
+    holdLatch(w, neighbor);  // Parent is held exclusively, so no one else can be waiting for n
 
     capacity = n->is_leaf ? order : order - 1;
 
     /* Coalescence. */
     if (neighbor->num_keys + n->num_keys < capacity)
-        return coalesceNodes(root, n, neighbor, neighbor_index, k_prime);
+        coalesceNodes(tree, w, n, neighbor, neighbor_index, k_prime_index);
 
     /* Redistribution. */
     else
-        return redistributeNodes(root, n, neighbor, neighbor_index, k_prime_index, k_prime);
+        redistributeNodes(tree, n, neighbor, neighbor_index, k_prime_index);
 }
 
 /* delete: Master deletion function. */
-node *delete(node *root, KEY_T key, ROW_PTR row_ptr) {
+void delete(bptree *tree, KEY_T key, ROW_PTR row_ptr) {
+    write_latches w;
     node *key_leaf;
+    bool removed = false;
+
+    if (tree == NULL || key.type != tree->key_type)
+        return;
+
+    /* Keys are unique, so the row can only be behind this key's slot. The descent already
+     * took the row off every count on the way down; a delete that finds nothing puts it back.
+     */
+    key_leaf = descendExclusive(tree, key, -1, false, &w);
+    int i = key_leaf != NULL ? findKeyInLeaf(tree, key_leaf, key) : -1;
+    if (i >= 0) {
+        void *slot = key_leaf->pointers[i];
+        if (isPostingSlot(slot)) {
+            /* Case: shared key. Drop the row from the posting list; the key stays until one row is left,
+             * at which point the slot goes back to holding that row directly.
+             */
+            posting_list *pl = slotPosting(slot);
+            removed = postingRemove(pl, row_ptr);
+            if (removed && pl->num_rows == 1) {
+                key_leaf->pointers[i] = postingFirst(pl);
+                postingDestroy(pl);
+            }
+        } else if (slot == row_ptr) {
+            /* Case: single row. Removing it removes the key; merges only touch latched nodes. */
+            deleteEntry(tree, &w, key_leaf, slot);
+            removed = true;
+        }
+    }
+    releaseWriteLatches(tree, &w);
+    if (!removed && key_leaf != NULL)
+        adjustPathCounts(tree, key, +1);
+}
+
+/* ==================== Tree images ==================== */
+
+/* An image is the tree's node blocks in breadth-first order from the root, so a loader
+ * can map them and use them where they lie. Keys and subtree counts are kept as they
+ * are. Links become 1-based node numbers (0 for none): the parent, the children and the
+ * next leaf. A leaf slot with one row holds its row id shifted left by one; a posting
+ * slot holds (word offset << 1) | 1 into the posting words, where a row count is
+ * followed by that many ids in ascending order. The keys / pointers / counts fields and
+ * the latch are set again on load. String keys point into a string heap and have no image.
+ * Children are numbered after their parent and leaves after the leaf before them. The
+ * loader checks that, and that children point back at their parent, so a damaged image
+ * cannot send a walk round in circles or from a leaf into an internal node. It also checks
+ * the contents lookups rely on: key order within and across nodes, and subtree counts.
+ */
+#define IMAGE_POSTING_TAG ((uintptr_t)1)
+
+static void *imageNode(void *nodes, size_t node_bytes, uintptr_t number) {
+    return (char *)nodes + (number - 1) * node_bytes;
+}
+
+static int compareIds(const void *a, const void *b) {
+    uint32_t ia = *(const uint32_t *)a;
+    uint32_t ib = *(const uint32_t *)b;
+    return (ia > ib) - (ia < ib);
+}
 
-    // Find the leaf containing this specific pointer
-    key_leaf = findLeaf(root, key, false);
-    
-    // Since findLeaf returns the first leaf >= key, we might need to traverse right
-    // if the key spans multiple leaves.
-    while (key_leaf != NULL) {
-        bool found_in_node = false;
-        for (int i = 0; i < key_leaf->num_keys; i++) {
-            if (compare_key(key_leaf->keys[i], key) == 0 && key_leaf->pointers[i] == row_ptr) {
-                found_in_node = true;
-                break;
+/* bptreeImageCreate: Numbers the nodes level by level (the queue doubles as the numbering),
+ * then writes each block with its links and rows replaced by numbers and ids.
+ */
+bool bptreeImageCreate(bptree *tree, bplus_row_id row_id, void *ctx, bplus_image *image) {
+    memset(image, 0, sizeof(*image));
+    if (tree == NULL || tree->root == NULL || tree->key_type == KEY_STRING)
+        return false;
+    int order = tree->order;
+    size_t keys_offset = nodeKeysOffset();
+    size_t pointers_offset = nodePointersOffset(tree->key_size, order);
+    size_t counts_offset = nodeCountsOffset(tree->key_size, order);
+
+    long capacity = 64, num_nodes = 1;
+    node **queue = malloc(capacity * sizeof(node *));
+    uintptr_t *parents = malloc(capacity * sizeof(uintptr_t));
+    if (queue == NULL || parents == NULL)
+    {
+        perror("Tree image queue.");
+        exit(EXIT_FAILURE);
+    }
+    queue[0] = tree->root;
+    parents[0] = 0;
+    for (long k = 0; k < num_nodes; k++)
+    {
+        node *n = queue[k];
+        if (n->is_leaf)
+            continue;
+        if (num_nodes + n->num_keys + 1 > capacity)
+        {
+            while (num_nodes + n->num_keys + 1 > capacity)
+                capacity *= 2;
+            queue = realloc(queue, capacity * sizeof(node *));
+            parents = realloc(parents, capacity * sizeof(uintptr_t));
+            if (queue == NULL || parents == NULL)
+            {
+                perror("Tree image queue.");
+                exit(EXIT_FAILURE);
             }
         }
-        
-        if (found_in_node) {
-            return deleteEntry(root, key_leaf, key, row_ptr);
+        for (int i = 0; i <= n->num_keys; i++)
+        {
+            queue[num_nodes] = n->pointers[i];
+            parents[num_nodes++] = (uintptr_t)(k + 1);
         }
+    }
 
-        // If we went past the key, stop
-        if (key_leaf->num_keys > 0 && compare_key(key_leaf->keys[0], key) > 0)
-            break;
-            
-        key_leaf = key_leaf->pointers[order - 1];
+    char *blocks = calloc(num_nodes, tree->node_bytes);
+    size_t postings_capacity = 1024;
+    image->postings = malloc(postings_capacity * sizeof(uint32_t));
+    ROW_PTR *run = NULL;
+    int run_capacity = 0;
+    if (blocks == NULL || image->postings == NULL)
+    {
+        perror("Tree image allocation.");
+        exit(EXIT_FAILURE);
+    }
+    image->nodes = blocks;
+    image->num_nodes = num_nodes;
+
+    bool ok = true;
+    long next_child = 2;  // Number of the first child of the next internal node
+    for (long k = 0; k < num_nodes && ok; k++)
+    {
+        node *n = queue[k];
+        char *block = blocks + k * tree->node_bytes;
+        node *out = (node *)block;
+        void **pointers = (void **)(block + pointers_offset);
+        out->is_leaf = n->is_leaf;
+        out->num_keys = n->num_keys;
+        out->parent = (node *)parents[k];
+        memcpy(block + keys_offset, n->keys, (size_t)n->num_keys * tree->key_size);
+
+        if (!n->is_leaf)
+        {
+            memcpy(block + counts_offset, n->counts, (size_t)(n->num_keys + 1) * sizeof(int));
+            for (int i = 0; i <= n->num_keys; i++)
+                pointers[i] = (void *)(uintptr_t)next_child++;
+            continue;
+        }
+
+        for (int i = 0; i < n->num_keys && ok; i++)
+        {
+            void *slot = n->pointers[i];
+            if (!isPostingSlot(slot))
+            {
+                long id = row_id(ctx, (ROW_PTR)slot);
+                ok = id >= 0;
+                pointers[i] = (void *)((uintptr_t)id << 1);
+                continue;
+            }
+            posting_list *pl = slotPosting(slot);
+            if (pl->num_rows > run_capacity)
+            {
+                run_capacity = pl->num_rows;
+                free(run);
+                run = malloc(run_capacity * sizeof(ROW_PTR));
+                if (run == NULL)
+                {
+                    perror("Tree image posting run.");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            int count = postingDecode(pl, run);
+            if (image->num_postings + 1 + count > postings_capacity)
+            {
+                while (image->num_postings + 1 + count > postings_capacity)
+                    postings_capacity *= 2;
+                image->postings = realloc(image->postings, postings_capacity * sizeof(uint32_t));
+                if (image->postings == NULL)
+                {
+                    perror("Tree image postings.");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            size_t offset = image->num_postings;
+            uint32_t *ids = image->postings + offset + 1;
+            image->postings[offset] = (uint32_t)count;
+            for (int r = 0; r < count && ok; r++)
+            {
+                long id = row_id(ctx, run[r]);
+                ok = id >= 0;
+                ids[r] = (uint32_t)id;
+            }
+            qsort(ids, count, sizeof(uint32_t), compareIds);
+            image->num_postings += 1 + count;
+            pointers[i] = (void *)(((uintptr_t)offset << 1) | IMAGE_POSTING_TAG);
+        }
+
+        // Leaves sit at the end of the queue in chain order, so the next leaf is the next node
+        node *next = n->pointers[order - 1];
+        if (next != NULL)
+        {
+            ok = ok && k + 1 < num_nodes && queue[k + 1] == next;
+            pointers[order - 1] = (void *)(uintptr_t)(k + 2);
+        }
+    }
+
+    free(run);
+    free(queue);
+    free(parents);
+    if (!ok)
+        bptreeImageFree(image);
+    return ok;
+}
+
+void bptreeImageFree(bplus_image *image) {
+    free(image->nodes);
+    free(image->postings);
+    memset(image, 0, sizeof(*image));
+}
+
+/* imageKey: The i-th key of an image node (whose keys field is not set yet). False for a
+ * boolean byte other than 0 or 1.
+ */
+static bool imageKey(const bptree *tree, const node *n, int i, KEY_T *key) {
+    const char *keys = (const char *)n + nodeKeysOffset();
+    key->type = tree->key_type;
+    switch (tree->key_type)
+    {
+    case KEY_UINT64: memcpy(&key->v.u64, keys + i * sizeof(uint64_t), sizeof(uint64_t)); break;
+    case KEY_INT:    memcpy(&key->v.i32, keys + i * sizeof(int32_t), sizeof(int32_t)); break;
+    case KEY_BOOL:
+    {
+        unsigned char b = (unsigned char)keys[i];
+        if (b > 1)
+            return false;
+        key->v.b = b != 0;
+        break;
+    }
+    case KEY_STRING: return false;
     }
-    
-    return root;
+    return true;
+}
+
+/* imageNodeValid: Everything node k refers to and holds. Children and the next leaf must
+ * come later in the image, and every row id and posting run must lie within range. Keys
+ * must rise strictly and stay within the node's bounds, which it then hands down to its
+ * children; leaves must chain in image order.
+ */
+static bool imageNodeValid(const bptree *tree, void *nodes, long k, long num_nodes,
+                           const uint32_t *postings, size_t num_postings, int num_rows, image_bounds bounds[]) {
+    node *n = imageNode(nodes, tree->node_bytes, (uintptr_t)(k + 1));
+    int order = tree->order;
+    unsigned char is_leaf;
+    memcpy(&is_leaf, &n->is_leaf, 1);
+    uintptr_t parent = (uintptr_t)n->parent;
+    if (is_leaf > 1 || n->num_keys < 0 || n->num_keys > order - 1 ||
+        parent > (uintptr_t)k || (k == 0) != (parent == 0))
+        return false;
+
+    const image_bounds *b = &bounds[k];
+    KEY_T key, prev;
+    for (int i = 0; i < n->num_keys; i++)
+    {
+        if (!imageKey(tree, n, i, &key) ||
+            (i > 0 && compare_key(prev, key) >= 0) ||
+            (b->has_lo && compare_key(b->lo, key) > 0) ||
+            (b->has_hi && compare_key(key, b->hi) >= 0))
+            return false;
+        prev = key;
+    }
+
+    void **pointers = (void **)((char *)n + nodePointersOffset(tree->key_size, order));
+    if (!is_leaf)
+    {
+        bool leaf_children = false;
+        for (int i = 0; i <= n->num_keys; i++)
+        {
+            uintptr_t child = (uintptr_t)pointers[i];
+            if (child <= (uintptr_t)(k + 1) || child > (uintptr_t)num_nodes)
+                return false;
+            node *c = imageNode(nodes, tree->node_bytes, child);
+            memcpy(&is_leaf, &c->is_leaf, 1);
+            if ((uintptr_t)c->parent != (uintptr_t)(k + 1) || (i > 0 && (is_leaf != 0) != leaf_children))
+                return false;
+            leaf_children = is_leaf != 0;
+
+            // Child i holds the keys in [separator i - 1, separator i)
+            image_bounds *cb = &bounds[child - 1];
+            cb->has_lo = i > 0 || b->has_lo;
+            cb->has_hi = i < n->num_keys || b->has_hi;
+            if (i > 0)
+                imageKey(tree, n, i - 1, &cb->lo);
+            else
+                cb->lo = b->lo;
+            if (i < n->num_keys)
+                imageKey(tree, n, i, &cb->hi);
+            else
+                cb->hi = b->hi;
+        }
+        return true;
+    }
+
+    for (int i = 0; i < n->num_keys; i++)
+    {
+        uintptr_t slot = (uintptr_t)pointers[i];
+        if ((slot & IMAGE_POSTING_TAG) == 0)
+        {
+            if ((slot >> 1) >= (uintptr_t)num_rows)
+                return false;
+            continue;
+        }
+        uintptr_t offset = slot >> 1;
+        if (offset >= num_postings || postings[offset] < 2 ||
+            postings[offset] > num_postings - offset - 1)
+            return false;
+        for (uint32_t r = 1; r <= postings[offset]; r++)
+            if (postings[offset + r] >= (uint32_t)num_rows)
+                return false;
+    }
+    // Leaves close the image in chain order: each one's next leaf is the following node
+    uintptr_t next = (uintptr_t)pointers[order - 1];
+    if (k + 1 == num_nodes)
+        return next == 0;
+    if (next != (uintptr_t)(k + 2))
+        return false;
+    memcpy(&is_leaf, &((node *)imageNode(nodes, tree->node_bytes, next))->is_leaf, 1);
+    return is_leaf == 1;
+}
+
+/* imageCountsValid: Walks the image bottom-up (children come after their parent) and checks
+ * that every internal count equals the rows its child actually holds.
+ */
+static bool imageCountsValid(const bptree *tree, void *nodes, long num_nodes, const uint32_t *postings) {
+    long *totals = malloc(num_nodes * sizeof(long));
+    if (totals == NULL)
+    {
+        perror("Tree image counts.");
+        exit(EXIT_FAILURE);
+    }
+    bool ok = true;
+    for (long k = num_nodes - 1; k >= 0 && ok; k--)
+    {
+        node *n = imageNode(nodes, tree->node_bytes, (uintptr_t)(k + 1));
+        void **pointers = (void **)((char *)n + nodePointersOffset(tree->key_size, tree->order));
+        long total = 0;
+        if (n->is_leaf)
+        {
+            for (int i = 0; i < n->num_keys; i++)
+            {
+                uintptr_t slot = (uintptr_t)pointers[i];
+                total += (slot & IMAGE_POSTING_TAG) ? (long)postings[slot >> 1] : 1;
+            }
+        }
+        else
+        {
+            const int *counts = (const int *)((char *)n + nodeCountsOffset(tree->key_size, tree->order));
+            for (int i = 0; i <= n->num_keys && ok; i++)
+            {
+                long child_total = totals[(uintptr_t)pointers[i] - 1];
+                ok = counts[i] == child_total;
+                total += child_total;
+            }
+        }
+        totals[k] = total;
+    }
+    free(totals);
+    return ok;
+}
+
+/* bptreeFromImage: Checks every node's links, keys and counts first, so a bad image is turned
+ * down before anything is rewritten, then swaps numbers and ids for addresses node by node.
+ */
+bptree *bptreeFromImage(KeyType key_type, int order, size_t node_bytes, void *nodes, long num_nodes,
+                        size_t mapping_bytes, const uint32_t *postings, size_t num_postings,
+                        ROW_PTR rows[], int num_rows) {
+    if (key_type == KEY_STRING || nodes == NULL || num_nodes <= 0 || rows == NULL)
+        return NULL;
+    bptree *tree = bptreeCreate(key_type, order);
+    if (tree->order != order || tree->node_bytes != node_bytes ||
+        (size_t)num_nodes > mapping_bytes / node_bytes)
+    {
+        destroy_tree(tree);
+        return NULL;
+    }
+    image_bounds *bounds = malloc(num_nodes * sizeof(image_bounds));
+    if (bounds == NULL)
+    {
+        perror("Tree image bounds.");
+        exit(EXIT_FAILURE);
+    }
+    bounds[0].has_lo = bounds[0].has_hi = false;  // The root's keys are unbounded
+    bool valid = true;
+    for (long k = 0; k < num_nodes && valid; k++)
+        valid = imageNodeValid(tree, nodes, k, num_nodes, postings, num_postings, num_rows, bounds);
+    free(bounds);
+    if (!valid || !imageCountsValid(tree, nodes, num_nodes, postings))
+    {
+        destroy_tree(tree);
+        return NULL;
+    }
+
+    ROW_PTR *run = NULL;
+    int run_capacity = 0;
+    for (long k = 0; k < num_nodes; k++)
+    {
+        node *n = imageNode(nodes, node_bytes, (uintptr_t)(k + 1));
+        n->keys = (char *)n + nodeKeysOffset();
+        n->pointers = (void **)((char *)n + nodePointersOffset(tree->key_size, order));
+        n->counts = (int *)((char *)n + nodeCountsOffset(tree->key_size, order));
+        uintptr_t parent = (uintptr_t)n->parent;
+        n->parent = parent != 0 ? imageNode(nodes, node_bytes, parent) : NULL;
+        atomic_init(&n->latch, 0);
+
+        if (!n->is_leaf)
+        {
+            for (int i = 0; i <= n->num_keys; i++)
+                n->pointers[i] = imageNode(nodes, node_bytes, (uintptr_t)n->pointers[i]);
+            continue;
+        }
+        for (int i = 0; i < n->num_keys; i++)
+        {
+            uintptr_t slot = (uintptr_t)n->pointers[i];
+            if ((slot & IMAGE_POSTING_TAG) == 0)
+            {
+                n->pointers[i] = rows[slot >> 1];
+                continue;
+            }
+            const uint32_t *ids = postings + (slot >> 1);
+            int count = (int)ids[0];
+            if (count > run_capacity)
+            {
+                run_capacity = count;
+                free(run);
+                run = malloc(run_capacity * sizeof(ROW_PTR));
+                if (run == NULL)
+                {
+                    perror("Tree image posting run.");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            bool sorted = true;
+            for (int r = 0; r < count; r++)
+            {
+                run[r] = rows[ids[r + 1]];
+                if (r > 0 && (uintptr_t)run[r] < (uintptr_t)run[r - 1])
+                    sorted = false;
+            }
+            if (!sorted)  // Ids are in file order; posting lists need address order
+                qsort(run, count, sizeof(ROW_PTR), compareRows);
+            n->pointers[i] = (void *)((uintptr_t)postingFromSorted(run, count) | POSTING_TAG);
+        }
+        uintptr_t next = (uintptr_t)n->pointers[order - 1];
+        n->pointers[order - 1] = next != 0 ? imageNode(nodes, node_bytes, next) : NULL;
+    }
+    free(run);
+
+    tree->root = nodes;
+    atomic_store_explicit(&tree->stats.nodes, num_nodes, memory_order_relaxed);
+    nodeArenaAdoptMapping(tree->arena, nodes, mapping_bytes, num_nodes);
+    return tree;
 }
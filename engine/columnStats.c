@@ -0,0 +1,143 @@
+/*
+ * Column statistics: row counts, distinct keys, min / max and equi-depth histograms of the
+ * indexed attributes, used by the index planner (indexPlan.c) to estimate how many rows a
+ * key range holds before choosing between index lookups and a table scan.
+ */
+
+#include "../include/columnStats.h"
+#include "../include/recordSchema.h"  // compare_key
+#include <string.h>
+
+/* ==================== Helpers ==================== */
+
+/* keyValue: Numeric keys on one axis for interpolation (false = 0, true = 1). */
+static double keyValue(KEY_T key) {
+    switch (key.type) {
+        case KEY_UINT64: return (double)key.v.u64;
+        case KEY_INT: return (double)key.v.i32;
+        case KEY_BOOL: return key.v.b ? 1.0 : 0.0;
+        default: return 0.0;
+    }
+}
+
+/* findBucket: First bucket whose upper key is >= key, or NULL past the last one. */
+static stats_bucket *findBucket(column_stats *stats, KEY_T key) {
+    int lo = 0, hi = stats->num_buckets;
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        if (compare_key(stats->buckets[mid].upper, key) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < stats->num_buckets ? &stats->buckets[lo] : NULL;
+}
+
+/* ==================== Building ==================== */
+
+void columnStatsBuild(column_stats *stats, bptree *tree) {
+    memset(stats, 0, sizeof(*stats));
+    stats->key_type = tree != NULL ? tree->key_type : KEY_STRING;
+    stats->num_rows = stats->built_rows = countRows(tree);
+    if (stats->key_type == KEY_STRING || stats->num_rows == 0)
+        return;
+
+    // Keys arrive in order with their row counts; a bucket closes at the first key that fills it
+    int depth = (stats->num_rows + STATS_MAX_BUCKETS - 1) / STATS_MAX_BUCKETS;
+    stats_bucket *bucket = NULL;
+    bplus_cursor cursor;
+    KEY_T key;
+    int rows;
+    bptreeCursorOpenAll(&cursor, tree);
+    while (bptreeCursorNextKey(&cursor, &key, &rows)) {
+        if (stats->distinct++ == 0)
+            stats->min = key;
+        stats->max = key;
+        if (bucket == NULL)
+            bucket = &stats->buckets[stats->num_buckets++];
+        bucket->upper = key;
+        bucket->rows += rows;
+        bucket->distinct++;
+        if (bucket->rows >= depth && stats->num_buckets < STATS_MAX_BUCKETS)
+            bucket = NULL;
+    }
+    bptreeCursorClose(&cursor);
+}
+
+/* ==================== Maintenance ==================== */
+
+void columnStatsAdd(column_stats *stats, KEY_T key) {
+    stats->num_rows++;
+    stats->changes++;
+    if (stats->key_type == KEY_STRING)
+        return;
+    if (stats->num_buckets == 0) {
+        stats->buckets[0].upper = stats->min = stats->max = key;
+        stats->buckets[0].rows = stats->buckets[0].distinct = stats->distinct = 1;
+        stats->num_buckets = 1;
+        return;
+    }
+
+    // A key outside [min, max] is new; one inside may be, but only a rebuild can tell
+    stats_bucket *bucket = findBucket(stats, key);
+    if (bucket == NULL) {
+        bucket = &stats->buckets[stats->num_buckets - 1];
+        bucket->upper = stats->max = key;
+        bucket->distinct++;
+        stats->distinct++;
+    } else if (compare_key(key, stats->min) < 0) {
+        stats->min = key;
+        bucket->distinct++;
+        stats->distinct++;
+    }
+    bucket->rows++;
+}
+
+void columnStatsRemove(column_stats *stats, KEY_T key) {
+    if (stats->num_rows > 0)
+        stats->num_rows--;
+    stats->changes++;
+    if (stats->key_type == KEY_STRING)
+        return;
+    stats_bucket *bucket = findBucket(stats, key);
+    if (bucket != NULL && bucket->rows > 0)
+        bucket->rows--;
+}
+
+bool columnStatsRefresh(column_stats *stats, bptree *tree) {
+    if (stats->changes == 0 || (long long)stats->changes * STATS_REBUILD_DIVISOR <= stats->built_rows)
+        return false;
+    columnStatsBuild(stats, tree);
+    return true;
+}
+
+/* ==================== Estimates ==================== */
+
+double columnStatsEstimate(const column_stats *stats, KEY_T key_start, KEY_T key_end) {
+    if (stats->num_buckets == 0)
+        return stats->num_rows;
+
+    /* Within a bucket the rows are taken as spread evenly over its keys. Its upper key is known
+     * to exist; the others are taken as spread evenly below it, and a range that reaches
+     * any of them holds at least one, so an equality on an existing key estimates
+     * rows / distinct rather than the odds of hitting a key at all.
+     */
+    double start = keyValue(key_start), end = keyValue(key_end);
+    double lower = keyValue(stats->min), estimate = 0.0;
+    for (int b = 0; b < stats->num_buckets; b++) {
+        const stats_bucket *bucket = &stats->buckets[b];
+        double upper = keyValue(bucket->upper);
+        double from = start > lower ? start : lower;
+        double to = end < upper ? end : upper;
+        if (from <= to && bucket->rows > 0 && bucket->distinct > 0) {
+            double others = bucket->distinct - 1.0, keys = 0.0;
+            if (others > 0.0) {
+                keys = others * (to - from + (to < upper ? 1.0 : 0.0)) / (upper - lower);
+                if (keys < 1.0 && to < upper) keys = 1.0;
+                if (keys > others) keys = others;
+            }
+            if (to >= upper) keys += 1.0;
+            estimate += bucket->rows * keys / bucket->distinct;
+        }
+        lower = upper + 1.0;
+    }
+    return estimate;
+}
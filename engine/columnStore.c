@@ -0,0 +1,731 @@
+/*
+ * Column store: typed per-attribute arrays built from the record structs, so full-table
+ * scans read a few bytes per row per predicate instead of a whole record and its strings.
+ */
+
+#define _POSIX_C_SOURCE 200809L  // strcasecmp
+#include "../include/columnStore.h"
+#include "../include/executeEngine-serial.h"  // struct whereClauseS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#if defined(__SSE2__)
+#include <immintrin.h>  // AVX2 / SSE compare kernels
+#endif
+
+#define COLUMN_INITIAL_ROWS 1024
+#define COLUMN_INITIAL_HEAP 4096
+#define SCAN_WORDS (COLUMN_SCAN_BLOCK / 64)  // Match bits of a scan block, 64 rows per word
+#define SCAN_SPARSE_ROWS 8  // Words with fewer active rows test them one by one
+
+typedef enum { OP_EQ, OP_NEQ, OP_GT, OP_LT, OP_GTE, OP_LTE, OP_INVALID } scan_op;
+
+/* ==================== Column storage ==================== */
+
+static size_t valueBytes(FieldType type) {
+    switch (type) {
+    case FIELD_UINT64: return sizeof(unsigned long long);
+    case FIELD_INT: return sizeof(int);
+    case FIELD_BOOL: return sizeof(bool);
+    default: return 0;
+    }
+}
+
+static void *growArray(void *array, size_t bytes) {
+    void *grown = realloc(array, bytes);
+    if (grown == NULL) {
+        perror("Column store allocation failed");
+        exit(EXIT_FAILURE);
+    }
+    return grown;
+}
+
+/* rowCapacity: Capacity (a doubling of COLUMN_INITIAL_ROWS) that holds at least rows rows. */
+static int rowCapacity(int capacity, int rows) {
+    if (capacity <= 0)
+        capacity = COLUMN_INITIAL_ROWS;
+    while (capacity < rows)
+        capacity *= 2;
+    return capacity;
+}
+
+/* reserveRows: Makes room for at least rows rows in every column. */
+static void reserveRows(column_store *store, int rows) {
+    if (rows <= store->capacity)
+        return;
+    int capacity = rowCapacity(store->capacity, rows);
+    for (int c = 0; c < store->num_columns; c++) {
+        column *col = &store->columns[c];
+        if (col->codes != NULL)
+            col->codes = growArray(col->codes, capacity * sizeof(uint16_t));
+        else if (col->field->type == FIELD_STRING)
+            col->offsets = growArray(col->offsets, capacity * sizeof(uint64_t));
+        else
+            col->values = growArray(col->values, capacity * valueBytes(col->field->type));
+    }
+    store->capacity = capacity;
+}
+
+/* appendHeap: Copies value (at most length bytes, NUL-terminated in the heap) and returns
+ * its heap offset.
+ */
+static uint64_t appendHeap(column *col, const char *value, size_t length) {
+    if (col->heap_bytes + length + 1 > col->heap_capacity) {
+        size_t capacity = col->heap_capacity > 0 ? col->heap_capacity : COLUMN_INITIAL_HEAP;
+        while (capacity < col->heap_bytes + length + 1)
+            capacity *= 2;
+        col->heap = growArray(col->heap, capacity);
+        col->heap_capacity = capacity;
+    }
+    uint64_t offset = col->heap_bytes;
+    memcpy(col->heap + offset, value, length);
+    col->heap[offset + length] = '\0';
+    col->heap_bytes += length + 1;
+    return offset;
+}
+
+/* ==================== Dictionary encoding ==================== */
+
+typedef struct {
+    const char *value;
+    uint64_t offset;
+    int id;
+} dict_entry;
+
+static int compareDictEntries(const void *a, const void *b) {
+    return strcmp(((const dict_entry *)a)->value, ((const dict_entry *)b)->value);
+}
+
+/* compareBounded: strcmp of a dictionary entry against value[0..length). */
+static int compareBounded(const char *entry, const char *value, size_t length) {
+    int c = strncmp(entry, value, length);
+    return c != 0 ? c : entry[length] != '\0';
+}
+
+/* dictionaryBound: First code whose value is >= value[0..length) (or > it when upper). */
+static int dictionaryBound(const column *col, const char *value, size_t length, bool upper) {
+    int low = 0, high = col->dict_size;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        int c = compareBounded(col->heap + col->offsets[mid], value, length);
+        if (c < 0 || (upper && c == 0))
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+static uint64_t hashString(const char *value, size_t length) {
+    uint64_t hash = 1469598103934665603ULL;  // FNV-1a
+    for (size_t i = 0; i < length; i++)
+        hash = (hash ^ (unsigned char)value[i]) * 1099511628211ULL;
+    return hash;
+}
+
+/* Hash set of an encoding column's distinct values while the store is built, mapping each
+ * to its provisional id (order of first appearance) until sortDictionary ranks them.
+ */
+typedef struct {
+    int *slots;  // Provisional id per slot, -1 when empty
+    size_t num_slots;
+} dict_builder;
+
+static void beginDictionary(column *col, dict_builder *builder, int num_records, int capacity) {
+    builder->num_slots = 64;
+    while (builder->num_slots < 2 * (size_t)(num_records < COLUMN_DICT_MAX_CODES ? num_records : COLUMN_DICT_MAX_CODES))
+        builder->num_slots *= 2;
+    builder->slots = growArray(NULL, builder->num_slots * sizeof(int));
+    memset(builder->slots, -1, builder->num_slots * sizeof(int));
+    col->codes = growArray(NULL, capacity * sizeof(uint16_t));
+}
+
+/* dictionaryAdd: Gives row the provisional id of value[0..length), adding the value when
+ * new. Returns false, adding nothing, when the dictionary is full.
+ */
+static bool dictionaryAdd(column *col, dict_builder *builder, int row, const char *value, size_t length) {
+    size_t mask = builder->num_slots - 1;
+    size_t slot = hashString(value, length) & mask;
+    while (builder->slots[slot] >= 0 && compareBounded(col->heap + col->offsets[builder->slots[slot]], value, length) != 0)
+        slot = (slot + 1) & mask;
+    if (builder->slots[slot] < 0) {
+        if (col->dict_size == COLUMN_DICT_MAX_CODES)
+            return false;
+        if (col->dict_size == col->dict_capacity) {
+            col->dict_capacity = col->dict_capacity > 0 ? col->dict_capacity * 2 : 64;
+            col->offsets = growArray(col->offsets, col->dict_capacity * sizeof(uint64_t));
+        }
+        col->offsets[col->dict_size] = appendHeap(col, value, length);
+        builder->slots[slot] = col->dict_size++;
+    }
+    col->codes[row] = (uint16_t)builder->slots[slot];
+    return true;
+}
+
+/* sortDictionary: Sorts the distinct values and renumbers every row's provisional id to
+ * its value's rank.
+ */
+static void sortDictionary(column *col, int num_rows) {
+    dict_entry *entries = growArray(NULL, (col->dict_size + 1) * sizeof(dict_entry));
+    int *rank = growArray(NULL, (col->dict_size + 1) * sizeof(int));
+    for (int id = 0; id < col->dict_size; id++) {
+        entries[id].value = col->heap + col->offsets[id];
+        entries[id].offset = col->offsets[id];
+        entries[id].id = id;
+    }
+    qsort(entries, col->dict_size, sizeof(dict_entry), compareDictEntries);
+    for (int code = 0; code < col->dict_size; code++) {
+        col->offsets[code] = entries[code].offset;
+        rank[entries[code].id] = code;
+    }
+    for (int i = 0; i < num_rows; i++)
+        col->codes[i] = (uint16_t)rank[col->codes[i]];
+    free(rank);
+    free(entries);
+}
+
+/* decodeColumn: Turns a dictionary-encoded column back into a plain one; every row points
+ * at its dictionary entry, which already sits in the heap. Works on provisional ids too.
+ */
+static void decodeColumn(column *col, int num_rows, int capacity) {
+    uint64_t *offsets = growArray(NULL, capacity * sizeof(uint64_t));
+    for (int i = 0; i < num_rows; i++)
+        offsets[i] = col->offsets[col->codes[i]];
+    free(col->offsets);
+    free(col->codes);
+    col->offsets = offsets;
+    col->codes = NULL;
+    col->dict_size = col->dict_capacity = 0;
+}
+
+/* dictionaryAppend: Code for value[0..length) in an encoded column, adding it to the
+ * dictionary when new. Codes after the insertion point shift up by one so the dictionary
+ * stays sorted. Returns -1 when the dictionary is full.
+ */
+static int dictionaryAppend(column *col, int num_rows, const char *value, size_t length) {
+    int code = dictionaryBound(col, value, length, false);
+    if (code < col->dict_size && compareBounded(col->heap + col->offsets[code], value, length) == 0)
+        return code;
+    if (col->dict_size == COLUMN_DICT_MAX_CODES)
+        return -1;
+    if (col->dict_size == col->dict_capacity) {
+        col->dict_capacity = col->dict_capacity > 0 ? col->dict_capacity * 2 : 64;
+        col->offsets = growArray(col->offsets, col->dict_capacity * sizeof(uint64_t));
+    }
+    memmove(&col->offsets[code + 1], &col->offsets[code], (col->dict_size - code) * sizeof(uint64_t));
+    col->offsets[code] = appendHeap(col, value, length);
+    col->dict_size++;
+    for (int i = 0; i < num_rows; i++)
+        col->codes[i] += col->codes[i] >= code;
+    return code;
+}
+
+/* ==================== Building ==================== */
+
+/* columnStoreBuild: Copies the records in one row-wise pass (each record is read
+ * once). String columns start out dictionary-encoded and fall back to a plain heap when
+ * they overflow the dictionary, or when over half of the first COLUMN_DICT_SAMPLE rows
+ * are distinct (timestamps, raw commands), where a dictionary would save little.
+ */
+column_store *columnStoreBuild(record **records, int num_records) {
+    column_store *store = malloc(sizeof(column_store));
+    if (store == NULL) {
+        perror("Column store creation failed");
+        exit(EXIT_FAILURE);
+    }
+    size_t num_fields;
+    const FieldInfo *fields = get_record_fields(&num_fields);
+    store->num_rows = num_records;
+    store->capacity = rowCapacity(0, num_records);
+    store->num_columns = (int)num_fields;
+    store->columns = calloc(num_fields, sizeof(column));
+    dict_builder *builders = calloc(num_fields, sizeof(dict_builder));
+    if (store->columns == NULL || builders == NULL) {
+        perror("Column store creation failed");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t f = 0; f < num_fields; f++) {
+        column *col = &store->columns[f];
+        col->field = &fields[f];
+        if (col->field->type == FIELD_STRING) {
+            beginDictionary(col, &builders[f], num_records, store->capacity);
+        } else {
+            col->values = growArray(NULL, store->capacity * valueBytes(col->field->type));
+        }
+    }
+
+    for (int i = 0; i < num_records; i++) {
+        for (size_t f = 0; f < num_fields; f++) {
+            column *col = &store->columns[f];
+            const char *src = (const char *)records[i] + col->field->offset;
+            switch (col->field->type) {
+            case FIELD_UINT64: ((unsigned long long *)col->values)[i] = *(const unsigned long long *)src; break;
+            case FIELD_INT: ((int *)col->values)[i] = *(const int *)src; break;
+            case FIELD_BOOL: ((bool *)col->values)[i] = *(const bool *)src; break;
+            case FIELD_STRING: {
+                const char *value = *(const char *const *)src;
+                size_t length = strlen(value);
+                if (col->codes != NULL) {
+                    bool sampled_distinct = i == COLUMN_DICT_SAMPLE && col->dict_size > COLUMN_DICT_SAMPLE / 2;
+                    if (!sampled_distinct && dictionaryAdd(col, &builders[f], i, value, length))
+                        break;
+                    decodeColumn(col, i, store->capacity);
+                }
+                col->offsets[i] = appendHeap(col, value, length);
+                break;
+            }
+            }
+        }
+    }
+
+    for (size_t f = 0; f < num_fields; f++) {
+        if (store->columns[f].codes != NULL)
+            sortDictionary(&store->columns[f], num_records);
+        free(builders[f].slots);
+    }
+    free(builders);
+    return store;
+}
+
+void columnStoreAppend(column_store *store, const record *r) {
+    reserveRows(store, store->num_rows + 1);
+    int row = store->num_rows;
+    for (int c = 0; c < store->num_columns; c++) {
+        column *col = &store->columns[c];
+        const char *src = (const char *)r + col->field->offset;
+        switch (col->field->type) {
+        case FIELD_UINT64: ((unsigned long long *)col->values)[row] = *(const unsigned long long *)src; break;
+        case FIELD_INT: ((int *)col->values)[row] = *(const int *)src; break;
+        case FIELD_BOOL: ((bool *)col->values)[row] = *(const bool *)src; break;
+        case FIELD_STRING: {
+            const char *value = *(const char *const *)src;
+            size_t length = strlen(value);
+            if (col->codes != NULL) {
+                int code = dictionaryAppend(col, row, value, length);
+                if (code >= 0) {
+                    col->codes[row] = (uint16_t)code;
+                    break;
+                }
+                decodeColumn(col, row, store->capacity);
+            }
+            col->offsets[row] = appendHeap(col, value, length);
+            break;
+        }
+        }
+    }
+    store->num_rows++;
+}
+
+void columnStoreDestroy(column_store *store) {
+    if (store == NULL) return;
+    for (int c = 0; c < store->num_columns; c++) {
+        free(store->columns[c].values);
+        free(store->columns[c].offsets);
+        free(store->columns[c].heap);
+        free(store->columns[c].codes);
+    }
+    free(store->columns);
+    free(store);
+}
+
+const column *columnStoreColumn(const column_store *store, const char *attribute) {
+    size_t num_fields;
+    const FieldInfo *fields = get_record_fields(&num_fields);
+    const FieldInfo *info = get_field_info(attribute);
+    return info != NULL ? &store->columns[info - fields] : NULL;
+}
+
+const char *columnStoreString(const column *col, int row) {
+    return col->heap + col->offsets[col->codes != NULL ? col->codes[row] : (uint64_t)row];
+}
+
+/* ==================== Compare kernels ==================== */
+
+/* Each kernel compares up to 64 consecutive column values with a constant and returns
+ * bit i set for value i: equal to it in *eq, greater in *gt (opBits turns the two into
+ * any operator). The instruction set is picked at compile time (see SIMD_FLAGS in the
+ * makefile); without AVX2 / SSE every value is compared on its own.
+ */
+
+static inline uint64_t opBits(scan_op op, uint64_t eq, uint64_t gt) {
+    switch (op) {
+    case OP_EQ: return eq;
+    case OP_NEQ: return ~eq;
+    case OP_GT: return gt;
+    case OP_LT: return ~(eq | gt);
+    case OP_GTE: return eq | gt;
+    default: return ~gt;
+    }
+}
+
+static inline void compareInts(const int *values, int n, int value, uint64_t *eq, uint64_t *gt) {
+    uint64_t e = 0, g = 0;
+    int i = 0;
+#if defined(__AVX2__)
+    __m256i needle = _mm256_set1_epi32(value);
+    for (; i + 8 <= n; i += 8) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)(values + i));
+        e |= (uint64_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(block, needle))) << i;
+        g |= (uint64_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(block, needle))) << i;
+    }
+#endif
+#if defined(__SSE2__)
+    __m128i needle4 = _mm_set1_epi32(value);
+    for (; i + 4 <= n; i += 4) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(values + i));
+        e |= (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(block, needle4))) << i;
+        g |= (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(block, needle4))) << i;
+    }
+#endif
+    for (; i < n; i++) {
+        e |= (uint64_t)(values[i] == value) << i;
+        g |= (uint64_t)(values[i] > value) << i;
+    }
+    *eq = e;
+    *gt = g;
+}
+
+/* compareU64s: The vector units only have signed 64-bit compares, so both sides are
+ * flipped by the sign bit first.
+ */
+static inline void compareU64s(const unsigned long long *values, int n, unsigned long long value, uint64_t *eq, uint64_t *gt) {
+    uint64_t e = 0, g = 0;
+    int i = 0;
+#if defined(__AVX2__)
+    __m256i bias = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+    __m256i needle = _mm256_xor_si256(_mm256_set1_epi64x((long long)value), bias);
+    for (; i + 4 <= n; i += 4) {
+        __m256i block = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(values + i)), bias);
+        e |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(block, needle))) << i;
+        g |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(block, needle))) << i;
+    }
+#endif
+#if defined(__SSE4_2__)
+    __m128i bias2 = _mm_set1_epi64x((long long)0x8000000000000000ULL);
+    __m128i needle2 = _mm_xor_si128(_mm_set1_epi64x((long long)value), bias2);
+    for (; i + 2 <= n; i += 2) {
+        __m128i block = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(values + i)), bias2);
+        e |= (uint64_t)_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(block, needle2))) << i;
+        g |= (uint64_t)_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(block, needle2))) << i;
+    }
+#endif
+    for (; i < n; i++) {
+        e |= (uint64_t)(values[i] == value) << i;
+        g |= (uint64_t)(values[i] > value) << i;
+    }
+    *eq = e;
+    *gt = g;
+}
+
+/* compareBools: Equality only (bools are stored as 0 / 1 bytes). */
+static inline uint64_t compareBools(const bool *values, int n, bool value) {
+    uint64_t e = 0;
+    int i = 0;
+#if defined(__AVX2__)
+    __m256i needle = _mm256_set1_epi8((char)value);
+    for (; i + 32 <= n; i += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)(values + i));
+        e |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle)) << i;
+    }
+#endif
+#if defined(__SSE2__)
+    __m128i needle16 = _mm_set1_epi8((char)value);
+    for (; i + 16 <= n; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(values + i));
+        e |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle16)) << i;
+    }
+#endif
+    for (; i < n; i++)
+        e |= (uint64_t)(values[i] == value) << i;
+    return e;
+}
+
+/* codesInRange: Bit i set when codes[i] lies in [low, low + width). code - low wraps to
+ * at least width below low (low + width <= COLUMN_DICT_MAX_CODES), so one unsigned 16-bit
+ * compare decides it; vector lanes compare signed, hence the sign-bit flips.
+ */
+static inline uint64_t codesInRange(const uint16_t *codes, int n, uint32_t low, uint32_t width) {
+    uint64_t in = 0;
+    int i = 0;
+#if defined(__AVX2__)
+    __m256i bias = _mm256_set1_epi16((short)0x8000);
+    __m256i base = _mm256_set1_epi16((short)low);
+    __m256i limit = _mm256_xor_si256(_mm256_set1_epi16((short)width), bias);
+    for (; i + 16 <= n; i += 16) {
+        __m256i offset = _mm256_sub_epi16(_mm256_loadu_si256((const __m256i *)(codes + i)), base);
+        __m256i lt = _mm256_cmpgt_epi16(limit, _mm256_xor_si256(offset, bias));
+        // Packing works per 128-bit lane: rows 0-7 land in mask bits 0-7, rows 8-15 in 16-23
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_packs_epi16(lt, lt));
+        in |= (uint64_t)((mask & 0xFF) | ((mask >> 8) & 0xFF00)) << i;
+    }
+#endif
+#if defined(__SSE2__)
+    __m128i bias8 = _mm_set1_epi16((short)0x8000);
+    __m128i base8 = _mm_set1_epi16((short)low);
+    __m128i limit8 = _mm_xor_si128(_mm_set1_epi16((short)width), bias8);
+    for (; i + 8 <= n; i += 8) {
+        __m128i offset = _mm_sub_epi16(_mm_loadu_si128((const __m128i *)(codes + i)), base8);
+        __m128i lt = _mm_cmpgt_epi16(limit8, _mm_xor_si128(offset, bias8));
+        in |= (uint64_t)(_mm_movemask_epi8(_mm_packs_epi16(lt, lt)) & 0xFF) << i;
+    }
+#endif
+    for (; i < n; i++)
+        in |= (uint64_t)((uint32_t)codes[i] - low < width) << i;
+    return in;
+}
+
+/* ==================== Predicate evaluation ==================== */
+
+static scan_op parseOperator(const char *op) {
+    if (strcmp(op, "=") == 0) return OP_EQ;
+    if (strcmp(op, "!=") == 0) return OP_NEQ;
+    if (strcmp(op, ">") == 0) return OP_GT;
+    if (strcmp(op, "<") == 0) return OP_LT;
+    if (strcmp(op, ">=") == 0) return OP_GTE;
+    if (strcmp(op, "<=") == 0) return OP_LTE;
+    return OP_INVALID;
+}
+
+/* One WHERE condition bound to its column, with the constant converted once per scan
+ * rather than once per row. Conditions on dictionary-encoded columns become a code range:
+ * a row matches when its code lies in [code_low, code_low + code_width), or outside it
+ * when code_negate is set.
+ */
+typedef struct scan_pred {
+    const column *col;  // NULL: matches nothing
+    scan_op op;
+    unsigned long long u64_value;
+    int int_value;
+    bool bool_value;
+    const char *string_value;
+    uint32_t code_low;
+    uint32_t code_width;
+    bool code_negate;
+    const struct scan_pred *sub;   // Parenthesised sub-clause, evaluated instead of the condition
+    const struct scan_pred *next;  // Rest of the chain
+    bool or_next;                  // Combined with next by OR (AND otherwise)
+} scan_pred;
+
+static int countConditions(const struct whereClauseS *wc) {
+    int count = 0;
+    for (; wc != NULL; wc = wc->next)
+        count += 1 + countConditions(wc->sub);
+    return count;
+}
+
+/* bindCondition: Converts the constant the way whereCompile converts it. Anything a
+ * WHERE program has no comparison for (unknown attribute or operator, ordering on
+ * sudo_used) matches nothing.
+ */
+static void bindCondition(const column_store *store, const struct whereClauseS *wc, scan_pred *pred) {
+    pred->col = (wc->attribute != NULL && wc->value != NULL) ? columnStoreColumn(store, wc->attribute) : NULL;
+    pred->op = wc->operator != NULL ? parseOperator(wc->operator) : OP_INVALID;
+    if (pred->col == NULL || pred->op == OP_INVALID) {
+        pred->col = NULL;
+        return;
+    }
+
+    switch (pred->col->field->type) {
+    case FIELD_UINT64: pred->u64_value = strtoull(wc->value, NULL, 10); break;
+    case FIELD_INT: pred->int_value = atoi(wc->value); break;
+    case FIELD_BOOL:
+        pred->bool_value = strcasecmp(wc->value, "true") == 0 || strcmp(wc->value, "1") == 0;
+        if (pred->op != OP_EQ && pred->op != OP_NEQ)
+            pred->col = NULL;
+        break;
+    case FIELD_STRING: {
+        pred->string_value = wc->value;
+        if (pred->col->codes == NULL)
+            break;
+        // Codes are ranks in the sorted dictionary, so every comparison is a code range
+        size_t length = strlen(wc->value);
+        uint32_t first = (uint32_t)dictionaryBound(pred->col, wc->value, length, false);  // First code >= value
+        uint32_t after = (uint32_t)dictionaryBound(pred->col, wc->value, length, true);   // First code > value
+        uint32_t size = (uint32_t)pred->col->dict_size;
+        uint32_t low = 0, high = size;
+        switch (pred->op) {
+        case OP_EQ: case OP_NEQ: low = first; high = after; break;
+        case OP_GT: low = after; break;
+        case OP_GTE: low = first; break;
+        case OP_LT: high = first; break;
+        default: high = after; break;
+        }
+        pred->code_low = low;
+        pred->code_width = high - low;
+        pred->code_negate = pred->op == OP_NEQ;
+        break;
+    }
+    }
+}
+
+/* bindClause: Binds a where clause chain into nodes (countConditions(wc) of them). */
+static const scan_pred *bindClause(const column_store *store, const struct whereClauseS *wc, scan_pred *nodes, int *used) {
+    if (wc == NULL)
+        return NULL;
+    scan_pred *pred = &nodes[(*used)++];
+    memset(pred, 0, sizeof(*pred));
+    if (wc->sub != NULL)
+        pred->sub = bindClause(store, wc->sub, nodes, used);
+    else
+        bindCondition(store, wc, pred);
+    pred->or_next = wc->logical_op != NULL && strcmp(wc->logical_op, "OR") == 0;
+    pred->next = bindClause(store, wc->next, nodes, used);
+    return pred;
+}
+
+/* conditionBits: Bit i set when row + i (i < n <= 64) matches a bound condition; bits at
+ * and past n are undefined.
+ */
+static uint64_t conditionBits(const scan_pred *pred, int row, int n) {
+    const column *col = pred->col;
+    uint64_t eq = 0, gt = 0;
+    switch (col->field->type) {
+    case FIELD_UINT64:
+        compareU64s((const unsigned long long *)col->values + row, n, pred->u64_value, &eq, &gt);
+        break;
+    case FIELD_INT:
+        compareInts((const int *)col->values + row, n, pred->int_value, &eq, &gt);
+        break;
+    case FIELD_BOOL:
+        eq = compareBools((const bool *)col->values + row, n, pred->bool_value);
+        break;
+    case FIELD_STRING:
+        if (col->codes != NULL) {
+            uint64_t in = codesInRange(col->codes + row, n, pred->code_low, pred->code_width);
+            return pred->code_negate ? ~in : in;
+        }
+        for (int i = 0; i < n; i++) {
+            int c = strcmp(col->heap + col->offsets[row + i], pred->string_value);
+            eq |= (uint64_t)(c == 0) << i;
+            gt |= (uint64_t)(c > 0) << i;
+        }
+        break;
+    }
+    return opBits(pred->op, eq, gt);
+}
+
+/* filterCondition: bits = active rows of the block that match one bound comparison.
+ * A word with many active rows goes through the kernels 64 rows at a time; one with few
+ * tests only its active rows, walking them like a selection vector. On a plain string
+ * column, where each row costs a strcmp, any inactive row is reason enough to walk.
+ */
+static void filterCondition(const scan_pred *pred, int begin, int count, const uint64_t *active, uint64_t *bits) {
+    int words = (count + 63) / 64;
+    if (pred->col == NULL) {
+        memset(bits, 0, words * sizeof(uint64_t));
+        return;
+    }
+    bool plain_string = pred->col->field->type == FIELD_STRING && pred->col->codes == NULL;
+
+    for (int w = 0; w < words; w++) {
+        uint64_t live = active[w];
+        int row = begin + w * 64;
+        int n = count - w * 64 < 64 ? count - w * 64 : 64;
+        int num_live = __builtin_popcountll(live);
+        if (live == 0) {
+            bits[w] = 0;
+        } else if (num_live < (plain_string ? n : SCAN_SPARSE_ROWS)) {
+            uint64_t match = 0;
+            for (uint64_t rest = live; rest != 0; rest &= rest - 1) {
+                int i = __builtin_ctzll(rest);
+                match |= (conditionBits(pred, row + i, 1) & 1) << i;
+            }
+            bits[w] = match;
+        } else {
+            bits[w] = conditionBits(pred, row, n) & live;
+        }
+    }
+}
+
+/* filterClause: bits = active rows of the block (count <= COLUMN_SCAN_BLOCK) matching the
+ * clause, in the same evaluation order as evaluateWhereClause: a condition (or parenthesised
+ * sub-clause) combined with the rest of the chain by its logical_op, AND unless it is "OR".
+ * The rest of an AND chain only sees the rows still matching, and the rest of an OR chain
+ * only those not matched yet, so a decided block skips the remaining conditions.
+ */
+static void filterClause(const scan_pred *pred, int begin, int count, const uint64_t *active, uint64_t *bits) {
+    if (pred->sub != NULL)
+        filterClause(pred->sub, begin, count, active, bits);
+    else
+        filterCondition(pred, begin, count, active, bits);
+    if (pred->next == NULL)
+        return;
+
+    int words = (count + 63) / 64;
+    uint64_t undecided[SCAN_WORDS], rest[SCAN_WORDS];
+    uint64_t any = 0;
+    for (int w = 0; w < words; w++) {
+        undecided[w] = pred->or_next ? active[w] & ~bits[w] : bits[w];
+        any |= undecided[w];
+    }
+    if (any == 0)
+        return;
+    filterClause(pred->next, begin, count, undecided, rest);
+    for (int w = 0; w < words; w++)
+        bits[w] = pred->or_next ? bits[w] | rest[w] : rest[w];
+}
+
+/* filterBlock: Match bits of rows [begin, begin + count), count <= COLUMN_SCAN_BLOCK. */
+static void filterBlock(const scan_pred *pred, int begin, int count, uint64_t *bits) {
+    int words = (count + 63) / 64;
+    uint64_t all[SCAN_WORDS];
+    for (int w = 0; w < words; w++)
+        all[w] = count - w * 64 >= 64 ? ~0ULL : (1ULL << (count - w * 64)) - 1;
+    if (pred == NULL)
+        memcpy(bits, all, words * sizeof(uint64_t));
+    else
+        filterClause(pred, begin, count, all, bits);
+}
+
+static void filterRows(const scan_pred *pred, int begin, int end, uint8_t *mask) {
+    uint64_t bits[SCAN_WORDS];
+    for (int block = begin; block < end; block += COLUMN_SCAN_BLOCK) {
+        int count = end - block < COLUMN_SCAN_BLOCK ? end - block : COLUMN_SCAN_BLOCK;
+        filterBlock(pred, block, count, bits);
+        for (int i = 0; i < count; i++)
+            mask[block - begin + i] = (bits[i / 64] >> (i % 64)) & 1;
+    }
+}
+
+/* bindWhereClause: Bound form of whereClause (NULL for no clause); free the nodes after use. */
+static const scan_pred *bindWhereClause(const column_store *store, const struct whereClauseS *whereClause, scan_pred **nodes) {
+    *nodes = growArray(NULL, (countConditions(whereClause) + 1) * sizeof(scan_pred));
+    int used = 0;
+    return bindClause(store, whereClause, *nodes, &used);
+}
+
+void columnStoreFilter(const column_store *store, struct whereClauseS *whereClause, int begin, int end, uint8_t *mask) {
+    scan_pred *nodes;
+    const scan_pred *pred = bindWhereClause(store, whereClause, &nodes);
+    filterRows(pred, begin, end, mask);
+    free(nodes);
+}
+
+int *columnStoreSelect(const column_store *store, struct whereClauseS *whereClause, int *num_matches) {
+    int capacity = COLUMN_INITIAL_ROWS;
+    int count = 0;
+    int *rows = growArray(NULL, capacity * sizeof(int));
+    uint64_t bits[SCAN_WORDS];
+    scan_pred *nodes;
+    const scan_pred *pred = bindWhereClause(store, whereClause, &nodes);
+
+    for (int block = 0; block < store->num_rows; block += COLUMN_SCAN_BLOCK) {
+        int end = block + COLUMN_SCAN_BLOCK < store->num_rows ? block + COLUMN_SCAN_BLOCK : store->num_rows;
+        filterBlock(pred, block, end - block, bits);
+        if (count + (end - block) > capacity) {
+            while (capacity < count + (end - block))
+                capacity *= 2;
+            rows = growArray(rows, capacity * sizeof(int));
+        }
+        // Selection vector of the block: one row id per set bit
+        for (int w = 0; w * 64 < end - block; w++) {
+            for (uint64_t match = bits[w]; match != 0; match &= match - 1)
+                rows[count++] = block + w * 64 + __builtin_ctzll(match);
+        }
+    }
+
+    free(nodes);
+    *num_matches = count;
+    return rows;
+}
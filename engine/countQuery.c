@@ -0,0 +1,74 @@
+/*
+ * COUNT(*) queries shared by the serial, OpenMP and MPI engines: recognising them, answering
+ * them from index subtree counts where one key range covers the WHERE clause, and building
+ * the single-cell result.
+ */
+
+#define _POSIX_C_SOURCE 200809L  // strdup
+#include "../include/countQuery.h"
+#include "../include/executeEngine-serial.h"  // struct engineS, struct whereClauseS, struct resultSetS
+#include "../include/indexPlan.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool isCountStar(const char *selectItems[], int numItems) {
+    return selectItems != NULL && numItems == 1 && strcmp(selectItems[0], "COUNT(*)") == 0;
+}
+
+bool countFromIndex(const struct engineS *engine, const struct whereClauseS *whereClause, int *count) {
+    if (whereClause == NULL) {
+        *count = engine->num_records;
+        return true;
+    }
+    if (whereClause->next != NULL || whereClause->sub != NULL || whereClause->attribute == NULL ||
+        whereClause->operator == NULL || whereClause->value == NULL) {
+        return false;
+    }
+
+    for (int i = 0; i < engine->num_indexes; i++) {
+        if (strcmp(whereClause->attribute, engine->indexed_attributes[i]) != 0) {
+            continue;
+        }
+        KEY_T key_start, key_end;
+        bool empty = false;
+        if (!indexKeyRange(engine->attribute_types[i], whereClause->operator, whereClause->value,
+                           &key_start, &key_end, &empty)) {
+            return false;
+        }
+        *count = empty ? 0 : countRange(engine->bplus_tree_roots[i], key_start, key_end);
+        return true;
+    }
+    return false;
+}
+
+struct resultSetS *makeCountResult(int count, double time_taken) {
+    struct resultSetS *queryResults = (struct resultSetS *)malloc(sizeof(struct resultSetS));
+    if (queryResults == NULL) {
+        perror("Failed to allocate COUNT(*) result");
+        exit(EXIT_FAILURE);
+    }
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%d", count);
+
+    queryResults->numRecords = 1;
+    queryResults->numColumns = 1;
+    queryResults->columnNames = (char **)malloc(sizeof(char *));
+    queryResults->columnTypes = (FieldType *)malloc(sizeof(FieldType));
+    queryResults->data = (char ***)malloc(sizeof(char **));
+    if (queryResults->columnNames == NULL || queryResults->columnTypes == NULL || queryResults->data == NULL) {
+        perror("Failed to allocate COUNT(*) result");
+        exit(EXIT_FAILURE);
+    }
+    queryResults->data[0] = (char **)malloc(sizeof(char *));
+    if (queryResults->data[0] == NULL) {
+        perror("Failed to allocate COUNT(*) result");
+        exit(EXIT_FAILURE);
+    }
+    queryResults->columnNames[0] = strdup("COUNT(*)");
+    queryResults->columnTypes[0] = FIELD_INT;
+    queryResults->data[0][0] = strdup(buffer);
+    queryResults->queryTime = time_taken;
+    queryResults->success = true;
+    return queryResults;
+}
@@ -0,0 +1,204 @@
+/*
+ * CSV field splitting for the data file loaders. Lines are scanned 64 bytes at a time:
+ * a block is turned into a bitmask of the bytes the splitter has to look at (commas,
+ * quotes, line ends), and the quote state machine jumps from set bit to set bit instead
+ * of testing every byte of the plain text in between.
+ */
+
+#define _POSIX_C_SOURCE 200809L  // strcasecmp
+#include "../include/csvParse.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#if defined(__SSE2__)
+#include <immintrin.h>  // AVX2 / SSE2 delimiter compares
+#endif
+
+/* ==================== Delimiter bitmasks ==================== */
+
+/* Bytes per bitmask block (one bit per byte of a uint64_t). */
+#define CSV_BLOCK_BYTES 64
+
+static inline bool isSpecial(char c) {
+    return c == ',' || c == '"' || c == '\n' || c == '\r' || c == '\0';
+}
+
+/* specialMask: Bit i is set when p[i] (i < n <= CSV_BLOCK_BYTES) is a comma, quote,
+ * '\n', '\r' or NUL. Only p[0..n) is read. The instruction set is picked at compile time
+ * (see SIMD_FLAGS in the makefile); without AVX2 / SSE2 every byte is tested.
+ */
+static inline uint64_t specialMask(const char *p, size_t n) {
+    uint64_t mask = 0;
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i comma = _mm256_set1_epi8(','), quote = _mm256_set1_epi8('"');
+    const __m256i newline = _mm256_set1_epi8('\n'), carriage = _mm256_set1_epi8('\r');
+    const __m256i zero = _mm256_setzero_si256();
+    for (; i + 32 <= n; i += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)(p + i));
+        __m256i hits = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, comma), _mm256_cmpeq_epi8(block, quote)),
+            _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, newline), _mm256_cmpeq_epi8(block, carriage)),
+                            _mm256_cmpeq_epi8(block, zero)));
+        mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(hits) << i;
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i comma4 = _mm_set1_epi8(','), quote4 = _mm_set1_epi8('"');
+    const __m128i newline4 = _mm_set1_epi8('\n'), carriage4 = _mm_set1_epi8('\r');
+    const __m128i zero4 = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, comma4), _mm_cmpeq_epi8(block, quote4)),
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, newline4), _mm_cmpeq_epi8(block, carriage4)),
+                         _mm_cmpeq_epi8(block, zero4)));
+        mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(hits) << i;
+    }
+#endif
+    for (; i < n; i++) {
+        if (isSpecial(p[i])) mask |= 1ULL << i;
+    }
+    return mask;
+}
+
+/* Cursor over the special bytes of a line, one bitmask block at a time */
+typedef struct {
+    const char *line;
+    size_t length;
+    size_t block;   // Offset of the block the mask covers
+    uint64_t mask;  // Special bytes of line[block .. block + CSV_BLOCK_BYTES)
+} special_scan;
+
+/* nextSpecial: Offset of the first special byte at or after from (length if none). */
+static inline size_t nextSpecial(special_scan *scan, size_t from) {
+    while (from < scan->length) {
+        if (from < scan->block || from >= scan->block + CSV_BLOCK_BYTES) {
+            size_t n = scan->length - from;
+            scan->block = from;
+            scan->mask = specialMask(scan->line + from, n < CSV_BLOCK_BYTES ? n : CSV_BLOCK_BYTES);
+        }
+        uint64_t rest = scan->mask >> (from - scan->block);
+        if (rest != 0) return from + (size_t)__builtin_ctzll(rest);
+        from = scan->block + CSV_BLOCK_BYTES;
+    }
+    return scan->length;
+}
+
+/* ==================== Field splitting ==================== */
+
+int csvSplitLine(char *line, size_t length, const char **fields, size_t *lengths, int max_fields) {
+    special_scan scan = { line, length, 0, 0 };
+    scan.mask = specialMask(line, length < CSV_BLOCK_BYTES ? length : CSV_BLOCK_BYTES);
+
+    size_t pos = 0;
+    int count = 0;
+    while (count < max_fields && pos < length) {
+        char first = line[pos];
+        if (first == '\n' || first == '\r' || first == '\0') break;  // End of the line
+
+        // The unquoted text is compacted to the start of the field (it is never longer)
+        size_t start = pos, out = pos;
+        bool in_quotes = false;
+        if (first == '"') {
+            in_quotes = true;
+            pos++;  // Skip opening quote
+        }
+
+        for (;;) {
+            // Plain bytes up to the next special one are copied (or kept) as a run
+            size_t next = nextSpecial(&scan, pos);
+            if (out != pos) memmove(line + out, line + pos, next - pos);
+            out += next - pos;
+            pos = next;
+            if (pos >= length) break;
+
+            char c = line[pos];
+            if (c == '\n' || c == '\r' || c == '\0') break;
+            if (c == ',') {
+                pos++;
+                if (!in_quotes) break;  // End of the field
+                line[out++] = ',';
+            } else if (in_quotes) {
+                if (pos + 1 < length && line[pos + 1] == '"') {
+                    line[out++] = '"';  // Escaped quote
+                    pos += 2;
+                } else {
+                    in_quotes = false;  // End of quoted text
+                    pos++;
+                }
+            } else {
+                line[out++] = '"';  // A quote inside unquoted text is kept
+                pos++;
+            }
+        }
+
+        line[out] = '\0';
+        fields[count] = line + start;
+        if (lengths != NULL) lengths[count] = out - start;
+        count++;
+    }
+
+    for (int i = count; i < max_fields; i++) {
+        fields[i] = "";
+        if (lengths != NULL) lengths[i] = 0;
+    }
+    return count;
+}
+
+void csvParseRecord(record *rec, char *line, size_t length) {
+    const char *fields[CSV_RECORD_FIELDS];
+    csvSplitLine(line, length, fields, NULL, CSV_RECORD_FIELDS);
+
+    rec->command_id = csvParseUint64(fields[0]);
+    rec->raw_command = fields[1];
+    rec->base_command = fields[2];
+    rec->shell_type = fields[3];
+    rec->exit_code = csvParseInt(fields[4]);
+    rec->timestamp = fields[5];
+    rec->sudo_used = csvParseBool(fields[6]);
+    rec->working_directory = fields[7];
+    rec->user_id = csvParseInt(fields[8]);
+    rec->user_name = fields[9];
+    rec->host_name = fields[10];
+    rec->risk_level = csvParseInt(fields[11]);
+}
+
+/* ==================== Numeric fields ==================== */
+
+/* Plain digit strings (the data file's integer columns) are summed directly; anything
+ * else (signs, spaces, overflow) goes to the C library so the result never differs.
+ */
+
+uint64_t csvParseUint64(const char *text) {
+    uint64_t value = 0;
+    int digits = 0;
+    for (; digits < 20 && text[digits] >= '0' && text[digits] <= '9'; digits++) {
+        value = value * 10 + (uint64_t)(text[digits] - '0');
+    }
+    if (digits == 0 || digits > 19 || text[digits] != '\0') {
+        return strtoull(text, NULL, 10);
+    }
+    return value;
+}
+
+int csvParseInt(const char *text) {
+    const char *p = text;
+    bool negative = *p == '-';
+    if (negative) p++;
+    int value = 0;
+    int digits = 0;
+    for (; p[digits] >= '0' && p[digits] <= '9'; digits++) {
+        if (digits == 9) return atoi(text);  // Might not fit in an int
+        value = value * 10 + (p[digits] - '0');
+    }
+    if (digits == 0 || p[digits] != '\0') {
+        return atoi(text);
+    }
+    return negative ? -value : value;
+}
+
+bool csvParseBool(const char *text) {
+    return strcasecmp(text, "true") == 0 || strcmp(text, "1") == 0;
+}
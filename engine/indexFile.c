@@ -0,0 +1,295 @@
+/*
+ * Index files: B+ tree indexes saved next to the data file and memory-mapped on the
+ * next start, so unchanged data does not pay for extracting and sorting every key again.
+ * The file holds the tree's own nodes; loading relocates them where they are mapped.
+ */
+
+#define _POSIX_C_SOURCE 200809L  // pread, fstat st_mtim, posix_madvise
+#include "../include/indexFile.h"
+#include "../include/recordSchema.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define FNV_OFFSET 1469598103934665603ULL
+#define FNV_PRIME 1099511628211ULL
+
+// Row pointer with its row id (save-time reverse lookup).
+typedef struct {
+    uintptr_t row;
+    uint32_t id;
+} row_ref;
+
+/* ==================== Data file identity ==================== */
+
+static bool indexCacheEnabled(void) {
+    const char *env = getenv(INDEX_CACHE_ENV);
+    return env == NULL || strcmp(env, "0") != 0;
+}
+
+static uint64_t fnv1a(uint64_t hash, const unsigned char *bytes, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/* dataFileIdentity: The checksum hashes INDEX_CHECKSUM_SAMPLE bytes at the start, middle
+ * and end, so a check costs three reads however large the log is; size and mtime catch
+ * everything else.
+ */
+bool dataFileIdentity(const char *datafile, data_file_identity *identity) {
+    int fd = open(datafile, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    identity->size = (uint64_t)st.st_size;
+    identity->mtime_sec = (int64_t)st.st_mtim.tv_sec;
+    identity->mtime_nsec = (int64_t)st.st_mtim.tv_nsec;
+
+    unsigned char *buffer = malloc(INDEX_CHECKSUM_SAMPLE);
+    if (buffer == NULL) {
+        perror("Index checksum buffer allocation failed");
+        exit(EXIT_FAILURE);
+    }
+    uint64_t size = identity->size;
+    uint64_t tail = size > INDEX_CHECKSUM_SAMPLE ? size - INDEX_CHECKSUM_SAMPLE : 0;
+    uint64_t offsets[3] = { 0, size / 2, tail };
+    uint64_t hash = fnv1a(FNV_OFFSET, (const unsigned char *)&size, sizeof(size));
+    bool ok = true;
+    for (int s = 0; s < 3 && ok; s++) {
+        ssize_t got = pread(fd, buffer, INDEX_CHECKSUM_SAMPLE, (off_t)offsets[s]);
+        if (got < 0)
+            ok = false;
+        else
+            hash = fnv1a(hash, buffer, (size_t)got);
+    }
+    free(buffer);
+    close(fd);
+    identity->checksum = hash;
+    return ok;
+}
+
+bool sameDataFile(const data_file_identity *a, const data_file_identity *b) {
+    return a->size == b->size && a->mtime_sec == b->mtime_sec &&
+           a->mtime_nsec == b->mtime_nsec && a->checksum == b->checksum;
+}
+
+/* ==================== Public API ==================== */
+
+char *indexFilePath(const char *datafile, const char *attribute) {
+    size_t length = strlen(datafile) + 1 + strlen(attribute) + strlen(INDEX_FILE_SUFFIX) + 1;
+    char *path = malloc(length);
+    if (path == NULL) {
+        perror("Index path allocation failed");
+        exit(EXIT_FAILURE);
+    }
+    snprintf(path, length, "%s.%s%s", datafile, attribute, INDEX_FILE_SUFFIX);
+    return path;
+}
+
+static int compareRowRefs(const void *a, const void *b) {
+    uintptr_t ra = ((const row_ref *)a)->row;
+    uintptr_t rb = ((const row_ref *)b)->row;
+    return (ra > rb) - (ra < rb);
+}
+
+/* findRowId: Row id of row in refs (sorted by address), or -1 when it is not a loaded record. */
+static long findRowId(const row_ref *refs, int num_refs, ROW_PTR row) {
+    int lo = 0, hi = num_refs;
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        if (refs[mid].row < (uintptr_t)row) lo = mid + 1;
+        else hi = mid;
+    }
+    return (lo < num_refs && refs[lo].row == (uintptr_t)row) ? (long)refs[lo].id : -1;
+}
+
+/* Reverse lookup behind the image's row ids. */
+typedef struct {
+    const row_ref *refs;
+    int num_refs;
+} row_ids;
+
+static long imageRowId(void *ctx, ROW_PTR row) {
+    const row_ids *ids = ctx;
+    return findRowId(ids->refs, ids->num_refs, row);
+}
+
+static uint64_t pageAlign(uint64_t offset) {
+    return (offset + INDEX_FILE_PAGE - 1) / INDEX_FILE_PAGE * INDEX_FILE_PAGE;
+}
+
+/* writeZeros: Pads the file up to a section boundary. */
+static bool writeZeros(FILE *file, uint64_t bytes) {
+    static const unsigned char zeros[INDEX_FILE_PAGE];
+    while (bytes > 0) {
+        size_t n = bytes < sizeof(zeros) ? (size_t)bytes : sizeof(zeros);
+        if (fwrite(zeros, 1, n, file) != n)
+            return false;
+        bytes -= n;
+    }
+    return true;
+}
+
+bool indexFileSave(const char *datafile, const char *attribute, bptree *tree, record **records, int num_records) {
+    if (!indexCacheEnabled() || datafile == NULL || tree == NULL || records == NULL || num_records <= 0)
+        return false;
+    if (strlen(attribute) >= sizeof(((index_file_header *)0)->attribute))
+        return false;
+
+    index_file_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, INDEX_FILE_MAGIC, sizeof(h.magic));
+    h.version = INDEX_FILE_VERSION;
+    h.key_type = (uint32_t)tree->key_type;
+    strcpy(h.attribute, attribute);
+    if (!dataFileIdentity(datafile, &h.data))
+        return false;
+    h.num_records = (uint64_t)num_records;
+
+    // Rows come out of the tree as pointers; map them back to positions in records[]
+    row_ref *refs = malloc(num_records * sizeof(row_ref));
+    if (refs == NULL) {
+        perror("Index save allocation failed");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < num_records; i++) {
+        refs[i].row = (uintptr_t)records[i];
+        refs[i].id = (uint32_t)i;
+    }
+    qsort(refs, num_records, sizeof(row_ref), compareRowRefs);
+
+    // A row that is not a loaded record (or a string key) leaves nothing sensible to save
+    row_ids ids = { refs, num_records };
+    bplus_image image;
+    bool ok = bptreeImageCreate(tree, imageRowId, &ids, &image);
+    free(refs);
+    if (!ok)
+        return false;
+    h.num_rows = (uint64_t)countRows(tree);
+    h.order = (uint32_t)tree->order;
+    h.node_bytes = (uint32_t)tree->node_bytes;
+    h.num_nodes = (uint64_t)image.num_nodes;
+    h.nodes_offset = INDEX_FILE_PAGE;
+    uint64_t node_section = h.num_nodes * h.node_bytes;
+    h.postings_offset = pageAlign(h.nodes_offset + node_section);
+    h.num_postings = (uint64_t)image.num_postings;
+
+    // Write beside the final name and rename, so readers (other ranks) never see half a file
+    char *path = indexFilePath(datafile, attribute);
+    size_t tmp_length = strlen(path) + 32;
+    char *tmp_path = malloc(tmp_length);
+    if (tmp_path == NULL) {
+        perror("Index path allocation failed");
+        exit(EXIT_FAILURE);
+    }
+    snprintf(tmp_path, tmp_length, "%s.tmp.%ld", path, (long)getpid());
+
+    FILE *file = fopen(tmp_path, "wb");
+    if (file != NULL) {
+        ok = fwrite(&h, sizeof(h), 1, file) == 1 &&
+             writeZeros(file, h.nodes_offset - sizeof(h)) &&
+             fwrite(image.nodes, h.node_bytes, image.num_nodes, file) == (size_t)image.num_nodes &&
+             writeZeros(file, h.postings_offset - h.nodes_offset - node_section) &&
+             fwrite(image.postings, sizeof(uint32_t), image.num_postings, file) == image.num_postings;
+        ok = (fclose(file) == 0) && ok;
+        if (ok)
+            ok = rename(tmp_path, path) == 0;
+        if (!ok)
+            remove(tmp_path);
+    } else {
+        ok = false;
+    }
+
+    bptreeImageFree(&image);
+    free(tmp_path);
+    free(path);
+    return ok;
+}
+
+bptree *indexFileLoad(const char *datafile, const char *attribute, record **records, int num_records) {
+    if (!indexCacheEnabled() || datafile == NULL || records == NULL || num_records <= 0)
+        return NULL;
+    const FieldInfo *info = get_field_info(attribute);
+    if (info == NULL)
+        return NULL;
+    KeyType key_type = key_type_for_field(info->type);
+
+    char *path = indexFilePath(datafile, attribute);
+    int fd = open(path, O_RDONLY);
+    free(path);
+    if (fd < 0)
+        return NULL;
+    struct stat st;
+    index_file_header h;
+    if (fstat(fd, &st) != 0 || st.st_size < INDEX_FILE_PAGE ||
+        pread(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h)) {
+        close(fd);
+        return NULL;
+    }
+    uint64_t file_size = (uint64_t)st.st_size;
+
+    /* The file is only trusted when it was written for this exact data file, the same
+     * loaded records and the tree layout this build would pick; anything else is a
+     * stale cache and gets rebuilt.
+     */
+    data_file_identity now;
+    bool valid = memcmp(h.magic, INDEX_FILE_MAGIC, sizeof(h.magic)) == 0 &&
+                 h.version == INDEX_FILE_VERSION &&
+                 h.key_type == (uint32_t)key_type &&
+                 strncmp(h.attribute, attribute, sizeof(h.attribute)) == 0 &&
+                 h.num_records == (uint64_t)num_records &&
+                 h.num_rows == (uint64_t)num_records &&
+                 h.order == (uint32_t)bptreeDefaultOrder(key_type) &&
+                 h.node_bytes > 0 && h.num_nodes > 0 &&
+                 h.nodes_offset % INDEX_FILE_PAGE == 0 && h.nodes_offset >= INDEX_FILE_PAGE &&
+                 h.postings_offset % INDEX_FILE_PAGE == 0 && h.postings_offset <= file_size &&
+                 h.nodes_offset < h.postings_offset &&
+                 h.num_nodes <= (h.postings_offset - h.nodes_offset) / h.node_bytes &&
+                 h.num_postings <= (file_size - h.postings_offset) / sizeof(uint32_t) &&
+                 dataFileIdentity(datafile, &now) &&
+                 sameDataFile(&now, &h.data);
+    if (!valid) {
+        close(fd);
+        return NULL;
+    }
+
+    // Private and writable: the loader turns node numbers and row ids into pointers in place
+    size_t nodes_bytes = (size_t)(h.postings_offset - h.nodes_offset);
+    void *nodes = mmap(NULL, nodes_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, (off_t)h.nodes_offset);
+    void *postings = NULL;
+    size_t postings_bytes = (size_t)h.num_postings * sizeof(uint32_t);
+    if (nodes != MAP_FAILED && postings_bytes > 0) {
+        postings = mmap(NULL, postings_bytes, PROT_READ, MAP_PRIVATE, fd, (off_t)h.postings_offset);
+        if (postings == MAP_FAILED) {
+            munmap(nodes, nodes_bytes);
+            nodes = MAP_FAILED;
+        }
+    }
+    close(fd);
+    if (nodes == MAP_FAILED)
+        return NULL;
+    posix_madvise(nodes, nodes_bytes, POSIX_MADV_WILLNEED);
+
+    bptree *tree = bptreeFromImage(key_type, (int)h.order, h.node_bytes, nodes, (long)h.num_nodes, nodes_bytes,
+                                   postings, (size_t)h.num_postings, (ROW_PTR *)records, num_records);
+    if (tree != NULL && countRows(tree) != num_records) {
+        destroy_tree(tree);  // The arena unmaps the nodes with it
+        tree = NULL;
+    } else if (tree == NULL) {
+        munmap(nodes, nodes_bytes);
+    }
+    if (postings != NULL)
+        munmap(postings, postings_bytes);
+    return tree;
+}
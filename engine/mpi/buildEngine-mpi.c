@@ -2,6 +2,8 @@
 
 #define _POSIX_C_SOURCE 200809L  // Enable strdup
 #include "../../include/buildEngine-mpi.h"
+#include "../../include/csvParse.h"
+#include "../../include/indexFile.h"
 #include <string.h>
 #include <strings.h>
 #include <mpi.h>
@@ -12,18 +14,30 @@ FieldType mapAttributeTypeMPI(int attributeType);
 
 // Creates a serial B+ tree from data file, returns the tree root
 bool makeIndexMPI(struct engineS *engine, const char *indexName, int attributeType) {
-    // Load all records from the engine's data source
+    // Load this rank's records from the engine's data source
     record **records = engine->all_records;
     int numRecords = engine->num_records;
+    int size;
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
     
-    // Build the B+ tree from the records array
-    node *root = loadIntoBplusTreeMPI(records, numRecords, indexName);
+    // Reuse the index saved by an earlier run while the data file is unchanged;
+    // otherwise build the B+ tree from the records array and save it for the next run.
+    // Index files cover the whole table, so with several ranks each one builds a local
+    // index over its own partition instead
+    bptree *root = size == 1 ? indexFileLoad(engine->datafile, indexName, records, numRecords) : NULL;
+    if (root == NULL) {
+        root = loadIntoBplusTreeMPI(records, numRecords, indexName);
+        if (root != NULL && size == 1) {
+            indexFileSave(engine->datafile, indexName, root, records, numRecords);
+        }
+    }
     if (VERBOSE && root == NULL) {
         fprintf(stderr, "Failed to load data into B+ tree\n");
     }
 
     // Add to the engine's known tree roots
     engine->bplus_tree_roots[engine->num_indexes] = root;
+    columnStatsBuild(&engine->index_stats[engine->num_indexes], root);  // For the index planner
     engine->indexed_attributes[engine->num_indexes] = strdup(indexName);
     engine->num_indexes += 1;
     engine->attribute_types[engine->num_indexes-1] = mapAttributeTypeMPI(attributeType);
@@ -37,255 +51,184 @@ bool makeIndexMPI(struct engineS *engine, const char *indexName, int attributeTy
  *   num_records - number of records in the array
  *   attributeName - name of the attribute to index
  * Returns:
- *  root of the B+ tree
+ *  handle of the B+ tree
 */
-node *loadIntoBplusTreeMPI(record **records, int num_records, const char *attributeName) {
-    // Instantiate the B+ tree root
-    node *root = NULL;
-    
-    // Iterate through each record and insert into the B+ tree
+bptree *loadIntoBplusTreeMPI(record **records, int num_records, const char *attributeName) {
+    // Each index gets its own tree handle; the order is sized to the key type
+    const FieldInfo *info = get_field_info(attributeName);
+    if (info == NULL) {
+        fprintf(stderr, "Unknown index attribute: %s\n", attributeName);
+        return NULL;
+    }
+    bptree *tree = bptreeCreate(key_type_for_field(info->type), 0);
+    if (num_records <= 0) {
+        return tree;  // Nothing to index yet, later inserts will populate it
+    }
+
+    // Pair every record with its key so the tree can be built bottom-up in one pass
+    bplus_entry *entries = (bplus_entry *)malloc(num_records * sizeof(bplus_entry));
+    if (entries == NULL) {
+        fprintf(stderr, "Memory allocation failed for bulk load entries\n");
+        destroy_tree(tree);
+        return NULL;
+    }
     for (int i = 0; i < num_records; i++) {
-        
-        // Extract the current record as a key
-        record *currentRecord = records[i];
-        KEY_T key = extract_key_from_record(currentRecord, attributeName);
+        entries[i].key = extract_key_from_record(records[i], attributeName);
+        entries[i].row_ptr = (ROW_PTR)records[i];
+    }
 
-        // Insert the record into the B+ tree using the key
-        root = insert(root, key, (ROW_PTR)currentRecord);
+    // Sort once and pack the leaves/internal nodes instead of inserting record by record
+    bulkLoad(tree, entries, num_records, BULK_FILL_FACTOR);
+    free(entries);
 
-        // Validate insertion via printing (only in verbose mode)
-        if (VERBOSE) {
-            printTree(root);
-        }
+    // Validate the build via printing (only in verbose mode)
+    if (VERBOSE) {
+        printTree(tree);
     }
 
-    return root;  // Return the root of the constructed B+ tree
+    return tree;  // Return the constructed B+ tree
 }
 
-/* Load the full CSV file into memory as an array of record structs 
+/* ==================== Parallel loading ==================== */
+
+// Largest single MPI_File_read_at_all (a rank's range is read in rounds of this size)
+#define LOAD_READ_ROUND (1 << 30)
+// Bytes read at a time while looking for the line start after a range boundary
+#define LOAD_PROBE_BYTES 65536
+
+/* lineStartAtOrAfter: Smallest offset >= pos where a line starts (0, or just after a
+ * newline), or file_size when no line starts there. Reads the file independently.
+ */
+static MPI_Offset lineStartAtOrAfter(MPI_File fh, MPI_Offset pos, MPI_Offset file_size) {
+    if (pos <= 0) return 0;
+    if (pos >= file_size) return file_size;
+    char probe[LOAD_PROBE_BYTES];
+    for (MPI_Offset at = pos - 1; at < file_size; at += LOAD_PROBE_BYTES) {
+        int want = (int)(file_size - at < LOAD_PROBE_BYTES ? file_size - at : LOAD_PROBE_BYTES);
+        MPI_Status status;
+        int got = 0;
+        MPI_File_read_at(fh, at, probe, want, MPI_CHAR, &status);
+        MPI_Get_count(&status, MPI_CHAR, &got);
+        if (got <= 0) break;
+        char *newline = memchr(probe, '\n', (size_t)got);
+        if (newline != NULL) return at + (newline - probe) + 1;
+    }
+    return file_size;
+}
+
+/* Load this rank's partition of the CSV file into memory as an array of record structs
+ * Every rank reads and parses only its own line-aligned byte range of the file (collective
+ * MPI-IO reads, no broadcast of the file) and keeps those records: rank r holds the r-th
+ * contiguous slice of the table, in file order, and the query engine works on the slices.
  * Parameters:
  *   filepath - path to the CSV data file
+ *   record_block_out - set to the contiguous block holding the records (caller frees)
+ *   record_block_bytes_out - set to the length of that block
+ *   strings - string heap that takes over the text buffer the string fields point into
  * Returns:
- *   Array of all record structs in the file
+ *   Array of this rank's record structs
 */
-record **getAllRecordsFromFileMPI(const char *filepath, int *num_records) {
-    int rank;
+record **getAllRecordsFromFileMPI(const char *filepath, int *num_records, void **record_block_out, size_t *record_block_bytes_out, string_heap *strings) {
+    int rank, size;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-    char *file_content = NULL;
-    long file_size = 0;
-
-    // Rank 0 reads the file from disk
-    if (rank == 0) {
-        FILE *file = fopen(filepath, "r");
-        if (file == NULL) {
-            fprintf(stderr, "Error opening file: %s\n", filepath);
-            file_size = -1; // Signal error
-        } else {
-            fseek(file, 0, SEEK_END);
-            file_size = ftell(file);
-            fseek(file, 0, SEEK_SET);
-            
-            file_content = (char *)malloc(file_size + 1);
-            if (file_content) {
-                size_t read_size = fread(file_content, 1, file_size, file);
-                if (read_size != (size_t)file_size) {
-                    fprintf(stderr, "Error reading file content\n");
-                    free(file_content);
-                    file_content = NULL;
-                    file_size = -1;
-                } else {
-                    file_content[file_size] = '\0';
-                }
-            } else {
-                file_size = -1; // Memory error
-            }
-            fclose(file);
-        }
+    MPI_File fh;
+    if (MPI_File_open(MPI_COMM_WORLD, filepath, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+        if (rank == 0) fprintf(stderr, "Error opening file: %s\n", filepath);
+        return NULL;
     }
-
-    // Broadcast file size to all ranks
-    MPI_Bcast(&file_size, 1, MPI_LONG, 0, MPI_COMM_WORLD);
-
-    if (file_size < 0) {
-        return NULL; // Propagate error
+    MPI_Offset file_size = 0;
+    MPI_File_get_size(fh, &file_size);
+
+    // Split the body (after the header line) evenly, then move each split to a line start;
+    // every rank finds its own boundaries, so no offsets need to be exchanged
+    MPI_Offset body = lineStartAtOrAfter(fh, 1, file_size);
+    MPI_Offset body_bytes = file_size - body;
+    MPI_Offset start = rank == 0 ? body : lineStartAtOrAfter(fh, body + body_bytes / size * rank, file_size);
+    MPI_Offset end = rank == size - 1 ? file_size : lineStartAtOrAfter(fh, body + body_bytes / size * (rank + 1), file_size);
+    size_t local_bytes = (size_t)(end - start);
+
+    char *text = malloc(local_bytes + 1);
+    if (text == NULL) {
+        perror("Failed to allocate file range");
+        exit(EXIT_FAILURE);
     }
+    text[local_bytes] = '\0';
+
+    // Collective reads in rounds, so a range past INT_MAX bytes still loads
+    MPI_Offset max_bytes = 0, local_length = (MPI_Offset)local_bytes;
+    MPI_Allreduce(&local_length, &max_bytes, 1, MPI_OFFSET, MPI_MAX, MPI_COMM_WORLD);
+    for (MPI_Offset done = 0; done < max_bytes; done += LOAD_READ_ROUND) {
+        MPI_Offset left = local_length > done ? local_length - done : 0;
+        int want = (int)(left < LOAD_READ_ROUND ? left : LOAD_READ_ROUND);
+        MPI_File_read_at_all(fh, start + done, text + done, want, MPI_CHAR, MPI_STATUS_IGNORE);
+    }
+    MPI_File_close(&fh);
 
-    // Allocate memory on other ranks
-    if (rank != 0) {
-        file_content = (char *)malloc(file_size + 1);
-        if (!file_content) {
-            fprintf(stderr, "Rank %d failed to allocate memory for file content\n", rank);
-            // In a real app, we should signal abort here
-            return NULL;
+    // Parse the lines into one growing block (file order is address order, which the
+    // indexes use to order rows with equal keys)
+    record *block = NULL;
+    size_t capacity = 0;
+    int count = 0;
+    char *text_end = text + local_bytes;
+    for (char *line = text; line < text_end; ) {
+        char *eol = memchr(line, '\n', (size_t)(text_end - line));
+        if (eol == NULL) eol = text_end;  // Last line without a newline
+        if (eol > line) {
+            if ((size_t)count == capacity) {
+                capacity = capacity == 0 ? 1024 : capacity * 2;
+                block = realloc(block, capacity * sizeof(record));
+                if (block == NULL) {
+                    perror("Failed to allocate record block");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            csvParseRecord(&block[count], line, (size_t)(eol - line));
+            count++;
         }
+        line = eol + 1;
     }
 
-    // Broadcast file content to all ranks
-    // Note: MPI_Bcast count is int. If file_size > INT_MAX, this needs chunking.
-    // For this project, we assume file_size fits in int.
-    MPI_Bcast(file_content, (int)file_size + 1, MPI_CHAR, 0, MPI_COMM_WORLD);
+    // The records' string fields point into the text, so the heap keeps it
+    stringHeapAdopt(strings, text, local_bytes + 1);
 
-    // Parse records from memory buffer
     record **records = NULL;
-    int count = 0;
-    
-    char *cursor = file_content;
-    
-    // Skip header line
-    char *eol = strchr(cursor, '\n');
-    if (eol) {
-        cursor = eol + 1;
-    }
-
-    while (*cursor) {
-        // Find end of line
-        eol = strchr(cursor, '\n');
-        if (!eol) {
-            // Handle last line without newline
-            if (*cursor) eol = cursor + strlen(cursor);
-            else break;
+    if (count > 0) {
+        records = malloc(count * sizeof(record *));
+        if (records == NULL) {
+            perror("Failed to allocate record array");
+            exit(EXIT_FAILURE);
         }
-
-        if (eol > cursor) {
-            // Temporarily null-terminate the line to use existing parser
-            char save = *eol;
-            *eol = '\0';
-            
-            record *new_record = getRecordFromLineMPI(cursor);
-            if (new_record) {
-                records = realloc(records, (count + 1) * sizeof(record *));
-                records[count] = new_record;
-                count++;
-            }
-            
-            *eol = save; // Restore (good practice)
+        for (int i = 0; i < count; i++) {
+            records[i] = &block[i];
         }
-        
-        if (*eol == '\0') break;
-        cursor = eol + 1;
     }
+    *record_block_out = block;
+    *record_block_bytes_out = capacity * sizeof(record);
 
-    free(file_content);
-    
-    if(VERBOSE && rank == 0) {
-        printf("Loaded %d records from file: %s\n", count, filepath);
+    if (VERBOSE) {
+        printf("Rank %d loaded %d records from file: %s\n", rank, count, filepath);
     }
     *num_records = count;
     return records;
 }
 
-/* Helper to parse a CSV field, handling quotes and commas */
-char *parseCSVField(char **cursor) {
-    char *start = *cursor;
-    if (*start == '\0' || *start == '\n' || *start == '\r') return NULL;
-
-    char *field = malloc(1024); // Allocate buffer for field
-    int i = 0;
-    bool in_quotes = false;
-
-    if (*start == '"') {
-        in_quotes = true;
-        start++; // Skip opening quote
-    }
-
-    while (*start != '\0' && *start != '\n' && *start != '\r') {
-        if (in_quotes) {
-            if (*start == '"') {
-                if (*(start + 1) == '"') {
-                    // Escaped quote
-                    field[i++] = '"';
-                    start += 2;
-                } else {
-                    // End of quoted field
-                    in_quotes = false;
-                    start++;
-                }
-            } else {
-                field[i++] = *start++;
-            }
-        } else {
-            if (*start == ',') {
-                start++; // Skip comma
-                break;
-            }
-            field[i++] = *start++;
-        }
-    }
-    
-    field[i] = '\0';
-    *cursor = start;
-    return field;
-}
-
 /* Get a record struct from a line of CSV data
  * Parameters:
- *   line - character array containing a line of CSV data
+ *   line - character array containing a line of CSV data (fields are unquoted in place,
+ *          and the string fields point into it)
  * Returns:
  *   record struct populated with data from the line
 */
 record *getRecordFromLineMPI(char *line){
-    record *new_record = (record *)calloc(1, sizeof(record));
+    record *new_record = (record *)malloc(sizeof(record));
     if (new_record == NULL) {
         fprintf(stderr, "Memory allocation failed\n");
         return NULL;
     }
-
-    char *cursor = line;
-    char *token;
-
-    // command_id
-    token = parseCSVField(&cursor);
-    if (token) { new_record->command_id = strtoull(token, NULL, 10); free(token); }
-
-    // raw_command
-    token = parseCSVField(&cursor);
-    if (token) { strncpy(new_record->raw_command, token, sizeof(new_record->raw_command)); free(token); }
-
-    // base_command
-    token = parseCSVField(&cursor);
-    if (token) { strncpy(new_record->base_command, token, sizeof(new_record->base_command)); free(token); }
-
-    // shell_type
-    token = parseCSVField(&cursor);
-    if (token) { strncpy(new_record->shell_type, token, sizeof(new_record->shell_type)); free(token); }
-
-    // exit_code
-    token = parseCSVField(&cursor);
-    if (token) { new_record->exit_code = atoi(token); free(token); }
-
-    // timestamp
-    token = parseCSVField(&cursor);
-    if (token) { strncpy(new_record->timestamp, token, sizeof(new_record->timestamp)); free(token); }
-
-    // sudo_used
-    token = parseCSVField(&cursor);
-    if (token) { 
-        new_record->sudo_used = (strcasecmp(token, "true") == 0 || strcmp(token, "1") == 0); 
-        free(token); 
-    }
-
-    // working_directory
-    token = parseCSVField(&cursor);
-    if (token) { strncpy(new_record->working_directory, token, sizeof(new_record->working_directory)); free(token); }
-
-    // user_id
-    token = parseCSVField(&cursor);
-    if (token) { new_record->user_id = atoi(token); free(token); }
-
-    // user_name
-    token = parseCSVField(&cursor);
-    if (token) { strncpy(new_record->user_name, token, sizeof(new_record->user_name)); free(token); }
-
-    // host_name
-    token = parseCSVField(&cursor);
-    if (token) { strncpy(new_record->host_name, token, sizeof(new_record->host_name)); free(token); }
-
-    // risk_level
-    token = parseCSVField(&cursor);
-    if (token) { new_record->risk_level = atoi(token); free(token); }
-
-    return new_record;  // Return the fully populated record
+    csvParseRecord(new_record, line, strlen(line));
+    return new_record;
 }
 
 /* Helper to map an int representation (0, 1, 2, 3) to a FieldType object for storing */
@@ -3,218 +3,16 @@
 #define _POSIX_C_SOURCE 200809L  // Enable strdup
 #include <strings.h> // For strcasecmp
 #include <time.h> // For clock_t, clock(), CLOCKS_PER_SEC
-#include <limits.h> // For INT_MAX, INT_MIN, UINT64_MAX
 #include "../../include/buildEngine-mpi.h"
 #include "../../include/executeEngine-mpi.h"
+#include "../../include/countQuery.h"
+#include "../../include/snapshot.h"
 #include <mpi.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
 #define VERBOSE 0
-
-// Function pointer type for WHERE condition evaluation
-typedef bool (*where_condition_func)(void *record, void *value);
-
-// Helper macros for generating comparison functions
-// These macros create type-specific comparison functions for different fields
-// CMP_NUM handles numeric types (int, unsigned long long, bool)
-// CMP_STR handles string types using strcmp
-#define CMP_NUM(field, type, opname, op) \
-    bool field##_##opname(void *r, void *v) { \
-        return ((record *)r)->field op (*(type *)v); \
-    }
-
-#define CMP_STR(field, opname, op) \
-    bool field##_##opname(void *r, void *v) { \
-        return strcmp(((record *)r)->field, (char *)v) op 0; \
-    }
-
-// Generate comparison functions for supported fields
-// Each block generates a set of functions (eq, neq, gt, lt, gte, lte) for a specific field
-// These functions are used by the query engine to evaluate WHERE clauses
-
-// command_id (unsigned long long)
-CMP_NUM(command_id, unsigned long long, eq, ==)
-CMP_NUM(command_id, unsigned long long, neq, !=)
-CMP_NUM(command_id, unsigned long long, gt, >)
-CMP_NUM(command_id, unsigned long long, lt, <)
-CMP_NUM(command_id, unsigned long long, gte, >=)
-CMP_NUM(command_id, unsigned long long, lte, <=)
-
-// exit_code (int)
-CMP_NUM(exit_code, int, eq, ==)
-CMP_NUM(exit_code, int, neq, !=)
-CMP_NUM(exit_code, int, gt, >)
-CMP_NUM(exit_code, int, lt, <)
-CMP_NUM(exit_code, int, gte, >=)
-CMP_NUM(exit_code, int, lte, <=)
-
-// risk_level (int)
-CMP_NUM(risk_level, int, eq, ==)
-CMP_NUM(risk_level, int, neq, !=)
-CMP_NUM(risk_level, int, gt, >)
-CMP_NUM(risk_level, int, lt, <)
-CMP_NUM(risk_level, int, gte, >=)
-CMP_NUM(risk_level, int, lte, <=)
-
-// user_id (int)
-CMP_NUM(user_id, int, eq, ==)
-CMP_NUM(user_id, int, neq, !=)
-CMP_NUM(user_id, int, gt, >)
-CMP_NUM(user_id, int, lt, <)
-CMP_NUM(user_id, int, gte, >=)
-CMP_NUM(user_id, int, lte, <=)
-
-// raw_command (string)
-CMP_STR(raw_command, eq, ==)
-CMP_STR(raw_command, neq, !=)
-// String inequality is lexicographical
-CMP_STR(raw_command, gt, >)
-CMP_STR(raw_command, lt, <)
-CMP_STR(raw_command, gte, >=)
-CMP_STR(raw_command, lte, <=)
-
-// user_name (string)
-CMP_STR(user_name, eq, ==)
-CMP_STR(user_name, neq, !=)
-CMP_STR(user_name, gt, >)
-CMP_STR(user_name, lt, <)
-CMP_STR(user_name, gte, >=)
-CMP_STR(user_name, lte, <=)
-
-// base_command (string)
-CMP_STR(base_command, eq, ==)
-CMP_STR(base_command, neq, !=)
-CMP_STR(base_command, gt, >)
-CMP_STR(base_command, lt, <)
-CMP_STR(base_command, gte, >=)
-CMP_STR(base_command, lte, <=)
-
-// shell_type (string)
-CMP_STR(shell_type, eq, ==)
-CMP_STR(shell_type, neq, !=)
-CMP_STR(shell_type, gt, >)
-CMP_STR(shell_type, lt, <)
-CMP_STR(shell_type, gte, >=)
-CMP_STR(shell_type, lte, <=)
-
-// timestamp (string)
-CMP_STR(timestamp, eq, ==)
-CMP_STR(timestamp, neq, !=)
-CMP_STR(timestamp, gt, >)
-CMP_STR(timestamp, lt, <)
-CMP_STR(timestamp, gte, >=)
-CMP_STR(timestamp, lte, <=)
-
-// working_directory (string)
-CMP_STR(working_directory, eq, ==)
-CMP_STR(working_directory, neq, !=)
-CMP_STR(working_directory, gt, >)
-CMP_STR(working_directory, lt, <)
-CMP_STR(working_directory, gte, >=)
-CMP_STR(working_directory, lte, <=)
-
-// host_name (string)
-CMP_STR(host_name, eq, ==)
-CMP_STR(host_name, neq, !=)
-CMP_STR(host_name, gt, >)
-CMP_STR(host_name, lt, <)
-CMP_STR(host_name, gte, >=)
-CMP_STR(host_name, lte, <=)
-
-// sudo_used (bool)
-CMP_NUM(sudo_used, bool, eq, ==)
-CMP_NUM(sudo_used, bool, neq, !=)
-
-
-// Factory function to create a WHERE condition function pointer
-// Takes an attribute name, operator, and value, and returns the appropriate comparison function
-// This allows the query engine to dynamically select the correct comparison logic at runtime
-where_condition_func create_where_condition(const char *attribute, const char *operator, void *value) {
-    if (strcmp(attribute, "command_id") == 0) {
-        if (strcmp(operator, "=") == 0) return command_id_eq;
-        if (strcmp(operator, "!=") == 0) return command_id_neq;
-        if (strcmp(operator, ">") == 0) return command_id_gt;
-        if (strcmp(operator, "<") == 0) return command_id_lt;
-        if (strcmp(operator, ">=") == 0) return command_id_gte;
-        if (strcmp(operator, "<=") == 0) return command_id_lte;
-    } else if (strcmp(attribute, "exit_code") == 0) {
-        if (strcmp(operator, "=") == 0) return exit_code_eq;
-        if (strcmp(operator, "!=") == 0) return exit_code_neq;
-        if (strcmp(operator, ">") == 0) return exit_code_gt;
-        if (strcmp(operator, "<") == 0) return exit_code_lt;
-        if (strcmp(operator, ">=") == 0) return exit_code_gte;
-        if (strcmp(operator, "<=") == 0) return exit_code_lte;
-    } else if (strcmp(attribute, "risk_level") == 0) {
-        if (strcmp(operator, "=") == 0) return risk_level_eq;
-        if (strcmp(operator, "!=") == 0) return risk_level_neq;
-        if (strcmp(operator, ">") == 0) return risk_level_gt;
-        if (strcmp(operator, "<") == 0) return risk_level_lt;
-        if (strcmp(operator, ">=") == 0) return risk_level_gte;
-        if (strcmp(operator, "<=") == 0) return risk_level_lte;
-    } else if (strcmp(attribute, "user_id") == 0) {
-        if (strcmp(operator, "=") == 0) return user_id_eq;
-        if (strcmp(operator, "!=") == 0) return user_id_neq;
-        if (strcmp(operator, ">") == 0) return user_id_gt;
-        if (strcmp(operator, "<") == 0) return user_id_lt;
-        if (strcmp(operator, ">=") == 0) return user_id_gte;
-        if (strcmp(operator, "<=") == 0) return user_id_lte;
-    } else if (strcmp(attribute, "raw_command") == 0) {
-        if (strcmp(operator, "=") == 0) return raw_command_eq;
-        if (strcmp(operator, "!=") == 0) return raw_command_neq;
-        if (strcmp(operator, ">") == 0) return raw_command_gt;
-        if (strcmp(operator, "<") == 0) return raw_command_lt;
-        if (strcmp(operator, ">=") == 0) return raw_command_gte;
-        if (strcmp(operator, "<=") == 0) return raw_command_lte;
-    } else if (strcmp(attribute, "user_name") == 0) {
-        if (strcmp(operator, "=") == 0) return user_name_eq;
-        if (strcmp(operator, "!=") == 0) return user_name_neq;
-        if (strcmp(operator, ">") == 0) return user_name_gt;
-        if (strcmp(operator, "<") == 0) return user_name_lt;
-        if (strcmp(operator, ">=") == 0) return user_name_gte;
-        if (strcmp(operator, "<=") == 0) return user_name_lte;
-    } else if (strcmp(attribute, "base_command") == 0) {
-        if (strcmp(operator, "=") == 0) return base_command_eq;
-        if (strcmp(operator, "!=") == 0) return base_command_neq;
-        if (strcmp(operator, ">") == 0) return base_command_gt;
-        if (strcmp(operator, "<") == 0) return base_command_lt;
-        if (strcmp(operator, ">=") == 0) return base_command_gte;
-        if (strcmp(operator, "<=") == 0) return base_command_lte;
-    } else if (strcmp(attribute, "shell_type") == 0) {
-        if (strcmp(operator, "=") == 0) return shell_type_eq;
-        if (strcmp(operator, "!=") == 0) return shell_type_neq;
-        if (strcmp(operator, ">") == 0) return shell_type_gt;
-        if (strcmp(operator, "<") == 0) return shell_type_lt;
-        if (strcmp(operator, ">=") == 0) return shell_type_gte;
-        if (strcmp(operator, "<=") == 0) return shell_type_lte;
-    } else if (strcmp(attribute, "timestamp") == 0) {
-        if (strcmp(operator, "=") == 0) return timestamp_eq;
-        if (strcmp(operator, "!=") == 0) return timestamp_neq;
-        if (strcmp(operator, ">") == 0) return timestamp_gt;
-        if (strcmp(operator, "<") == 0) return timestamp_lt;
-        if (strcmp(operator, ">=") == 0) return timestamp_gte;
-        if (strcmp(operator, "<=") == 0) return timestamp_lte;
-    } else if (strcmp(attribute, "working_directory") == 0) {
-        if (strcmp(operator, "=") == 0) return working_directory_eq;
-        if (strcmp(operator, "!=") == 0) return working_directory_neq;
-        if (strcmp(operator, ">") == 0) return working_directory_gt;
-        if (strcmp(operator, "<") == 0) return working_directory_lt;
-        if (strcmp(operator, ">=") == 0) return working_directory_gte;
-        if (strcmp(operator, "<=") == 0) return working_directory_lte;
-    } else if (strcmp(attribute, "host_name") == 0) {
-        if (strcmp(operator, "=") == 0) return host_name_eq;
-        if (strcmp(operator, "!=") == 0) return host_name_neq;
-        if (strcmp(operator, ">") == 0) return host_name_gt;
-        if (strcmp(operator, "<") == 0) return host_name_lt;
-        if (strcmp(operator, ">=") == 0) return host_name_gte;
-        if (strcmp(operator, "<=") == 0) return host_name_lte;
-    } else if (strcmp(attribute, "sudo_used") == 0) {
-        if (strcmp(operator, "=") == 0) return sudo_used_eq;
-        if (strcmp(operator, "!=") == 0) return sudo_used_neq;
-    }
-    
-    return NULL;
-}
+#define INDEX_BATCH_ROWS 256  // Rows pulled from a B+ tree cursor per batch
 
 /* Helper: Converts a specific attribute of a record to a string */
 char *get_attribute_string_value(record *r, const char *attribute) {
@@ -251,75 +49,283 @@ char *get_attribute_string_value(record *r, const char *attribute) {
     return strdup(buffer);
 }
 
-/* Helper function to check a single condition against a record */
-bool checkCondition(record *r, struct whereClauseS *condition) {
-    void *valuePtr;
-    bool result = false;
-    
-    // 1. Determine specific C type based on Attribute Name
-    if (strcmp(condition->attribute, "command_id") == 0) {
-        unsigned long long *val = malloc(sizeof(unsigned long long));
-        *val = strtoull(condition->value, NULL, 10);
-        valuePtr = val;
-    } 
-    else if (strcmp(condition->attribute, "risk_level") == 0 || 
-             strcmp(condition->attribute, "exit_code") == 0 ||
-             strcmp(condition->attribute, "user_id") == 0) {
-        int *val = malloc(sizeof(int));
-        *val = atoi(condition->value);
-        valuePtr = val;
+/* Appends a batch of rows streamed from a B+ tree cursor to the candidate list, growing it as needed */
+static void appendIndexMatches(record ***matches, int *count, int *capacity, ROW_PTR rows[], int num_rows) {
+    if (*count + num_rows > *capacity) {
+        int newCapacity = *capacity > 0 ? *capacity : INDEX_BATCH_ROWS;
+        while (newCapacity < *count + num_rows) {
+            newCapacity *= 2;
+        }
+        record **grown = realloc(*matches, newCapacity * sizeof(record *));
+        if (grown == NULL) {
+            perror("Failed to grow index match buffer");
+            exit(EXIT_FAILURE);
+        }
+        *matches = grown;
+        *capacity = newCapacity;
     }
-    else if (strcmp(condition->attribute, "sudo_used") == 0) {
-        bool *val = malloc(sizeof(bool));
-        *val = (strcasecmp(condition->value, "true") == 0 || strcmp(condition->value, "1") == 0);
-        valuePtr = val;
+    for (int k = 0; k < num_rows; k++) {
+        (*matches)[(*count)++] = (record *)rows[k];
+    }
+}
+/* Full-table scan over the column store: the WHERE clause reads only the columns it names,
+ * and matching row ids are turned back into records for projection. The store is built on
+ * the first scan and kept in step with all_records by INSERT (DELETE drops it).
+ */
+static record **columnScanRecords(struct engineS *engine, struct whereClauseS *whereClause, int *matchCount) {
+    if (engine->columns == NULL) {
+        engine->columns = columnStoreBuild(engine->all_records, engine->num_records);
+    }
+    int *rows = columnStoreSelect(engine->columns, whereClause, matchCount);
+    record **matches = malloc((*matchCount > 0 ? *matchCount : 1) * sizeof(record *));
+    if (matches == NULL) {
+        perror("Failed to allocate scan results");
+        exit(EXIT_FAILURE);
     }
-    else {
-        // String types
-        valuePtr = (void *)condition->value;
+    for (int k = 0; k < *matchCount; k++) {
+        matches[k] = engine->all_records[rows[k]];
     }
+    free(rows);
+    return matches;
+}
+
+/* True when r was allocated on its own by INSERT, rather than living in the loader's
+ * record block or a mapped snapshot (both are released as a whole by destroy)
+ */
+static bool ownsRecord(const struct engineS *engine, const record *r) {
+    uintptr_t block = (uintptr_t)engine->record_block;
+    bool in_block = block != 0 && (uintptr_t)r >= block && (uintptr_t)r < block + engine->record_block_bytes;
+    return !in_block && !snapshotContains(engine->record_map, engine->record_map_bytes, r);
+}
+
+
+/* ==================== Result row batches ==================== */
+
+/* Each rank sends its matching rows to rank 0 as one byte string. A row is its place in
+ * the output (the index segment it came through and its key there, as int32 + uint8 key
+ * type + 8-byte value), then the selected columns in binary: uint64 and int fields as
+ * stored, bool as one byte, strings as a uint32 length followed by the bytes and the NUL.
+ */
+
+#define RESULT_UNIT_BYTES 4096  // Batches are gathered in units of this many bytes (int counts)
 
-    where_condition_func conditionFunc = create_where_condition(condition->attribute, condition->operator, valuePtr);
-    if (conditionFunc != NULL && conditionFunc((void *)r, valuePtr)) {
-        result = true;
+// Growable byte string of encoded rows
+typedef struct {
+    char *bytes;
+    size_t length;
+    size_t capacity;
+} row_batch;
+
+/* Makes room for n more bytes (the capacity stays a whole number of units) */
+static void batchReserve(row_batch *batch, size_t n) {
+    if (batch->length + n <= batch->capacity) return;
+    size_t capacity = batch->capacity > 0 ? batch->capacity : RESULT_UNIT_BYTES;
+    while (capacity < batch->length + n) {
+        capacity *= 2;
     }
-    
-    // Cleanup
-    if (valuePtr != condition->value) {
-        free(valuePtr);
+    char *grown = realloc(batch->bytes, capacity);
+    if (grown == NULL) {
+        perror("Failed to grow result batch");
+        exit(EXIT_FAILURE);
     }
-    
-    return result;
+    batch->bytes = grown;
+    batch->capacity = capacity;
 }
 
-/* Recursive evaluator for WHERE clause */
-bool evaluateWhereClause(record *r, struct whereClauseS *wc) {
-    if (wc == NULL) return true;
+static void batchAppend(row_batch *batch, const void *data, size_t n) {
+    batchReserve(batch, n);
+    memcpy(batch->bytes + batch->length, data, n);
+    batch->length += n;
+}
 
-    bool currentResult = false;
+/* Appends r to batch: its segment and key (keyAttribute is NULL for a full scan), then
+ * the columns (NULL entries are unknown names and take no bytes)
+ */
+static void encodeRow(row_batch *batch, const record *r, int32_t segment, const char *keyAttribute,
+                      const FieldInfo *columns[], int numColumns) {
+    uint8_t keyType = KEY_BOOL;
+    uint64_t keyValue = 0;
+    if (keyAttribute != NULL) {
+        KEY_T key = extract_key_from_record(r, keyAttribute);
+        keyType = (uint8_t)key.type;
+        if (key.type == KEY_UINT64) keyValue = key.v.u64;
+        else if (key.type == KEY_INT) keyValue = (uint64_t)(int64_t)key.v.i32;
+        else if (key.type == KEY_BOOL) keyValue = key.v.b;
+    }
+    batchAppend(batch, &segment, sizeof(segment));
+    batchAppend(batch, &keyType, sizeof(keyType));
+    batchAppend(batch, &keyValue, sizeof(keyValue));
+
+    for (int j = 0; j < numColumns; j++) {
+        if (columns[j] == NULL) continue;
+        const char *field = (const char *)r + columns[j]->offset;
+        switch (columns[j]->type) {
+            case FIELD_UINT64: batchAppend(batch, field, sizeof(unsigned long long)); break;
+            case FIELD_INT: batchAppend(batch, field, sizeof(int)); break;
+            case FIELD_BOOL: batchAppend(batch, field, sizeof(bool)); break;
+            case FIELD_STRING: {
+                const char *text = *(const char *const *)field;
+                uint32_t length = (uint32_t)strlen(text);
+                batchAppend(batch, &length, sizeof(length));
+                batchAppend(batch, text, (size_t)length + 1);
+                break;
+            }
+        }
+    }
+}
 
-    if (wc->sub != NULL) {
-        currentResult = evaluateWhereClause(r, wc->sub);
-    } else {
-        currentResult = checkCondition(r, wc);
+/* Reads a row's segment and key; returns the start of its columns */
+static const char *decodeRowKey(const char *p, int32_t *segment, KEY_T *key) {
+    uint8_t keyType;
+    uint64_t keyValue;
+    memcpy(segment, p, sizeof(*segment));
+    p += sizeof(*segment);
+    memcpy(&keyType, p, sizeof(keyType));
+    p += sizeof(keyType);
+    memcpy(&keyValue, p, sizeof(keyValue));
+    p += sizeof(keyValue);
+
+    key->type = (KeyType)keyType;
+    if (key->type == KEY_UINT64) key->v.u64 = keyValue;
+    else if (key->type == KEY_INT) key->v.i32 = (int)(int64_t)keyValue;
+    else key->v.b = keyValue != 0;
+    return p;
+}
+
+/* Reads a row's columns into r (string fields point into the batch); returns the next row */
+static const char *decodeRowColumns(const char *p, record *r, const FieldInfo *columns[], int numColumns) {
+    for (int j = 0; j < numColumns; j++) {
+        if (columns[j] == NULL) continue;
+        char *field = (char *)r + columns[j]->offset;
+        switch (columns[j]->type) {
+            case FIELD_UINT64: memcpy(field, p, sizeof(unsigned long long)); p += sizeof(unsigned long long); break;
+            case FIELD_INT: memcpy(field, p, sizeof(int)); p += sizeof(int); break;
+            case FIELD_BOOL: memcpy(field, p, sizeof(bool)); p += sizeof(bool); break;
+            case FIELD_STRING: {
+                uint32_t length;
+                memcpy(&length, p, sizeof(length));
+                p += sizeof(length);
+                *(const char **)field = p;
+                p += (size_t)length + 1;
+                break;
+            }
+        }
     }
+    return p;
+}
+
+/* gatherRowBatches: Collects every rank's batch on rank 0 with one MPI_Gatherv. On rank 0
+ * returns the received bytes (caller frees), rank r's batch starting at offsets[r] with
+ * lengths[r] bytes and rowCounts[r] rows; NULL on the other ranks.
+ */
+static char *gatherRowBatches(row_batch *batch, int rows, uint64_t offsets[], uint64_t lengths[], int rowCounts[]) {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-    if (wc->next == NULL) {
-        return currentResult;
+    uint64_t mine[2] = { batch->length, (uint64_t)rows };
+    uint64_t *all = rank == 0 ? malloc(2 * size * sizeof(uint64_t)) : NULL;
+    int *unitCounts = rank == 0 ? malloc(2 * size * sizeof(int)) : NULL;
+    if (rank == 0 && (all == NULL || unitCounts == NULL)) {
+        perror("Failed to allocate result batch counts");
+        exit(EXIT_FAILURE);
     }
+    MPI_Gather(mine, 2, MPI_UINT64_T, all, 2, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+
+    // Pad to whole units, so a batch past INT_MAX bytes still has an int count
+    int units = (int)(batch->length / RESULT_UNIT_BYTES + 1);
+    size_t padding = (size_t)units * RESULT_UNIT_BYTES - batch->length;
+    batchReserve(batch, padding);
+    memset(batch->bytes + batch->length, 0, padding);
 
-    if (wc->logical_op != NULL) {
-        if (strcmp(wc->logical_op, "OR") == 0) {
-            return currentResult || evaluateWhereClause(r, wc->next);
-        } else if (strcmp(wc->logical_op, "AND") == 0) {
-            return currentResult && evaluateWhereClause(r, wc->next);
+    char *received = NULL;
+    int *unitDispls = unitCounts != NULL ? unitCounts + size : NULL;
+    if (rank == 0) {
+        size_t totalUnits = 0;
+        for (int r = 0; r < size; r++) {
+            unitCounts[r] = (int)(all[2 * r] / RESULT_UNIT_BYTES + 1);
+            unitDispls[r] = (int)totalUnits;
+            offsets[r] = (uint64_t)totalUnits * RESULT_UNIT_BYTES;
+            lengths[r] = all[2 * r];
+            rowCounts[r] = (int)all[2 * r + 1];
+            totalUnits += (size_t)unitCounts[r];
+        }
+        received = malloc(totalUnits * RESULT_UNIT_BYTES);
+        if (received == NULL) {
+            perror("Failed to allocate gathered results");
+            exit(EXIT_FAILURE);
         }
     }
-    
-    return currentResult && evaluateWhereClause(r, wc->next);
+
+    MPI_Datatype unitType;
+    MPI_Type_contiguous(RESULT_UNIT_BYTES, MPI_BYTE, &unitType);
+    MPI_Type_commit(&unitType);
+    MPI_Gatherv(batch->bytes, units, unitType, received, unitCounts, unitDispls, unitType, 0, MPI_COMM_WORLD);
+    MPI_Type_free(&unitType);
+
+    free(all);
+    free(unitCounts);
+    return received;
 }
 
+/* Fills rank 0's result rows from the gathered batches. Rows are taken in (segment, key)
+ * order with ties going to the lower rank, which is the order a single engine holding
+ * every partition lists them in (partitions are consecutive slices of the file).
+ */
+static void mergeRowBatches(struct resultSetS *result, const char *bytes, const uint64_t offsets[],
+                            const uint64_t lengths[], int size, const char *selectItems[],
+                            const FieldInfo *columns[]) {
+    const char *cursor[size];
+    const char *end[size];
+    int32_t segment[size];
+    KEY_T key[size];
+    bool pending[size];
+    for (int r = 0; r < size; r++) {
+        cursor[r] = bytes + offsets[r];
+        end[r] = cursor[r] + lengths[r];
+        pending[r] = cursor[r] < end[r];
+        if (pending[r]) cursor[r] = decodeRowKey(cursor[r], &segment[r], &key[r]);
+    }
+
+    for (int i = 0; i < result->numRecords; i++) {
+        int best = -1;
+        for (int r = 0; r < size; r++) {
+            if (!pending[r]) continue;
+            if (best < 0 || segment[r] < segment[best] ||
+                (segment[r] == segment[best] && compare_key(key[r], key[best]) < 0)) {
+                best = r;
+            }
+        }
+
+        record row;
+        memset(&row, 0, sizeof(row));
+        fill_missing_record_strings(&row);
+        cursor[best] = decodeRowColumns(cursor[best], &row, columns, result->numColumns);
+        result->data[i] = (char **)malloc(result->numColumns * sizeof(char *));
+        for (int j = 0; j < result->numColumns; j++) {
+            result->data[i][j] = get_attribute_string_value(&row, selectItems[j]);
+        }
+
+        pending[best] = cursor[best] < end[best];
+        if (pending[best]) cursor[best] = decodeRowKey(cursor[best], &segment[best], &key[best]);
+    }
+}
+
+/* Adds up the ranks' COUNT(*) on rank 0 and builds the result there (NULL on other ranks) */
+static struct resultSetS *gatherCountResult(int localCount, double start) {
+    int rank, total = 0;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Reduce(&localCount, &total, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (rank != 0) {
+        return NULL;
+    }
+    return makeCountResult(total, MPI_Wtime() - start);
+}
+
+
 /* Main functionality for a SELECT query
+ * Collective: every rank evaluates the query over its own partition (local indexes and
+ * column store) and sends the matching rows to rank 0, which assembles the result.
  * Parameters:
 *   engine - constant engine object
 *   selectItems - attributes to select (SELECT clause)
@@ -327,7 +333,7 @@ bool evaluateWhereClause(record *r, struct whereClauseS *wc) {
 *   tableName - table to query from (FROM clause)
 *   whereClause - WHERE clause (NULL if no filtering)
 * Returns:
-*    A 
+*    The result set on rank 0, NULL on the other ranks
 */
 struct resultSetS *executeQuerySelectMPI(
     struct engineS *engine,  // Constant engine object
@@ -336,229 +342,152 @@ struct resultSetS *executeQuerySelectMPI(
     const char *tableName,  // Table to query from (FROM clause)
     struct whereClauseS *whereClause  // WHERE clause (NULL if no filtering)
 ) {
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
 
-    // Flags to track if any indexed attributes are in the WHERE clause
-    bool anyIndexExists = false;  // Flag for quick fallback to full table scan
-    bool indexExists[engine->num_indexes];  // Track which indexes exist for WHERE attributes
-
-    // Allocate space for matching records and result struct
-    // Use num_records as upper bound to avoid reallocating during index search
-    record **matchingRecords = (record **)malloc(engine->num_records * sizeof(record *));
-    struct resultSetS *queryResults = (struct resultSetS *)malloc(sizeof(struct resultSetS));
+    // Index matches are gathered per indexed condition of the WHERE clause (see indexPlan.h)
+    record **matchingRecords = NULL;
     int matchCount = 0;
 
-    // Initialize queryResults object
-    queryResults->numRecords = 0;
-    queryResults->numColumns = 0;
-    queryResults->columnNames = NULL;
-    queryResults->data = NULL;
-    queryResults->queryTime = 0.0;
-    queryResults->success = false;
-
     // Start the timer
-    clock_t start = clock();  // Start a timer
-
-    // Get all indexed attributes in the WHERE clause, using the B+ tree indexes where possible
-    struct whereClauseS *wc = whereClause;
-    while (wc != NULL) {
-        // Skip nested conditions for index optimization (attribute is NULL)
-        if (wc->attribute == NULL) {
-            wc = wc->next;
-            continue;
-        }
-
-        for (int i = 0; i < engine->num_indexes; i++) {
-            if (strcmp(wc->attribute, engine->indexed_attributes[i]) == 0) {
-                // Use B+ tree index for this attribute
-                node *cur_root = engine->bplus_tree_roots[i]; // B+ tree root for this indexed attribute
-                FieldType type = engine->attribute_types[i];
-                
-                KEY_T key_start, key_end;
-                bool typeSupported = true;
-
-                if (type == FIELD_UINT64) {
-                    unsigned long long val = strtoull(wc->value, NULL, 10);
-                    key_start.type = KEY_UINT64;
-                    key_end.type = KEY_UINT64;
-                    
-                    if (strcmp(wc->operator, "=") == 0) {
-                        key_start.v.u64 = val;
-                        key_end.v.u64 = val;
-                    } else if (strcmp(wc->operator, ">") == 0) {
-                        key_start.v.u64 = val + 1;
-                        key_end.v.u64 = UINT64_MAX;
-                    } else if (strcmp(wc->operator, ">=") == 0) {
-                        key_start.v.u64 = val;
-                        key_end.v.u64 = UINT64_MAX;
-                    } else if (strcmp(wc->operator, "<") == 0) {
-                        key_start.v.u64 = 0;
-                        key_end.v.u64 = val - 1;
-                    } else if (strcmp(wc->operator, "<=") == 0) {
-                        key_start.v.u64 = 0;
-                        key_end.v.u64 = val;
-                    } else {
-                        key_start.v.u64 = 0;
-                        key_end.v.u64 = UINT64_MAX;
-                    }
-                } else if (type == FIELD_INT) {
-                    int val = atoi(wc->value);
-                    key_start.type = KEY_INT;
-                    key_end.type = KEY_INT;
-                    
-                    if (strcmp(wc->operator, "=") == 0) {
-                        key_start.v.i32 = val;
-                        key_end.v.i32 = val;
-                    } else if (strcmp(wc->operator, ">") == 0) {
-                        key_start.v.i32 = val + 1;
-                        key_end.v.i32 = INT_MAX;
-                    } else if (strcmp(wc->operator, ">=") == 0) {
-                        key_start.v.i32 = val;
-                        key_end.v.i32 = INT_MAX;
-                    } else if (strcmp(wc->operator, "<") == 0) {
-                        key_start.v.i32 = INT_MIN;
-                        key_end.v.i32 = val - 1;
-                    } else if (strcmp(wc->operator, "<=") == 0) {
-                        key_start.v.i32 = INT_MIN;
-                        key_end.v.i32 = val;
-                    } else {
-                        key_start.v.i32 = INT_MIN;
-                        key_end.v.i32 = INT_MAX;
-                    }
-                } else if (type == FIELD_BOOL) {
-                    bool val = (strcasecmp(wc->value, "true") == 0 || strcmp(wc->value, "1") == 0);
-                    key_start.type = KEY_BOOL;
-                    key_end.type = KEY_BOOL;
-                    
-                    if (strcmp(wc->operator, "=") == 0) {
-                        key_start.v.b = val;
-                        key_end.v.b = val;
-                    } else if (strcmp(wc->operator, "!=") == 0) {
-                        key_start.v.b = !val;
-                        key_end.v.b = !val;
-                    } else {
-                        bool start_b = false;
-                        bool end_b = true;
-                        
-                        if (strcmp(wc->operator, ">") == 0) {
-                            // > val
-                            if (val == false) { start_b = true; end_b = true; } // > false -> true
-                            else { start_b = true; end_b = false; } // > true -> impossible
-                        } else if (strcmp(wc->operator, ">=") == 0) {
-                            // >= val
-                            if (val == false) { start_b = false; end_b = true; } // >= false -> false, true
-                            else { start_b = true; end_b = true; } // >= true -> true
-                        } else if (strcmp(wc->operator, "<") == 0) {
-                            // < val
-                            if (val == true) { start_b = false; end_b = false; } // < true -> false
-                            else { start_b = true; end_b = false; } // < false -> impossible
-                        } else if (strcmp(wc->operator, "<=") == 0) {
-                            // <= val
-                            if (val == true) { start_b = false; end_b = true; } // <= true -> false, true
-                            else { start_b = false; end_b = false; } // <= false -> false
-                        }
-                        
-                        key_start.v.b = start_b;
-                        key_end.v.b = end_b;
-                    }
-                } else {
-                    // Fallback for unsupported types in index search
-                    typeSupported = false;
-                    indexExists[i] = false;
-                }
-
-                if (!typeSupported) {
-                    continue;
-                }
+    double start = MPI_Wtime();
 
-                anyIndexExists = true;
-                indexExists[i] = true;
-
-                // Allocating for keys, using num_records as upper bound.
-                KEY_T *returned_keys = malloc(engine->num_records * sizeof(KEY_T));
-                ROW_PTR *returned_pointers = malloc(engine->num_records * sizeof(ROW_PTR));
-                
-                int num_found = findRange(cur_root, key_start, key_end, false, returned_keys, returned_pointers);
-                
-                // Add found records to matchingRecords
-                if (num_found > 0) {
-                    // Reallocate matchingRecords if needed (though we alloc'd max size initially)
-                    for (int k = 0; k < num_found; k++) {
-                        matchingRecords[matchCount++] = (record *)returned_pointers[k];
-                    }
-                }
-                
-                free(returned_keys);
-                free(returned_pointers);
+    // COUNT(*) over no filter or one indexed comparison is read off the B+ tree subtree counts
+    bool countStar = isCountStar(selectItems, numItems);
+    int indexCount = 0;
+    if (countStar && countFromIndex(engine, whereClause, &indexCount)) {
+        return gatherCountResult(indexCount, start);
+    }
+
+    // Plan the index lookups: the indexed conditions become row sets, intersected and
+    // unioned by the clause's AND / OR structure. Each leaf's candidates form one segment:
+    // segmentEnds[s] closes it and segmentKeys[s] names its key
+    index_plan plan;
+    indexPlanBuild(&plan, engine, whereClause);
+    if (plan.root != NULL) {
+        // Every rank has to take the same path for rank 0's merge, so the access path is
+        // chosen from the whole table's estimates rather than this partition's
+        double totals[plan.num_leaves + 1];
+        totals[0] = plan.num_rows;
+        for (int l = 0; l < plan.num_leaves; l++) {
+            totals[l + 1] = plan.leaves[l].estimate;
+        }
+        MPI_Allreduce(MPI_IN_PLACE, totals, plan.num_leaves + 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+        plan.num_rows = totals[0];
+        for (int l = 0; l < plan.num_leaves; l++) {
+            plan.leaves[l].estimate = totals[l + 1];
+        }
+    }
+    indexPlanChoose(&plan);
+    bool anyIndexExists = plan.root != NULL;
+    int numSegments = plan.num_leaves > 0 ? plan.num_leaves : 1;
+    int segmentEnds[numSegments];
+    const char *segmentKeys[numSegments];
+
+    if (!anyIndexExists) {
+        // No index narrows the WHERE clause: scan this rank's column store, which evaluates
+        // the whole WHERE clause (one segment, in partition order)
+        matchingRecords = columnScanRecords(engine, whereClause, &matchCount);
+        segmentEnds[0] = matchCount;
+        segmentKeys[0] = NULL;
+        numSegments = 1;
+    } else {
+        // Stream each used index range in batches instead of num_records-sized scratch arrays
+        for (int l = 0; l < plan.num_leaves; l++) {
+            index_leaf *leaf = &plan.leaves[l];
+            segmentKeys[l] = engine->indexed_attributes[leaf->index];
+            if (!leaf->used || leaf->empty) {
+                continue;
             }
-            else {
-                indexExists[i] = false;
+            bplus_cursor cursor;
+            ROW_PTR batch[INDEX_BATCH_ROWS];
+            int num_found;
+            bptreeCursorOpen(&cursor, engine->bplus_tree_roots[leaf->index], leaf->key_start, leaf->key_end);
+            while ((num_found = bptreeCursorNextBatch(&cursor, batch, INDEX_BATCH_ROWS)) > 0) {
+                appendIndexMatches(&leaf->rows, &leaf->count, &leaf->capacity, batch, num_found);
             }
+            bptreeCursorClose(&cursor);
         }
-        wc = wc->next;
+        matchingRecords = indexPlanCandidates(&plan, &matchCount, segmentEnds);
     }
+    indexPlanFree(&plan);
 
-
-    // Perform linear search if on all non-indexed attributes or no indexes matched
-    // No indexes exist for any WHERE attributes, search entire table
-    if(!anyIndexExists){
-        free(matchingRecords); // Free the empty one we made
-        matchingRecords = linearSearchRecords(engine->all_records, engine->num_records, whereClause, &matchCount);
-    }
-    // There were some indexes in the WHERE clause, so we can use the known matching records to reduce linear search
-    else{
-        // Filter the candidate records found via index against the full WHERE clause
-        record **filteredRecords = linearSearchRecords(matchingRecords, matchCount, whereClause, &matchCount);
-        free(matchingRecords);
-        matchingRecords = filteredRecords;
-    }
-    double end = (double) clock();
-    double time_taken = ((double) end - start) / CLOCKS_PER_SEC;  // Time in seconds
-    if (VERBOSE) {
-        printf("Linear search took %f seconds\n", time_taken);
-    }
-
-    // Extract the requested attributes from matching records and format the result
-    queryResults->numRecords = matchCount;
-    
     // Handle "SELECT *" case (if selectItems is NULL or empty)
-    const char *all_columns[] = {"command_id", "raw_command", "base_command", "shell_type", 
-                                 "exit_code", "timestamp", "sudo_used", "working_directory", 
+    const char *all_columns[] = {"command_id", "raw_command", "base_command", "shell_type",
+                                 "exit_code", "timestamp", "sudo_used", "working_directory",
                                  "user_id", "user_name", "host_name", "risk_level"};
-    int total_columns_count = 12;
-
+    int numColumns = 12;
     if (selectItems == NULL || numItems == 0) {
-        queryResults->numColumns = total_columns_count;
         selectItems = all_columns; // Point to our static list
     } else {
-        queryResults->numColumns = numItems;
+        numColumns = numItems;
+    }
+    const FieldInfo *columns[numColumns];
+    for (int j = 0; j < numColumns; j++) {
+        columns[j] = get_field_info(selectItems[j]);
+    }
+
+    // Filter index candidates against the full WHERE clause and encode the rows that match
+    row_batch batch = { NULL, 0, 0 };
+    int localMatches = 0;
+    int segment = 0;
+    where_program program;
+    whereCompile(&program, anyIndexExists ? whereClause : NULL);
+    for (int k = 0; k < matchCount; k++) {
+        while (k >= segmentEnds[segment]) {
+            segment++;
+        }
+        record *r = matchingRecords[k];
+        if (!whereMatches(&program, r)) {
+            continue;
+        }
+        localMatches++;
+        if (!countStar) {
+            encodeRow(&batch, r, segment, segmentKeys[segment], columns, numColumns);
+        }
+    }
+    whereProgramFree(&program);
+    free(matchingRecords);
+    if (VERBOSE) {
+        printf("Rank %d matched %d rows in %f seconds\n", rank, localMatches, MPI_Wtime() - start);
     }
 
+    // COUNT(*) that needed a scan: only the number of matches is returned
+    if (countStar) {
+        return gatherCountResult(localMatches, start);
+    }
+
+    uint64_t offsets[size], lengths[size];
+    int rowCounts[size];
+    char *received = gatherRowBatches(&batch, localMatches, offsets, lengths, rowCounts);
+    free(batch.bytes);
+    if (rank != 0) {
+        return NULL;
+    }
+
+    // Rank 0: extract the requested attributes from the gathered rows and format the result
+    struct resultSetS *queryResults = (struct resultSetS *)malloc(sizeof(struct resultSetS));
+    queryResults->numRecords = 0;
+    for (int r = 0; r < size; r++) {
+        queryResults->numRecords += rowCounts[r];
+    }
+    queryResults->numColumns = numColumns;
+
     // Allocate memory for column headers
     queryResults->columnNames = (char **)malloc(queryResults->numColumns * sizeof(char *));
     for (int i = 0; i < queryResults->numColumns; i++) {
         queryResults->columnNames[i] = strdup(selectItems[i]);
     }
 
-    // Allocate memory for data matrix [rows][cols]
+    // Allocate memory for data matrix [rows][cols] and populate it
     queryResults->data = (char ***)malloc(queryResults->numRecords * sizeof(char **));
+    mergeRowBatches(queryResults, received, offsets, lengths, size, selectItems, columns);
+    free(received);
 
-    // Populate the matrix
-    for (int i = 0; i < queryResults->numRecords; i++) {
-        queryResults->data[i] = (char **)malloc(queryResults->numColumns * sizeof(char *));
-        record *r = matchingRecords[i];
-        
-        for (int j = 0; j < queryResults->numColumns; j++) {
-            // Extract ONLY the attribute requested in selectItems[j]
-            queryResults->data[i][j] = get_attribute_string_value(r, selectItems[j]);
-        }
-    }
-
-    // Clean up the temporary array of pointers (temp array, NOT records themselves)
-    free(matchingRecords);
-    
-    queryResults->queryTime = time_taken;
+    queryResults->queryTime = MPI_Wtime() - start;
     queryResults->success = true;
-    
+
     // Allocate column types (placeholder)
     queryResults->columnTypes = (FieldType *)malloc(queryResults->numColumns * sizeof(FieldType));
     memset(queryResults->columnTypes, 0, queryResults->numColumns * sizeof(FieldType));
@@ -623,7 +552,11 @@ bool executeQueryInsertMPI(
     }
 
     // Append the new record to engine->all_records in memory
-    // ALL ranks must update their local copy of the records so they can be used for future queries
+    // Only the last rank keeps it: partitions are consecutive slices of the file and the
+    // record was appended to the end of it
+    if (rank != size - 1) {
+        return true;
+    }
     engine->all_records = (record **)realloc(engine->all_records, (engine->num_records + 1) * sizeof(record *));
     if (engine->all_records == NULL) {
         if (VERBOSE) {
@@ -639,48 +572,116 @@ bool executeQueryInsertMPI(
         return false;
     }
     *record_copy = *newRecord;  // Copy the contents of newRecord (properly allocating memory outside function scope)
+    copy_record_strings(record_copy, engine->strings);  // The caller's strings need not outlive the query
     engine->all_records[engine->num_records] = record_copy;
 
     // Increment the record count
     engine->num_records += 1;
+    if (engine->columns != NULL) {
+        columnStoreAppend(engine->columns, record_copy);  // Same row id as in all_records
+    }
 
-    // Update any relevant B+ tree indexes to include the new record
-    // Distribute the index updates among the ranks
-    // Each rank is responsible for a subset of the indexes: i % size == rank
+    // Update the rank's local B+ tree indexes to include the new record
     bool success = true;
     for (int i = 0; i < engine->num_indexes; i++) {
-        if (i % size == rank) {
-            const char *indexed_attr = engine->indexed_attributes[i];
-            
-            // Insert the new record into the B+ tree for this indexed attribute
-            node *root = engine->bplus_tree_roots[i];
-            KEY_T key = extract_key_from_record(record_copy, indexed_attr);
-            root = insert(root, key, (ROW_PTR)record_copy);
-            engine->bplus_tree_roots[i] = root;
-            
-            if(root == NULL) {
-                if (VERBOSE) {
-                    fprintf(stderr, "Failed to insert new record into B+ tree for attribute: %s on rank %d\n", indexed_attr, rank);
-                }
-                success = false;
+        const char *indexed_attr = engine->indexed_attributes[i];
+        
+        // Insert the new record into the B+ tree for this indexed attribute
+        bptree *tree = engine->bplus_tree_roots[i];
+        if(tree == NULL) {
+            if (VERBOSE) {
+                fprintf(stderr, "Failed to insert new record into B+ tree for attribute: %s on rank %d\n", indexed_attr, rank);
             }
+            success = false;
+            continue;
         }
+        KEY_T key = extract_key_from_record(record_copy, indexed_attr);
+        insert(tree, key, (ROW_PTR)record_copy);
+        columnStatsAdd(&engine->index_stats[i], key);
+        columnStatsRefresh(&engine->index_stats[i], tree);
     }
    
     return success;
 }
 
-// assumes same external declarations as in the OpenMP version
+#define DELETE_WRITE_ROUND (1 << 30)  // Largest single MPI_File_write_at_all of the data file rewrite
+
+/* Rewrites the data file from every rank's records (collective). Each rank formats its
+ * partition and writes it at its offset in the file, after the partitions of lower ranks.
+ * Returns false when the file could not be opened.
+ */
+static bool rewriteDataFileMPI(struct engineS *engine) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    char *text = NULL;
+    size_t length = 0;
+    FILE *stream = open_memstream(&text, &length);
+    if (stream == NULL) {
+        perror("Failed to format data file");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < engine->num_records; i++) {
+        record *r = engine->all_records[i];
+        fprintf(stream, "%llu,%s,%s,%s,%d,%s,%d,%s,%d,%s,%s,%d\n",
+            r->command_id,
+            r->raw_command,
+            r->base_command,
+            r->shell_type,
+            r->exit_code,
+            r->timestamp,
+            r->sudo_used,
+            r->working_directory,
+            r->user_id,
+            r->user_name,
+            r->host_name,
+            r->risk_level);
+    }
+    fclose(stream);
+
+    long long localBytes = (long long)length, offset = 0, totalBytes = 0, maxBytes = 0;
+    MPI_Exscan(&localBytes, &offset, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (rank == 0) offset = 0;  // MPI_Exscan leaves rank 0's result undefined
+    MPI_Allreduce(&localBytes, &totalBytes, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(&localBytes, &maxBytes, 1, MPI_LONG_LONG, MPI_MAX, MPI_COMM_WORLD);
+
+    MPI_File fh;
+    if (MPI_File_open(MPI_COMM_WORLD, engine->datafile, MPI_MODE_WRONLY | MPI_MODE_CREATE, MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+        if (VERBOSE) {
+            fprintf(stderr, "Failed to open data file for rewriting: %s\n", engine->datafile);
+        }
+        free(text);
+        return false;
+    }
+    MPI_File_set_size(fh, (MPI_Offset)totalBytes);
 
+    // Collective writes in rounds, so a partition past INT_MAX bytes is still written
+    for (long long done = 0; done < maxBytes; done += DELETE_WRITE_ROUND) {
+        long long left = localBytes > done ? localBytes - done : 0;
+        int want = (int)(left < DELETE_WRITE_ROUND ? left : DELETE_WRITE_ROUND);
+        MPI_File_write_at_all(fh, (MPI_Offset)(offset + done), text + done, want, MPI_CHAR, MPI_STATUS_IGNORE);
+    }
+    MPI_File_close(&fh);
+    free(text);
+    return true;
+}
+
+/* Main functionality for DELETE logic
+ * Collective: every rank deletes the matching records of its own partition (and from its
+ * local indexes), then the ranks rewrite the data file together.
+ * Parameters:
+ *   engine - constant engine object
+ *   tableName - name of the table
+ *   whereClause - WHERE clause (NULL deletes every record)
+ * Returns:
+ *   Result set holding the number of deleted records (on every rank)
+*/
 struct resultSetS *executeQueryDeleteMPI(
     struct engineS *engine,
     const char *tableName,
     struct whereClauseS *whereClause
 ) {
     MPI_Comm comm = MPI_COMM_WORLD;
-    int rank, size;
-    MPI_Comm_rank(comm, &rank);
-    MPI_Comm_size(comm, &size);
 
     struct resultSetS *result = (struct resultSetS *)malloc(sizeof(struct resultSetS));
     if (!result) {
@@ -697,99 +698,27 @@ struct resultSetS *executeQueryDeleteMPI(
 
     double start = MPI_Wtime();
 
-    // We assume num_records is the same on all ranks (e.g., broadcasted beforehand if needed)
-    int num_records = engine->num_records;
-
-    // Block partition of records across ranks
-    int base = num_records / size;
-    int rem  = num_records % size;
-
-    int local_n;
-    int local_start;
-
-    if (rank < rem) {
-        local_n     = base + 1;
-        local_start = rank * (base + 1);
-    } else {
-        local_n     = base;
-        local_start = rem * (base + 1) + (rank - rem) * base;
-    }
-
-    // Local flags for this rank's chunk
-    int *localFlags = (local_n > 0)
-        ? (int *)calloc(local_n, sizeof(int))
-        : NULL;
-
+    // Local WHERE evaluation, deleting and compacting in one pass
     int localDeleted = 0;
-
-    // Local WHERE evaluation
-    for (int i = 0; i < local_n; i++) {
-        int globalIdx = local_start + i;
-        record *currentRecord = engine->all_records[globalIdx];
-        bool shouldDelete;
-
-        if (whereClause == NULL) {
-            shouldDelete = true;
-        } else {
-            shouldDelete = evaluateWhereClause(currentRecord, whereClause);
-        }
-
-        if (shouldDelete) {
-            localFlags[i] = 1;
-            localDeleted++;
-        }
-    }
-
-    // Total deleted count across all ranks
-    int globalDeleted = 0;
-    MPI_Allreduce(&localDeleted, &globalDeleted, 1, MPI_INT, MPI_SUM, comm);
-
-    // Gather all flags on ALL ranks
-    int *recvCounts = (int *)malloc(size * sizeof(int));
-    int *displs     = (int *)malloc(size * sizeof(int));
-    int *globalFlags = (int *)calloc(num_records, sizeof(int));
-
-    // Share counts with everyone
-    MPI_Allgather(&local_n, 1, MPI_INT,
-               recvCounts, 1, MPI_INT,
-               comm);
-
-    // Calculate displacements
-    int offset = 0;
-    for (int r = 0; r < size; r++) {
-        displs[r] = offset;
-        offset   += recvCounts[r];
-    }
-
-    // Share flags with everyone
-    MPI_Allgatherv(localFlags, local_n, MPI_INT,
-                globalFlags, recvCounts, displs, MPI_INT,
-                comm);
-
-    if (localFlags) {
-        free(localFlags);
-    }
-
-    // ALL ranks apply deletions to keep memory and indexes in sync
     int writeIndex = 0;
 
-    for (int i = 0; i < num_records; i++) {
+    where_program program;
+    whereCompile(&program, whereClause);
+    for (int i = 0; i < engine->num_records; i++) {
         record *currentRecord = engine->all_records[i];
 
-        if (globalFlags[i]) {
-            // Remove from B+ Tree Indexes
-            // CRITICAL: Only update indexes owned by this rank
+        if (whereMatches(&program, currentRecord)) {
+            // Remove from this rank's B+ Tree Indexes
             for (int j = 0; j < engine->num_indexes; j++) {
-                if (j % size == rank) {
-                    const char *indexed_attr = engine->indexed_attributes[j];
-                    KEY_T key = extract_key_from_record(currentRecord, indexed_attr);
-                    engine->bplus_tree_roots[j] =
-                        delete(engine->bplus_tree_roots[j], key, (ROW_PTR)currentRecord);
-                }
+                const char *indexed_attr = engine->indexed_attributes[j];
+                KEY_T key = extract_key_from_record(currentRecord, indexed_attr);
+                delete(engine->bplus_tree_roots[j], key, (ROW_PTR)currentRecord);
+                columnStatsRemove(&engine->index_stats[j], key);
             }
 
-            // Free record memory (All ranks must free their local copy)
-            free(currentRecord);
+            // Free record memory (loaded records stay in their block or mapping)
+            if (ownsRecord(engine, currentRecord)) free(currentRecord);
+            localDeleted++;
         } else {
             // Keep record and compact
             if (writeIndex != i) {
@@ -798,48 +727,32 @@ struct resultSetS *executeQueryDeleteMPI(
             writeIndex++;
         }
     }
+    whereProgramFree(&program);
 
     engine->num_records = writeIndex;
 
-    // Only Rank 0 rewrites the file
-    if (rank == 0) {
-        FILE *file = fopen(engine->datafile, "w");
-        if (file != NULL) {
-            for (int i = 0; i < engine->num_records; i++) {
-                record *r = engine->all_records[i];
-                fprintf(file, "%llu,%s,%s,%s,%d,%s,%d,%s,%d,%s,%s,%d\n",
-                    r->command_id,
-                    r->raw_command,
-                    r->base_command,
-                    r->shell_type,
-                    r->exit_code,
-                    r->timestamp,
-                    r->sudo_used,
-                    r->working_directory,
-                    r->user_id,
-                    r->user_name,
-                    r->host_name,
-                    r->risk_level);
-            }
-            fclose(file);
-        } else {
-            if (VERBOSE) {
-                fprintf(stderr,
-                        "Failed to open data file for rewriting: %s\n",
-                        engine->datafile);
-            }
-        }
+    // Statistics that drifted too far from their index are gathered again
+    for (int j = 0; j < engine->num_indexes; j++) {
+        columnStatsRefresh(&engine->index_stats[j], engine->bplus_tree_roots[j]);
     }
 
+    // Row ids shifted; the column store is rebuilt by the next full-table scan
+    if (localDeleted > 0) {
+        columnStoreDestroy(engine->columns);
+        engine->columns = NULL;
+    }
+
+    // Total deleted count across all ranks
+    int globalDeleted = 0;
+    MPI_Allreduce(&localDeleted, &globalDeleted, 1, MPI_INT, MPI_SUM, comm);
+
+    bool file_success = rewriteDataFileMPI(engine);
+
     double time_taken = MPI_Wtime() - start;
 
     result->numRecords = globalDeleted;
     result->queryTime  = time_taken;
-    result->success    = true;
-
-    if (globalFlags) free(globalFlags);
-    if (recvCounts)  free(recvCounts);
-    if (displs)      free(displs);
+    result->success    = file_success;
 
     return result;
 }
@@ -873,13 +786,21 @@ struct engineS *initializeEngineMPI(
     // Initialize indexes and tree roots
     engine->tableName = strdup(tableName);
     engine->num_indexes = 0; // Start at 0, makeIndexSerial will increment
-    engine->bplus_tree_roots = (node **)malloc(num_indexes * sizeof(node *));
+    engine->bplus_tree_roots = (bptree **)malloc(num_indexes * sizeof(bptree *));
     engine->indexed_attributes = (char **)malloc(num_indexes * sizeof(char *));
     engine->attribute_types = (FieldType *)malloc(num_indexes * sizeof(FieldType));
+    engine->index_stats = (column_stats *)malloc(num_indexes * sizeof(column_stats));
     engine->all_records = NULL; // Initialize to NULL, will be set later
     engine->num_records = 0; // Initialize record count to 0
     engine->record_block = NULL; // Initialize to NULL
-    if (engine->bplus_tree_roots == NULL || engine->indexed_attributes == NULL || engine->attribute_types == NULL) {
+    engine->record_block_bytes = 0;
+    engine->record_map = NULL; // No snapshot mapped yet
+    engine->record_map_bytes = 0;
+    engine->columns = NULL; // Built by the first full-table scan
+    engine->locks = NULL; // Queries run one at a time
+    engine->strings = stringHeapCreate(); // String fields of parsed and inserted records
+    if (engine->bplus_tree_roots == NULL || engine->indexed_attributes == NULL || engine->attribute_types == NULL ||
+        engine->index_stats == NULL) {
         perror("Failed to allocate memory for engine components");
         free(engine);
         exit(EXIT_FAILURE);
@@ -888,7 +809,28 @@ struct engineS *initializeEngineMPI(
     // Read all records from the database into memory and store in engine->all_records
     if(!datafile){ datafile = "../data/commands_50k.csv"; }; // Filepath default
     engine->datafile = strdup(datafile);
-    engine->all_records = getAllRecordsFromFileMPI(datafile, &engine->num_records);  // Directly update record count
+    // Every rank maps the snapshot of an unchanged data file (one shared page cache copy);
+    // if any rank cannot, all of them take the collective CSV path instead. Either way a
+    // rank holds one partition of the table
+    engine->all_records = snapshotLoad(datafile, &engine->num_records, &engine->record_map, &engine->record_map_bytes);
+    int mapped = engine->all_records != NULL, all_mapped = 0;
+    MPI_Allreduce(&mapped, &all_mapped, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    if (!all_mapped) {
+        free(engine->all_records);
+        snapshotUnmap(engine->record_map, engine->record_map_bytes);
+        engine->record_map = NULL;
+        engine->record_map_bytes = 0;
+        engine->all_records = getAllRecordsFromFileMPI(datafile, &engine->num_records, &engine->record_block, &engine->record_block_bytes, engine->strings);  // Directly update record count
+    } else {
+        // Each rank keeps only its consecutive slice of the mapped records, like the CSV loader
+        int rank, size;
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_size(MPI_COMM_WORLD, &size);
+        int first = (int)((long long)engine->num_records * rank / size);
+        int last = (int)((long long)engine->num_records * (rank + 1) / size);
+        memmove(engine->all_records, engine->all_records + first, (size_t)(last - first) * sizeof(record *));
+        engine->num_records = last - first;
+    }
 
     // Copy indexed attribute names and types into engine struct (defaults)
     for (int i = 0; i < num_indexes; i++) {
@@ -926,13 +868,28 @@ void destroyEngineMPI(struct engineS *engine) {
         /* Free: attribute types array */
         if (engine->attribute_types != NULL) free(engine->attribute_types);
 
+        /* Free: index statistics */
+        free(engine->index_stats);
+
         /* Free: all records allocated from file */
         if (engine->all_records != NULL) {
             for (int i = 0; i < engine->num_records; i++) {
-                if (engine->all_records[i] != NULL) free(engine->all_records[i]);
+                // Loaded records are released with their block or mapping
+                record *r = engine->all_records[i];
+                if (r != NULL && ownsRecord(engine, r)) free(r);
             }
             free(engine->all_records);
         }
+        free(engine->record_block);
+
+        /* Free: column store */
+        columnStoreDestroy(engine->columns);
+
+        /* Free: mapped snapshot */
+        snapshotUnmap(engine->record_map, engine->record_map_bytes);
+
+        /* Free: string fields of all records */
+        stringHeapDestroy(engine->strings);
 
         /* Free: duplicated strings */
         if (engine->tableName) free(engine->tableName);
@@ -984,26 +941,31 @@ int isAttributeIndexed(struct engineS *engine, const char *attributeName) {
 
 /* Performs a linear search through a given array of records based on the WHERE clause */
 record **linearSearchRecords(record **records, int num_records, struct whereClauseS *whereClause, int *matchingRecords) {
-    // Allocate space for results array
-    record **results = malloc(sizeof(record *));
+    // Allocate space for results array (every record may match; trimmed afterwards)
+    record **results = malloc((num_records > 0 ? num_records : 1) * sizeof(record *));
+    if (results == NULL) {
+        perror("Failed to allocate linear search results");
+        exit(EXIT_FAILURE);
+    }
     *matchingRecords = 0;
 
-    // Iterate through all records and apply WHERE clause filtering
+    // Compile the WHERE clause once, then run it against every record
+    where_program program;
+    whereCompile(&program, whereClause);
     for(int i = 0; i < num_records; i++) {
         record *currentRecord = records[i];
-        bool matches = true;
-
-        if (whereClause != NULL) {
-            matches = evaluateWhereClause(currentRecord, whereClause);
-        }
 
         // If record matches all conditions, add to results
-        if (matches) {
-            results = realloc(results, (*matchingRecords + 1) * sizeof(record *));
+        if (whereMatches(&program, currentRecord)) {
             results[*matchingRecords] = currentRecord;
             (*matchingRecords)++;
         }
     }
+    whereProgramFree(&program);
+    if (*matchingRecords > 0 && *matchingRecords < num_records) {
+        record **trimmed = realloc(results, *matchingRecords * sizeof(record *));
+        if (trimmed != NULL) results = trimmed;
+    }
 
     // Return the array of matching records
     return results;
@@ -0,0 +1,128 @@
+/*
+ * Node arena: slab allocator for the fixed-size nodes of one B+ tree.
+ * Replaces one aligned_alloc / free per node with bump allocation from large slabs.
+ */
+
+#define _POSIX_C_SOURCE 200809L  // munmap
+#include "../include/nodeArena.h"
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+/* ==================== Lock ==================== */
+
+static void arenaLock(node_arena *arena) {
+    int spins = 0;
+    while (atomic_flag_test_and_set_explicit(&arena->lock, memory_order_acquire)) {
+        if (++spins >= 64) {
+            sched_yield();
+            spins = 0;
+        }
+    }
+}
+
+static void arenaUnlock(node_arena *arena) {
+    atomic_flag_clear_explicit(&arena->lock, memory_order_release);
+}
+
+/* ==================== Slabs ==================== */
+
+/* addSlab: Chains a new slab and makes its blocks the bump region. The first block of
+ * every slab holds the link to the previous slab, so nothing else is allocated.
+ */
+static void addSlab(node_arena *arena) {
+    size_t bytes = (size_t)(arena->blocks_per_slab + 1) * arena->block_bytes;
+    char *slab = aligned_alloc(arena->align, bytes);
+    if (slab == NULL) {
+        perror("Node arena slab allocation failed");
+        exit(EXIT_FAILURE);
+    }
+    *(void **)slab = arena->slabs;
+    arena->slabs = slab;
+    arena->bump = slab + arena->block_bytes;
+    arena->bump_left = arena->blocks_per_slab;
+    arena->num_slabs++;
+}
+
+/* ==================== Public API ==================== */
+
+node_arena *nodeArenaCreate(size_t block_bytes, size_t align) {
+    node_arena *arena = malloc(sizeof(node_arena));
+    if (arena == NULL) {
+        perror("Node arena creation failed");
+        exit(EXIT_FAILURE);
+    }
+    atomic_flag_clear(&arena->lock);
+    arena->block_bytes = block_bytes;
+    arena->align = align;
+    arena->blocks_per_slab = (int)(NODE_ARENA_SLAB_BYTES / block_bytes);
+    if (arena->blocks_per_slab < 1)
+        arena->blocks_per_slab = 1;
+    arena->slabs = NULL;
+    arena->bump = NULL;
+    arena->bump_left = 0;
+    arena->free_list = NULL;
+    arena->num_slabs = 0;
+    arena->live_blocks = 0;
+    arena->mapping = NULL;
+    arena->mapping_bytes = 0;
+    return arena;
+}
+
+void *nodeArenaAlloc(node_arena *arena) {
+    void *block;
+    arenaLock(arena);
+    if (arena->free_list != NULL) {
+        // Recycle the most recently freed block (still warm in cache)
+        block = arena->free_list;
+        arena->free_list = *(void **)block;
+    } else {
+        if (arena->bump_left == 0)
+            addSlab(arena);
+        block = arena->bump;
+        arena->bump += arena->block_bytes;
+        arena->bump_left--;
+    }
+    arena->live_blocks++;
+    arenaUnlock(arena);
+    return block;
+}
+
+void nodeArenaFree(node_arena *arena, void *block) {
+    if (block == NULL) return;
+    arenaLock(arena);
+    *(void **)block = arena->free_list;
+    arena->free_list = block;
+    arena->live_blocks--;
+    arenaUnlock(arena);
+}
+
+/* nodeArenaAdoptMapping: The mapped blocks count as handed out; freed ones join the free
+ * list like any other block, so the mapping is only released as a whole.
+ */
+void nodeArenaAdoptMapping(node_arena *arena, void *mapping, size_t bytes, long num_blocks) {
+    arenaLock(arena);
+    arena->mapping = mapping;
+    arena->mapping_bytes = bytes;
+    arena->live_blocks += num_blocks;
+    arenaUnlock(arena);
+}
+
+size_t nodeArenaBytes(const node_arena *arena) {
+    return sizeof(node_arena) +
+           (size_t)arena->num_slabs * (arena->blocks_per_slab + 1) * arena->block_bytes;
+}
+
+void nodeArenaDestroy(node_arena *arena) {
+    if (arena == NULL) return;
+    void *slab = arena->slabs;
+    while (slab != NULL) {
+        void *prev = *(void **)slab;
+        free(slab);
+        slab = prev;
+    }
+    if (arena->mapping != NULL)
+        munmap(arena->mapping, arena->mapping_bytes);
+    free(arena);
+}
@@ -1,16 +1,18 @@
 /* Skeleton for the Serial Implementation - uses the bplus serial engine and tokenizer to execute a provided SQL query */
 
-#define _POSIX_C_SOURCE 200809L  // Enable strdup
+#define _POSIX_C_SOURCE 200809L  // Enable strdup, fstat, posix_madvise
 #include "../../include/buildEngine-omp.h"
+#include "../../include/csvParse.h"
+#include "../../include/indexFile.h"
+#include <fcntl.h>
 #include <string.h>
 #include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <omp.h>
 #define VERBOSE 0  // Essentially testing mode
 
-// Forward declarations
-void fillRecordFromLineOMP(char *line, record *new_record);
-void parseCSVFieldToBuffer(char **cursor, char *buffer, size_t max_len);
-
 // Forward declaration
 FieldType mapAttributeTypeOMP(int attributeType);
 
@@ -20,14 +22,22 @@ bool makeIndexOMP(struct engineS *engine, const char *indexName, int attributeTy
     record **records = engine->all_records;
     int numRecords = engine->num_records;
     
-    // Build the B+ tree from the records array
-    node *root = loadIntoBplusTreeOMP(records, numRecords, indexName);
+    // Reuse the index saved by an earlier run while the data file is unchanged;
+    // otherwise build the B+ tree from the records array and save it for the next run
+    bptree *root = indexFileLoad(engine->datafile, indexName, records, numRecords);
+    if (root == NULL) {
+        root = loadIntoBplusTreeOMP(records, numRecords, indexName);
+        if (root != NULL) {
+            indexFileSave(engine->datafile, indexName, root, records, numRecords);
+        }
+    }
     if (VERBOSE && root == NULL) {
         fprintf(stderr, "Failed to load data into B+ tree\n");
     }
 
     // Add to the engine's known tree roots
     engine->bplus_tree_roots[engine->num_indexes] = root;
+    columnStatsBuild(&engine->index_stats[engine->num_indexes], root);  // For the index planner
     engine->indexed_attributes[engine->num_indexes] = strdup(indexName);
     engine->num_indexes += 1;
     engine->attribute_types[engine->num_indexes-1] = mapAttributeTypeOMP(attributeType);
@@ -41,142 +51,185 @@ bool makeIndexOMP(struct engineS *engine, const char *indexName, int attributeTy
  *   num_records - number of records in the array
  *   attributeName - name of the attribute to index
  * Returns:
- *  root of the B+ tree
+ *  handle of the B+ tree
 */
-node *loadIntoBplusTreeOMP(record **records, int num_records, const char *attributeName) {
-    // Instantiate the B+ tree root
-    node *root = NULL;
-    
-    // Parallelize the iteration and insertion into the B+ tree
-    // Use critical section to protect tree modifications
-    //#pragma omp parallel for schedule(dynamic)
+bptree *loadIntoBplusTreeOMP(record **records, int num_records, const char *attributeName) {
+    // Each index gets its own tree handle; the order is sized to the key type
+    const FieldInfo *info = get_field_info(attributeName);
+    if (info == NULL) {
+        fprintf(stderr, "Unknown index attribute: %s\n", attributeName);
+        return NULL;
+    }
+    bptree *tree = bptreeCreate(key_type_for_field(info->type), 0);
+    if (num_records <= 0) {
+        return tree;  // Nothing to index yet, later inserts will populate it
+    }
+
+    // Pair every record with its key so the tree can be built bottom-up in one pass
+    bplus_entry *entries = (bplus_entry *)malloc(num_records * sizeof(bplus_entry));
+    if (entries == NULL) {
+        fprintf(stderr, "Memory allocation failed for bulk load entries\n");
+        destroy_tree(tree);
+        return NULL;
+    }
+
+    // Key extraction is independent per record, so it can be done in parallel
+    #pragma omp parallel for schedule(static)
     for (int i = 0; i < num_records; i++) {
-        
-        // Extract the current record as a key (can be done in parallel)
-        record *currentRecord = records[i];
-        KEY_T key = extract_key_from_record(currentRecord, attributeName);
+        entries[i].key = extract_key_from_record(records[i], attributeName);
+        entries[i].row_ptr = (ROW_PTR)records[i];
+    }
 
-        // Insert the record into the B+ tree using the key
-        // Critical section needed as tree structure is modified
-        //#pragma omp critical
-        //{
-            root = insert(root, key, (ROW_PTR)currentRecord);
-        //}
+    // Sort once and pack the leaves/internal nodes instead of inserting record by record
+    bulkLoad(tree, entries, num_records, BULK_FILL_FACTOR);
+    free(entries);
 
-        // Validate insertion via printing (only in verbose mode)
-        if (VERBOSE) {
-            //#pragma omp critical
-            {
-                printTree(root);
-            }
-        }
+    // Validate the build via printing (only in verbose mode)
+    if (VERBOSE) {
+        printTree(tree);
     }
 
-    return root;  // Return the root of the constructed B+ tree
+    return tree;  // Return the constructed B+ tree
+}
+
+/* Start of the line after the one p is in (end when p is in the last line) */
+static char *nextLineStart(char *p, char *end) {
+    char *newline = memchr(p, '\n', (size_t)(end - p));
+    return newline != NULL ? newline + 1 : end;
+}
+
+/* Number of non-empty lines in [start, end), which holds whole newline-terminated lines */
+static int countLines(char *start, char *end) {
+    int count = 0;
+    for (char *line = start; line < end; ) {
+        char *next = nextLineStart(line, end);
+        if (*line != '\n') count++;
+        line = next;
+    }
+    return count;
 }
 
 /* Load the full CSV file into memory as an array of record structs 
+ * The file is mapped privately instead of read into a buffer, and split into chunks at
+ * line boundaries that threads count and then parse in place, straight from the mapped
+ * pages (only the pages a thread writes field terminators to get a private copy).
  * Parameters:
  *   filepath - path to the CSV data file
+ *   record_block_out, record_block_bytes_out - receive the single allocation holding every record
+ *   strings - string heap that takes over the mapping the string fields point into
  * Returns:
  *   Array of all record structs in the file
 */
-record **getAllRecordsFromFileOMP(const char *filepath, int *num_records, void **record_block_out) {
+record **getAllRecordsFromFileOMP(const char *filepath, int *num_records, void **record_block_out, size_t *record_block_bytes_out, string_heap *strings) {
     // Attempt to open the file from the provided path
-    FILE *file = fopen(filepath, "r");
-    if (file == NULL) {
+    int fd = open(filepath, O_RDONLY);
+    if (fd < 0) {
         fprintf(stderr, "Error opening file: %s\n", filepath);
         return NULL;
     }
 
-    fseek(file, 0, SEEK_END);
-    long filesize = ftell(file);
-    fseek(file, 0, SEEK_SET);
-
-    if (filesize == 0) {
-        fclose(file);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
         *num_records = 0;
         return NULL;
     }
-
-    char *content = malloc(filesize + 1);
-    if (!content) {
-        fclose(file);
+    size_t filesize = (size_t)st.st_size;
+
+    // Private and writable, so fields are unquoted and NUL-terminated in place without
+    // touching the file; pages are read in on demand, so no file-sized buffer is needed
+    char *content = mmap(NULL, filesize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (content == MAP_FAILED) {
+        perror("Failed to map data file");
         return NULL;
     }
-    
-    size_t read_size = fread(content, 1, filesize, file);
-    content[filesize] = '\0';
-    fclose(file);
-
-    // Count lines to pre-allocate arrays
-    int line_count = 0;
-    for (long i = 0; i < filesize; i++) {
-        if (content[i] == '\n') line_count++;
+    posix_madvise(content, filesize, POSIX_MADV_SEQUENTIAL);
+    char *end = content + filesize;
+
+    // Skip the header; an unterminated last line is parsed from a copy below, since the
+    // mapping has no byte after it to terminate its last field with
+    char *body = nextLineStart(content, end);
+    char *tail = end;
+    if (body < end && end[-1] != '\n') {
+        tail = end - 1;
+        while (tail > body && tail[-1] != '\n') tail--;
     }
-    if (filesize > 0 && content[filesize-1] != '\n') line_count++;
 
-    if (line_count == 0) {
-        free(content);
-        *num_records = 0;
-        return NULL;
+    // Chunk boundaries at line starts, a few chunks per thread so uneven lines balance out
+    int num_chunks = omp_get_max_threads() * 4;
+    char **bounds = malloc((num_chunks + 1) * sizeof(char *));
+    int *offsets = malloc((num_chunks + 1) * sizeof(int));
+    if (bounds == NULL || offsets == NULL) {
+        perror("Failed to allocate loader chunks");
+        exit(EXIT_FAILURE);
+    }
+    size_t body_bytes = (size_t)(tail - body);
+    bounds[0] = body;
+    for (int c = 1; c < num_chunks; c++) {
+        char *split = body + body_bytes / num_chunks * c;
+        if (split < bounds[c - 1]) split = bounds[c - 1];
+        bounds[c] = (split > body && split[-1] != '\n') ? nextLineStart(split, tail) : split;
     }
+    bounds[num_chunks] = tail;
 
-    // Create line pointers
-    char **lines = malloc(line_count * sizeof(char*));
-    int idx = 0;
-    lines[idx++] = content;
-    for (long i = 0; i < filesize; i++) {
-        if (content[i] == '\n') {
-            content[i] = '\0';
-            if (idx < line_count && i + 1 < filesize) {
-                lines[idx++] = &content[i+1];
-            }
-        }
+    // Count each chunk's records in parallel, then prefix-sum them into record offsets
+    #pragma omp parallel for schedule(dynamic)
+    for (int c = 0; c < num_chunks; c++) {
+        offsets[c + 1] = countLines(bounds[c], bounds[c + 1]);
+    }
+    offsets[0] = 0;
+    for (int c = 0; c < num_chunks; c++) {
+        offsets[c + 1] += offsets[c];
     }
+    int count = offsets[num_chunks] + (tail < end ? 1 : 0);
 
-    // Allocate records array (max possible size)
-    record **records = malloc(idx * sizeof(record*));
-    
-    // Allocate a single block for all records to reduce malloc overhead and fragmentation
-    // We allocate idx records, though 0 is unused (header)
-    record *record_block = calloc(idx, sizeof(record));
-    if (!record_block) {
-        free(records);
-        free(lines);
-        free(content);
+    if (count == 0) {
+        free(bounds);
+        free(offsets);
+        munmap(content, filesize);
+        *num_records = 0;
         return NULL;
     }
 
-    if (record_block_out) {
-        *record_block_out = record_block;
+    // A single block for all records, in file order, to reduce malloc overhead and fragmentation
+    record **records = malloc(count * sizeof(record *));
+    record *record_block = calloc(count, sizeof(record));
+    if (records == NULL || record_block == NULL) {
+        perror("Failed to allocate records");
+        exit(EXIT_FAILURE);
     }
 
-    // Parallel parse
-    // Skip header (index 0)
+    // Parallel parse: each chunk fills its own range of the block
     #pragma omp parallel for schedule(dynamic)
-    for (int i = 1; i < idx; i++) {
-        if (lines[i] && *lines[i] != '\0') {
-            records[i] = &record_block[i];
-            fillRecordFromLineOMP(lines[i], records[i]);
-        } else {
-            records[i] = NULL;
+    for (int c = 0; c < num_chunks; c++) {
+        int r = offsets[c];
+        for (char *line = bounds[c]; line < bounds[c + 1]; ) {
+            char *next = nextLineStart(line, bounds[c + 1]);
+            if (*line != '\n') {
+                records[r] = &record_block[r];
+                csvParseRecord(records[r], line, (size_t)(next - line) - 1);  // Without its newline
+                r++;
+            }
+            line = next;
         }
     }
+    if (tail < end) {
+        char *last = (char *)stringHeapAdd(strings, tail, (size_t)(end - tail));
+        records[count - 1] = &record_block[count - 1];
+        csvParseRecord(records[count - 1], last, (size_t)(end - tail));
+    }
 
-    // Compact the array (remove NULLs and header slot)
-    int count = 0;
-    for (int i = 1; i < idx; i++) {
-        if (records[i] != NULL) {
-            records[count++] = records[i];
-        }
+    free(bounds);
+    free(offsets);
+    if (record_block_out) {
+        *record_block_out = record_block;
     }
-    
-    free(lines);
-    // content cannot be freed because we might have pointers into it?
-    // fillRecordFromLineOMP copies data into fixed size arrays in record struct.
-    // So we can free content.
-    free(content);
+    if (record_block_bytes_out) {
+        *record_block_bytes_out = (size_t)count * sizeof(record);
+    }
+    // The records' string fields point into the mapping (unquoted in place), so the heap keeps it
+    stringHeapAdoptMapping(strings, content, filesize);
 
     if(VERBOSE) {
         printf("Loaded %d records from file: %s\n", count, filepath);
@@ -185,107 +238,10 @@ record **getAllRecordsFromFileOMP(const char *filepath, int *num_records, void *
     return records;
 }
 
-/* Helper to parse a CSV field, handling quotes and commas */
-void parseCSVFieldToBuffer(char **cursor, char *buffer, size_t max_len) {
-    char *start = *cursor;
-    if (*start == '\0' || *start == '\n' || *start == '\r') {
-        buffer[0] = '\0';
-        return;
-    }
-
-    size_t i = 0;
-    bool in_quotes = false;
-
-    if (*start == '"') {
-        in_quotes = true;
-        start++; // Skip opening quote
-    }
-
-    while (*start != '\0' && *start != '\n' && *start != '\r' && i < max_len - 1) {
-        if (in_quotes) {
-            if (*start == '"') {
-                if (*(start + 1) == '"') {
-                    // Escaped quote
-                    buffer[i++] = '"';
-                    start += 2;
-                } else {
-                    // End of quoted field
-                    in_quotes = false;
-                    start++;
-                }
-            } else {
-                buffer[i++] = *start++;
-            }
-        } else {
-            if (*start == ',') {
-                start++; // Skip comma
-                break;
-            }
-            buffer[i++] = *start++;
-        }
-    }
-    
-    buffer[i] = '\0';
-    *cursor = start;
-}
-
-/* Fill a record struct from a line of CSV data */
-void fillRecordFromLineOMP(char *line, record *new_record) {
-    char *cursor = line;
-    char buffer[1024];
-
-    // command_id
-    parseCSVFieldToBuffer(&cursor, buffer, sizeof(buffer));
-    new_record->command_id = strtoull(buffer, NULL, 10);
-
-    // raw_command
-    parseCSVFieldToBuffer(&cursor, buffer, sizeof(buffer));
-    strncpy(new_record->raw_command, buffer, sizeof(new_record->raw_command));
-
-    // base_command
-    parseCSVFieldToBuffer(&cursor, buffer, sizeof(buffer));
-    strncpy(new_record->base_command, buffer, sizeof(new_record->base_command));
-
-    // shell_type
-    parseCSVFieldToBuffer(&cursor, buffer, sizeof(buffer));
-    strncpy(new_record->shell_type, buffer, sizeof(new_record->shell_type));
-
-    // exit_code
-    parseCSVFieldToBuffer(&cursor, buffer, sizeof(buffer));
-    new_record->exit_code = atoi(buffer);
-
-    // timestamp
-    parseCSVFieldToBuffer(&cursor, buffer, sizeof(buffer));
-    strncpy(new_record->timestamp, buffer, sizeof(new_record->timestamp));
-
-    // sudo_used
-    parseCSVFieldToBuffer(&cursor, buffer, sizeof(buffer));
-    new_record->sudo_used = (strcasecmp(buffer, "true") == 0 || strcmp(buffer, "1") == 0);
-
-    // working_directory
-    parseCSVFieldToBuffer(&cursor, buffer, sizeof(buffer));
-    strncpy(new_record->working_directory, buffer, sizeof(new_record->working_directory));
-
-    // user_id
-    parseCSVFieldToBuffer(&cursor, buffer, sizeof(buffer));
-    new_record->user_id = atoi(buffer);
-
-    // user_name
-    parseCSVFieldToBuffer(&cursor, buffer, sizeof(buffer));
-    strncpy(new_record->user_name, buffer, sizeof(new_record->user_name));
-
-    // host_name
-    parseCSVFieldToBuffer(&cursor, buffer, sizeof(buffer));
-    strncpy(new_record->host_name, buffer, sizeof(new_record->host_name));
-
-    // risk_level
-    parseCSVFieldToBuffer(&cursor, buffer, sizeof(buffer));
-    new_record->risk_level = atoi(buffer);
-}
-
 /* Get a record struct from a line of CSV data
  * Parameters:
- *   line - character array containing a line of CSV data
+ *   line - character array containing a line of CSV data (fields are unquoted in place,
+ *          and the string fields point into it)
  * Returns:
  *   record struct populated with data from the line
 */
@@ -295,7 +251,7 @@ record *getRecordFromLineOMP(char *line){
         fprintf(stderr, "Memory allocation failed\n");
         return NULL;
     }
-    fillRecordFromLineOMP(line, new_record);
+    csvParseRecord(new_record, line, strlen(line));
     return new_record;  // Return the fully populated record
 }
 
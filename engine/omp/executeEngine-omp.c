@@ -3,219 +3,28 @@
 #define _POSIX_C_SOURCE 200809L  // Enable strdup
 #include <strings.h> // For strcasecmp
 #include <time.h> // For clock_t, clock(), CLOCKS_PER_SEC
-#include <limits.h> // For INT_MAX, INT_MIN, UINT64_MAX
 #include "../../include/buildEngine-omp.h"
 #include "../../include/executeEngine-omp.h"
+#include "../../include/indexFile.h"
+#include "../../include/countQuery.h"
+#include "../../include/snapshot.h"
 #include <omp.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <unistd.h> // For getpid
+#include <pthread.h> // For the query locks
 #define VERBOSE 0
+#define INDEX_BATCH_ROWS 256  // Rows pulled from a B+ tree cursor per batch
+#define PARALLEL_SCAN_PARTS_PER_THREAD 4  // Range pieces per thread, so uneven pieces still balance
+#define LINEAR_SCAN_MIN_ROWS 4096  // Smallest chunk of a parallel linear search
 
+/* Query locks of an engine: QPEOMP runs queries side by side (see "OpenMP query concurrency" in docs/engine.md) */
+struct engine_locks {
+    pthread_rwlock_t records;  // Shared by SELECTs; exclusive while all_records, columns or index_stats change
+    pthread_mutex_t writer;  // One INSERT or DELETE at a time
+};
 
-// Function pointer type for WHERE condition evaluation
-typedef bool (*where_condition_func)(void *record, void *value);
-
-// Helper macros for generating comparison functions
-// These macros create type-specific comparison functions for different fields
-// CMP_NUM handles numeric types (int, unsigned long long, bool)
-// CMP_STR handles string types using strcmp
-#define CMP_NUM(field, type, opname, op) \
-    bool field##_##opname(void *r, void *v) { \
-        return ((record *)r)->field op (*(type *)v); \
-    }
-
-#define CMP_STR(field, opname, op) \
-    bool field##_##opname(void *r, void *v) { \
-        return strcmp(((record *)r)->field, (char *)v) op 0; \
-    }
-
-// Generate comparison functions for supported fields
-// Each block generates a set of functions (eq, neq, gt, lt, gte, lte) for a specific field
-// These functions are used by the query engine to evaluate WHERE clauses
-
-// command_id (unsigned long long)
-CMP_NUM(command_id, unsigned long long, eq, ==)
-CMP_NUM(command_id, unsigned long long, neq, !=)
-CMP_NUM(command_id, unsigned long long, gt, >)
-CMP_NUM(command_id, unsigned long long, lt, <)
-CMP_NUM(command_id, unsigned long long, gte, >=)
-CMP_NUM(command_id, unsigned long long, lte, <=)
-
-// exit_code (int)
-CMP_NUM(exit_code, int, eq, ==)
-CMP_NUM(exit_code, int, neq, !=)
-CMP_NUM(exit_code, int, gt, >)
-CMP_NUM(exit_code, int, lt, <)
-CMP_NUM(exit_code, int, gte, >=)
-CMP_NUM(exit_code, int, lte, <=)
-
-// risk_level (int)
-CMP_NUM(risk_level, int, eq, ==)
-CMP_NUM(risk_level, int, neq, !=)
-CMP_NUM(risk_level, int, gt, >)
-CMP_NUM(risk_level, int, lt, <)
-CMP_NUM(risk_level, int, gte, >=)
-CMP_NUM(risk_level, int, lte, <=)
-
-// user_id (int)
-CMP_NUM(user_id, int, eq, ==)
-CMP_NUM(user_id, int, neq, !=)
-CMP_NUM(user_id, int, gt, >)
-CMP_NUM(user_id, int, lt, <)
-CMP_NUM(user_id, int, gte, >=)
-CMP_NUM(user_id, int, lte, <=)
-
-// raw_command (string)
-CMP_STR(raw_command, eq, ==)
-CMP_STR(raw_command, neq, !=)
-// String inequality is lexicographical
-CMP_STR(raw_command, gt, >)
-CMP_STR(raw_command, lt, <)
-CMP_STR(raw_command, gte, >=)
-CMP_STR(raw_command, lte, <=)
-
-// user_name (string)
-CMP_STR(user_name, eq, ==)
-CMP_STR(user_name, neq, !=)
-CMP_STR(user_name, gt, >)
-CMP_STR(user_name, lt, <)
-CMP_STR(user_name, gte, >=)
-CMP_STR(user_name, lte, <=)
-
-// base_command (string)
-CMP_STR(base_command, eq, ==)
-CMP_STR(base_command, neq, !=)
-CMP_STR(base_command, gt, >)
-CMP_STR(base_command, lt, <)
-CMP_STR(base_command, gte, >=)
-CMP_STR(base_command, lte, <=)
-
-// shell_type (string)
-CMP_STR(shell_type, eq, ==)
-CMP_STR(shell_type, neq, !=)
-CMP_STR(shell_type, gt, >)
-CMP_STR(shell_type, lt, <)
-CMP_STR(shell_type, gte, >=)
-CMP_STR(shell_type, lte, <=)
-
-// timestamp (string)
-CMP_STR(timestamp, eq, ==)
-CMP_STR(timestamp, neq, !=)
-CMP_STR(timestamp, gt, >)
-CMP_STR(timestamp, lt, <)
-CMP_STR(timestamp, gte, >=)
-CMP_STR(timestamp, lte, <=)
-
-// working_directory (string)
-CMP_STR(working_directory, eq, ==)
-CMP_STR(working_directory, neq, !=)
-CMP_STR(working_directory, gt, >)
-CMP_STR(working_directory, lt, <)
-CMP_STR(working_directory, gte, >=)
-CMP_STR(working_directory, lte, <=)
-
-// host_name (string)
-CMP_STR(host_name, eq, ==)
-CMP_STR(host_name, neq, !=)
-CMP_STR(host_name, gt, >)
-CMP_STR(host_name, lt, <)
-CMP_STR(host_name, gte, >=)
-CMP_STR(host_name, lte, <=)
-
-// sudo_used (bool)
-CMP_NUM(sudo_used, bool, eq, ==)
-CMP_NUM(sudo_used, bool, neq, !=)
-
-
-// Factory function to create a WHERE condition function pointer
-// Takes an attribute name, operator, and value, and returns the appropriate comparison function
-// This allows the query engine to dynamically select the correct comparison logic at runtime
-where_condition_func create_where_condition(const char *attribute, const char *operator, void *value) {
-    if (strcmp(attribute, "command_id") == 0) {
-        if (strcmp(operator, "=") == 0) return command_id_eq;
-        if (strcmp(operator, "!=") == 0) return command_id_neq;
-        if (strcmp(operator, ">") == 0) return command_id_gt;
-        if (strcmp(operator, "<") == 0) return command_id_lt;
-        if (strcmp(operator, ">=") == 0) return command_id_gte;
-        if (strcmp(operator, "<=") == 0) return command_id_lte;
-    } else if (strcmp(attribute, "exit_code") == 0) {
-        if (strcmp(operator, "=") == 0) return exit_code_eq;
-        if (strcmp(operator, "!=") == 0) return exit_code_neq;
-        if (strcmp(operator, ">") == 0) return exit_code_gt;
-        if (strcmp(operator, "<") == 0) return exit_code_lt;
-        if (strcmp(operator, ">=") == 0) return exit_code_gte;
-        if (strcmp(operator, "<=") == 0) return exit_code_lte;
-    } else if (strcmp(attribute, "risk_level") == 0) {
-        if (strcmp(operator, "=") == 0) return risk_level_eq;
-        if (strcmp(operator, "!=") == 0) return risk_level_neq;
-        if (strcmp(operator, ">") == 0) return risk_level_gt;
-        if (strcmp(operator, "<") == 0) return risk_level_lt;
-        if (strcmp(operator, ">=") == 0) return risk_level_gte;
-        if (strcmp(operator, "<=") == 0) return risk_level_lte;
-    } else if (strcmp(attribute, "user_id") == 0) {
-        if (strcmp(operator, "=") == 0) return user_id_eq;
-        if (strcmp(operator, "!=") == 0) return user_id_neq;
-        if (strcmp(operator, ">") == 0) return user_id_gt;
-        if (strcmp(operator, "<") == 0) return user_id_lt;
-        if (strcmp(operator, ">=") == 0) return user_id_gte;
-        if (strcmp(operator, "<=") == 0) return user_id_lte;
-    } else if (strcmp(attribute, "raw_command") == 0) {
-        if (strcmp(operator, "=") == 0) return raw_command_eq;
-        if (strcmp(operator, "!=") == 0) return raw_command_neq;
-        if (strcmp(operator, ">") == 0) return raw_command_gt;
-        if (strcmp(operator, "<") == 0) return raw_command_lt;
-        if (strcmp(operator, ">=") == 0) return raw_command_gte;
-        if (strcmp(operator, "<=") == 0) return raw_command_lte;
-    } else if (strcmp(attribute, "user_name") == 0) {
-        if (strcmp(operator, "=") == 0) return user_name_eq;
-        if (strcmp(operator, "!=") == 0) return user_name_neq;
-        if (strcmp(operator, ">") == 0) return user_name_gt;
-        if (strcmp(operator, "<") == 0) return user_name_lt;
-        if (strcmp(operator, ">=") == 0) return user_name_gte;
-        if (strcmp(operator, "<=") == 0) return user_name_lte;
-    } else if (strcmp(attribute, "base_command") == 0) {
-        if (strcmp(operator, "=") == 0) return base_command_eq;
-        if (strcmp(operator, "!=") == 0) return base_command_neq;
-        if (strcmp(operator, ">") == 0) return base_command_gt;
-        if (strcmp(operator, "<") == 0) return base_command_lt;
-        if (strcmp(operator, ">=") == 0) return base_command_gte;
-        if (strcmp(operator, "<=") == 0) return base_command_lte;
-    } else if (strcmp(attribute, "shell_type") == 0) {
-        if (strcmp(operator, "=") == 0) return shell_type_eq;
-        if (strcmp(operator, "!=") == 0) return shell_type_neq;
-        if (strcmp(operator, ">") == 0) return shell_type_gt;
-        if (strcmp(operator, "<") == 0) return shell_type_lt;
-        if (strcmp(operator, ">=") == 0) return shell_type_gte;
-        if (strcmp(operator, "<=") == 0) return shell_type_lte;
-    } else if (strcmp(attribute, "timestamp") == 0) {
-        if (strcmp(operator, "=") == 0) return timestamp_eq;
-        if (strcmp(operator, "!=") == 0) return timestamp_neq;
-        if (strcmp(operator, ">") == 0) return timestamp_gt;
-        if (strcmp(operator, "<") == 0) return timestamp_lt;
-        if (strcmp(operator, ">=") == 0) return timestamp_gte;
-        if (strcmp(operator, "<=") == 0) return timestamp_lte;
-    } else if (strcmp(attribute, "working_directory") == 0) {
-        if (strcmp(operator, "=") == 0) return working_directory_eq;
-        if (strcmp(operator, "!=") == 0) return working_directory_neq;
-        if (strcmp(operator, ">") == 0) return working_directory_gt;
-        if (strcmp(operator, "<") == 0) return working_directory_lt;
-        if (strcmp(operator, ">=") == 0) return working_directory_gte;
-        if (strcmp(operator, "<=") == 0) return working_directory_lte;
-    } else if (strcmp(attribute, "host_name") == 0) {
-        if (strcmp(operator, "=") == 0) return host_name_eq;
-        if (strcmp(operator, "!=") == 0) return host_name_neq;
-        if (strcmp(operator, ">") == 0) return host_name_gt;
-        if (strcmp(operator, "<") == 0) return host_name_lt;
-        if (strcmp(operator, ">=") == 0) return host_name_gte;
-        if (strcmp(operator, "<=") == 0) return host_name_lte;
-    } else if (strcmp(attribute, "sudo_used") == 0) {
-        if (strcmp(operator, "=") == 0) return sudo_used_eq;
-        if (strcmp(operator, "!=") == 0) return sudo_used_neq;
-    }
-    
-    return NULL;
-}
 
 /* Helper: Converts a specific attribute of a record to a string */
 char *get_attribute_string_value(record *r, const char *attribute) {
@@ -252,72 +61,137 @@ char *get_attribute_string_value(record *r, const char *attribute) {
     return strdup(buffer);
 }
 
-/* Helper function to check a single condition against a record */
-bool checkCondition(record *r, struct whereClauseS *condition) {
-    void *valuePtr;
-    bool result = false;
-    
-    // 1. Determine specific C type based on Attribute Name
-    if (strcmp(condition->attribute, "command_id") == 0) {
-        unsigned long long *val = malloc(sizeof(unsigned long long));
-        *val = strtoull(condition->value, NULL, 10);
-        valuePtr = val;
-    } 
-    else if (strcmp(condition->attribute, "risk_level") == 0 || 
-             strcmp(condition->attribute, "exit_code") == 0 ||
-             strcmp(condition->attribute, "user_id") == 0) {
-        int *val = malloc(sizeof(int));
-        *val = atoi(condition->value);
-        valuePtr = val;
+/* Grows a candidate list so it can hold at least `needed` records */
+static void reserveIndexMatches(record ***matches, int *capacity, int needed) {
+    if (needed > *capacity) {
+        int newCapacity = *capacity > 0 ? *capacity : INDEX_BATCH_ROWS;
+        while (newCapacity < needed) {
+            newCapacity *= 2;
+        }
+        record **grown = realloc(*matches, newCapacity * sizeof(record *));
+        if (grown == NULL) {
+            perror("Failed to grow index match buffer");
+            exit(EXIT_FAILURE);
+        }
+        *matches = grown;
+        *capacity = newCapacity;
     }
-    else if (strcmp(condition->attribute, "sudo_used") == 0) {
-        bool *val = malloc(sizeof(bool));
-        *val = (strcasecmp(condition->value, "true") == 0 || strcmp(condition->value, "1") == 0);
-        valuePtr = val;
+}
+
+/* Appends a batch of rows streamed from a B+ tree cursor to the candidate list, growing it as needed */
+static void appendIndexMatches(record ***matches, int *count, int *capacity, ROW_PTR rows[], int num_rows) {
+    reserveIndexMatches(matches, capacity, *count + num_rows);
+    for (int k = 0; k < num_rows; k++) {
+        (*matches)[(*count)++] = (record *)rows[k];
     }
-    else {
-        // String types
-        valuePtr = (void *)condition->value;
+}
+/* Full-table scan over the column store: the WHERE clause reads only the columns it names,
+ * and matching row ids are turned back into records for projection. The store is built on
+ * the first scan and kept in step with all_records by INSERT (DELETE drops it). SELECTs
+ * run side by side, so the first ones to scan build it one at a time.
+ */
+static record **columnScanRecords(struct engineS *engine, struct whereClauseS *whereClause, int *matchCount) {
+    #pragma omp critical(column_store_build)
+    {
+        if (engine->columns == NULL) {
+            engine->columns = columnStoreBuild(engine->all_records, engine->num_records);
+        }
     }
-
-    where_condition_func conditionFunc = create_where_condition(condition->attribute, condition->operator, valuePtr);
-    if (conditionFunc != NULL && conditionFunc((void *)r, valuePtr)) {
-        result = true;
+    int *rows = columnStoreSelect(engine->columns, whereClause, matchCount);
+    record **matches = malloc((*matchCount > 0 ? *matchCount : 1) * sizeof(record *));
+    if (matches == NULL) {
+        perror("Failed to allocate scan results");
+        exit(EXIT_FAILURE);
     }
-    
-    // Cleanup
-    if (valuePtr != condition->value) {
-        free(valuePtr);
+    for (int k = 0; k < *matchCount; k++) {
+        matches[k] = engine->all_records[rows[k]];
     }
-    
-    return result;
+    free(rows);
+    return matches;
 }
 
-/* Recursive evaluator for WHERE clause */
-bool evaluateWhereClause(record *r, struct whereClauseS *wc) {
-    if (wc == NULL) return true;
+/* True when r was allocated on its own by INSERT, rather than living in the loader's
+ * record block or a mapped snapshot (both are released as a whole by destroy)
+ */
+static bool ownsRecord(const struct engineS *engine, const record *r) {
+    uintptr_t block = (uintptr_t)engine->record_block;
+    bool in_block = block != 0 && (uintptr_t)r >= block && (uintptr_t)r < block + engine->record_block_bytes;
+    return !in_block && !snapshotContains(engine->record_map, engine->record_map_bytes, r);
+}
 
-    bool currentResult = false;
 
-    if (wc->sub != NULL) {
-        currentResult = evaluateWhereClause(r, wc->sub);
-    } else {
-        currentResult = checkCondition(r, wc);
-    }
+/* Splits num_threads between the batch_size queries of a batch run side by side: returns the
+ * outer team size and sets *scan_threads to what each query's own scans get. A batch of more
+ * than one query nests the scans' teams inside the outer one, so a second active level is
+ * allowed for it.
+ */
+int queryBatchTeamOMP(int batch_size, int num_threads, int *scan_threads) {
+    int outer = batch_size < num_threads ? batch_size : num_threads;
+    if (outer < 1) outer = 1;
+    *scan_threads = num_threads / outer > 1 ? num_threads / outer : 1;
+    omp_set_max_active_levels(outer > 1 ? 2 : 1);
+    return outer;
+}
+
+/* Threads a parallel region started by the caller would run on: 1 once the caller is nested
+ * as deep as max-active-levels allows, where OpenMP serialises the region anyway
+ */
+int scanTeamSizeOMP(void) {
+    return omp_get_active_level() < omp_get_max_active_levels() ? omp_get_max_threads() : 1;
+}
 
-    if (wc->next == NULL) {
-        return currentResult;
+/* Scans [key_start, key_end] of an index and appends the matches in key order.
+ * The range is cut at internal-node separators (bptreeSplitRange) so each thread drains
+ * its own leaf segment into a private buffer; the buffers are concatenated afterwards.
+ * Ranges too small to split (a single leaf's worth), and calls that could not form a team
+ * (scanTeamSizeOMP), are scanned by the calling thread.
+ */
+static void scanIndexRangeOMP(bptree *tree, KEY_T key_start, KEY_T key_end,
+                              record ***matches, int *count, int *capacity) {
+    int team = scanTeamSizeOMP();
+    int max_parts = team * PARALLEL_SCAN_PARTS_PER_THREAD;
+    KEY_T cuts[max_parts];
+    int num_cuts = team > 1 ? bptreeSplitRange(tree, key_start, key_end, max_parts, cuts) : 0;
+    int parts = num_cuts + 1;
+
+    record **partMatches[parts];
+    int partCount[parts];
+    int partCapacity[parts];
+
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(team) if (parts > 1)
+    for (int p = 0; p < parts; p++) {
+        bplus_cursor cursor;
+        ROW_PTR batch[INDEX_BATCH_ROWS];
+        int num_found;
+        KEY_T lo = p == 0 ? key_start : cuts[p - 1];
+
+        partMatches[p] = NULL;
+        partCount[p] = 0;
+        partCapacity[p] = 0;
+        if (p == parts - 1) {
+            bptreeCursorOpen(&cursor, tree, lo, key_end);
+        } else {
+            bptreeCursorOpenBefore(&cursor, tree, lo, cuts[p]);
+        }
+        while ((num_found = bptreeCursorNextBatch(&cursor, batch, INDEX_BATCH_ROWS)) > 0) {
+            appendIndexMatches(&partMatches[p], &partCount[p], &partCapacity[p], batch, num_found);
+        }
+        bptreeCursorClose(&cursor);
     }
 
-    if (wc->logical_op != NULL) {
-        if (strcmp(wc->logical_op, "OR") == 0) {
-            return currentResult || evaluateWhereClause(r, wc->next);
-        } else if (strcmp(wc->logical_op, "AND") == 0) {
-            return currentResult && evaluateWhereClause(r, wc->next);
+    // Concatenate the thread-local buffers in key order
+    int total = *count;
+    for (int p = 0; p < parts; p++) {
+        total += partCount[p];
+    }
+    reserveIndexMatches(matches, capacity, total);
+    for (int p = 0; p < parts; p++) {
+        if (partCount[p] > 0) {
+            memcpy(&(*matches)[*count], partMatches[p], partCount[p] * sizeof(record *));
+            *count += partCount[p];
         }
+        free(partMatches[p]);
     }
-    
-    return currentResult && evaluateWhereClause(r, wc->next);
 }
 
 /* Main functionality for a SELECT query
@@ -338,13 +212,8 @@ struct resultSetS *executeQuerySelectOMP(
     struct whereClauseS *whereClause  // WHERE clause (NULL if no filtering)
 ) {
 
-    // Flags to track if any indexed attributes are in the WHERE clause
-    bool anyIndexExists = false;  // Flag for quick fallback to full table scan
-    bool indexExists[engine->num_indexes];  // Track which indexes exist for WHERE attributes
-
-    // Allocate space for matching records and result struct
-    // Use num_records as upper bound to avoid reallocating during index search
-    record **matchingRecords = (record **)malloc(engine->num_records * sizeof(record *));
+    // Allocate the result struct; the matching records are collected after planning
+    record **matchingRecords = NULL;
     struct resultSetS *queryResults = (struct resultSetS *)malloc(sizeof(struct resultSetS));
     int matchCount = 0;
 
@@ -359,160 +228,57 @@ struct resultSetS *executeQuerySelectOMP(
     // Start the timer
     clock_t start = clock();  // Start a timer
 
-    // Get all indexed attributes in the WHERE clause, using the B+ tree indexes where possible
-    struct whereClauseS *wc = whereClause;
-    while (wc != NULL) {
-        // Parallelized
-        #pragma omp parallel for
-        for (int i = 0; i < engine->num_indexes; i++) {
-            if (wc->attribute != NULL && strcmp(wc->attribute, engine->indexed_attributes[i]) == 0) {
-                // Use B+ tree index for this attribute
-                node *cur_root = engine->bplus_tree_roots[i]; // B+ tree root for this indexed attribute
-                FieldType type = engine->attribute_types[i];
-                
-                KEY_T key_start, key_end;
-                bool typeSupported = true;
-
-                if (type == FIELD_UINT64) {
-                    unsigned long long val = strtoull(wc->value, NULL, 10);
-                    key_start.type = KEY_UINT64;
-                    key_end.type = KEY_UINT64;
-                    
-                    if (strcmp(wc->operator, "=") == 0) {
-                        key_start.v.u64 = val;
-                        key_end.v.u64 = val;
-                    } else if (strcmp(wc->operator, ">") == 0) {
-                        key_start.v.u64 = val + 1;
-                        key_end.v.u64 = UINT64_MAX;
-                    } else if (strcmp(wc->operator, ">=") == 0) {
-                        key_start.v.u64 = val;
-                        key_end.v.u64 = UINT64_MAX;
-                    } else if (strcmp(wc->operator, "<") == 0) {
-                        key_start.v.u64 = 0;
-                        key_end.v.u64 = val - 1;
-                    } else if (strcmp(wc->operator, "<=") == 0) {
-                        key_start.v.u64 = 0;
-                        key_end.v.u64 = val;
-                    } else {
-                        key_start.v.u64 = 0;
-                        key_end.v.u64 = UINT64_MAX;
-                    }
-                } else if (type == FIELD_INT) {
-                    int val = atoi(wc->value);
-                    key_start.type = KEY_INT;
-                    key_end.type = KEY_INT;
-                    
-                    if (strcmp(wc->operator, "=") == 0) {
-                        key_start.v.i32 = val;
-                        key_end.v.i32 = val;
-                    } else if (strcmp(wc->operator, ">") == 0) {
-                        key_start.v.i32 = val + 1;
-                        key_end.v.i32 = INT_MAX;
-                    } else if (strcmp(wc->operator, ">=") == 0) {
-                        key_start.v.i32 = val;
-                        key_end.v.i32 = INT_MAX;
-                    } else if (strcmp(wc->operator, "<") == 0) {
-                        key_start.v.i32 = INT_MIN;
-                        key_end.v.i32 = val - 1;
-                    } else if (strcmp(wc->operator, "<=") == 0) {
-                        key_start.v.i32 = INT_MIN;
-                        key_end.v.i32 = val;
-                    } else {
-                        key_start.v.i32 = INT_MIN;
-                        key_end.v.i32 = INT_MAX;
-                    }
-                } else if (type == FIELD_BOOL) {
-                    bool val = (strcasecmp(wc->value, "true") == 0 || strcmp(wc->value, "1") == 0);
-                    key_start.type = KEY_BOOL;
-                    key_end.type = KEY_BOOL;
-                    
-                    if (strcmp(wc->operator, "=") == 0) {
-                        key_start.v.b = val;
-                        key_end.v.b = val;
-                    } else if (strcmp(wc->operator, "!=") == 0) {
-                        key_start.v.b = !val;
-                        key_end.v.b = !val;
-                    } else {
-                        bool start_b = false;
-                        bool end_b = true;
-                        
-                        if (strcmp(wc->operator, ">") == 0) {
-                            // > val
-                            if (val == false) { start_b = true; end_b = true; } // > false -> true
-                            else { start_b = true; end_b = false; } // > true -> impossible
-                        } else if (strcmp(wc->operator, ">=") == 0) {
-                            // >= val
-                            if (val == false) { start_b = false; end_b = true; } // >= false -> false, true
-                            else { start_b = true; end_b = true; } // >= true -> true
-                        } else if (strcmp(wc->operator, "<") == 0) {
-                            // < val
-                            if (val == true) { start_b = false; end_b = false; } // < true -> false
-                            else { start_b = true; end_b = false; } // < false -> impossible
-                        } else if (strcmp(wc->operator, "<=") == 0) {
-                            // <= val
-                            if (val == true) { start_b = false; end_b = true; } // <= true -> false, true
-                            else { start_b = false; end_b = false; } // <= false -> false
-                        }
-                        
-                        key_start.v.b = start_b;
-                        key_end.v.b = end_b;
-                    }
-                } else {
-                    // Fallback for unsupported types in index search
-                    typeSupported = false;
-                    indexExists[i] = false;
-                }
-
-                if (!typeSupported) {
-                    continue;
-                }
+    // Writers wait until the matched records are projected, so none is freed or moved under us
+    pthread_rwlock_rdlock(&engine->locks->records);
 
-                anyIndexExists = true;
-                indexExists[i] = true;                // Allocating for keys, using num_records as upper bound.
-                KEY_T *returned_keys = malloc(engine->num_records * sizeof(KEY_T));
-                ROW_PTR *returned_pointers = malloc(engine->num_records * sizeof(ROW_PTR));
-
-                int num_found = findRange(cur_root, key_start, key_end, false, returned_keys, returned_pointers);
+    // COUNT(*) over no filter or one indexed comparison is read off the B+ tree subtree counts
+    bool countStar = isCountStar(selectItems, numItems);
+    int indexCount = 0;
+    if (countStar && countFromIndex(engine, whereClause, &indexCount)) {
+        pthread_rwlock_unlock(&engine->locks->records);
+        free(queryResults);
+        return makeCountResult(indexCount, ((double) clock() - start) / CLOCKS_PER_SEC);
+    }
 
-                // Add found records to matchingRecords
-                if (num_found > 0) {
-                    // Reallocate matchingRecords if needed (though we alloc'd max size initially)
-                    for (int k = 0; k < num_found; k++) {
-                        #pragma omp critical
-                        matchingRecords[matchCount++] = (record *)returned_pointers[k];
-                    }
-                }
+    // Plan the index lookups: the indexed conditions become row sets, intersected and
+    // unioned by the clause's AND / OR structure
+    index_plan plan;
+    indexPlanBuild(&plan, engine, whereClause);
+    indexPlanChoose(&plan);
 
-                free(returned_keys);
-                free(returned_pointers);
-            }
-            else {
-                indexExists[i] = false;
+    if (plan.root == NULL) {
+        // No index narrows the WHERE clause: scan the column store
+        matchingRecords = columnScanRecords(engine, whereClause, &matchCount);
+    } else {
+        // Scan each used index range, split into leaf segments across this query's scan threads
+        for (int l = 0; l < plan.num_leaves; l++) {
+            index_leaf *leaf = &plan.leaves[l];
+            if (leaf->used && !leaf->empty) {
+                scanIndexRangeOMP(engine->bplus_tree_roots[leaf->index], leaf->key_start, leaf->key_end,
+                                  &leaf->rows, &leaf->count, &leaf->capacity);
             }
         }
-        wc = wc->next;
-    }
-
 
-    // Perform linear search if on all non-indexed attributes or no indexes matched
-    // No indexes exist for any WHERE attributes, search entire table
-    if(!anyIndexExists){
-        free(matchingRecords); // Free the empty one we made
-        matchingRecords = linearSearchRecords(engine->all_records, engine->num_records, whereClause, &matchCount);
-    }
-    // There were some indexes in the WHERE clause, so we can use the known matching records to reduce linear search
-    else{
-        // Filter the candidate records found via index against the full WHERE clause
-        record **filteredRecords = linearSearchRecords(matchingRecords, matchCount, whereClause, &matchCount);
-        free(matchingRecords);
-        matchingRecords = filteredRecords;
+        // Filter the combined candidates against the full WHERE clause
+        record **candidates = indexPlanCandidates(&plan, &matchCount, NULL);
+        matchingRecords = linearSearchRecords(candidates, matchCount, whereClause, &matchCount);
+        free(candidates);
     }
+    indexPlanFree(&plan);
     double end = (double) clock();
     double time_taken = ((double) end - start) / CLOCKS_PER_SEC;  // Time in seconds
     if (VERBOSE) {
         printf("Linear search took %f seconds\n", time_taken);
     }
 
+    // COUNT(*) that needed a scan: only the number of matches is returned
+    if (countStar) {
+        pthread_rwlock_unlock(&engine->locks->records);
+        free(matchingRecords);
+        free(queryResults);
+        return makeCountResult(matchCount, time_taken);
+    }
+
     // Extract the requested attributes from matching records and format the result
     queryResults->numRecords = matchCount;
     
@@ -551,6 +317,7 @@ struct resultSetS *executeQuerySelectOMP(
 
     // Clean up the temporary array of pointers (temp array, NOT records themselves)
     free(matchingRecords);
+    pthread_rwlock_unlock(&engine->locks->records);
     
     queryResults->queryTime = time_taken;
     queryResults->success = true;
@@ -595,6 +362,10 @@ bool executeQueryInsertOMP(
     }
     *record_copy = *newRecord;  // Copy the contents
 
+    // One writer at a time; SELECTs keep running until the record array itself changes
+    pthread_mutex_lock(&engine->locks->writer);
+    copy_record_strings(record_copy, engine->strings);  // The caller's strings need not outlive the query
+
     bool success = true;
     bool file_success = true;
     bool memory_success = true;
@@ -632,6 +403,8 @@ bool executeQueryInsertOMP(
         #pragma omp section
         {
             // Section 2: Memory Update
+            // realloc may move all_records, so no SELECT may be reading it
+            pthread_rwlock_wrlock(&engine->locks->records);
             record **temp = (record **)realloc(engine->all_records, (engine->num_records + 1) * sizeof(record *));
             if (temp == NULL) {
                 if (VERBOSE) {
@@ -642,7 +415,11 @@ bool executeQueryInsertOMP(
                 engine->all_records = temp;
                 engine->all_records[engine->num_records] = record_copy;
                 engine->num_records += 1;
+                if (engine->columns != NULL) {
+                    columnStoreAppend(engine->columns, record_copy);  // Same row id as in all_records
+                }
             }
+            pthread_rwlock_unlock(&engine->locks->records);
         }
 
         #pragma omp section
@@ -652,23 +429,34 @@ bool executeQueryInsertOMP(
             for (int i = 0; i < engine->num_indexes; i++) {
                 const char *indexed_attr = engine->indexed_attributes[i];
                 
-                node *root = engine->bplus_tree_roots[i];
-                KEY_T key = extract_key_from_record(record_copy, indexed_attr);
-                root = insert(root, key, (ROW_PTR)record_copy);
-                engine->bplus_tree_roots[i] = root;
-                
-                if(root == NULL) {
+                bptree *tree = engine->bplus_tree_roots[i];
+                if(tree == NULL) {
                     if (VERBOSE) {
                         #pragma omp critical
                         fprintf(stderr, "Failed to insert new record into B+ tree for attribute: %s\n", indexed_attr);
                     }
                     #pragma omp atomic write
                     index_success = false;
+                    continue;
                 }
+                KEY_T key = extract_key_from_record(record_copy, indexed_attr);
+                insert(tree, key, (ROW_PTR)record_copy);
             }
         }
     }
 
+    // Statistics follow once every tree holds the row, so a rebuild walks finished trees
+    pthread_rwlock_wrlock(&engine->locks->records);
+    for (int i = 0; i < engine->num_indexes; i++) {
+        bptree *tree = engine->bplus_tree_roots[i];
+        if (tree != NULL) {
+            columnStatsAdd(&engine->index_stats[i], extract_key_from_record(record_copy, engine->indexed_attributes[i]));
+            columnStatsRefresh(&engine->index_stats[i], tree);
+        }
+    }
+    pthread_rwlock_unlock(&engine->locks->records);
+    pthread_mutex_unlock(&engine->locks->writer);
+
     if (!file_success || !memory_success || !index_success) {
         success = false;
     }
@@ -696,40 +484,15 @@ struct resultSetS *executeQueryDeleteOMP(
 
     double start = omp_get_wtime();
 
+    // One writer at a time. Until the records are freed and compacted, SELECTs run beside this
+    // DELETE: the search and file rewrite only read all_records, and delete() latches the trees
+    pthread_mutex_lock(&engine->locks->writer);
+
     int num_records = engine->num_records;
     int deletedCount = 0;
 
-    // Compute delete flags in parallel
-    int *deleteFlags = (int *)calloc(num_records, sizeof(int));
-    if (!deleteFlags) {
-        return result; // result->success stays false
-    }
-
-    #pragma omp parallel
-    {
-        int localDeleted = 0;
-
-        #pragma omp for nowait
-        for (int i = 0; i < num_records; i++) {
-            record *currentRecord = engine->all_records[i];
-            bool shouldDelete;
-
-            if (whereClause == NULL) {
-                shouldDelete = true;  // Delete all if no WHERE clause
-            } else {
-                shouldDelete = evaluateWhereClause(currentRecord, whereClause);
-            }
-
-            if (shouldDelete) {
-                deleteFlags[i] = 1;
-                localDeleted++;
-            }
-        }
-
-        // Synchronize and update global deleted count
-        #pragma omp atomic
-        deletedCount += localDeleted;
-    }
+    // Matching records in table order, found by the parallel linear search
+    record **deleted = linearSearchRecords(engine->all_records, num_records, whereClause, &deletedCount);
 
     // Mutate engine, update B+ trees, free records, compact array
     int writeIndex = 0;
@@ -741,31 +504,21 @@ struct resultSetS *executeQueryDeleteOMP(
     bool tree_success = true;
     bool file_success = true;
 
-    #pragma omp parallel sections shared(engine, deleteFlags, tree_success, file_success)
+    #pragma omp parallel sections shared(engine, deleted, tree_success, file_success)
     {
         #pragma omp section
         {
             // Section 1: Update B+ Trees (Remove deleted records)
-            // We iterate through all records, check if they are marked for deletion
-            // Note: We are reading engine->all_records, which is safe as long as we don't modify it yet
-            #pragma omp parallel for shared(engine, deleteFlags) schedule(dynamic)
-            for (int i = 0; i < num_records; i++) {
-                if (deleteFlags[i]) {
-                    record *currentRecord = engine->all_records[i];
-                    for (int j = 0; j < engine->num_indexes; j++) {
-                        const char *indexed_attr = engine->indexed_attributes[j];
-                        KEY_T key = extract_key_from_record(currentRecord, indexed_attr);
-                        // B+ tree delete is not thread-safe for the same tree, so we need critical sections per tree?
-                        // Or we can assume different trees are independent, but multiple threads might hit the same tree.
-                        // The original code had a loop over records, then loop over indexes.
-                        // To parallelize safely, we should probably lock per tree or just run this section serially if B+ tree isn't thread safe.
-                        // Given the assignment context, we'll assume we need to protect the tree access.
-                        
-                        #pragma omp critical
-                        {
-                            engine->bplus_tree_roots[j] = delete(engine->bplus_tree_roots[j], key, (ROW_PTR)currentRecord);
-                        }
-                    }
+            // Note: the records are only read here; they are freed once both sections finish
+            #pragma omp parallel for shared(engine, deleted) schedule(dynamic)
+            for (int k = 0; k < deletedCount; k++) {
+                record *currentRecord = deleted[k];
+                for (int j = 0; j < engine->num_indexes; j++) {
+                    const char *indexed_attr = engine->indexed_attributes[j];
+                    KEY_T key = extract_key_from_record(currentRecord, indexed_attr);
+                    // delete() latches the tree nodes it changes, so threads hitting the same tree
+                    // only wait on each other where their paths overlap
+                    delete(engine->bplus_tree_roots[j], key, (ROW_PTR)currentRecord);
                 }
             }
         }
@@ -773,10 +526,23 @@ struct resultSetS *executeQueryDeleteOMP(
         #pragma omp section
         {
             // Section 2: Rewrite File (Write only non-deleted records)
-            FILE *file = fopen(engine->datafile, "w");
+            // Written beside the data file and renamed over it: the loader maps the data file,
+            // and truncating it in place would drop the mapped pages the records point into
+            size_t tmp_length = strlen(engine->datafile) + 32;
+            char *tmp_path = malloc(tmp_length);
+            if (tmp_path == NULL) {
+                perror("Data file path allocation failed");
+                exit(EXIT_FAILURE);
+            }
+            snprintf(tmp_path, tmp_length, "%s.tmp.%ld", engine->datafile, (long)getpid());
+            FILE *file = fopen(tmp_path, "w");
             if (file != NULL) {
+                // deleted[] is in table order, so one cursor walks it alongside the records
+                int next = 0;
                 for (int i = 0; i < num_records; i++) {
-                    if (!deleteFlags[i]) {
+                    if (next < deletedCount && engine->all_records[i] == deleted[next]) {
+                        next++;
+                    } else {
                         record *r = engine->all_records[i];
                         fprintf(file, "%llu,%s,%s,%s,%d,%s,%d,%s,%d,%s,%s,%d\n",
                             r->command_id,
@@ -793,23 +559,41 @@ struct resultSetS *executeQueryDeleteOMP(
                             r->risk_level);
                     }
                 }
-                fclose(file);
+                file_success = fclose(file) == 0 && rename(tmp_path, engine->datafile) == 0;
+                if (!file_success) {
+                    remove(tmp_path);
+                }
             } else {
                 if (VERBOSE) {
                     fprintf(stderr, "Failed to open data file for rewriting: %s\n", engine->datafile);
                 }
                 file_success = false;
             }
+            free(tmp_path);
         }
     }
 
+    // From here on the statistics, records and column store change under the SELECTs' feet
+    pthread_rwlock_wrlock(&engine->locks->records);
+
+    // Statistics follow the trees, one index per thread; drifted ones are gathered again
+    #pragma omp parallel for schedule(dynamic) if (deletedCount >= LINEAR_SCAN_MIN_ROWS)
+    for (int j = 0; j < engine->num_indexes; j++) {
+        for (int k = 0; k < deletedCount; k++) {
+            columnStatsRemove(&engine->index_stats[j], extract_key_from_record(deleted[k], engine->indexed_attributes[j]));
+        }
+        columnStatsRefresh(&engine->index_stats[j], engine->bplus_tree_roots[j]);
+    }
+
     // Serial Phase: Compact memory and free deleted records
     // This must happen after B+ tree updates and File writing are done reading the records
+    int next = 0;
     for (int i = 0; i < num_records; i++) {
         record *currentRecord = engine->all_records[i];
 
-        if (deleteFlags[i]) {
-            free(currentRecord);
+        if (next < deletedCount && currentRecord == deleted[next]) {
+            if (ownsRecord(engine, currentRecord)) free(currentRecord);
+            next++;
         } else {
             if (writeIndex != i) {
                 engine->all_records[writeIndex] = currentRecord;
@@ -819,6 +603,13 @@ struct resultSetS *executeQueryDeleteOMP(
     }
 
     engine->num_records = writeIndex;
+    free(deleted);
+
+    // Row ids shifted; the column store is rebuilt by the next full-table scan
+    columnStoreDestroy(engine->columns);
+    engine->columns = NULL;
+    pthread_rwlock_unlock(&engine->locks->records);
+    pthread_mutex_unlock(&engine->locks->writer);
 
     double time_taken = omp_get_wtime() - start;
 
@@ -856,21 +647,36 @@ struct engineS *initializeEngineOMP(
     // Initialize indexes and tree roots
     engine->tableName = strdup(tableName);
     engine->num_indexes = 0; // Start at 0, makeIndexSerial will increment
-    engine->bplus_tree_roots = (node **)malloc(num_indexes * sizeof(node *));
+    engine->bplus_tree_roots = (bptree **)malloc(num_indexes * sizeof(bptree *));
     engine->indexed_attributes = (char **)malloc(num_indexes * sizeof(char *));
     engine->attribute_types = (FieldType *)malloc(num_indexes * sizeof(FieldType));
+    engine->index_stats = (column_stats *)malloc(num_indexes * sizeof(column_stats));
     engine->all_records = NULL; // Initialize to NULL, will be set later
     engine->num_records = 0; // Initialize record count to 0
-    if (engine->bplus_tree_roots == NULL || engine->indexed_attributes == NULL || engine->attribute_types == NULL) {
+    engine->record_block = NULL; // Set by the CSV loader
+    engine->record_block_bytes = 0;
+    engine->record_map = NULL; // No snapshot mapped yet
+    engine->record_map_bytes = 0;
+    engine->columns = NULL; // Built by the first full-table scan
+    engine->strings = stringHeapCreate(); // String fields of parsed and inserted records
+    engine->locks = (struct engine_locks *)malloc(sizeof(struct engine_locks)); // QPEOMP runs queries side by side
+    if (engine->bplus_tree_roots == NULL || engine->indexed_attributes == NULL || engine->attribute_types == NULL ||
+        engine->index_stats == NULL || engine->locks == NULL) {
         perror("Failed to allocate memory for engine components");
         free(engine);
         exit(EXIT_FAILURE);
     }
+    pthread_rwlock_init(&engine->locks->records, NULL);
+    pthread_mutex_init(&engine->locks->writer, NULL);
 
     // Read all records from the database into memory and store in engine->all_records
     if(!datafile){ datafile = "../data/commands_50k.csv"; }; // Filepath default
     engine->datafile = strdup(datafile);
-    engine->all_records = getAllRecordsFromFileOMP(datafile, &engine->num_records, &engine->record_block);  // Directly update record count
+    // A snapshot of an unchanged data file is mapped in place; otherwise the CSV is parsed
+    engine->all_records = snapshotLoad(datafile, &engine->num_records, &engine->record_map, &engine->record_map_bytes);
+    if (engine->all_records == NULL) {
+        engine->all_records = getAllRecordsFromFileOMP(datafile, &engine->num_records, &engine->record_block, &engine->record_block_bytes, engine->strings);  // Directly update record count
+    }
 
     // Copy indexed attribute names and types into engine struct (defaults)
     engine->num_indexes = num_indexes; // Set total count upfront
@@ -880,13 +686,21 @@ struct engineS *initializeEngineOMP(
         // Build B+ tree index for each indexed attribute in parallel
         // We inline the logic of makeIndexOMP to allow parallel execution without race conditions on num_indexes
         
-        node *root = loadIntoBplusTreeOMP(engine->all_records, engine->num_records, indexed_attributes[i]);
+        // Saved index files are reused while the data file is unchanged (see indexFile.h)
+        bptree *root = indexFileLoad(engine->datafile, indexed_attributes[i], engine->all_records, engine->num_records);
+        if (root == NULL) {
+            root = loadIntoBplusTreeOMP(engine->all_records, engine->num_records, indexed_attributes[i]);
+            if (root != NULL) {
+                indexFileSave(engine->datafile, indexed_attributes[i], root, engine->all_records, engine->num_records);
+            }
+        }
         
         if (root == NULL) {
             fprintf(stderr, "Failed to create index for attribute: %s\n", indexed_attributes[i]);
         }
         
         engine->bplus_tree_roots[i] = root;
+        columnStatsBuild(&engine->index_stats[i], root);  // For the index planner
         engine->indexed_attributes[i] = strdup(indexed_attributes[i]);
         engine->attribute_types[i] = mapAttributeTypeOMP(attribute_types[i]);
     }
@@ -918,21 +732,37 @@ void destroyEngineOMP(struct engineS *engine) {
         /* Free: attribute types array */
         if (engine->attribute_types != NULL) free(engine->attribute_types);
 
+        /* Free: index statistics */
+        free(engine->index_stats);
+
         /* Free: all records allocated from file */
-        if (engine->record_block != NULL) {
-            // If block allocation was used, free the block
-            free(engine->record_block);
-        } else if (engine->all_records != NULL) {
-            // Fallback: free individual records if block is not set
+        if (engine->all_records != NULL) {
+            // Inserted records were allocated one by one; loaded ones go with their block or mapping
             for (int i = 0; i < engine->num_records; i++) {
-                if (engine->all_records[i] != NULL) free(engine->all_records[i]);
+                record *r = engine->all_records[i];
+                if (r != NULL && ownsRecord(engine, r)) free(r);
             }
         }
+        free(engine->record_block);
         
         if (engine->all_records != NULL) {
             free(engine->all_records);
         }
 
+        /* Free: column store */
+        columnStoreDestroy(engine->columns);
+
+        /* Free: mapped snapshot */
+        snapshotUnmap(engine->record_map, engine->record_map_bytes);
+
+        /* Free: string fields of all records */
+        stringHeapDestroy(engine->strings);
+
+        /* Free: query locks */
+        pthread_rwlock_destroy(&engine->locks->records);
+        pthread_mutex_destroy(&engine->locks->writer);
+        free(engine->locks);
+
         /* Free: duplicated strings */
         if (engine->tableName) free(engine->tableName);
         if (engine->datafile) free(engine->datafile);
@@ -959,8 +789,12 @@ bool addAttributeIndexOMP(
     const char *attributeName,  // Name of the attribute to index
     int attributeType  // Attribute type to index (0 = Uinteger, 1= = int, 2 = string, 3 = boolean)
 ) {
-    // Create a new B+ tree index for the specified attribute
+    // Create a new B+ tree index for the specified attribute; the index arrays may move
+    pthread_mutex_lock(&engine->locks->writer);
+    pthread_rwlock_wrlock(&engine->locks->records);
     bool makeIndexSuccess = makeIndexOMP(engine, attributeName, attributeType);
+    pthread_rwlock_unlock(&engine->locks->records);
+    pthread_mutex_unlock(&engine->locks->writer);
     if (makeIndexSuccess) {
         if (VERBOSE) {
             fprintf(stderr, "Failed to create B+ tree index for attribute: %s\n", attributeName);
@@ -981,30 +815,65 @@ int isAttributeIndexed(struct engineS *engine, const char *attributeName) {
     return -1;  // Attribute is not indexed, return -1 as signal value
 }
 
-/* Performs a linear search through a given array of records based on the WHERE clause */
+/* Performs a linear search through a given array of records based on the WHERE clause.
+ * The array is cut into chunks that threads scan into private match buffers; a prefix sum
+ * over the chunk counts then places every chunk in one exactly sized result, so the
+ * matches keep the order of records. Short arrays, and calls that could not form a team
+ * (scanTeamSizeOMP), are scanned by the calling thread.
+ */
 record **linearSearchRecords(record **records, int num_records, struct whereClauseS *whereClause, int *matchingRecords) {
-    // Allocate space for results array
-    record **results = malloc(sizeof(record *));
-    *matchingRecords = 0;
-
-    // Iterate through all records and apply WHERE clause filtering
-    for(int i = 0; i < num_records; i++) {
-        record *currentRecord = records[i];
-        bool matches = true;
-
-        if (whereClause != NULL) {
-            matches = evaluateWhereClause(currentRecord, whereClause);
+    int team = scanTeamSizeOMP();
+    int parts = team * PARALLEL_SCAN_PARTS_PER_THREAD;
+    int max_parts = (num_records + LINEAR_SCAN_MIN_ROWS - 1) / LINEAR_SCAN_MIN_ROWS;
+    if (parts > max_parts) parts = max_parts;
+    if (parts < 1) parts = 1;
+
+    record **partMatches[parts];
+    int partCount[parts];
+    int partCapacity[parts];
+
+    // Compile the WHERE clause once; the threads share the read-only program
+    where_program program;
+    whereCompile(&program, whereClause);
+
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(team) if (parts > 1)
+    for (int p = 0; p < parts; p++) {
+        int begin = (int)((long long)num_records * p / parts);
+        int end = (int)((long long)num_records * (p + 1) / parts);
+        partMatches[p] = NULL;
+        partCount[p] = 0;
+        partCapacity[p] = 0;
+        for (int i = begin; i < end; i++) {
+            if (whereMatches(&program, records[i])) {
+                reserveIndexMatches(&partMatches[p], &partCapacity[p], partCount[p] + 1);
+                partMatches[p][partCount[p]++] = records[i];
+            }
         }
+    }
+    whereProgramFree(&program);
 
-        // If record matches all conditions, add to results
-        if (matches) {
-            results = realloc(results, (*matchingRecords + 1) * sizeof(record *));
-            results[*matchingRecords] = currentRecord;
-            (*matchingRecords)++;
+    // Exclusive prefix sum of the chunk counts gives each chunk its offset in the result
+    int offsets[parts];
+    int total = 0;
+    for (int p = 0; p < parts; p++) {
+        offsets[p] = total;
+        total += partCount[p];
+    }
+
+    record **results = malloc((total > 0 ? total : 1) * sizeof(record *));
+    if (results == NULL) {
+        perror("Failed to allocate linear search results");
+        exit(EXIT_FAILURE);
+    }
+    #pragma omp parallel for schedule(static) num_threads(team) if (parts > 1 && total >= LINEAR_SCAN_MIN_ROWS)
+    for (int p = 0; p < parts; p++) {
+        if (partCount[p] > 0) {
+            memcpy(&results[offsets[p]], partMatches[p], partCount[p] * sizeof(record *));
         }
+        free(partMatches[p]);
     }
 
-    // Return the array of matching records
+    *matchingRecords = total;
     return results;
 }
 
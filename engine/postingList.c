@@ -0,0 +1,255 @@
+/*
+ * Posting lists: compact sorted row sets for duplicate index keys.
+ * Used by the B+ tree so low-cardinality columns keep one key entry per value.
+ */
+
+#include "../include/postingList.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Worst-case LEB128 bytes for one uintptr_t delta.
+#define VARINT_MAX_BYTES ((int)((sizeof(uintptr_t) * 8 + 6) / 7))
+
+/* ==================== Block encoding ==================== */
+
+/* encodeBlock: Rewrites block b from count sorted rows. */
+static void encodeBlock(posting_block *b, const uintptr_t rows[], int count) {
+    unsigned char scratch[POSTING_BLOCK_ROWS * VARINT_MAX_BYTES];
+    int bytes = 0;
+
+    for (int i = 1; i < count; i++) {
+        uintptr_t delta = rows[i] - rows[i - 1];
+        while (delta >= 0x80) {
+            scratch[bytes++] = (unsigned char)(delta | 0x80);
+            delta >>= 7;
+        }
+        scratch[bytes++] = (unsigned char)delta;
+    }
+
+    if (bytes == 0) {
+        free(b->data);
+        b->data = NULL;
+    } else if (bytes != b->num_bytes || b->data == NULL) {
+        unsigned char *data = realloc(b->data, bytes);
+        if (data == NULL) {
+            perror("Posting block allocation failed");
+            exit(EXIT_FAILURE);
+        }
+        b->data = data;
+    }
+    if (bytes > 0)
+        memcpy(b->data, scratch, bytes);
+    b->first = rows[0];
+    b->count = count;
+    b->num_bytes = bytes;
+}
+
+/* decodeBlock: Expands block b into rows (room for b->count); returns the count. */
+static int decodeBlock(const posting_block *b, uintptr_t rows[]) {
+    const unsigned char *p = b->data;
+    uintptr_t row = b->first;
+    rows[0] = row;
+    for (int i = 1; i < b->count; i++) {
+        uintptr_t delta = 0;
+        int shift = 0;
+        unsigned char byte;
+        do {
+            byte = *p++;
+            delta |= (uintptr_t)(byte & 0x7F) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+        row += delta;
+        rows[i] = row;
+    }
+    return b->count;
+}
+
+/* rowLowerBound: First index in rows[0..n) that is >= row. */
+static int rowLowerBound(const uintptr_t rows[], int n, uintptr_t row) {
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        if (rows[mid] < row) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/* ==================== Block directory ==================== */
+
+/* findBlock: Last block whose first row is <= row (block 0 if row is below all of them). */
+static int findBlock(const posting_list *pl, uintptr_t row) {
+    int lo = 0, hi = pl->num_blocks;
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        if (pl->blocks[mid].first <= row) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo > 0 ? lo - 1 : 0;
+}
+
+/* insertBlockAt: Opens an empty directory slot at index. */
+static posting_block *insertBlockAt(posting_list *pl, int index) {
+    if (pl->num_blocks == pl->cap_blocks) {
+        int cap = pl->cap_blocks ? pl->cap_blocks * 2 : 1;
+        posting_block *blocks = realloc(pl->blocks, cap * sizeof(posting_block));
+        if (blocks == NULL) {
+            perror("Posting directory allocation failed");
+            exit(EXIT_FAILURE);
+        }
+        pl->blocks = blocks;
+        pl->cap_blocks = cap;
+    }
+    memmove(&pl->blocks[index + 1], &pl->blocks[index],
+            (pl->num_blocks - index) * sizeof(posting_block));
+    pl->num_blocks++;
+    memset(&pl->blocks[index], 0, sizeof(posting_block));
+    return &pl->blocks[index];
+}
+
+/* removeBlockAt: Frees and closes the directory slot at index. */
+static void removeBlockAt(posting_list *pl, int index) {
+    free(pl->blocks[index].data);
+    memmove(&pl->blocks[index], &pl->blocks[index + 1],
+            (pl->num_blocks - index - 1) * sizeof(posting_block));
+    pl->num_blocks--;
+}
+
+/* ==================== Public API ==================== */
+
+posting_list *postingCreate(void) {
+    posting_list *pl = calloc(1, sizeof(posting_list));
+    if (pl == NULL) {
+        perror("Posting list allocation failed");
+        exit(EXIT_FAILURE);
+    }
+    return pl;
+}
+
+posting_list *postingFromSorted(void *const rows[], int num_rows) {
+    posting_list *pl = postingCreate();
+    uintptr_t chunk[POSTING_BULK_ROWS];
+    int filled = 0;
+
+    for (int i = 0; i < num_rows; i++) {
+        uintptr_t row = (uintptr_t)rows[i];
+        if (filled > 0 && chunk[filled - 1] == row)
+            continue;  // Same row listed twice
+        chunk[filled++] = row;
+        if (filled == POSTING_BULK_ROWS) {
+            encodeBlock(insertBlockAt(pl, pl->num_blocks), chunk, filled);
+            pl->num_rows += filled;
+            filled = 0;
+        }
+    }
+    if (filled > 0) {
+        encodeBlock(insertBlockAt(pl, pl->num_blocks), chunk, filled);
+        pl->num_rows += filled;
+    }
+    return pl;
+}
+
+bool postingAdd(posting_list *pl, void *row_ptr) {
+    uintptr_t row = (uintptr_t)row_ptr;
+    uintptr_t rows[POSTING_BLOCK_ROWS + 1];
+
+    if (pl->num_blocks == 0) {
+        rows[0] = row;
+        encodeBlock(insertBlockAt(pl, 0), rows, 1);
+        pl->num_rows = 1;
+        return true;
+    }
+
+    int b = findBlock(pl, row);
+    int count = decodeBlock(&pl->blocks[b], rows);
+    int pos = rowLowerBound(rows, count, row);
+    if (pos < count && rows[pos] == row)
+        return false;
+
+    memmove(&rows[pos + 1], &rows[pos], (count - pos) * sizeof(uintptr_t));
+    rows[pos] = row;
+    count++;
+    pl->num_rows++;
+
+    if (count <= POSTING_BLOCK_ROWS) {
+        encodeBlock(&pl->blocks[b], rows, count);
+        return true;
+    }
+
+    /* Case: block overflow. Split it in half; the right half becomes a new block. */
+    int half = count / 2;
+    encodeBlock(&pl->blocks[b], rows, half);
+    encodeBlock(insertBlockAt(pl, b + 1), &rows[half], count - half);
+    return true;
+}
+
+bool postingRemove(posting_list *pl, void *row_ptr) {
+    uintptr_t row = (uintptr_t)row_ptr;
+    uintptr_t rows[2 * POSTING_BLOCK_ROWS];
+
+    if (pl->num_blocks == 0)
+        return false;
+
+    int b = findBlock(pl, row);
+    int count = decodeBlock(&pl->blocks[b], rows);
+    int pos = rowLowerBound(rows, count, row);
+    if (pos == count || rows[pos] != row)
+        return false;
+
+    memmove(&rows[pos], &rows[pos + 1], (count - pos - 1) * sizeof(uintptr_t));
+    count--;
+    pl->num_rows--;
+
+    if (count == 0) {
+        removeBlockAt(pl, b);
+        return true;
+    }
+
+    /* Case: block a quarter full. Fold the next block into it when both fit in one. */
+    if (count < POSTING_BLOCK_ROWS / 4 && b + 1 < pl->num_blocks &&
+        count + pl->blocks[b + 1].count <= POSTING_BLOCK_ROWS) {
+        count += decodeBlock(&pl->blocks[b + 1], &rows[count]);
+        removeBlockAt(pl, b + 1);
+    }
+    encodeBlock(&pl->blocks[b], rows, count);
+    return true;
+}
+
+int postingDecode(const posting_list *pl, void *out[]) {
+    uintptr_t rows[POSTING_BLOCK_ROWS];
+    int n = 0;
+    for (int b = 0; b < pl->num_blocks; b++) {
+        int count = decodeBlock(&pl->blocks[b], rows);
+        for (int i = 0; i < count; i++)
+            out[n++] = (void *)rows[i];
+    }
+    return n;
+}
+
+int postingDecodeBlock(const posting_list *pl, int block, void *out[]) {
+    uintptr_t rows[POSTING_BLOCK_ROWS];
+    int count = decodeBlock(&pl->blocks[block], rows);
+    for (int i = 0; i < count; i++)
+        out[i] = (void *)rows[i];
+    return count;
+}
+
+void *postingFirst(const posting_list *pl) {
+    return pl->num_blocks > 0 ? (void *)pl->blocks[0].first : NULL;
+}
+
+size_t postingBytes(const posting_list *pl) {
+    size_t bytes = sizeof(posting_list) + pl->cap_blocks * sizeof(posting_block);
+    for (int b = 0; b < pl->num_blocks; b++)
+        bytes += pl->blocks[b].num_bytes;
+    return bytes;
+}
+
+void postingDestroy(posting_list *pl) {
+    if (pl == NULL) return;
+    for (int b = 0; b < pl->num_blocks; b++)
+        free(pl->blocks[b].data);
+    free(pl->blocks);
+    free(pl);
+}
@@ -0,0 +1,149 @@
+/*
+ * WHERE clause compilation: a whereClauseS tree is turned once per query into a flat
+ * program of typed compares with true / false jump targets, which the engines run for
+ * every row instead of re-reading attribute names and value strings.
+ */
+
+#define _POSIX_C_SOURCE 200809L  // strcasecmp
+#include "../include/predicate.h"
+#include "../include/executeEngine-serial.h"  // struct whereClauseS
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+
+/* ==================== Conditions ==================== */
+
+static bool parseWhereOperator(const char *op, uint8_t *out) {
+    if (strcmp(op, "=") == 0) *out = WHERE_EQ;
+    else if (strcmp(op, "!=") == 0) *out = WHERE_NEQ;
+    else if (strcmp(op, ">") == 0) *out = WHERE_GT;
+    else if (strcmp(op, "<") == 0) *out = WHERE_LT;
+    else if (strcmp(op, ">=") == 0) *out = WHERE_GTE;
+    else if (strcmp(op, "<=") == 0) *out = WHERE_LTE;
+    else return false;
+    return true;
+}
+
+/* bindCondition: Converts one condition's constant by the type of its attribute: strtoull
+ * for command_id, atoi for the int fields, "true" (any case) or "1" for sudo_used, and the
+ * value itself for strings. A condition without a valid comparison matches nothing.
+ */
+static void bindCondition(where_instr *instr, const struct whereClauseS *wc) {
+    memset(instr, 0, sizeof(*instr));
+    instr->kind = WHERE_FALSE;
+    if (wc->attribute == NULL || wc->operator == NULL || wc->value == NULL)
+        return;
+    const FieldInfo *info = get_field_info(wc->attribute);
+    uint8_t op;
+    if (info == NULL || !parseWhereOperator(wc->operator, &op))
+        return;
+
+    instr->op = op;
+    instr->offset = (uint16_t)info->offset;
+    switch (info->type) {
+    case FIELD_UINT64:
+        instr->kind = WHERE_UINT64;
+        instr->value.u64 = strtoull(wc->value, NULL, 10);
+        break;
+    case FIELD_INT:
+        instr->kind = WHERE_INT;
+        instr->value.i32 = atoi(wc->value);
+        break;
+    case FIELD_BOOL:
+        // Only equality is defined for booleans
+        if (op == WHERE_EQ || op == WHERE_NEQ) {
+            instr->kind = WHERE_BOOL;
+            instr->value.b = strcasecmp(wc->value, "true") == 0 || strcmp(wc->value, "1") == 0;
+        }
+        break;
+    case FIELD_STRING:
+        instr->kind = WHERE_STRING;
+        instr->value.str = wc->value;
+        break;
+    }
+}
+
+static bool isOrLink(const struct whereClauseS *wc) {
+    return wc->logical_op != NULL && strcmp(wc->logical_op, "OR") == 0;
+}
+
+/* ==================== Compilation ==================== */
+
+/* Instructions a chain compiles to: one per condition, sub-clauses inlined */
+static int countInstructions(const struct whereClauseS *wc) {
+    int count = 0;
+    for (; wc != NULL; wc = wc->next)
+        count += wc->sub != NULL ? countInstructions(wc->sub) : 1;
+    return count;
+}
+
+/* compileChain: Emits wc's chain so that it jumps to on_true when it holds and to on_false
+ * otherwise. A chain is "first op (rest)": with OR a true first item already decides the
+ * chain, with AND (or no operator) a false one does; otherwise evaluation falls through to
+ * the rest, whose first instruction directly follows the item's.
+ */
+static void compileChain(where_program *program, const struct whereClauseS *wc, int32_t on_true, int32_t on_false) {
+    for (; wc != NULL; wc = wc->next) {
+        int32_t item_true = on_true, item_false = on_false;
+        if (wc->next != NULL) {
+            int32_t rest = program->num_instrs + (wc->sub != NULL ? countInstructions(wc->sub) : 1);
+            if (isOrLink(wc))
+                item_false = rest;
+            else
+                item_true = rest;
+        }
+
+        if (wc->sub != NULL) {
+            compileChain(program, wc->sub, item_true, item_false);
+        } else {
+            where_instr *instr = &program->instrs[program->num_instrs++];
+            bindCondition(instr, wc);
+            instr->on_true = item_true;
+            instr->on_false = item_false;
+        }
+    }
+}
+
+void whereCompile(where_program *program, const struct whereClauseS *whereClause) {
+    int count = countInstructions(whereClause);
+    program->num_instrs = 0;
+    program->instrs = NULL;
+    if (count == 0)
+        return;
+    program->instrs = malloc(count * sizeof(where_instr));
+    if (program->instrs == NULL) {
+        perror("Failed to allocate WHERE program");
+        exit(EXIT_FAILURE);
+    }
+    compileChain(program, whereClause, WHERE_ACCEPT, WHERE_REJECT);
+}
+
+void whereProgramFree(where_program *program) {
+    free(program->instrs);
+    program->instrs = NULL;
+    program->num_instrs = 0;
+}
+
+/* ==================== Direct evaluation ==================== */
+
+/* Recursive evaluator for WHERE clause (one row; scans compile the clause instead) */
+bool evaluateWhereClause(record *r, struct whereClauseS *wc) {
+    if (wc == NULL) return true;
+
+    bool currentResult;
+    if (wc->sub != NULL) {
+        currentResult = evaluateWhereClause(r, wc->sub);
+    } else {
+        where_instr condition;
+        bindCondition(&condition, wc);
+        currentResult = whereTest(&condition, r);
+    }
+
+    if (wc->next == NULL) {
+        return currentResult;
+    }
+    if (isOrLink(wc)) {
+        return currentResult || evaluateWhereClause(r, wc->next);
+    }
+    return currentResult && evaluateWhereClause(r, wc->next);
+}
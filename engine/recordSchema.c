@@ -37,6 +37,32 @@ const FieldInfo *get_field_info(const char *name)
     return NULL;
 }
 
+/* List all fields (a field's position is its pointer minus the returned base) */
+const FieldInfo *get_record_fields(size_t *count)
+{
+    *count = NUM_RECORD_FIELDS;
+    return record_fields;
+}
+
+/* Copy every string field of a record into a string heap */
+void copy_record_strings(record *rec, string_heap *strings) {
+    for (size_t i = 0; i < NUM_RECORD_FIELDS; i++) {
+        if (record_fields[i].type != FIELD_STRING) continue;
+        const char **field = (const char **)((char *)rec + record_fields[i].offset);
+        const char *value = *field != NULL ? *field : "";
+        *field = stringHeapAdd(strings, value, strlen(value));
+    }
+}
+
+/* Give string fields that were never set the empty string */
+void fill_missing_record_strings(record *rec) {
+    for (size_t i = 0; i < NUM_RECORD_FIELDS; i++) {
+        if (record_fields[i].type != FIELD_STRING) continue;
+        const char **field = (const char **)((char *)rec + record_fields[i].offset);
+        if (*field == NULL) *field = "";
+    }
+}
+
 /* Extract a KEY_T suitable for indexing from a record field */
 KEY_T extract_key_from_record(const record *rec, const char *attr_name) {
     // Get field info for the attribute
@@ -69,7 +95,7 @@ KEY_T extract_key_from_record(const record *rec, const char *attr_name) {
 
     case FIELD_STRING:
         key.type = KEY_STRING;
-        key.v.str = (const char *)ptr;  // Will contain the actual string content
+        key.v.str = *(const char *const *)ptr;  // Points into the string heap
         break;
 
     default:
@@ -80,6 +106,19 @@ KEY_T extract_key_from_record(const record *rec, const char *attr_name) {
     return key;
 }
 
+/* Map a FieldType to the KeyType stored by an index over that field */
+KeyType key_type_for_field(FieldType type) {
+    switch (type) {
+    case FIELD_UINT64: return KEY_UINT64;
+    case FIELD_INT:    return KEY_INT;
+    case FIELD_BOOL:   return KEY_BOOL;
+    case FIELD_STRING: return KEY_STRING;
+    default:
+        fprintf(stderr, "Unsupported field type for index: %d\n", (int)type);
+        exit(EXIT_FAILURE);
+    }
+}
+
 /* Compare two KEY_T values; returns:
  *  < 0 if key1 < key2
  *  = 0 if key1 == key2
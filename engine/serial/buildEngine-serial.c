@@ -2,6 +2,8 @@
 
 #define _POSIX_C_SOURCE 200809L  // Enable strdup
 #include "../../include/buildEngine-serial.h"
+#include "../../include/csvParse.h"
+#include "../../include/indexFile.h"
 #include <string.h>
 #include <strings.h>
 #define VERBOSE 0  // Essentially testing mode
@@ -15,14 +17,22 @@ bool makeIndexSerial(struct engineS *engine, const char *indexName, int attribut
     record **records = engine->all_records;
     int numRecords = engine->num_records;
     
-    // Build the B+ tree from the records array
-    node *root = loadIntoBplusTree(records, numRecords, indexName);
+    // Reuse the index saved by an earlier run while the data file is unchanged;
+    // otherwise build the B+ tree from the records array and save it for the next run
+    bptree *root = indexFileLoad(engine->datafile, indexName, records, numRecords);
+    if (root == NULL) {
+        root = loadIntoBplusTree(records, numRecords, indexName);
+        if (root != NULL) {
+            indexFileSave(engine->datafile, indexName, root, records, numRecords);
+        }
+    }
     if (VERBOSE && root == NULL) {
         fprintf(stderr, "Failed to load data into B+ tree\n");
     }
 
     // Add to the engine's known tree roots
     engine->bplus_tree_roots[engine->num_indexes] = root;
+    columnStatsBuild(&engine->index_stats[engine->num_indexes], root);  // For the index planner
     engine->indexed_attributes[engine->num_indexes] = strdup(indexName);
     engine->num_indexes += 1;
     engine->attribute_types[engine->num_indexes-1] = mapAttributeType(attributeType);
@@ -36,38 +46,54 @@ bool makeIndexSerial(struct engineS *engine, const char *indexName, int attribut
  *   num_records - number of records in the array
  *   attributeName - name of the attribute to index
  * Returns:
- *  root of the B+ tree
+ *  handle of the B+ tree
 */
-node *loadIntoBplusTree(record **records, int num_records, const char *attributeName) {
-    // Instantiate the B+ tree root
-    node *root = NULL;
-    
-    // Iterate through each record and insert into the B+ tree
+bptree *loadIntoBplusTree(record **records, int num_records, const char *attributeName) {
+    // Each index gets its own tree handle; the order is sized to the key type
+    const FieldInfo *info = get_field_info(attributeName);
+    if (info == NULL) {
+        fprintf(stderr, "Unknown index attribute: %s\n", attributeName);
+        return NULL;
+    }
+    bptree *tree = bptreeCreate(key_type_for_field(info->type), 0);
+    if (num_records <= 0) {
+        return tree;  // Nothing to index yet, later inserts will populate it
+    }
+
+    // Pair every record with its key so the tree can be built bottom-up in one pass
+    bplus_entry *entries = (bplus_entry *)malloc(num_records * sizeof(bplus_entry));
+    if (entries == NULL) {
+        fprintf(stderr, "Memory allocation failed for bulk load entries\n");
+        destroy_tree(tree);
+        return NULL;
+    }
     for (int i = 0; i < num_records; i++) {
-        
-        // Extract the current record as a key
-        record *currentRecord = records[i];
-        KEY_T key = extract_key_from_record(currentRecord, attributeName);
+        entries[i].key = extract_key_from_record(records[i], attributeName);
+        entries[i].row_ptr = (ROW_PTR)records[i];
+    }
 
-        // Insert the record into the B+ tree using the key
-        root = insert(root, key, (ROW_PTR)currentRecord);
+    // Sort once and pack the leaves/internal nodes instead of inserting record by record
+    bulkLoad(tree, entries, num_records, BULK_FILL_FACTOR);
+    free(entries);
 
-        // Validate insertion via printing (only in verbose mode)
-        if (VERBOSE) {
-            printTree(root);
-        }
+    // Validate the build via printing (only in verbose mode)
+    if (VERBOSE) {
+        printTree(tree);
     }
 
-    return root;  // Return the root of the constructed B+ tree
+    return tree;  // Return the constructed B+ tree
 }
 
 /* Load the full CSV file into memory as an array of record structs 
  * Parameters:
  *   filepath - path to the CSV data file
+ *   record_block_out - set to the contiguous block holding the records (caller frees)
+ *   record_block_bytes_out - set to the length of that block
+ *   strings - string heap receiving the string fields
  * Returns:
  *   Array of all record structs in the file
 */
-record **getAllRecordsFromFile(const char *filepath, int *num_records) {
+record **getAllRecordsFromFile(const char *filepath, int *num_records, void **record_block_out, size_t *record_block_bytes_out, string_heap *strings) {
     // Attempt to open the file from the provided path
     FILE *file = fopen(filepath, "r");
     if (file == NULL) {
@@ -75,149 +101,85 @@ record **getAllRecordsFromFile(const char *filepath, int *num_records) {
         return NULL;
     }
 
-    // Initialize the records and count
-    record **records = NULL;
-    char line[1024];
+    // Records are parsed into one growing block (file order is address order, which the
+    // indexes use to order rows with equal keys); the pointer array is built at the end
+    record *block = NULL;
+    size_t capacity = 0;
+    char *line = NULL;  // Grown by getline, so long lines are read whole
+    size_t line_capacity = 0;
     int count = 0;
 
-    // Read each line and populate the records array
+    // Read each line and populate the records block
     bool first_line = true;
-    while (fgets(line, sizeof(line), file)) {
+    ssize_t length;
+    while ((length = getline(&line, &line_capacity, file)) != -1) {
         if (first_line) {
             first_line = false;
             continue; // Skip header
         }
-        record *new_record = getRecordFromLine(line);
-        records = realloc(records, (count + 1) * sizeof(record *));
+        if ((size_t)count == capacity) {
+            capacity = capacity == 0 ? 1024 : capacity * 2;
+            record *grown = realloc(block, capacity * sizeof(record));
+            if (grown == NULL) {
+                fprintf(stderr, "Memory allocation failed\n");
+                free(block);
+                free(line);
+                fclose(file);
+                return NULL;
+            }
+            block = grown;
+        }
+        if (length > 0 && line[length - 1] == '\n') length--;
+        fillRecordFromLine(&block[count], line, (size_t)length, strings);
+        count++;
+    }
+    free(line);
+    fclose(file);
+
+    record **records = NULL;
+    if (count > 0) {
+        records = malloc(count * sizeof(record *));
         if (records == NULL) {
             fprintf(stderr, "Memory allocation failed\n");
-            fclose(file);
+            free(block);
             return NULL;
         }
-        records[count] = new_record;
-        count++;
+        for (int i = 0; i < count; i++) {
+            records[i] = &block[i];
+        }
     }
 
-    // Close the file, set the output count, and return the records array
-    fclose(file);
+    // Set the outputs and return the records array
     if(VERBOSE) {
         printf("Loaded %d records from file: %s\n", count, filepath);
     }
+    *record_block_out = block;
+    *record_block_bytes_out = (size_t)count * sizeof(record);
     *num_records = count;
     return records;  // Return the array of all records
 }
 
-/* Helper to parse a CSV field, handling quotes and commas */
-char *parseCSVField(char **cursor) {
-    char *start = *cursor;
-    if (*start == '\0' || *start == '\n' || *start == '\r') return NULL;
-
-    char *field = malloc(1024); // Allocate buffer for field
-    int i = 0;
-    bool in_quotes = false;
-
-    if (*start == '"') {
-        in_quotes = true;
-        start++; // Skip opening quote
-    }
-
-    while (*start != '\0' && *start != '\n' && *start != '\r') {
-        if (in_quotes) {
-            if (*start == '"') {
-                if (*(start + 1) == '"') {
-                    // Escaped quote
-                    field[i++] = '"';
-                    start += 2;
-                } else {
-                    // End of quoted field
-                    in_quotes = false;
-                    start++;
-                }
-            } else {
-                field[i++] = *start++;
-            }
-        } else {
-            if (*start == ',') {
-                start++; // Skip comma
-                break;
-            }
-            field[i++] = *start++;
-        }
-    }
-    
-    field[i] = '\0';
-    *cursor = start;
-    return field;
-}
-
 /* Get a record struct from a line of CSV data
  * Parameters:
- *   line - character array containing a line of CSV data
+ *   line - character array containing a line of CSV data (fields are unquoted in place)
+ *   strings - string heap receiving the string fields
  * Returns:
  *   record struct populated with data from the line
 */
-record *getRecordFromLine(char *line){
-    record *new_record = (record *)calloc(1, sizeof(record));
+record *getRecordFromLine(char *line, string_heap *strings){
+    record *new_record = (record *)malloc(sizeof(record));
     if (new_record == NULL) {
         fprintf(stderr, "Memory allocation failed\n");
         return NULL;
     }
+    fillRecordFromLine(new_record, line, strlen(line), strings);
+    return new_record;
+}
 
-    char *cursor = line;
-    char *token;
-
-    // command_id
-    token = parseCSVField(&cursor);
-    if (token) { new_record->command_id = strtoull(token, NULL, 10); free(token); }
-
-    // raw_command
-    token = parseCSVField(&cursor);
-    if (token) { strncpy(new_record->raw_command, token, sizeof(new_record->raw_command)); free(token); }
-
-    // base_command
-    token = parseCSVField(&cursor);
-    if (token) { strncpy(new_record->base_command, token, sizeof(new_record->base_command)); free(token); }
-
-    // shell_type
-    token = parseCSVField(&cursor);
-    if (token) { strncpy(new_record->shell_type, token, sizeof(new_record->shell_type)); free(token); }
-
-    // exit_code
-    token = parseCSVField(&cursor);
-    if (token) { new_record->exit_code = atoi(token); free(token); }
-
-    // timestamp
-    token = parseCSVField(&cursor);
-    if (token) { strncpy(new_record->timestamp, token, sizeof(new_record->timestamp)); free(token); }
-
-    // sudo_used
-    token = parseCSVField(&cursor);
-    if (token) { 
-        new_record->sudo_used = (strcasecmp(token, "true") == 0 || strcmp(token, "1") == 0); 
-        free(token); 
-    }
-
-    // working_directory
-    token = parseCSVField(&cursor);
-    if (token) { strncpy(new_record->working_directory, token, sizeof(new_record->working_directory)); free(token); }
-
-    // user_id
-    token = parseCSVField(&cursor);
-    if (token) { new_record->user_id = atoi(token); free(token); }
-
-    // user_name
-    token = parseCSVField(&cursor);
-    if (token) { strncpy(new_record->user_name, token, sizeof(new_record->user_name)); free(token); }
-
-    // host_name
-    token = parseCSVField(&cursor);
-    if (token) { strncpy(new_record->host_name, token, sizeof(new_record->host_name)); free(token); }
-
-    // risk_level
-    token = parseCSVField(&cursor);
-    if (token) { new_record->risk_level = atoi(token); free(token); }
-
-    return new_record;  // Return the fully populated record
+/* Populate a record from a line of CSV data (see getRecordFromLine) */
+void fillRecordFromLine(record *new_record, char *line, size_t length, string_heap *strings){
+    csvParseRecord(new_record, line, length);  // String fields point into the line for now
+    copy_record_strings(new_record, strings);
 }
 
 /* Helper to map an int representation (0, 1, 2, 3) to a FieldType object for storing */
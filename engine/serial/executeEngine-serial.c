@@ -1,216 +1,13 @@
 /* Main engine functionality and whatnot */
 
 #define _POSIX_C_SOURCE 200809L  // Enable strdup
-#include <strings.h> // For strcasecmp
 #include <time.h> // For clock_t, clock(), CLOCKS_PER_SEC
-#include <limits.h> // For INT_MAX, INT_MIN, UINT64_MAX
 #include "../../include/buildEngine-serial.h"
 #include "../../include/executeEngine-serial.h"
+#include "../../include/countQuery.h"
+#include "../../include/snapshot.h"
 #define VERBOSE 0
-
-// Function pointer type for WHERE condition evaluation
-typedef bool (*where_condition_func)(void *record, void *value);
-
-// Helper macros for generating comparison functions
-// These macros create type-specific comparison functions for different fields
-// CMP_NUM handles numeric types (int, unsigned long long, bool)
-// CMP_STR handles string types using strcmp
-#define CMP_NUM(field, type, opname, op) \
-    bool field##_##opname(void *r, void *v) { \
-        return ((record *)r)->field op (*(type *)v); \
-    }
-
-#define CMP_STR(field, opname, op) \
-    bool field##_##opname(void *r, void *v) { \
-        return strcmp(((record *)r)->field, (char *)v) op 0; \
-    }
-
-// Generate comparison functions for supported fields
-// Each block generates a set of functions (eq, neq, gt, lt, gte, lte) for a specific field
-// These functions are used by the query engine to evaluate WHERE clauses
-
-// command_id (unsigned long long)
-CMP_NUM(command_id, unsigned long long, eq, ==)
-CMP_NUM(command_id, unsigned long long, neq, !=)
-CMP_NUM(command_id, unsigned long long, gt, >)
-CMP_NUM(command_id, unsigned long long, lt, <)
-CMP_NUM(command_id, unsigned long long, gte, >=)
-CMP_NUM(command_id, unsigned long long, lte, <=)
-
-// exit_code (int)
-CMP_NUM(exit_code, int, eq, ==)
-CMP_NUM(exit_code, int, neq, !=)
-CMP_NUM(exit_code, int, gt, >)
-CMP_NUM(exit_code, int, lt, <)
-CMP_NUM(exit_code, int, gte, >=)
-CMP_NUM(exit_code, int, lte, <=)
-
-// risk_level (int)
-CMP_NUM(risk_level, int, eq, ==)
-CMP_NUM(risk_level, int, neq, !=)
-CMP_NUM(risk_level, int, gt, >)
-CMP_NUM(risk_level, int, lt, <)
-CMP_NUM(risk_level, int, gte, >=)
-CMP_NUM(risk_level, int, lte, <=)
-
-// user_id (int)
-CMP_NUM(user_id, int, eq, ==)
-CMP_NUM(user_id, int, neq, !=)
-CMP_NUM(user_id, int, gt, >)
-CMP_NUM(user_id, int, lt, <)
-CMP_NUM(user_id, int, gte, >=)
-CMP_NUM(user_id, int, lte, <=)
-
-// raw_command (string)
-CMP_STR(raw_command, eq, ==)
-CMP_STR(raw_command, neq, !=)
-// String inequality is lexicographical
-CMP_STR(raw_command, gt, >)
-CMP_STR(raw_command, lt, <)
-CMP_STR(raw_command, gte, >=)
-CMP_STR(raw_command, lte, <=)
-
-// user_name (string)
-CMP_STR(user_name, eq, ==)
-CMP_STR(user_name, neq, !=)
-CMP_STR(user_name, gt, >)
-CMP_STR(user_name, lt, <)
-CMP_STR(user_name, gte, >=)
-CMP_STR(user_name, lte, <=)
-
-// base_command (string)
-CMP_STR(base_command, eq, ==)
-CMP_STR(base_command, neq, !=)
-CMP_STR(base_command, gt, >)
-CMP_STR(base_command, lt, <)
-CMP_STR(base_command, gte, >=)
-CMP_STR(base_command, lte, <=)
-
-// shell_type (string)
-CMP_STR(shell_type, eq, ==)
-CMP_STR(shell_type, neq, !=)
-CMP_STR(shell_type, gt, >)
-CMP_STR(shell_type, lt, <)
-CMP_STR(shell_type, gte, >=)
-CMP_STR(shell_type, lte, <=)
-
-// timestamp (string)
-CMP_STR(timestamp, eq, ==)
-CMP_STR(timestamp, neq, !=)
-CMP_STR(timestamp, gt, >)
-CMP_STR(timestamp, lt, <)
-CMP_STR(timestamp, gte, >=)
-CMP_STR(timestamp, lte, <=)
-
-// working_directory (string)
-CMP_STR(working_directory, eq, ==)
-CMP_STR(working_directory, neq, !=)
-CMP_STR(working_directory, gt, >)
-CMP_STR(working_directory, lt, <)
-CMP_STR(working_directory, gte, >=)
-CMP_STR(working_directory, lte, <=)
-
-// host_name (string)
-CMP_STR(host_name, eq, ==)
-CMP_STR(host_name, neq, !=)
-CMP_STR(host_name, gt, >)
-CMP_STR(host_name, lt, <)
-CMP_STR(host_name, gte, >=)
-CMP_STR(host_name, lte, <=)
-
-// sudo_used (bool)
-CMP_NUM(sudo_used, bool, eq, ==)
-CMP_NUM(sudo_used, bool, neq, !=)
-
-
-// Factory function to create a WHERE condition function pointer
-// Takes an attribute name, operator, and value, and returns the appropriate comparison function
-// This allows the query engine to dynamically select the correct comparison logic at runtime
-where_condition_func create_where_condition(const char *attribute, const char *operator, void *value) {
-    if (strcmp(attribute, "command_id") == 0) {
-        if (strcmp(operator, "=") == 0) return command_id_eq;
-        if (strcmp(operator, "!=") == 0) return command_id_neq;
-        if (strcmp(operator, ">") == 0) return command_id_gt;
-        if (strcmp(operator, "<") == 0) return command_id_lt;
-        if (strcmp(operator, ">=") == 0) return command_id_gte;
-        if (strcmp(operator, "<=") == 0) return command_id_lte;
-    } else if (strcmp(attribute, "exit_code") == 0) {
-        if (strcmp(operator, "=") == 0) return exit_code_eq;
-        if (strcmp(operator, "!=") == 0) return exit_code_neq;
-        if (strcmp(operator, ">") == 0) return exit_code_gt;
-        if (strcmp(operator, "<") == 0) return exit_code_lt;
-        if (strcmp(operator, ">=") == 0) return exit_code_gte;
-        if (strcmp(operator, "<=") == 0) return exit_code_lte;
-    } else if (strcmp(attribute, "risk_level") == 0) {
-        if (strcmp(operator, "=") == 0) return risk_level_eq;
-        if (strcmp(operator, "!=") == 0) return risk_level_neq;
-        if (strcmp(operator, ">") == 0) return risk_level_gt;
-        if (strcmp(operator, "<") == 0) return risk_level_lt;
-        if (strcmp(operator, ">=") == 0) return risk_level_gte;
-        if (strcmp(operator, "<=") == 0) return risk_level_lte;
-    } else if (strcmp(attribute, "user_id") == 0) {
-        if (strcmp(operator, "=") == 0) return user_id_eq;
-        if (strcmp(operator, "!=") == 0) return user_id_neq;
-        if (strcmp(operator, ">") == 0) return user_id_gt;
-        if (strcmp(operator, "<") == 0) return user_id_lt;
-        if (strcmp(operator, ">=") == 0) return user_id_gte;
-        if (strcmp(operator, "<=") == 0) return user_id_lte;
-    } else if (strcmp(attribute, "raw_command") == 0) {
-        if (strcmp(operator, "=") == 0) return raw_command_eq;
-        if (strcmp(operator, "!=") == 0) return raw_command_neq;
-        if (strcmp(operator, ">") == 0) return raw_command_gt;
-        if (strcmp(operator, "<") == 0) return raw_command_lt;
-        if (strcmp(operator, ">=") == 0) return raw_command_gte;
-        if (strcmp(operator, "<=") == 0) return raw_command_lte;
-    } else if (strcmp(attribute, "user_name") == 0) {
-        if (strcmp(operator, "=") == 0) return user_name_eq;
-        if (strcmp(operator, "!=") == 0) return user_name_neq;
-        if (strcmp(operator, ">") == 0) return user_name_gt;
-        if (strcmp(operator, "<") == 0) return user_name_lt;
-        if (strcmp(operator, ">=") == 0) return user_name_gte;
-        if (strcmp(operator, "<=") == 0) return user_name_lte;
-    } else if (strcmp(attribute, "base_command") == 0) {
-        if (strcmp(operator, "=") == 0) return base_command_eq;
-        if (strcmp(operator, "!=") == 0) return base_command_neq;
-        if (strcmp(operator, ">") == 0) return base_command_gt;
-        if (strcmp(operator, "<") == 0) return base_command_lt;
-        if (strcmp(operator, ">=") == 0) return base_command_gte;
-        if (strcmp(operator, "<=") == 0) return base_command_lte;
-    } else if (strcmp(attribute, "shell_type") == 0) {
-        if (strcmp(operator, "=") == 0) return shell_type_eq;
-        if (strcmp(operator, "!=") == 0) return shell_type_neq;
-        if (strcmp(operator, ">") == 0) return shell_type_gt;
-        if (strcmp(operator, "<") == 0) return shell_type_lt;
-        if (strcmp(operator, ">=") == 0) return shell_type_gte;
-        if (strcmp(operator, "<=") == 0) return shell_type_lte;
-    } else if (strcmp(attribute, "timestamp") == 0) {
-        if (strcmp(operator, "=") == 0) return timestamp_eq;
-        if (strcmp(operator, "!=") == 0) return timestamp_neq;
-        if (strcmp(operator, ">") == 0) return timestamp_gt;
-        if (strcmp(operator, "<") == 0) return timestamp_lt;
-        if (strcmp(operator, ">=") == 0) return timestamp_gte;
-        if (strcmp(operator, "<=") == 0) return timestamp_lte;
-    } else if (strcmp(attribute, "working_directory") == 0) {
-        if (strcmp(operator, "=") == 0) return working_directory_eq;
-        if (strcmp(operator, "!=") == 0) return working_directory_neq;
-        if (strcmp(operator, ">") == 0) return working_directory_gt;
-        if (strcmp(operator, "<") == 0) return working_directory_lt;
-        if (strcmp(operator, ">=") == 0) return working_directory_gte;
-        if (strcmp(operator, "<=") == 0) return working_directory_lte;
-    } else if (strcmp(attribute, "host_name") == 0) {
-        if (strcmp(operator, "=") == 0) return host_name_eq;
-        if (strcmp(operator, "!=") == 0) return host_name_neq;
-        if (strcmp(operator, ">") == 0) return host_name_gt;
-        if (strcmp(operator, "<") == 0) return host_name_lt;
-        if (strcmp(operator, ">=") == 0) return host_name_gte;
-        if (strcmp(operator, "<=") == 0) return host_name_lte;
-    } else if (strcmp(attribute, "sudo_used") == 0) {
-        if (strcmp(operator, "=") == 0) return sudo_used_eq;
-        if (strcmp(operator, "!=") == 0) return sudo_used_neq;
-    }
-    
-    return NULL;
-}
+#define INDEX_BATCH_ROWS 256  // Rows pulled from a B+ tree cursor per batch
 
 /* Helper: Converts a specific attribute of a record to a string */
 char *get_attribute_string_value(record *r, const char *attribute) {
@@ -247,74 +44,56 @@ char *get_attribute_string_value(record *r, const char *attribute) {
     return strdup(buffer);
 }
 
-/* Helper function to check a single condition against a record */
-bool checkCondition(record *r, struct whereClauseS *condition) {
-    void *valuePtr;
-    bool result = false;
-    
-    // 1. Determine specific C type based on Attribute Name
-    if (strcmp(condition->attribute, "command_id") == 0) {
-        unsigned long long *val = malloc(sizeof(unsigned long long));
-        *val = strtoull(condition->value, NULL, 10);
-        valuePtr = val;
-    } 
-    else if (strcmp(condition->attribute, "risk_level") == 0 || 
-             strcmp(condition->attribute, "exit_code") == 0 ||
-             strcmp(condition->attribute, "user_id") == 0) {
-        int *val = malloc(sizeof(int));
-        *val = atoi(condition->value);
-        valuePtr = val;
-    }
-    else if (strcmp(condition->attribute, "sudo_used") == 0) {
-        bool *val = malloc(sizeof(bool));
-        *val = (strcasecmp(condition->value, "true") == 0 || strcmp(condition->value, "1") == 0);
-        valuePtr = val;
-    }
-    else {
-        // String types
-        valuePtr = (void *)condition->value;
-    }
-
-    where_condition_func conditionFunc = create_where_condition(condition->attribute, condition->operator, valuePtr);
-    if (conditionFunc != NULL && conditionFunc((void *)r, valuePtr)) {
-        result = true;
+/* Appends a batch of rows streamed from a B+ tree cursor to the candidate list, growing it as needed */
+static void appendIndexMatches(record ***matches, int *count, int *capacity, ROW_PTR rows[], int num_rows) {
+    if (*count + num_rows > *capacity) {
+        int newCapacity = *capacity > 0 ? *capacity : INDEX_BATCH_ROWS;
+        while (newCapacity < *count + num_rows) {
+            newCapacity *= 2;
+        }
+        record **grown = realloc(*matches, newCapacity * sizeof(record *));
+        if (grown == NULL) {
+            perror("Failed to grow index match buffer");
+            exit(EXIT_FAILURE);
+        }
+        *matches = grown;
+        *capacity = newCapacity;
     }
-    
-    // Cleanup
-    if (valuePtr != condition->value) {
-        free(valuePtr);
+    for (int k = 0; k < num_rows; k++) {
+        (*matches)[(*count)++] = (record *)rows[k];
     }
-    
-    return result;
 }
-
-/* Recursive evaluator for WHERE clause */
-bool evaluateWhereClause(record *r, struct whereClauseS *wc) {
-    if (wc == NULL) return true;
-
-    bool currentResult = false;
-
-    if (wc->sub != NULL) {
-        currentResult = evaluateWhereClause(r, wc->sub);
-    } else {
-        currentResult = checkCondition(r, wc);
+/* Full-table scan over the column store: the WHERE clause reads only the columns it names,
+ * and matching row ids are turned back into records for projection. The store is built on
+ * the first scan and kept in step with all_records by INSERT (DELETE drops it).
+ */
+static record **columnScanRecords(struct engineS *engine, struct whereClauseS *whereClause, int *matchCount) {
+    if (engine->columns == NULL) {
+        engine->columns = columnStoreBuild(engine->all_records, engine->num_records);
+    }
+    int *rows = columnStoreSelect(engine->columns, whereClause, matchCount);
+    record **matches = malloc((*matchCount > 0 ? *matchCount : 1) * sizeof(record *));
+    if (matches == NULL) {
+        perror("Failed to allocate scan results");
+        exit(EXIT_FAILURE);
     }
-
-    if (wc->next == NULL) {
-        return currentResult;
+    for (int k = 0; k < *matchCount; k++) {
+        matches[k] = engine->all_records[rows[k]];
     }
+    free(rows);
+    return matches;
+}
 
-    if (wc->logical_op != NULL) {
-        if (strcmp(wc->logical_op, "OR") == 0) {
-            return currentResult || evaluateWhereClause(r, wc->next);
-        } else if (strcmp(wc->logical_op, "AND") == 0) {
-            return currentResult && evaluateWhereClause(r, wc->next);
-        }
-    }
-    
-    return currentResult && evaluateWhereClause(r, wc->next);
+/* True when r was allocated on its own by INSERT, rather than living in the loader's
+ * record block or a mapped snapshot (both are released as a whole by destroy)
+ */
+static bool ownsRecord(const struct engineS *engine, const record *r) {
+    uintptr_t block = (uintptr_t)engine->record_block;
+    bool in_block = block != 0 && (uintptr_t)r >= block && (uintptr_t)r < block + engine->record_block_bytes;
+    return !in_block && !snapshotContains(engine->record_map, engine->record_map_bytes, r);
 }
 
+
 /* Main functionality for a SELECT query
  * Parameters:
 *   engine - constant engine object
@@ -333,13 +112,8 @@ struct resultSetS *executeQuerySelectSerial(
     struct whereClauseS *whereClause  // WHERE clause (NULL if no filtering)
 ) {
 
-    // Flags to track if any indexed attributes are in the WHERE clause
-    bool anyIndexExists = false;  // Flag for quick fallback to full table scan
-    bool indexExists[engine->num_indexes];  // Track which indexes exist for WHERE attributes
-
-    // Allocate space for matching records and result struct
-    // Use num_records as upper bound to avoid reallocating during index search
-    record **matchingRecords = (record **)malloc(engine->num_records * sizeof(record *));
+    // Allocate the result struct; the matching records are collected after planning
+    record **matchingRecords = NULL;
     struct resultSetS *queryResults = (struct resultSetS *)malloc(sizeof(struct resultSetS));
     int matchCount = 0;
 
@@ -354,130 +128,59 @@ struct resultSetS *executeQuerySelectSerial(
     // Start the timer
     clock_t start = clock();  // Start a timer
 
-    // Get all indexed attributes in the WHERE clause, using the B+ tree indexes where possible
-    struct whereClauseS *wc = whereClause;
-    while (wc != NULL) {
-        // Skip nested conditions for index lookup (they don't have a direct attribute)
-        if (wc->attribute == NULL) {
-            wc = wc->next;
-            continue;
-        }
-
-        for (int i = 0; i < engine->num_indexes; i++) {
-            if (strcmp(wc->attribute, engine->indexed_attributes[i]) == 0) {
-                indexExists[i] = true;
-
-                // Use B+ tree index for this attribute
-                node *cur_root = engine->bplus_tree_roots[i]; // B+ tree root for this indexed attribute
-                FieldType type = engine->attribute_types[i];
-                
-                KEY_T key_start, key_end;
-                bool typeSupported = true;
-
-                if (type == FIELD_UINT64) {
-                    unsigned long long val = strtoull(wc->value, NULL, 10);
-                    key_start.type = KEY_UINT64;
-                    key_end.type = KEY_UINT64;
-                    
-                    if (strcmp(wc->operator, "=") == 0) {
-                        key_start.v.u64 = val;
-                        key_end.v.u64 = val;
-                    } else if (strcmp(wc->operator, ">") == 0) {
-                        key_start.v.u64 = val + 1;
-                        key_end.v.u64 = UINT64_MAX;
-                    } else if (strcmp(wc->operator, ">=") == 0) {
-                        key_start.v.u64 = val;
-                        key_end.v.u64 = UINT64_MAX;
-                    } else if (strcmp(wc->operator, "<") == 0) {
-                        key_start.v.u64 = 0;
-                        key_end.v.u64 = val - 1;
-                    } else if (strcmp(wc->operator, "<=") == 0) {
-                        key_start.v.u64 = 0;
-                        key_end.v.u64 = val;
-                    } else {
-                        key_start.v.u64 = 0;
-                        key_end.v.u64 = UINT64_MAX;
-                    }
-                } else if (type == FIELD_INT) {
-                    int val = atoi(wc->value);
-                    key_start.type = KEY_INT;
-                    key_end.type = KEY_INT;
-                    
-                    if (strcmp(wc->operator, "=") == 0) {
-                        key_start.v.i32 = val;
-                        key_end.v.i32 = val;
-                    } else if (strcmp(wc->operator, ">") == 0) {
-                        key_start.v.i32 = val + 1;
-                        key_end.v.i32 = INT_MAX;
-                    } else if (strcmp(wc->operator, ">=") == 0) {
-                        key_start.v.i32 = val;
-                        key_end.v.i32 = INT_MAX;
-                    } else if (strcmp(wc->operator, "<") == 0) {
-                        key_start.v.i32 = INT_MIN;
-                        key_end.v.i32 = val - 1;
-                    } else if (strcmp(wc->operator, "<=") == 0) {
-                        key_start.v.i32 = INT_MIN;
-                        key_end.v.i32 = val;
-                    } else {
-                        key_start.v.i32 = INT_MIN;
-                        key_end.v.i32 = INT_MAX;
-                    }
-                } else {
-                    // Fallback for unsupported types in index search
-                    typeSupported = false;
-                    indexExists[i] = false;
-                }
+    // COUNT(*) over no filter or one indexed comparison is read off the B+ tree subtree counts
+    bool countStar = isCountStar(selectItems, numItems);
+    int indexCount = 0;
+    if (countStar && countFromIndex(engine, whereClause, &indexCount)) {
+        free(queryResults);
+        return makeCountResult(indexCount, ((double) clock() - start) / CLOCKS_PER_SEC);
+    }
 
-                if (!typeSupported) {
-                    continue;
-                }
+    // Plan the index lookups: the indexed conditions become row sets, intersected and
+    // unioned by the clause's AND / OR structure
+    index_plan plan;
+    indexPlanBuild(&plan, engine, whereClause);
+    indexPlanChoose(&plan);
 
-                anyIndexExists = true;
-
-                // Allocating for keys, using num_records as upper bound.
-                KEY_T *returned_keys = malloc(engine->num_records * sizeof(KEY_T));
-                ROW_PTR *returned_pointers = malloc(engine->num_records * sizeof(ROW_PTR));
-                
-                int num_found = findRange(cur_root, key_start, key_end, false, returned_keys, returned_pointers);
-                
-                // Add found records to matchingRecords
-                if (num_found > 0) {
-                    // Reallocate matchingRecords if needed (though we alloc'd max size initially)
-                    for (int k = 0; k < num_found; k++) {
-                        matchingRecords[matchCount++] = (record *)returned_pointers[k];
-                    }
-                }
-                
-                free(returned_keys);
-                free(returned_pointers);
+    if (plan.root == NULL) {
+        // No index narrows the WHERE clause: scan the column store
+        matchingRecords = columnScanRecords(engine, whereClause, &matchCount);
+    } else {
+        // Stream each used index range in batches instead of num_records-sized scratch arrays
+        for (int l = 0; l < plan.num_leaves; l++) {
+            index_leaf *leaf = &plan.leaves[l];
+            if (!leaf->used || leaf->empty) {
+                continue;
             }
-            else {
-                indexExists[i] = false;
+            bplus_cursor cursor;
+            ROW_PTR batch[INDEX_BATCH_ROWS];
+            int num_found;
+            bptreeCursorOpen(&cursor, engine->bplus_tree_roots[leaf->index], leaf->key_start, leaf->key_end);
+            while ((num_found = bptreeCursorNextBatch(&cursor, batch, INDEX_BATCH_ROWS)) > 0) {
+                appendIndexMatches(&leaf->rows, &leaf->count, &leaf->capacity, batch, num_found);
             }
+            bptreeCursorClose(&cursor);
         }
-        wc = wc->next;
-    }
-
 
-    // Perform linear search if on all non-indexed attributes or no indexes matched
-    // No indexes exist for any WHERE attributes, search entire table
-    if(!anyIndexExists){
-        free(matchingRecords); // Free the empty one we made
-        matchingRecords = linearSearchRecords(engine->all_records, engine->num_records, whereClause, &matchCount);
-    }
-    // There were some indexes in the WHERE clause, so we can use the known matching records to reduce linear search
-    else{
-        // Filter the candidate records found via index against the full WHERE clause
-        record **filteredRecords = linearSearchRecords(matchingRecords, matchCount, whereClause, &matchCount);
-        free(matchingRecords);
-        matchingRecords = filteredRecords;
+        // Filter the combined candidates against the full WHERE clause
+        record **candidates = indexPlanCandidates(&plan, &matchCount, NULL);
+        matchingRecords = linearSearchRecords(candidates, matchCount, whereClause, &matchCount);
+        free(candidates);
     }
+    indexPlanFree(&plan);
     double end = (double) clock();
     double time_taken = ((double) end - start) / CLOCKS_PER_SEC;  // Time in seconds
     if (VERBOSE) {
         printf("Linear search took %f seconds\n", time_taken);
     }
 
+    // COUNT(*) that needed a scan: only the number of matches is returned
+    if (countStar) {
+        free(matchingRecords);
+        free(queryResults);
+        return makeCountResult(matchCount, time_taken);
+    }
+
     // Extract the requested attributes from matching records and format the result
     queryResults->numRecords = matchCount;
     
@@ -590,27 +293,31 @@ bool executeQueryInsertSerial(
         return false;
     }
     *record_copy = *newRecord;  // Copy the contents of newRecord (properly allocating memory outside function scope)
+    copy_record_strings(record_copy, engine->strings);  // The caller's strings need not outlive the query
     engine->all_records[engine->num_records] = record_copy;
 
     // Increment the record count
     engine->num_records += 1;
+    if (engine->columns != NULL) {
+        columnStoreAppend(engine->columns, record_copy);  // Same row id as in all_records
+    }
 
     // Update any relevant B+ tree indexes to include the new record
     for (int i = 0; i < engine->num_indexes; i++) {
         const char *indexed_attr = engine->indexed_attributes[i];
         
         // Insert the new record into the B+ tree for this indexed attribute
-        node *root = engine->bplus_tree_roots[i];
-        KEY_T key = extract_key_from_record(record_copy, indexed_attr);
-        root = insert(root, key, (ROW_PTR)record_copy);
-        engine->bplus_tree_roots[i] = root;
-        
-        if(root == NULL) {
+        bptree *tree = engine->bplus_tree_roots[i];
+        if(tree == NULL) {
             if (VERBOSE) {
                 fprintf(stderr, "Failed to insert new record into B+ tree for attribute: %s\n", indexed_attr);
             }
             return false;
         }
+        KEY_T key = extract_key_from_record(record_copy, indexed_attr);
+        insert(tree, key, (ROW_PTR)record_copy);
+        columnStatsAdd(&engine->index_stats[i], key);
+        columnStatsRefresh(&engine->index_stats[i], tree);
     }
 
     return true;  // Placeholder for now
@@ -642,30 +349,28 @@ struct resultSetS *executeQueryDeleteSerial(
     int deletedCount = 0;
     int writeIndex = 0;
 
+    // Compile the WHERE clause once (no clause deletes every record)
+    where_program program;
+    whereCompile(&program, whereClause);
+
     // Iterate through all records in the engine
     for (int i = 0; i < engine->num_records; i++) {
         record *currentRecord = engine->all_records[i];
-        bool shouldDelete = false;
 
         // Check if the record matches the WHERE clause
-        if (whereClause == NULL) {
-            shouldDelete = true; // Delete all if no WHERE clause
-        } else {
-            shouldDelete = evaluateWhereClause(currentRecord, whereClause);
-        }
-
-        if (shouldDelete) {
+        if (whereMatches(&program, currentRecord)) {
             // Delete the matched record
             
             // Remove from B+ Tree Indexes
             for (int j = 0; j < engine->num_indexes; j++) {
                  const char *indexed_attr = engine->indexed_attributes[j];
                  KEY_T key = extract_key_from_record(currentRecord, indexed_attr);
-                 engine->bplus_tree_roots[j] = delete(engine->bplus_tree_roots[j], key, (ROW_PTR)currentRecord);
+                 delete(engine->bplus_tree_roots[j], key, (ROW_PTR)currentRecord);
+                 columnStatsRemove(&engine->index_stats[j], key);
             }
 
-            // Free the record memory
-            free(currentRecord);
+            // Free the record memory (loaded records stay in their block or mapping)
+            if (ownsRecord(engine, currentRecord)) free(currentRecord);
             deletedCount++;
         } else {
             // Keep the record, move it to the current write position if needed
@@ -675,10 +380,20 @@ struct resultSetS *executeQueryDeleteSerial(
             writeIndex++;
         }
     }
+    whereProgramFree(&program);
 
     // Update the record count in the engine
     engine->num_records = writeIndex;
 
+    // Statistics that drifted too far from their index are gathered again
+    for (int j = 0; j < engine->num_indexes; j++) {
+        columnStatsRefresh(&engine->index_stats[j], engine->bplus_tree_roots[j]);
+    }
+
+    // Row ids shifted; the column store is rebuilt by the next full-table scan
+    columnStoreDestroy(engine->columns);
+    engine->columns = NULL;
+
     // Rewrite the CSV file with the remaining records
     FILE *file = fopen(engine->datafile, "w");
     if (file != NULL) {
@@ -741,13 +456,21 @@ struct engineS *initializeEngineSerial(
     // Initialize indexes and tree roots
     engine->tableName = strdup(tableName);
     engine->num_indexes = 0; // Start at 0, makeIndexSerial will increment
-    engine->bplus_tree_roots = (node **)malloc(num_indexes * sizeof(node *));
+    engine->bplus_tree_roots = (bptree **)malloc(num_indexes * sizeof(bptree *));
     engine->indexed_attributes = (char **)malloc(num_indexes * sizeof(char *));
     engine->attribute_types = (FieldType *)malloc(num_indexes * sizeof(FieldType));
+    engine->index_stats = (column_stats *)malloc(num_indexes * sizeof(column_stats));
     engine->all_records = NULL; // Initialize to NULL, will be set later
     engine->num_records = 0; // Initialize record count to 0
     engine->record_block = NULL; // Initialize to NULL
-    if (engine->bplus_tree_roots == NULL || engine->indexed_attributes == NULL || engine->attribute_types == NULL) {
+    engine->record_block_bytes = 0;
+    engine->record_map = NULL; // No snapshot mapped yet
+    engine->record_map_bytes = 0;
+    engine->columns = NULL; // Built by the first full-table scan
+    engine->locks = NULL; // Queries run one at a time
+    engine->strings = stringHeapCreate(); // String fields of parsed and inserted records
+    if (engine->bplus_tree_roots == NULL || engine->indexed_attributes == NULL || engine->attribute_types == NULL ||
+        engine->index_stats == NULL) {
         perror("Failed to allocate memory for engine components");
         free(engine);
         exit(EXIT_FAILURE);
@@ -756,7 +479,11 @@ struct engineS *initializeEngineSerial(
     // Read all records from the database into memory and store in engine->all_records
     if(!datafile){ datafile = "../data/commands_50k.csv"; }; // Filepath default
     engine->datafile = strdup(datafile);
-    engine->all_records = getAllRecordsFromFile(datafile, &engine->num_records);  // Directly update record count
+    // A snapshot of an unchanged data file is mapped in place; otherwise the CSV is parsed
+    engine->all_records = snapshotLoad(datafile, &engine->num_records, &engine->record_map, &engine->record_map_bytes);
+    if (engine->all_records == NULL) {
+        engine->all_records = getAllRecordsFromFile(datafile, &engine->num_records, &engine->record_block, &engine->record_block_bytes, engine->strings);  // Directly update record count
+    }
 
     // Copy indexed attribute names and types into engine struct (defaults)
     for (int i = 0; i < num_indexes; i++) {
@@ -794,13 +521,28 @@ void destroyEngineSerial(struct engineS *engine) {
         /* Free: attribute types array */
         if (engine->attribute_types != NULL) free(engine->attribute_types);
 
+        /* Free: index statistics */
+        free(engine->index_stats);
+
         /* Free: all records allocated from file */
         if (engine->all_records != NULL) {
             for (int i = 0; i < engine->num_records; i++) {
-                if (engine->all_records[i] != NULL) free(engine->all_records[i]);
+                // Loaded records are released with their block or mapping
+                record *r = engine->all_records[i];
+                if (r != NULL && ownsRecord(engine, r)) free(r);
             }
             free(engine->all_records);
         }
+        free(engine->record_block);
+
+        /* Free: column store */
+        columnStoreDestroy(engine->columns);
+
+        /* Free: mapped snapshot */
+        snapshotUnmap(engine->record_map, engine->record_map_bytes);
+
+        /* Free: string fields of all records */
+        stringHeapDestroy(engine->strings);
 
         /* Free: duplicated strings */
         if (engine->tableName) free(engine->tableName);
@@ -852,26 +594,31 @@ int isAttributeIndexed(struct engineS *engine, const char *attributeName) {
 
 /* Performs a linear search through a given array of records based on the WHERE clause */
 record **linearSearchRecords(record **records, int num_records, struct whereClauseS *whereClause, int *matchingRecords) {
-    // Allocate space for results array
-    record **results = malloc(sizeof(record *));
+    // Allocate space for results array (every record may match; trimmed afterwards)
+    record **results = malloc((num_records > 0 ? num_records : 1) * sizeof(record *));
+    if (results == NULL) {
+        perror("Failed to allocate linear search results");
+        exit(EXIT_FAILURE);
+    }
     *matchingRecords = 0;
 
-    // Iterate through all records and apply WHERE clause filtering
+    // Compile the WHERE clause once, then run it against every record
+    where_program program;
+    whereCompile(&program, whereClause);
     for(int i = 0; i < num_records; i++) {
         record *currentRecord = records[i];
-        bool matches = true;
-
-        if (whereClause != NULL) {
-            matches = evaluateWhereClause(currentRecord, whereClause);
-        }
 
         // If record matches all conditions, add to results
-        if (matches) {
-            results = realloc(results, (*matchingRecords + 1) * sizeof(record *));
+        if (whereMatches(&program, currentRecord)) {
             results[*matchingRecords] = currentRecord;
             (*matchingRecords)++;
         }
     }
+    whereProgramFree(&program);
+    if (*matchingRecords > 0 && *matchingRecords < num_records) {
+        record **trimmed = realloc(results, *matchingRecords * sizeof(record *));
+        if (trimmed != NULL) results = trimmed;
+    }
 
     // Return the array of matching records
     return results;
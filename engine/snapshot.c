@@ -0,0 +1,207 @@
+/*
+ * Snapshots: the parsed records of a data file saved in binary form, so the next start
+ * maps them instead of parsing every CSV line again.
+ */
+
+#define _POSIX_C_SOURCE 200809L  // fstat, posix_madvise
+#include "../include/snapshot.h"
+#include "../include/recordSchema.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// stdio buffer for writing the record section
+#define SNAPSHOT_WRITE_BUFFER (1 << 20)
+
+// Offsets in struct record of its string fields
+static int stringFieldOffsets(size_t offsets[]) {
+    size_t num_fields;
+    const FieldInfo *fields = get_record_fields(&num_fields);
+    int count = 0;
+    for (size_t f = 0; f < num_fields; f++)
+        if (fields[f].type == FIELD_STRING)
+            offsets[count++] = fields[f].offset;
+    return count;
+}
+
+static const char **stringField(record *r, size_t offset) {
+    return (const char **)((char *)r + offset);
+}
+
+static bool snapshotEnabled(void) {
+    const char *env = getenv(SNAPSHOT_ENV);
+    return env == NULL || strcmp(env, "0") != 0;
+}
+
+/* ==================== Public API ==================== */
+
+char *snapshotPath(const char *datafile) {
+    size_t length = strlen(datafile) + strlen(SNAPSHOT_SUFFIX) + 1;
+    char *path = malloc(length);
+    if (path == NULL) {
+        perror("Snapshot path allocation failed");
+        exit(EXIT_FAILURE);
+    }
+    snprintf(path, length, "%s%s", datafile, SNAPSHOT_SUFFIX);
+    return path;
+}
+
+bool snapshotSave(const char *datafile, record **records, int num_records) {
+    if (datafile == NULL || records == NULL || num_records < 0)
+        return false;
+
+    snapshot_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, SNAPSHOT_MAGIC, sizeof(h.magic));
+    h.version = SNAPSHOT_VERSION;
+    h.record_size = (uint32_t)sizeof(record);
+    if (!dataFileIdentity(datafile, &h.data))
+        return false;
+    h.num_records = (uint64_t)num_records;
+    h.records_offset = SNAPSHOT_PAGE;
+    h.strings_offset = h.records_offset + (uint64_t)num_records * sizeof(record);
+    size_t string_fields[sizeof(record) / sizeof(char *)];
+    int num_string_fields = stringFieldOffsets(string_fields);
+    for (int i = 0; i < num_records; i++)
+        for (int f = 0; f < num_string_fields; f++)
+            h.strings_bytes += strlen(*stringField(records[i], string_fields[f])) + 1;
+
+    // Write beside the final name and rename, so a running engine never maps half a file
+    char *path = snapshotPath(datafile);
+    size_t tmp_length = strlen(path) + 32;
+    char *tmp_path = malloc(tmp_length);
+    if (tmp_path == NULL) {
+        perror("Snapshot path allocation failed");
+        exit(EXIT_FAILURE);
+    }
+    snprintf(tmp_path, tmp_length, "%s.tmp.%ld", path, (long)getpid());
+
+    bool ok = false;
+    FILE *file = fopen(tmp_path, "wb");
+    if (file != NULL) {
+        setvbuf(file, NULL, _IOFBF, SNAPSHOT_WRITE_BUFFER);
+        unsigned char *page = calloc(1, SNAPSHOT_PAGE);
+        if (page == NULL) {
+            perror("Snapshot page allocation failed");
+            exit(EXIT_FAILURE);
+        }
+        memcpy(page, &h, sizeof(h));
+        ok = fwrite(page, 1, SNAPSHOT_PAGE, file) == SNAPSHOT_PAGE;
+        free(page);
+        // Records with their strings as string section offsets, then the strings in the same order
+        uint64_t string_offset = 0;
+        for (int i = 0; i < num_records && ok; i++) {
+            record image = *records[i];
+            for (int f = 0; f < num_string_fields; f++) {
+                const char **field = stringField(&image, string_fields[f]);
+                uint64_t length = strlen(*field) + 1;
+                *field = (const char *)(uintptr_t)string_offset;
+                string_offset += length;
+            }
+            ok = fwrite(&image, sizeof(record), 1, file) == 1;
+        }
+        for (int i = 0; i < num_records && ok; i++) {
+            for (int f = 0; f < num_string_fields && ok; f++) {
+                const char *value = *stringField(records[i], string_fields[f]);
+                size_t length = strlen(value) + 1;
+                ok = fwrite(value, 1, length, file) == length;
+            }
+        }
+        ok = (fclose(file) == 0) && ok;
+        if (ok)
+            ok = rename(tmp_path, path) == 0;
+        if (!ok)
+            remove(tmp_path);
+    }
+
+    free(tmp_path);
+    free(path);
+    return ok;
+}
+
+record **snapshotLoad(const char *datafile, int *num_records, void **map_out, size_t *map_bytes_out) {
+    if (!snapshotEnabled() || datafile == NULL)
+        return NULL;
+
+    char *path = snapshotPath(datafile);
+    int fd = open(path, O_RDONLY);
+    free(path);
+    if (fd < 0)
+        return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < SNAPSHOT_PAGE) {
+        close(fd);
+        return NULL;
+    }
+    size_t file_size = (size_t)st.st_size;
+    // Private and writable, so the loader can relocate string offsets into pointers (never written back)
+    void *map = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return NULL;
+
+    const snapshot_header *h = map;
+    data_file_identity now;
+    bool valid = memcmp(h->magic, SNAPSHOT_MAGIC, sizeof(h->magic)) == 0 &&
+                 h->version == SNAPSHOT_VERSION &&
+                 h->record_size == (uint32_t)sizeof(record) &&
+                 h->records_offset % SNAPSHOT_PAGE == 0 &&
+                 h->records_offset <= file_size &&
+                 h->num_records <= (file_size - h->records_offset) / sizeof(record) &&
+                 h->num_records <= (uint64_t)INT32_MAX &&
+                 h->strings_offset == h->records_offset + h->num_records * sizeof(record) &&
+                 h->strings_bytes <= file_size - h->strings_offset &&
+                 (h->strings_bytes == 0 || ((const char *)map)[h->strings_offset + h->strings_bytes - 1] == '\0') &&
+                 dataFileIdentity(datafile, &now) &&
+                 sameDataFile(&now, &h->data);
+    if (!valid) {
+        munmap(map, file_size);
+        return NULL;
+    }
+
+    // Start reading the records ahead; index builds and scans touch all of them
+    posix_madvise(map, file_size, POSIX_MADV_WILLNEED);
+    int n = (int)h->num_records;
+    record *block = (record *)((char *)map + h->records_offset);
+    record **records = malloc((n > 0 ? n : 1) * sizeof(record *));
+    if (records == NULL) {
+        perror("Snapshot record array allocation failed");
+        exit(EXIT_FAILURE);
+    }
+    // Point the string fields back into the mapping (this writes the record pages, privately)
+    const char *strings = (const char *)map + h->strings_offset;
+    size_t string_fields[sizeof(record) / sizeof(char *)];
+    int num_string_fields = stringFieldOffsets(string_fields);
+    for (int i = 0; i < n; i++) {
+        records[i] = &block[i];
+        for (int f = 0; f < num_string_fields; f++) {
+            const char **field = stringField(&block[i], string_fields[f]);
+            uintptr_t offset = (uintptr_t)*field;
+            if (offset >= h->strings_bytes) {
+                free(records);
+                munmap(map, file_size);
+                return NULL;
+            }
+            *field = strings + offset;
+        }
+    }
+
+    *num_records = n;
+    *map_out = map;
+    *map_bytes_out = file_size;
+    return records;
+}
+
+bool snapshotContains(const void *map, size_t map_bytes, const void *row) {
+    uintptr_t base = (uintptr_t)map;
+    return map != NULL && (uintptr_t)row >= base && (uintptr_t)row < base + map_bytes;
+}
+
+void snapshotUnmap(void *map, size_t map_bytes) {
+    if (map != NULL)
+        munmap(map, map_bytes);
+}
@@ -0,0 +1,96 @@
+/*
+ * String heap: append-only chunks holding the string fields of records, so a record is
+ * a few pointers instead of fixed-size char arrays that are mostly padding.
+ */
+
+#define _POSIX_C_SOURCE 200809L  // munmap
+#include "../include/stringHeap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/* ==================== Chunks ==================== */
+
+static string_chunk *newChunk(string_heap *heap, char *data, size_t used, size_t capacity, bool mapped) {
+    string_chunk *chunk = malloc(sizeof(string_chunk));
+    if (chunk == NULL) {
+        perror("String heap chunk allocation failed");
+        exit(EXIT_FAILURE);
+    }
+    chunk->data = data;
+    chunk->used = used;
+    chunk->capacity = capacity;
+    chunk->mapped = mapped;
+    chunk->next = heap->chunks;
+    heap->chunks = chunk;
+    heap->bytes += capacity;
+    return chunk;
+}
+
+/* ==================== Public API ==================== */
+
+string_heap *stringHeapCreate(void) {
+    string_heap *heap = malloc(sizeof(string_heap));
+    if (heap == NULL) {
+        perror("String heap creation failed");
+        exit(EXIT_FAILURE);
+    }
+    heap->chunks = NULL;
+    heap->bytes = 0;
+    return heap;
+}
+
+const char *stringHeapAdd(string_heap *heap, const char *value, size_t length) {
+    string_chunk *chunk = heap->chunks;
+    if (chunk == NULL || chunk->capacity - chunk->used < length + 1) {
+        size_t capacity = length + 1 > STRING_HEAP_CHUNK_BYTES ? length + 1 : STRING_HEAP_CHUNK_BYTES;
+        char *data = malloc(capacity);
+        if (data == NULL) {
+            perror("String heap chunk allocation failed");
+            exit(EXIT_FAILURE);
+        }
+        chunk = newChunk(heap, data, 0, capacity, false);
+    }
+    char *copy = chunk->data + chunk->used;
+    memcpy(copy, value, length);
+    copy[length] = '\0';
+    chunk->used += length + 1;
+    return copy;
+}
+
+/* adoptChunk: Adds a full chunk (later strings go to a fresh chunk instead of past the
+ * adopted contents) behind the chunk currently being appended to, which keeps its room.
+ */
+static void adoptChunk(string_heap *heap, char *data, size_t bytes, bool mapped) {
+    string_chunk *adopted = newChunk(heap, data, bytes, bytes, mapped);
+    if (adopted->next != NULL) {
+        heap->chunks = adopted->next;
+        adopted->next = heap->chunks->next;
+        heap->chunks->next = adopted;
+    }
+}
+
+void stringHeapAdopt(string_heap *heap, char *buffer, size_t bytes) {
+    adoptChunk(heap, buffer, bytes, false);
+}
+
+void stringHeapAdoptMapping(string_heap *heap, void *map, size_t bytes) {
+    adoptChunk(heap, map, bytes, true);
+}
+
+void stringHeapDestroy(string_heap *heap) {
+    if (heap == NULL) return;
+    string_chunk *chunk = heap->chunks;
+    while (chunk != NULL) {
+        string_chunk *next = chunk->next;
+        if (chunk->mapped) {
+            munmap(chunk->data, chunk->capacity);
+        } else {
+            free(chunk->data);
+        }
+        free(chunk);
+        chunk = next;
+    }
+    free(heap);
+}
@@ -3,10 +3,25 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 #include "logType.h"  // Structure of each table entry (record)
+#include "postingList.h"  // POSTING_BLOCK_ROWS (cursor buffer size)
 
-// Default order (fanout). Adjust to change branching factor and height.
-#define ORDER 3
+// Nodes are single allocations rounded up to whole cache lines.
+#define BPLUS_CACHE_LINE 64
+
+// Target size of one node when picking the default order (32 cache lines).
+#define BPLUS_NODE_BYTES 2048
+
+// Order (fanout) limits. The split / merge logic needs at least 3.
+#define BPLUS_MIN_ORDER 3
+#define BPLUS_MAX_ORDER 4096
+
+// Environment variable that overrides the default order at runtime.
+#define BPLUS_ORDER_ENV "BPLUS_ORDER"
+
+// Target node occupancy when bulk loading (leaves headroom for later inserts).
+#define BULK_FILL_FACTOR 0.9
 
 /* --- Configurable key + value types --- */
 
@@ -29,39 +44,169 @@ typedef struct {
     } v;
 } KEY_T;
 
-typedef void *ROW_PTR;  // Pointer to the table row.
+typedef void *ROW_PTR;  // Pointer to the table row (at least 2-byte aligned).
+
+// Key / row pair used as bulk loading input.
+typedef struct {
+    KEY_T key;
+    ROW_PTR row_ptr;
+} bplus_entry;
 
 
 // Node structure for the B+ Tree.
+// Keys are stored densely in the tree's native type (uint64_t, int32_t, bool or
+// const char *), so KEY_T only appears at the API boundary.
+// Each key is stored once. A leaf pointer is the row itself, or a tagged posting
+// list (see postingList.h) when several rows share the key.
 typedef struct node node;
 struct node {
     void **pointers;
-    KEY_T *keys;
+    void *keys;        // Typed key array: tree->key_size bytes per key
+    int *counts;       // Internal nodes: rows under each child (posting rows included)
     struct node *parent;
     bool is_leaf;
     int num_keys;
-    struct node *next; // Queue linkage for printing.
+    atomic_int latch;  // Reader-writer latch: 0 free, > 0 readers, -1 writer
 };
 
+// Node memory source for one tree. alloc returns a BPLUS_CACHE_LINE aligned block of
+// tree->node_bytes (or NULL on failure); release takes it back. Both may be called from
+// several threads at once when the tree is shared.
+typedef struct {
+    void *(*alloc)(void *ctx, size_t bytes);
+    void (*release)(void *ctx, void *block);
+    void *ctx;
+} bplus_allocator;
+
+// Structural counters of one tree (snapshot returned by bptreeGetStats).
+typedef struct {
+    long nodes;           // Nodes currently allocated
+    long splits;          // Leaf and internal node splits
+    long merges;          // Nodes folded into a sibling on underflow
+    long redistributions; // Entries borrowed from a sibling on underflow
+} bplus_stats;
+
+// Tree handle: owns the root, the per-tree layout parameters, the node allocator and
+// the structural counters. Nothing in bplus.c is process-global, so trees with different
+// orders, key types and allocators can be built and queried side by side.
+// insert, delete, find_rows, countRange and cursors may run from several threads at
+// once: they latch-couple down the tree (see "Node latches" in bplus.c). bulkLoad,
+// destroy_tree, findLeaf and the print helpers need the tree to themselves.
+typedef struct bptree {
+    node *root;        // NULL while the tree is empty
+    KeyType key_type;  // Type of every key stored in this tree
+    size_t key_size;   // Bytes per key in the node key arrays
+    int order;         // Max children per internal node (leaves hold order - 1 keys)
+    size_t node_bytes; // Size of one node allocation (multiple of BPLUS_CACHE_LINE)
+    atomic_int root_latch; // Guards the root pointer itself (same encoding as node latches)
+    bplus_allocator allocator;
+    struct node_arena *arena; // Owned slab arena behind allocator (NULL for a caller's allocator)
+    bool verbose_output; // Print helpers also emit node and row addresses
+    struct {
+        atomic_long nodes, splits, merges, redistributions;
+    } stats;
+} bptree;
+
+// Streaming range scan over [key_start, key_end] (see bptreeCursorOpen).
+// Lives on the caller's stack; rows are produced leaf by leaf and one posting block
+// at a time, so no result-sized buffers are needed. An open cursor holds a shared latch
+// on its current leaf, so writers to that leaf wait until it moves on or is closed; a
+// thread must not modify the tree while it has a cursor open on it.
+typedef struct bplus_cursor {
+    bptree *tree;
+    KEY_T key_end;                       // Upper bound
+    bool end_exclusive;                  // Stop before key_end instead of after it
+    bool unbounded;                      // No upper bound (bptreeCursorOpenAll)
+    node *leaf;                          // Current leaf (NULL once exhausted)
+    int slot;                            // Next key slot to read in leaf
+    int slot_end;                        // First slot past key_end in leaf
+    KEY_T key;                           // Key of the buffered rows
+    posting_list *posting;               // Posting list being drained (NULL for single rows)
+    int block;                           // Next posting block to decode
+    ROW_PTR rows[POSTING_BLOCK_ROWS];    // Buffered rows for key
+    int num_rows;
+    int row_pos;
+} bplus_cursor;
+
+// Creates an empty tree. order <= 0 selects bptreeDefaultOrder(key_type).
+bptree *bptreeCreate(KeyType key_type, int order);
+// Same as bptreeCreate, but nodes come from allocator. NULL (and bptreeCreate) gives the
+// tree its own slab arena (nodeArena.h), released in one pass by destroy_tree.
+bptree *bptreeCreateWith(KeyType key_type, int order, const bplus_allocator *allocator);
+// Copies the tree's structural counters into stats.
+void bptreeGetStats(bptree *tree, bplus_stats *stats);
+// Cache-line sized default order for a key type (BPLUS_ORDER_ENV overrides it).
+int bptreeDefaultOrder(KeyType key_type);
+
 // Function prototypes for B+ Tree operations.
-node *insert(node *root, KEY_T key, ROW_PTR row_ptr);
-node *delete(node *root, KEY_T key, ROW_PTR row_ptr);
-int find_rows(node *root, KEY_T key, ROW_PTR **results);
-void printTree(node *const root);
-void printLeaves(node *const root);
-int height(node *const root);
+void insert(bptree *tree, KEY_T key, ROW_PTR row_ptr);
+void delete(bptree *tree, KEY_T key, ROW_PTR row_ptr);
+// Replaces the tree contents with unsorted entries (sorted and compacted in place). fill_factor in (0, 1].
+void bulkLoad(bptree *tree, bplus_entry entries[], int num_entries, double fill_factor);
+// Same as bulkLoad for entries already in key order (rows sharing a key may come in any order).
+void bulkLoadSorted(bptree *tree, bplus_entry entries[], int num_entries, double fill_factor);
+int find_rows(bptree *tree, KEY_T key, ROW_PTR **results);
+void printTree(bptree *const tree);
+void printLeaves(bptree *const tree);
+int height(bptree *const tree);
 int pathToLeaves(node *const root, node *child);
-void findAndPrint(node *const root, KEY_T key);
-void findAndPrintRange(node *const root, KEY_T key_start, KEY_T key_end, bool verbose);
-int findRange(node *const root, KEY_T key_start, KEY_T key_end, bool verbose,
+void findAndPrint(bptree *const tree, KEY_T key);
+void findAndPrintRange(bptree *const tree, KEY_T key_start, KEY_T key_end, bool verbose);
+int findRange(bptree *const tree, KEY_T key_start, KEY_T key_end, bool verbose,
               KEY_T returned_keys[], ROW_PTR returned_pointers[]);
-node *findLeaf(node *const root, KEY_T key, bool verbose);
+node *findLeaf(bptree *const tree, KEY_T key, bool verbose);
 
-/* Destroy a whole tree and free all nodes/arrays */
-void destroy_tree(node *root);
+// Positions cursor at the first row with key >= key_start.
+void bptreeCursorOpen(bplus_cursor *cursor, bptree *tree, KEY_T key_start, KEY_T key_end);
+// Same as bptreeCursorOpen, but the scan stops before key_stop ([key_start, key_stop)).
+void bptreeCursorOpenBefore(bplus_cursor *cursor, bptree *tree, KEY_T key_start, KEY_T key_stop);
+// Scans every row of the tree in key order.
+void bptreeCursorOpenAll(bplus_cursor *cursor, bptree *tree);
+// Next row in key order (key may be NULL). Returns false once past key_end.
+bool bptreeCursorNext(bplus_cursor *cursor, KEY_T *key, ROW_PTR *row);
+// Copies up to max_rows next rows into rows; returns how many (0 once exhausted).
+int bptreeCursorNextBatch(bplus_cursor *cursor, ROW_PTR rows[], int max_rows);
+// Skips the rest of the current key and moves to the next one, reporting its key and row
+// count without reading its rows. Returns false once past key_end.
+bool bptreeCursorNextKey(bplus_cursor *cursor, KEY_T *key, int *num_rows);
+// Ends the scan early and drops the leaf latch (an exhausted cursor has already dropped it).
+void bptreeCursorClose(bplus_cursor *cursor);
+// Cuts [key_start, key_end] into up to max_parts sub-ranges of similar leaf counts using
+// internal separators. Writes the (sorted) cut keys and returns how many there are:
+// part p scans [cuts[p - 1], cuts[p]) with key_start / key_end closing the two ends.
+int bptreeSplitRange(bptree *tree, KEY_T key_start, KEY_T key_end, int max_parts, KEY_T cuts[]);
+// Rows with key_start <= key <= key_end, from the per-child subtree counts (no leaf scan).
+int countRange(bptree *tree, KEY_T key_start, KEY_T key_end);
+// Total rows indexed by the tree (posting-list rows included).
+int countRows(bptree *tree);
+
+// Flat copy of a tree for index files (see "Tree images" in bplus.c).
+typedef struct {
+    void *nodes;          // num_nodes blocks of tree->node_bytes, breadth-first from the root
+    long num_nodes;
+    uint32_t *postings;   // Row id runs of keys with several rows
+    size_t num_postings;  // uint32_t words in postings
+} bplus_image;
+
+// Row id of a row for bptreeImageCreate, or -1 when the row has none.
+typedef long (*bplus_row_id)(void *ctx, ROW_PTR row);
+
+// Flattens a tree with numeric or boolean keys; rows are named by row_id. False (and an
+// empty image) for string keys, an empty tree or a row without an id. The tree must not
+// change meanwhile.
+bool bptreeImageCreate(bptree *tree, bplus_row_id row_id, void *ctx, bplus_image *image);
+void bptreeImageFree(bplus_image *image);
+// Turns image nodes back into a tree in place. nodes is the start of a writable mapping of
+// mapping_bytes, which the tree's arena takes over; rows[id] resolves row ids. NULL when
+// the layout differs from bptreeCreate(key_type, order) or a link or id is out of range
+// (the mapping then stays with the caller).
+bptree *bptreeFromImage(KeyType key_type, int order, size_t node_bytes, void *nodes, long num_nodes,
+                        size_t mapping_bytes, const uint32_t *postings, size_t num_postings,
+                        ROW_PTR rows[], int num_rows);
+
+/* Destroy a whole tree (all nodes and the handle itself) */
+void destroy_tree(bptree *tree);
 // Key comparison function
 int compare_keys(const KEY_T *key1, const KEY_T *key2);
 
-void set_rank(int rank);
-
 #endif // BPLUS_SERIAL_H
\ No newline at end of file
@@ -29,27 +29,27 @@
  */
 bool makeIndexMPI(struct engineS *engine, const char *indexName, int attributeType);
 
-record **getAllRecordsFromFileMPI(const char *filepath, int *num_records);
-node *loadIntoBplusTreeMPI(record **records, int num_records, const char *attributeName);
+record **getAllRecordsFromFileMPI(const char *filepath, int *num_records, void **record_block_out, size_t *record_block_bytes_out, string_heap *strings);
+bptree *loadIntoBplusTreeMPI(record **records, int num_records, const char *attributeName);
 record *getRecordFromLineMPI(char *line);
 FieldType mapAttributeTypeMPI(int attributeType);
 
 /*
  * loadIntoBplusTree: Loads an array of records into a B+ tree
  * 
- * Iterates through the provided array of record pointers and inserts each
- * record into a B+ tree using command_id as the key. The tree is built
- * incrementally with automatic splitting when nodes become full.
+ * Extracts the indexed attribute from every record into (key, row) pairs,
+ * sorts them once and bulk loads the tree bottom-up (see bulkLoad), filling
+ * nodes to BULK_FILL_FACTOR instead of inserting and splitting per record.
  * 
  * Parameters:
- *   engine - pointer to the engine structure (for attribute info)
- *   records - array of record pointers to insert
+ *   records - array of record pointers to index
  *   num_records - number of records in the array
+ *   attributeName - name of the attribute to index
  * 
  * Returns:
- *   Pointer to the root node of the populated B+ tree, or NULL on error
+ *   Handle of the populated B+ tree (empty when there are no records), or NULL on error
  */
-node *loadIntoBplusTree(record **records, int num_records, const char *attributeName);
+bptree *loadIntoBplusTree(record **records, int num_records, const char *attributeName);
 
 /*
  * getAllRecordsFromFile: Loads CSV file into memory as record array
@@ -61,12 +61,13 @@ node *loadIntoBplusTree(record **records, int num_records, const char *attribute
  * Parameters:
  *   filepath - path to the CSV data file
  *   num_records - output parameter set to the count of loaded records
+ *   strings - string heap receiving the records' string fields
  * 
  * Returns:
  *   Pointer to dynamically allocated array of record pointers, or NULL on error.
  *   Caller is responsible for freeing the array and individual records.
  */
-record **getAllRecordsFromFile(const char *filepath, int *num_records);
+record **getAllRecordsFromFile(const char *filepath, int *num_records, void **record_block_out, size_t *record_block_bytes_out, string_heap *strings);
 
 /*
  * getRecordFromLine: Parses a CSV line into a record struct
@@ -79,12 +80,13 @@ record **getAllRecordsFromFile(const char *filepath, int *num_records);
  * 
  * Parameters:
  *   line - null-terminated string containing one line of CSV data
+ *   strings - string heap receiving copies of the string fields
  * 
  * Returns:
  *   Pointer to a newly allocated and populated record struct, or NULL on
  *   memory allocation failure. Caller is responsible for freeing.
  */
-record *getRecordFromLine(char *line);
+record *getRecordFromLine(char *line, string_heap *strings);
 
 /*
  * mapAttributeType: Maps integer type code to FieldType enum
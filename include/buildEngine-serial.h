@@ -31,36 +31,41 @@ bool makeIndexSerial(struct engineS *engine, const char *indexName, int attribut
 /*
  * loadIntoBplusTree: Loads an array of records into a B+ tree
  * 
- * Iterates through the provided array of record pointers and inserts each
- * record into a B+ tree using command_id as the key. The tree is built
- * incrementally with automatic splitting when nodes become full.
+ * Extracts the indexed attribute from every record into (key, row) pairs,
+ * sorts them once and bulk loads the tree bottom-up (see bulkLoad), filling
+ * nodes to BULK_FILL_FACTOR instead of inserting and splitting per record.
  * 
  * Parameters:
- *   engine - pointer to the engine structure (for attribute info)
- *   records - array of record pointers to insert
+ *   records - array of record pointers to index
  *   num_records - number of records in the array
+ *   attributeName - name of the attribute to index
  * 
  * Returns:
- *   Pointer to the root node of the populated B+ tree, or NULL on error
+ *   Handle of the populated B+ tree (empty when there are no records), or NULL on error
  */
-node *loadIntoBplusTree(record **records, int num_records, const char *attributeName);
+bptree *loadIntoBplusTree(record **records, int num_records, const char *attributeName);
 
 /*
  * getAllRecordsFromFile: Loads CSV file into memory as record array
  * 
  * Reads a CSV file line-by-line, parsing each line into a record struct
- * and building a dynamically allocated array of all records. The array
- * is resized as needed during reading.
+ * stored in one contiguous block (grown as needed, in file order), then
+ * builds the array of pointers into it. Lines and fields of any length
+ * are read whole.
  * 
  * Parameters:
  *   filepath - path to the CSV data file
  *   num_records - output parameter set to the count of loaded records
+ *   record_block_out - output parameter set to the block holding the records
+ *   record_block_bytes_out - output parameter set to the length of the block
+ *   strings - string heap receiving the records' string fields
  * 
  * Returns:
  *   Pointer to dynamically allocated array of record pointers, or NULL on error.
- *   Caller is responsible for freeing the array and individual records.
+ *   Caller is responsible for freeing the array and the record block; the
+ *   strings live until the heap is destroyed.
  */
-record **getAllRecordsFromFile(const char *filepath, int *num_records);
+record **getAllRecordsFromFile(const char *filepath, int *num_records, void **record_block_out, size_t *record_block_bytes_out, string_heap *strings);
 
 /*
  * getRecordFromLine: Parses a CSV line into a record struct
@@ -72,13 +77,24 @@ record **getAllRecordsFromFile(const char *filepath, int *num_records);
  *   host_name, risk_level
  * 
  * Parameters:
- *   line - null-terminated string containing one line of CSV data
+ *   line - null-terminated string containing one line of CSV data (fields
+ *          are unquoted in place, so the line is modified)
+ *   strings - string heap receiving copies of the string fields
  * 
  * Returns:
  *   Pointer to a newly allocated and populated record struct, or NULL on
  *   memory allocation failure. Caller is responsible for freeing.
  */
-record *getRecordFromLine(char *line);
+record *getRecordFromLine(char *line, string_heap *strings);
+
+/*
+ * fillRecordFromLine: Parses a CSV line into caller-provided record storage
+ * 
+ * Same parsing as getRecordFromLine (line[0..length) without the newline,
+ * see csvSplitLine), writing into rec instead of a new allocation (used to
+ * fill the loader's record block).
+ */
+void fillRecordFromLine(record *rec, char *line, size_t length, string_heap *strings);
 
 /*
  * mapAttributeType: Maps integer type code to FieldType enum
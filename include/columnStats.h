@@ -0,0 +1,49 @@
+#ifndef COLUMN_STATS_H
+#define COLUMN_STATS_H
+
+#include <stdbool.h>
+#include "bplus.h"
+
+// Most buckets of an equi-depth histogram.
+#define STATS_MAX_BUCKETS 32
+// Statistics are rebuilt from their index once the inserts and deletes since the last build
+// pass 1/STATS_REBUILD_DIVISOR of the rows they were built from.
+#define STATS_REBUILD_DIVISOR 8
+
+// Keys in (previous bucket's upper, upper]: the rows holding them and how many distinct keys there are.
+typedef struct {
+    KEY_T upper;
+    int rows;
+    int distinct;
+} stats_bucket;
+
+/* Statistics of one indexed attribute, read from its B+ tree in key order: row count,
+ * distinct keys (NDV), min / max and an equi-depth histogram (buckets of about
+ * num_rows / STATS_MAX_BUCKETS rows; a key never straddles two buckets, so a column with
+ * few distinct keys gets one bucket per key). INSERT and DELETE adjust the counts in
+ * place; distinct counts only grow there, and a rebuild settles them again.
+ * String attributes keep only num_rows.
+ */
+typedef struct {
+    KeyType key_type;
+    int num_rows;
+    int distinct;
+    KEY_T min;
+    KEY_T max;
+    int num_buckets;
+    stats_bucket buckets[STATS_MAX_BUCKETS];
+    int built_rows;  // num_rows at the last build
+    int changes;     // Inserts and deletes since then
+} column_stats;
+
+// Gathers the statistics of tree's keys (one pass over its distinct keys).
+void columnStatsBuild(column_stats *stats, bptree *tree);
+// Accounts for one row inserted with / deleted from key.
+void columnStatsAdd(column_stats *stats, KEY_T key);
+void columnStatsRemove(column_stats *stats, KEY_T key);
+// Rebuilds from tree once enough rows changed since the last build; returns whether it did.
+bool columnStatsRefresh(column_stats *stats, bptree *tree);
+// Estimated rows with key_start <= key <= key_end. Attributes without a histogram estimate every row.
+double columnStatsEstimate(const column_stats *stats, KEY_T key_start, KEY_T key_end);
+
+#endif // COLUMN_STATS_H
@@ -0,0 +1,63 @@
+#ifndef COLUMN_STORE_H
+#define COLUMN_STORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "logType.h"
+#include "recordSchema.h"
+
+struct whereClauseS;
+
+// Rows evaluated per predicate pass; one block of match flags stays in L1.
+#define COLUMN_SCAN_BLOCK 1024
+// Most distinct values a dictionary-encoded string column may hold (codes are uint16_t).
+#define COLUMN_DICT_MAX_CODES 65535
+// String columns with over half of their first COLUMN_DICT_SAMPLE rows distinct stay plain.
+#define COLUMN_DICT_SAMPLE 4096
+
+/* One attribute of every row. Fixed-width attributes are a typed array (uint64_t, int
+ * or bool by FieldType); strings are NUL-terminated in one heap. A plain string column
+ * keeps the heap offset of each row's value in offsets. A dictionary-encoded one (few
+ * distinct values, like shell_type or host_name) keeps each distinct value once, with
+ * offsets listing them in sorted order and codes holding each row's position in that
+ * list, so comparing codes orders rows the same way as strcmp on their values.
+ */
+typedef struct {
+    const FieldInfo *field;  // Attribute (name, type, offset in struct record)
+    void *values;            // Fixed-width values, indexed by row id
+    uint64_t *offsets;       // String columns: start of each row's value (plain) or of each dictionary entry in heap
+    char *heap;
+    size_t heap_bytes;
+    size_t heap_capacity;
+    uint16_t *codes;         // Dictionary-encoded columns: code of each row's value, NULL for plain columns
+    int dict_size;           // Dictionary entries in offsets
+    int dict_capacity;
+} column;
+
+/* Columnar (PAX-style) copy of a table: one column per record field, row ids match
+ * positions in the engine's all_records. Scans and WHERE evaluation read only the
+ * columns a predicate names; rows are fetched by id for projection.
+ */
+typedef struct column_store {
+    int num_rows;
+    int capacity;         // Rows the columns have room for
+    int num_columns;
+    column *columns;      // In record field order (see get_record_fields)
+} column_store;
+
+// Builds columns for records[0..num_records).
+column_store *columnStoreBuild(record **records, int num_records);
+// Appends r as the next row id.
+void columnStoreAppend(column_store *store, const record *r);
+// Frees the store and all its columns (NULL is ignored).
+void columnStoreDestroy(column_store *store);
+// Column of attribute, or NULL for an unknown attribute.
+const column *columnStoreColumn(const column_store *store, const char *attribute);
+// Value of a string column at row, whether the column is plain or dictionary-encoded.
+const char *columnStoreString(const column *col, int row);
+// Evaluates whereClause for rows [begin, end) into mask[0..end-begin) (1 = row matches).
+void columnStoreFilter(const column_store *store, struct whereClauseS *whereClause, int begin, int end, uint8_t *mask);
+// Row ids matching whereClause, in row order (caller frees); the count goes to *num_matches.
+int *columnStoreSelect(const column_store *store, struct whereClauseS *whereClause, int *num_matches);
+
+#endif // COLUMN_STORE_H
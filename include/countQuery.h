@@ -0,0 +1,21 @@
+#ifndef COUNT_QUERY_H
+#define COUNT_QUERY_H
+
+#include <stdbool.h>
+
+struct engineS;
+struct whereClauseS;
+struct resultSetS;
+
+// True when the SELECT list is exactly COUNT(*).
+bool isCountStar(const char *selectItems[], int numItems);
+
+// Answers COUNT(*) from the B+ tree subtree counts when the WHERE clause is absent or a
+// single comparison on an indexed attribute that one key range answers (indexKeyRange).
+// Returns false when the rows must be scanned instead.
+bool countFromIndex(const struct engineS *engine, const struct whereClauseS *whereClause, int *count);
+
+// Single-cell result of a COUNT(*) query (caller frees, like any result set).
+struct resultSetS *makeCountResult(int count, double time_taken);
+
+#endif
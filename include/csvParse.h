@@ -0,0 +1,34 @@
+#ifndef CSV_PARSE_H
+#define CSV_PARSE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "logType.h"  // record struct
+
+// Columns of a data file line, in struct record order (see logType.h).
+#define CSV_RECORD_FIELDS 12
+
+/* Splits one CSV line into up to max_fields fields, in place.
+ * line[0..length) holds the line without its newline, and line[length] must be writable
+ * (it is the newline or NUL after the line). Quoted fields are unquoted ("" becomes ")
+ * over the line itself and every field is NUL-terminated there, so fields[i] points into
+ * line and lengths[i] (lengths may be NULL) is its length. Fields missing from a short line
+ * are set to "". A line ends at its length, or earlier at a '\n', '\r' or NUL byte.
+ * Returns the number of fields present on the line.
+ */
+int csvSplitLine(char *line, size_t length, const char **fields, size_t *lengths, int max_fields);
+
+/* Parses a data file line into rec (every field set; string fields point into line, as
+ * with csvSplitLine, and are "" when missing).
+ */
+void csvParseRecord(record *rec, char *line, size_t length);
+
+// Field value as strtoull(text, NULL, 10) would read it.
+uint64_t csvParseUint64(const char *text);
+// Field value as atoi(text) would read it.
+int csvParseInt(const char *text);
+// True for "true" (any case) or "1".
+bool csvParseBool(const char *text);
+
+#endif // CSV_PARSE_H
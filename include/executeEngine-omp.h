@@ -50,4 +50,12 @@ bool addAttributeIndexOMP(
     int attributeType
 );
 
+// Splits num_threads between batch_size queries run side by side on an outer parallel loop.
+// Returns the outer team size; each query sets omp_set_num_threads(*scan_threads) before it
+// runs, so its index and linear scans get the threads the outer team leaves over.
+int queryBatchTeamOMP(int batch_size, int num_threads, int *scan_threads);
+
+// Threads a scan started by the calling thread would run on (1 when no nested team can form).
+int scanTeamSizeOMP(void);
+
 #endif // EXECUTE_ENGINE_OMP_H
@@ -9,19 +9,31 @@
 #include <string.h>
 #include "logType.h"
 #include "recordSchema.h"
+#include "columnStore.h"
+#include "columnStats.h"
+#include "predicate.h"
+#include "indexPlan.h"
+#include "stringHeap.h"
 
 /* Struct for the engine */
 /* Holds the state of the database engine, including all data records and active indexes. */
 struct engineS {
     char *tableName; // Name of the table represented by this engine
-    node **bplus_tree_roots; // Array of roots for all B+ tree indexes
+    bptree **bplus_tree_roots; // Array of tree handles for all B+ tree indexes
     int num_indexes; // Number of indexes
     char **indexed_attributes; // Names of indexed attributes
     FieldType *attribute_types; // Types of indexed attributes (from record schema)
+    column_stats *index_stats; // Statistics of each indexed attribute (parallel to bplus_tree_roots), for the index planner
     record **all_records; // Array of all records in the table (for full table scans on non-indexed queries and for assigning row pointers)
     int num_records; // Total number of records in the table
     char *datafile; // Path to the data file
     void *record_block; // Pointer to the contiguous block of records (if block allocation is used, e.g. in OMP)
+    size_t record_block_bytes; // Length of record_block
+    void *record_map; // Mapped snapshot holding the loaded records (NULL when they were parsed from the CSV)
+    size_t record_map_bytes; // Length of record_map
+    column_store *columns; // Columnar copy of all_records for full-table scans (built by the first scan, NULL until then)
+    string_heap *strings; // String fields of the parsed and inserted records
+    struct engine_locks *locks; // Guards the fields above against queries running side by side (OMP engine; NULL otherwise)
 };
 
 /* Result set - The results of any given query 
@@ -0,0 +1,69 @@
+#ifndef INDEX_FILE_H
+#define INDEX_FILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "bplus.h"
+#include "logType.h"
+
+// Index files live next to the data file: <datafile>.<attribute>.idx
+#define INDEX_FILE_SUFFIX ".idx"
+
+// Set to "0" to neither read nor write index files.
+#define INDEX_CACHE_ENV "QPE_INDEX_CACHE"
+
+#define INDEX_FILE_MAGIC "QPEIDX01"
+#define INDEX_FILE_VERSION 2
+
+// Page size the node and posting sections are aligned to.
+#define INDEX_FILE_PAGE 4096
+
+// Bytes hashed at the start, middle and end of the data file for the checksum.
+#define INDEX_CHECKSUM_SAMPLE (64 * 1024)
+
+// Identity of a data file: an index or snapshot is only trusted while it matches.
+typedef struct {
+    uint64_t size;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    uint64_t checksum;        // FNV-1a over the sampled data file bytes
+} data_file_identity;
+
+/* On-disk header (first page of the file). Native byte order; an index file is a
+ * cache for one machine, not an exchange format. The node section at nodes_offset is
+ * the tree's image (see "Tree images" in bplus.c): num_nodes node blocks whose links
+ * are node numbers and whose rows are uint32_t row ids (position in the data file,
+ * header excluded). The posting section at postings_offset holds the id runs of keys
+ * shared by several rows. Both sections are page aligned, so the node section is
+ * mapped on its own and becomes the tree's nodes.
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t key_type;        // KeyType of the tree
+    char attribute[64];       // Indexed attribute name
+    data_file_identity data;  // Data file identity when the index was written
+    uint64_t num_records;     // Records loaded from the data file
+    uint64_t num_rows;        // Rows indexed by the tree
+    uint32_t order;           // Tree order the nodes were laid out for
+    uint32_t node_bytes;      // Size of one node block
+    uint64_t num_nodes;       // Node blocks in the node section
+    uint64_t nodes_offset;    // Start of the node section
+    uint64_t postings_offset; // Start of the posting section
+    uint64_t num_postings;    // uint32_t words in the posting section
+} index_file_header;
+
+// Reads the identity of datafile. False when the file cannot be read.
+bool dataFileIdentity(const char *datafile, data_file_identity *identity);
+// True when both identities describe the same file contents.
+bool sameDataFile(const data_file_identity *a, const data_file_identity *b);
+// Index file path for attribute (caller frees).
+char *indexFilePath(const char *datafile, const char *attribute);
+// Writes tree's nodes with its rows as ids into records[]. Returns false if nothing was written.
+bool indexFileSave(const char *datafile, const char *attribute, bptree *tree, record **records, int num_records);
+// Maps the index file's nodes and turns them into the tree in place. NULL when the file is
+// missing, disabled, or no longer matches the data file / records / tree layout (the caller
+// builds from scratch).
+bptree *indexFileLoad(const char *datafile, const char *attribute, record **records, int num_records);
+
+#endif // INDEX_FILE_H
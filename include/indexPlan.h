@@ -0,0 +1,66 @@
+#ifndef INDEX_PLAN_H
+#define INDEX_PLAN_H
+
+#include <stdbool.h>
+#include "bplus.h"
+#include "logType.h"
+#include "recordSchema.h"
+
+struct engineS;
+struct whereClauseS;
+struct index_plan_node;
+
+/* One condition of a WHERE clause answered by a B+ tree index: the key range it selects,
+ * and (once the engine has scanned it) the rows the index holds for that range, in key order.
+ */
+typedef struct {
+    const struct whereClauseS *condition;
+    int index;            // Position of the condition's index in engine->indexed_attributes
+    KEY_T key_start;
+    KEY_T key_end;
+    bool empty;           // No key satisfies the condition; nothing to scan
+    double estimate;      // Rows the range holds (countRange on the index; -1 without column_stats)
+    bool used;            // The candidate set depends on this leaf (unused leaves are not scanned)
+    record **rows;        // Index hits, appended by the engine's scan
+    int count;
+    int capacity;
+} index_leaf;
+
+/* Which rows a WHERE clause can be narrowed to from its indexes. Each indexed condition is a
+ * leaf; the leaves combine by the clause's own AND / OR chains and parenthesised sub-clauses
+ * into intersections and unions of row sets. An AND keeps whichever operands are indexed (the
+ * rest is checked by the row filter afterwards); an OR needs both operands indexed, otherwise
+ * any row could match and the table has to be scanned. indexPlanChoose then weighs the
+ * leaves' estimates: an AND may drop operands that cost more to intersect than to filter,
+ * and a plan expected to touch more than a scan would is dropped for the scan.
+ */
+typedef struct {
+    int num_leaves;
+    index_leaf *leaves;                  // Indexed conditions in clause order
+    double num_rows;                     // Table rows the estimates are out of (-1: no statistics)
+    struct index_plan_node *nodes;
+    struct index_plan_node *root;        // NULL: no index narrows the clause, scan the table
+} index_plan;
+
+// Key range [*key_start, *key_end] an index on a type attribute holds for `op value`.
+// Returns false when no single range answers it (!= on a number, unknown operators);
+// *empty is set when no key can match (e.g. > INT_MAX, or ordering on a bool).
+bool indexKeyRange(FieldType type, const char *op, const char *value, KEY_T *key_start, KEY_T *key_end, bool *empty);
+
+// Plans whereClause against the engine's indexes and counts each leaf's rows from its tree's
+// subtree counts (only when engine->index_stats is set, so the plan can be costed).
+void indexPlanBuild(index_plan *plan, const struct engineS *engine, const struct whereClauseS *whereClause);
+// Chooses the access path from the estimates (all leaves without statistics) and marks the
+// leaves it uses. The engine then scans each used, non-empty leaf's range into its rows
+// before asking for the candidates.
+void indexPlanChoose(index_plan *plan);
+
+// Rows of the combined set (caller frees), each listed once: leaf by leaf in clause order, in
+// each leaf's key order. segmentEnds (num_leaves entries, or NULL) receives the end of each
+// leaf's run in the result. The rows still have to be filtered by the full clause.
+record **indexPlanCandidates(const index_plan *plan, int *count, int segmentEnds[]);
+
+// Frees the plan and the leaves' rows.
+void indexPlanFree(index_plan *plan);
+
+#endif // INDEX_PLAN_H
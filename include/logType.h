@@ -8,18 +8,19 @@
 #include <string.h> // for strcmp in get_field_info
 
 // Record structure representing a command log entry
+// String fields point into the owning engine's string heap (see stringHeap.h), never NULL
 typedef struct record {
     unsigned long long command_id; // Unique key for the record
-    char raw_command[512]; // Full command string
-    char base_command[100]; // Base command without arguments
-    char shell_type[20]; // Type of shell (eg, bash, zsh)
+    const char *raw_command; // Full command string
+    const char *base_command; // Base command without arguments
+    const char *shell_type; // Type of shell (eg, bash, zsh)
     int exit_code; // Exit code of the command
-    char timestamp[30]; // Execution timestamp
+    const char *timestamp; // Execution timestamp
     bool sudo_used; // Whether the command was run with sudo
-    char working_directory[200]; // Directory where the command was executed
+    const char *working_directory; // Directory where the command was executed
     int user_id; // ID of the user who executed the command
-    char user_name[50]; // Name of the user who executed the command
-    char host_name[100]; // Hostname of the machine
+    const char *user_name; // Name of the user who executed the command
+    const char *host_name; // Hostname of the machine
     int risk_level; // Risk level associated with the command
 } record;
 
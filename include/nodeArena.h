@@ -0,0 +1,48 @@
+#ifndef NODE_ARENA_H
+#define NODE_ARENA_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+// Bytes per slab requested from the system (rounded down to whole nodes, at least one).
+#define NODE_ARENA_SLAB_BYTES (256 * 1024)
+
+/* Fixed-size block allocator for the nodes of one B+ tree.
+ * Blocks are carved in address order from large cache-line aligned slabs, so nodes
+ * built together (bulk load, a run of splits) sit next to each other in memory. Freed
+ * blocks go on a free list and are handed out again before the slab grows.
+ * Destroying the arena releases every slab at once, without visiting the blocks.
+ * An arena may also own one mapping of ready-made blocks (a loaded index file), unmapped
+ * with the slabs.
+ * A spinlock guards the arena, so concurrent writers of one tree may share it.
+ */
+typedef struct node_arena {
+    atomic_flag lock;
+    size_t block_bytes;   // Size of one block (multiple of the alignment)
+    size_t align;         // Alignment of every block
+    int blocks_per_slab;
+    void *slabs;          // Chain of slabs; the first block-sized piece of each holds the link
+    char *bump;           // Next unused block in the newest slab
+    int bump_left;        // Unused blocks left in the newest slab
+    void *free_list;      // Recycled blocks, linked through their first word
+    long num_slabs;
+    long live_blocks;     // Blocks currently handed out
+    void *mapping;        // Adopted mapping of blocks (NULL if none)
+    size_t mapping_bytes; // Length of mapping
+} node_arena;
+
+// Creates an arena of align-aligned blocks of block_bytes (a multiple of align).
+node_arena *nodeArenaCreate(size_t block_bytes, size_t align);
+// Returns one block (contents undefined).
+void *nodeArenaAlloc(node_arena *arena);
+// Gives a block back for reuse.
+void nodeArenaFree(node_arena *arena, void *block);
+// Takes over a writable mapping whose first num_blocks blocks are already in use; it is
+// unmapped by nodeArenaDestroy. An arena adopts at most one mapping.
+void nodeArenaAdoptMapping(node_arena *arena, void *mapping, size_t bytes, long num_blocks);
+// Heap bytes held by the arena (all slabs, used or not).
+size_t nodeArenaBytes(const node_arena *arena);
+// Frees every slab and the arena itself (outstanding blocks become invalid).
+void nodeArenaDestroy(node_arena *arena);
+
+#endif // NODE_ARENA_H
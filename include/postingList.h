@@ -0,0 +1,52 @@
+#ifndef POSTING_LIST_H
+#define POSTING_LIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Max rows held by one posting block (bounds the work of a single add / remove).
+#define POSTING_BLOCK_ROWS 128
+
+// Rows per block when building from a sorted run (leaves room for later adds).
+#define POSTING_BULK_ROWS 112
+
+/* Sorted set of row pointers shared by every row with the same index key.
+ * Rows are split into blocks of at most POSTING_BLOCK_ROWS. Each block keeps its
+ * first row verbatim and the remaining rows as LEB128 varint deltas, so rows that
+ * live close together in memory cost one or two bytes each.
+ */
+typedef struct {
+    uintptr_t first;     // Smallest row in the block
+    int count;           // Rows in the block (first included)
+    int num_bytes;       // Bytes of encoded deltas
+    unsigned char *data; // count - 1 varint deltas
+} posting_block;
+
+typedef struct posting_list {
+    int num_rows;          // Total rows across all blocks
+    int num_blocks;
+    int cap_blocks;
+    posting_block *blocks; // Ordered by first row
+} posting_list;
+
+// Creates an empty posting list.
+posting_list *postingCreate(void);
+// Builds a posting list from rows already sorted by address (duplicates skipped).
+posting_list *postingFromSorted(void *const rows[], int num_rows);
+// Adds a row. Returns false if the row was already present.
+bool postingAdd(posting_list *pl, void *row);
+// Removes a row in O(log n) block lookup plus one block rewrite. Returns false if absent.
+bool postingRemove(posting_list *pl, void *row);
+// Writes every row in address order to out (room for pl->num_rows); returns the count.
+int postingDecode(const posting_list *pl, void *out[]);
+// Writes the rows of one block (at most POSTING_BLOCK_ROWS) to out; returns the count.
+int postingDecodeBlock(const posting_list *pl, int block, void *out[]);
+// Returns any one row of the list (the smallest), or NULL when empty.
+void *postingFirst(const posting_list *pl);
+// Heap bytes owned by the list (directory + encoded blocks).
+size_t postingBytes(const posting_list *pl);
+// Frees the list and all blocks.
+void postingDestroy(posting_list *pl);
+
+#endif // POSTING_LIST_H
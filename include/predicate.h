@@ -0,0 +1,98 @@
+#ifndef PREDICATE_H
+#define PREDICATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "logType.h"
+
+struct whereClauseS;
+
+// Jump targets that end a program: the row matches / does not match.
+#define WHERE_ACCEPT (-1)
+#define WHERE_REJECT (-2)
+
+typedef enum { WHERE_EQ, WHERE_NEQ, WHERE_GT, WHERE_LT, WHERE_GTE, WHERE_LTE } where_op;
+
+// Field type an instruction compares; WHERE_FALSE is a condition with no valid comparison
+// (unknown attribute or operator, ordering on a bool), which matches nothing.
+typedef enum { WHERE_UINT64, WHERE_INT, WHERE_BOOL, WHERE_STRING, WHERE_FALSE } where_kind;
+
+/* One comparison of a record field with a constant that was converted at compile time.
+ * Evaluation then continues at on_true or on_false: an instruction index, or
+ * WHERE_ACCEPT / WHERE_REJECT.
+ */
+typedef struct {
+    uint8_t kind;      // where_kind
+    uint8_t op;        // where_op
+    uint16_t offset;   // Offset of the field in struct record
+    int32_t on_true;
+    int32_t on_false;
+    union {
+        unsigned long long u64;
+        int i32;
+        bool b;
+        const char *str;  // Points at the clause's value
+    } value;
+} where_instr;
+
+/* A WHERE clause compiled into a flat branch program. AND / OR chains and parenthesised
+ * sub-clauses become jumps between instructions (with the same short-circuit order as
+ * evaluateWhereClause), so evaluating a row looks up no attribute names, parses no
+ * constants and allocates nothing. Lives on the caller's stack; the clause must outlive it.
+ */
+typedef struct {
+    int num_instrs;       // 0: matches every row
+    where_instr *instrs;
+} where_program;
+
+// Compiles whereClause (NULL matches every row) into program.
+void whereCompile(where_program *program, const struct whereClauseS *whereClause);
+// Frees the instructions of a compiled program.
+void whereProgramFree(where_program *program);
+
+/* Compares field value a with constant b by op (three-way result c = sign(a - b)). */
+static inline bool whereCompare(int c, uint8_t op) {
+    switch (op) {
+    case WHERE_EQ: return c == 0;
+    case WHERE_NEQ: return c != 0;
+    case WHERE_GT: return c > 0;
+    case WHERE_LT: return c < 0;
+    case WHERE_GTE: return c >= 0;
+    default: return c <= 0;
+    }
+}
+
+/* Evaluates one instruction's comparison on r. */
+static inline bool whereTest(const where_instr *instr, const record *r) {
+    const char *field = (const char *)r + instr->offset;
+    switch (instr->kind) {
+    case WHERE_UINT64: {
+        unsigned long long v = *(const unsigned long long *)field;
+        return whereCompare((v > instr->value.u64) - (v < instr->value.u64), instr->op);
+    }
+    case WHERE_INT: {
+        int v = *(const int *)field;
+        return whereCompare((v > instr->value.i32) - (v < instr->value.i32), instr->op);
+    }
+    case WHERE_BOOL:
+        return (*(const bool *)field == instr->value.b) == (instr->op == WHERE_EQ);
+    case WHERE_STRING:
+        return whereCompare(strcmp(*(const char *const *)field, instr->value.str), instr->op);
+    default:
+        return false;
+    }
+}
+
+/* True when r satisfies the compiled clause. */
+static inline bool whereMatches(const where_program *program, const record *r) {
+    if (program->num_instrs == 0) return true;
+    int pc = 0;
+    while (pc >= 0) {
+        const where_instr *instr = &program->instrs[pc];
+        pc = whereTest(instr, r) ? instr->on_true : instr->on_false;
+    }
+    return pc == WHERE_ACCEPT;
+}
+
+#endif // PREDICATE_H
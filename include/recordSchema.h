@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include "logType.h"  // Record structs
 #include "bplus.h"  // KEY_T
+#include "stringHeap.h"  // Record string storage
 
 // Metadata about each field in the record struct
 typedef enum {
@@ -23,8 +24,16 @@ typedef struct {
 
 // Helper that provides the offset and type of the given attribute
 const FieldInfo *get_field_info(const char *name);
+// Helper that lists every record field in struct order (*count receives the number of fields)
+const FieldInfo *get_record_fields(size_t *count);
+// Helper that points every string field of rec at a copy in strings (e.g. an INSERT's values)
+void copy_record_strings(record *rec, string_heap *strings);
+// Helper that points every NULL string field of rec at "" (fields missing from a CSV line)
+void fill_missing_record_strings(record *rec);
 // Helper that extracts the key value from a record given the attribute name
 KEY_T extract_key_from_record(const record *rec, const char *attr_name);
+// Helper that maps a field type to the B+ tree key type used to index it
+KeyType key_type_for_field(FieldType type);
 // Helper for comparing two KEY_T values
 int compare_key(KEY_T key1, KEY_T key2);
 
@@ -0,0 +1,54 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "indexFile.h"
+#include "logType.h"
+
+// Snapshots live next to the data file: <datafile>.snap
+#define SNAPSHOT_SUFFIX ".snap"
+
+// Set to "0" to ignore snapshots and always parse the CSV.
+#define SNAPSHOT_ENV "QPE_SNAPSHOT"
+
+#define SNAPSHOT_MAGIC "QPESNAP1"
+#define SNAPSHOT_VERSION 2
+
+// Page size the record section is aligned to.
+#define SNAPSHOT_PAGE 4096
+
+/* On-disk header (first page of the file). The record section that follows at
+ * records_offset (page aligned) is the loaded records as an array of struct record in
+ * native layout, in data file order, with each string field holding the offset of its
+ * value in the string section (NUL-terminated values, right after the records). Loading
+ * turns the offsets back into pointers inside the mapping, so a mapped snapshot is used
+ * in place. It is a cache of one data file for one build: record_size and the data file
+ * identity must match or the CSV is parsed instead.
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;     // sizeof(record) of the writer
+    data_file_identity data;  // Data file identity when the snapshot was written
+    uint64_t num_records;     // Records in the record section
+    uint64_t records_offset;  // Start of the record section
+    uint64_t strings_offset;  // Start of the string section
+    uint64_t strings_bytes;   // Length of the string section
+} snapshot_header;
+
+// Snapshot path for datafile (caller frees).
+char *snapshotPath(const char *datafile);
+// Writes records to datafile's snapshot. Returns false if nothing was written.
+bool snapshotSave(const char *datafile, record **records, int num_records);
+// Maps datafile's snapshot and returns the record pointer array into it (caller frees the
+// array, and releases the mapping with snapshotUnmap). NULL when the snapshot is missing,
+// disabled, or no longer matches the data file (the caller parses the CSV).
+record **snapshotLoad(const char *datafile, int *num_records, void **map_out, size_t *map_bytes_out);
+// True when row lives in the mapping (so it must not be passed to free).
+bool snapshotContains(const void *map, size_t map_bytes, const void *row);
+// Releases a mapping returned by snapshotLoad (NULL is ignored).
+void snapshotUnmap(void *map, size_t map_bytes);
+
+#endif // SNAPSHOT_H
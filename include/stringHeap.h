@@ -0,0 +1,42 @@
+#ifndef STRING_HEAP_H
+#define STRING_HEAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Bytes per chunk requested from the system (a longer string gets a chunk of its own).
+#define STRING_HEAP_CHUNK_BYTES (1024 * 1024)
+
+/* One block of string bytes: allocated by the heap, or a caller's buffer or file mapping
+ * the heap took over (a loaded file whose fields were unquoted in place).
+ */
+typedef struct string_chunk {
+    struct string_chunk *next;
+    char *data;
+    size_t used;
+    size_t capacity;
+    bool mapped;  // data is an mmap'd region (released with munmap, not free)
+} string_chunk;
+
+/* Append-only storage for the variable-length string fields of records.
+ * Strings are copied in NUL-terminated and never move or get freed one by one, so a
+ * record keeps a plain pointer to each of its strings for as long as the heap lives.
+ * Destroying the heap releases every chunk at once. Not thread-safe: one writer at a time.
+ */
+typedef struct string_heap {
+    string_chunk *chunks;  // Newest first; strings are appended to the first one
+    size_t bytes;          // Bytes held by all chunks
+} string_heap;
+
+// Creates an empty heap.
+string_heap *stringHeapCreate(void);
+// Copies value[0..length) into the heap, NUL-terminated, and returns the copy.
+const char *stringHeapAdd(string_heap *heap, const char *value, size_t length);
+// Takes ownership of buffer (malloc'd, bytes long); strings in it live as long as the heap.
+void stringHeapAdopt(string_heap *heap, char *buffer, size_t bytes);
+// Takes ownership of a private file mapping (bytes long, as passed to mmap).
+void stringHeapAdoptMapping(string_heap *heap, void *map, size_t bytes);
+// Frees every chunk and the heap itself (NULL is ignored).
+void stringHeapDestroy(string_heap *heap);
+
+#endif // STRING_HEAP_H
@@ -13,8 +13,8 @@ static inline KEY_T make_key_u64(uint64_t val) {
 
 // Test building and looking up in a small serial B+ tree
 int main() {
-    // Defining the tree root
-    node *root = NULL;
+    // Defining the tree (default order for the key type)
+    bptree *tree = bptreeCreate(KEY_UINT64, 0);
 
     // Create some dummy row pointers (just casting ints for demo)
     ROW_PTR row1 = (ROW_PTR)(intptr_t)33;
@@ -24,24 +24,25 @@ int main() {
     ROW_PTR row5 = (ROW_PTR)(intptr_t)10;
 
     // Inserting keys and row pointers
-    root = insert(root, make_key_u64(5), row1);
-    root = insert(root, make_key_u64(15), row2);
-    root = insert(root, make_key_u64(25), row3);
-    root = insert(root, make_key_u64(35), row4);
-    root = insert(root, make_key_u64(45), row5);
+    insert(tree, make_key_u64(5), row1);
+    insert(tree, make_key_u64(15), row2);
+    insert(tree, make_key_u64(25), row3);
+    insert(tree, make_key_u64(35), row4);
+    insert(tree, make_key_u64(45), row5);
 
     // Printing the tree structure
-    printTree(root);
+    printTree(tree);
 
     // Testing lookups
     printf("\n--- Single key lookup: key 15 ---\n");
-    findAndPrint(root, make_key_u64(15));
+    findAndPrint(tree, make_key_u64(15));
     
     printf("\n--- Range query: keys 10-30 (should find 15, 25) ---\n");
-    findAndPrintRange(root, make_key_u64(10), make_key_u64(30), false);
+    findAndPrintRange(tree, make_key_u64(10), make_key_u64(30), false);
     
     printf("\n--- Range query: keys 5-45 (should find all) ---\n");
-    findAndPrintRange(root, make_key_u64(5), make_key_u64(45), false);
+    findAndPrintRange(tree, make_key_u64(5), make_key_u64(45), false);
 
+    destroy_tree(tree);
     return 0;
 }
\ No newline at end of file
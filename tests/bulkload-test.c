@@ -0,0 +1,92 @@
+#include "../include/bplus.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_ROWS 1000
+#define NUM_DISTINCT 37
+
+int main() {
+    printf("Testing B+ Tree Bulk Loading...\n");
+
+    // Fake row storage: the tree only stores addresses, so ints are enough
+    static int rows[NUM_ROWS];
+    bplus_entry *entries = malloc(NUM_ROWS * sizeof(bplus_entry));
+    assert(entries != NULL);
+
+    // Unsorted keys with plenty of duplicates
+    int expected[NUM_DISTINCT] = {0};
+    for (int i = 0; i < NUM_ROWS; i++) {
+        int k = (i * 7919) % NUM_DISTINCT;
+        rows[i] = k;
+        entries[i].key.type = KEY_INT;
+        entries[i].key.v.i32 = k;
+        entries[i].row_ptr = &rows[i];
+        expected[k]++;
+    }
+
+    // Small order so the tree has several levels
+    bptree *tree = bptreeCreate(KEY_INT, 4);
+    bulkLoad(tree, entries, NUM_ROWS, BULK_FILL_FACTOR);
+    free(entries);
+    assert(tree->root != NULL);
+    assert(height(tree) > 1);
+
+    // Every key must be found with all of its duplicates
+    KEY_T key;
+    key.type = KEY_INT;
+    for (int k = 0; k < NUM_DISTINCT; k++) {
+        key.v.i32 = k;
+        ROW_PTR *results = NULL;
+        int count = find_rows(tree, key, &results);
+        assert(count == expected[k]);
+        for (int i = 0; i < count; i++) {
+            assert(*(int *)results[i] == k);
+        }
+        free(results);
+    }
+    printf("  Point lookups OK\n");
+
+    // A range over the whole key space returns every row in key order
+    KEY_T lo = { .type = KEY_INT, .v.i32 = 0 };
+    KEY_T hi = { .type = KEY_INT, .v.i32 = NUM_DISTINCT };
+    KEY_T *keys = malloc(NUM_ROWS * sizeof(KEY_T));
+    ROW_PTR *ptrs = malloc(NUM_ROWS * sizeof(ROW_PTR));
+    int total = findRange(tree, lo, hi, false, keys, ptrs);
+    assert(total == NUM_ROWS);
+    for (int i = 1; i < total; i++) {
+        assert(keys[i - 1].v.i32 <= keys[i].v.i32);
+    }
+    printf("  Range scan OK (%d rows)\n", total);
+
+    // The bulk loaded tree must keep working with incremental updates
+    static int extra = NUM_DISTINCT;
+    key.v.i32 = NUM_DISTINCT;
+    insert(tree, key, &extra);
+    ROW_PTR *results = NULL;
+    assert(find_rows(tree, key, &results) == 1);
+    free(results);
+
+    key.v.i32 = 5;
+    for (int i = 0; i < NUM_ROWS; i++) {
+        if (rows[i] == 5) {
+            delete(tree, key, &rows[i]);
+        }
+    }
+    results = NULL;
+    assert(find_rows(tree, key, &results) == 0);
+    free(results);
+    total = findRange(tree, lo, hi, false, keys, ptrs);
+    assert(total == NUM_ROWS - expected[5] + 1);
+    printf("  Insert/delete after bulk load OK\n");
+
+    // Empty input yields an empty tree
+    bulkLoad(tree, NULL, 0, BULK_FILL_FACTOR);
+    assert(tree->root == NULL);
+
+    free(keys);
+    free(ptrs);
+    destroy_tree(tree);
+    printf("Bulk Load Test Passed!\n");
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include "../include/bplus.h"
+#include "../include/columnStats.h"
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_ROWS 6000
+#define KEY_SPACE 900
+
+static int rows[NUM_ROWS];
+static int key_of[NUM_ROWS];  // Key each row is stored under, or -1 when absent
+
+static KEY_T intKey(int k) {
+    KEY_T key = { .type = KEY_INT };
+    key.v.i32 = k;
+    return key;
+}
+
+static int bruteCount(int lo, int hi) {
+    int total = 0;
+    for (int i = 0; i < NUM_ROWS; i++)
+        if (key_of[i] >= lo && key_of[i] <= hi) total++;
+    return total;
+}
+
+static int bruteDistinct(void) {
+    static char seen[KEY_SPACE * 2];
+    int distinct = 0;
+    for (int k = 0; k < KEY_SPACE * 2; k++) seen[k] = 0;
+    for (int i = 0; i < NUM_ROWS; i++)
+        if (key_of[i] >= 0 && !seen[key_of[i]]) {
+            seen[key_of[i]] = 1;
+            distinct++;
+        }
+    return distinct;
+}
+
+/* checkShape: Histogram invariants against the rows actually stored. */
+static void checkShape(const column_stats *stats) {
+    int total = 0, distinct = 0;
+    assert(stats->num_buckets >= 1 && stats->num_buckets <= STATS_MAX_BUCKETS);
+    for (int b = 0; b < stats->num_buckets; b++) {
+        assert(b == 0 || stats->buckets[b - 1].upper.v.i32 < stats->buckets[b].upper.v.i32);
+        assert(stats->buckets[b].distinct >= 1);
+        total += stats->buckets[b].rows;
+        distinct += stats->buckets[b].distinct;
+    }
+    assert(total == stats->num_rows && total == bruteCount(0, KEY_SPACE * 2));
+    assert(distinct == stats->distinct);
+    assert(stats->max.v.i32 == stats->buckets[stats->num_buckets - 1].upper.v.i32);
+}
+
+/* checkEstimates: Ranges estimate within a bucket's rows of the truth, as built. */
+static void checkEstimates(const column_stats *stats, double tolerance) {
+    for (int lo = -10; lo < KEY_SPACE + 10; lo += 29) {
+        for (int width = 0; width < KEY_SPACE; width += 113) {
+            double estimate = columnStatsEstimate(stats, intKey(lo), intKey(lo + width));
+            int actual = bruteCount(lo, lo + width);
+            assert(fabs(estimate - actual) <= tolerance);
+        }
+    }
+}
+
+int main() {
+    printf("Testing column statistics...\n");
+
+    // Skewed keys: low keys hold many more rows than high ones
+    bptree *tree = bptreeCreate(KEY_INT, 0);
+    for (int i = 0; i < NUM_ROWS; i++) {
+        int k = (int)((long long)(i * 7919 % NUM_ROWS) * (i % KEY_SPACE) / NUM_ROWS);
+        key_of[i] = k;
+        insert(tree, intKey(k), &rows[i]);
+    }
+
+    // The key cursor reports each distinct key once with its row count
+    bplus_cursor cursor;
+    KEY_T key;
+    int count, keys = 0, total = 0;
+    bptreeCursorOpenAll(&cursor, tree);
+    while (bptreeCursorNextKey(&cursor, &key, &count)) {
+        assert(count == bruteCount(key.v.i32, key.v.i32));
+        keys++;
+        total += count;
+    }
+    bptreeCursorClose(&cursor);
+    assert(keys == bruteDistinct() && total == NUM_ROWS);
+
+    column_stats stats;
+    columnStatsBuild(&stats, tree);
+    assert(stats.num_rows == NUM_ROWS && stats.distinct == keys);
+    assert(stats.min.v.i32 == 0 && stats.changes == 0);
+    checkShape(&stats);
+    int depth = (NUM_ROWS + STATS_MAX_BUCKETS - 1) / STATS_MAX_BUCKETS;
+    for (int b = 0; b + 1 < stats.num_buckets; b++)
+        assert(stats.buckets[b].rows >= depth);
+    checkEstimates(&stats, 2.0 * depth);
+    assert(columnStatsEstimate(&stats, intKey(KEY_SPACE + 1), intKey(KEY_SPACE * 2)) == 0.0);
+    assert(columnStatsEstimate(&stats, intKey(-5), intKey(KEY_SPACE * 2)) > NUM_ROWS - 1);
+    printf("  Build OK (%d keys, %d buckets)\n", keys, stats.num_buckets);
+
+    // Deletes and inserts (some past the largest key) are counted in place until a rebuild is due
+    int changes = 0;
+    for (int i = 0; i < NUM_ROWS && !columnStatsRefresh(&stats, tree); i += 7) {
+        if (i % 2 == 0) {
+            delete(tree, intKey(key_of[i]), &rows[i]);
+            columnStatsRemove(&stats, intKey(key_of[i]));
+            key_of[i] = -1;
+        } else {
+            delete(tree, intKey(key_of[i]), &rows[i]);
+            columnStatsRemove(&stats, intKey(key_of[i]));
+            key_of[i] = KEY_SPACE + i % 50;
+            insert(tree, intKey(key_of[i]), &rows[i]);
+            columnStatsAdd(&stats, intKey(key_of[i]));
+            assert(stats.max.v.i32 >= key_of[i]);
+        }
+        changes++;
+        if (stats.changes > 0) checkShape(&stats);
+    }
+    assert(changes > 0 && stats.changes == 0 && stats.built_rows == stats.num_rows);
+    checkShape(&stats);
+    assert(stats.distinct == bruteDistinct());
+    printf("  Maintenance OK (rebuilt after %d changes)\n", changes);
+
+    // Few distinct keys get one bucket each, so equalities and ranges are exact
+    bptree *flags = bptreeCreate(KEY_BOOL, 0);
+    bptree *levels = bptreeCreate(KEY_INT, 0);
+    for (int i = 0; i < NUM_ROWS; i++) {
+        KEY_T flag = { .type = KEY_BOOL };
+        flag.v.b = i % 10 == 0;
+        insert(flags, flag, &rows[i]);
+        insert(levels, intKey(i % 6 == 5 ? 5 : i % 3), &rows[i]);
+    }
+    column_stats flag_stats, level_stats;
+    columnStatsBuild(&flag_stats, flags);
+    columnStatsBuild(&level_stats, levels);
+    KEY_T no = { .type = KEY_BOOL }, yes = { .type = KEY_BOOL };
+    no.v.b = false;
+    yes.v.b = true;
+    assert(flag_stats.num_buckets == 2 && flag_stats.distinct == 2);
+    assert(columnStatsEstimate(&flag_stats, yes, yes) == NUM_ROWS / 10);
+    assert(columnStatsEstimate(&flag_stats, no, no) == NUM_ROWS - NUM_ROWS / 10);
+    assert(level_stats.num_buckets == 4);
+    assert(columnStatsEstimate(&level_stats, intKey(5), intKey(5)) == NUM_ROWS / 6);
+    assert(columnStatsEstimate(&level_stats, intKey(3), intKey(4)) == 0.0);
+    assert(columnStatsEstimate(&level_stats, intKey(1), intKey(INT_MAX)) == NUM_ROWS - NUM_ROWS / 3);
+    printf("  Low-cardinality keys OK\n");
+
+    // Empty and missing trees estimate nothing; the first insert starts a histogram
+    column_stats empty;
+    columnStatsBuild(&empty, NULL);
+    assert(empty.num_rows == 0 && columnStatsEstimate(&empty, intKey(0), intKey(10)) == 0.0);
+    bptree *fresh = bptreeCreate(KEY_INT, 0);
+    columnStatsBuild(&empty, fresh);
+    assert(empty.key_type == KEY_INT && empty.num_buckets == 0);
+    insert(fresh, intKey(42), &rows[0]);
+    columnStatsAdd(&empty, intKey(42));
+    assert(empty.num_buckets == 1 && columnStatsEstimate(&empty, intKey(42), intKey(42)) == 1.0);
+    assert(columnStatsRefresh(&empty, fresh) && empty.num_rows == 1);
+
+    destroy_tree(fresh);
+    destroy_tree(levels);
+    destroy_tree(flags);
+    destroy_tree(tree);
+    printf("Column Stats Test Passed!\n");
+    return 0;
+}
@@ -0,0 +1,249 @@
+#include "../include/executeEngine-serial.h"
+#include "../include/columnStore.h"
+#include <assert.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_RECORDS 5000
+
+static const char *users[] = { "alice", "bob", "carol", "dave" };
+static const char *hosts[] = { "labpc-01", "labpc-02", "labpc-03" };
+static string_heap *strings;
+
+// Formats a record string into the test's string heap.
+static const char *text(const char *format, ...) {
+    char buffer[1024];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    return stringHeapAdd(strings, buffer, (size_t)length);
+}
+
+// Checks the column scan against evaluateWhereClause on every row.
+static int checkScan(column_store *store, record **records, int num_records, struct whereClauseS *wc) {
+    int num_matches = 0;
+    int *rows = columnStoreSelect(store, wc, &num_matches);
+    int expected = 0;
+    for (int i = 0; i < num_records; i++) {
+        if (evaluateWhereClause(records[i], wc)) {
+            assert(expected < num_matches && rows[expected] == i);
+            expected++;
+        }
+    }
+    assert(expected == num_matches);
+    free(rows);
+    return num_matches;
+}
+
+static struct whereClauseS condition(const char *attribute, const char *op, const char *value) {
+    struct whereClauseS wc = { attribute, op, value, 0, NULL, NULL, NULL };
+    return wc;
+}
+
+static unsigned int seed = 2024;
+static int next_random(int bound) {
+    seed = seed * 1103515245u + 12345u;
+    return (int)((seed >> 16) % (unsigned int)bound);
+}
+
+// Random chain of conditions (some parenthesised) out of nodes[], with selectivities from
+// a handful of rows (sparse words) to nearly all of them (decided blocks).
+static struct whereClauseS *randomChain(struct whereClauseS nodes[], int *used, int max_nodes, int depth) {
+    static const char *ops[] = { "=", "!=", ">", "<", ">=", "<=" };
+    static const char *links[] = { "AND", "OR", NULL };
+    static const char *probes[][2] = {
+        { "command_id", "2500" }, { "command_id", "4990" }, { "command_id", "40" }, { "exit_code", "2" },
+        { "risk_level", "3" }, { "user_id", "1150" }, { "user_id", "1003" }, { "sudo_used", "true" },
+        { "user_name", "bob" }, { "host_name", "labpc-02" }, { "base_command", "cmd7" },
+        { "timestamp", "2026-01-15T00:00:00Z" }, { "raw_command", "cmd 5 --flag" }
+    };
+    int length = 1 + next_random(4);
+    struct whereClauseS *first = NULL, *prev = NULL;
+    for (int i = 0; i < length && *used < max_nodes; i++) {
+        struct whereClauseS *node = &nodes[(*used)++];
+        if (depth < 2 && next_random(4) == 0 && *used < max_nodes) {
+            *node = condition(NULL, NULL, NULL);
+            node->sub = randomChain(nodes, used, max_nodes, depth + 1);
+        } else {
+            int p = next_random((int)(sizeof(probes) / sizeof(probes[0])));
+            *node = condition(probes[p][0], ops[next_random(6)], probes[p][1]);
+        }
+        if (prev != NULL) {
+            prev->next = node;
+            prev->logical_op = links[next_random(3)];
+        } else {
+            first = node;
+        }
+        prev = node;
+    }
+    return first;
+}
+
+int main() {
+    printf("Testing column store...\n");
+    strings = stringHeapCreate();
+
+    record *block = calloc(NUM_RECORDS + 2, sizeof(record));
+    record **records = malloc((NUM_RECORDS + 2) * sizeof(record *));
+    assert(block != NULL && records != NULL);
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        record *r = &block[i];
+        r->command_id = i;
+        r->raw_command = text("cmd %d --flag", i % 97);
+        r->base_command = text("cmd%d", i % 13);
+        r->shell_type = i % 2 ? "bash" : "zsh";
+        r->exit_code = i % 4;
+        r->timestamp = text("2026-01-%02dT00:00:00Z", 1 + i % 28);
+        r->sudo_used = i % 5 == 0;
+        r->working_directory = text("/home/u%d", i % 50);
+        r->user_id = 1000 + i % 300;
+        r->user_name = users[i % 4];
+        r->host_name = hosts[i % 3];
+        r->risk_level = i % 6;
+        records[i] = r;
+    }
+    // Strings are kept whole, however long
+    block[7].working_directory = text("/home/%0400d", 7);
+
+    column_store *store = columnStoreBuild(records, NUM_RECORDS);
+    assert(store->num_rows == NUM_RECORDS);
+    const column *dir = columnStoreColumn(store, "working_directory");
+    assert(strcmp(columnStoreString(dir, 7), block[7].working_directory) == 0);
+    assert(columnStoreColumn(store, "no_such_column") == NULL);
+
+    // Low-cardinality strings are dictionary-encoded with codes in sorted value order
+    const column *user = columnStoreColumn(store, "user_name");
+    assert(user->codes != NULL && user->dict_size == 4);
+    for (int code = 1; code < user->dict_size; code++)
+        assert(strcmp(user->heap + user->offsets[code - 1], user->heap + user->offsets[code]) < 0);
+    for (int i = 0; i < NUM_RECORDS; i++)
+        assert(strcmp(columnStoreString(user, i), records[i]->user_name) == 0);
+    assert(columnStoreColumn(store, "timestamp")->dict_size == 28);
+
+    // Every attribute / operator pair on its own
+    const char *ops[] = { "=", "!=", ">", "<", ">=", "<=", "LIKE" };
+    const char *probes[][2] = {
+        { "command_id", "2500" }, { "exit_code", "2" }, { "risk_level", "3" }, { "user_id", "1150" },
+        { "sudo_used", "true" }, { "sudo_used", "0" }, { "user_name", "bob" }, { "host_name", "labpc-02" },
+        { "raw_command", "cmd 5 --flag" }, { "base_command", "cmd7" }, { "shell_type", "zsh" },
+        { "timestamp", "2026-01-15T00:00:00Z" }, { "working_directory", "/home/u7" }, { "no_such_column", "1" },
+        // Values missing from the dictionary: between, before and after its entries
+        { "host_name", "labpc-025" }, { "user_name", "a" }, { "user_name", "zed" }, { "shell_type", "" }
+    };
+    for (size_t p = 0; p < sizeof(probes) / sizeof(probes[0]); p++) {
+        for (size_t o = 0; o < sizeof(ops) / sizeof(ops[0]); o++) {
+            struct whereClauseS wc = condition(probes[p][0], ops[o], probes[p][1]);
+            checkScan(store, records, NUM_RECORDS, &wc);
+        }
+    }
+    assert(checkScan(store, records, NUM_RECORDS, NULL) == NUM_RECORDS);
+    printf("  Single conditions OK\n");
+
+    // Chains combine right to left like evaluateWhereClause: a AND b OR c == a AND (b OR c)
+    struct whereClauseS a = condition("risk_level", ">=", "4");
+    struct whereClauseS b = condition("user_name", "=", "alice");
+    struct whereClauseS c = condition("sudo_used", "=", "true");
+    a.next = &b; a.logical_op = "AND";
+    b.next = &c; b.logical_op = "OR";
+    int chained = checkScan(store, records, NUM_RECORDS, &a);
+    assert(chained > 0);
+
+    // Parenthesised sub-clause: (exit_code = 1 OR exit_code = 3) AND host_name != "labpc-03"
+    struct whereClauseS e1 = condition("exit_code", "=", "1");
+    struct whereClauseS e3 = condition("exit_code", "=", "3");
+    e1.next = &e3; e1.logical_op = "OR";
+    struct whereClauseS group = { NULL, NULL, NULL, 0, NULL, NULL, &e1 };
+    struct whereClauseS host = condition("host_name", "!=", "labpc-03");
+    group.next = &host; group.logical_op = "AND";
+    assert(checkScan(store, records, NUM_RECORDS, &group) > 0);
+    printf("  Chains and sub-clauses OK (%d rows)\n", chained);
+
+    // Random nestings: blocks decided early, sparse and dense words, the partial last block
+    for (int k = 0; k < 400; k++) {
+        struct whereClauseS nodes[12];
+        int used = 0;
+        checkScan(store, records, NUM_RECORDS, randomChain(nodes, &used, 12, 0));
+    }
+    printf("  Random clauses OK\n");
+
+    // Appended rows take the next row id and are scanned like the rest
+    block[NUM_RECORDS] = block[0];
+    block[NUM_RECORDS].command_id = NUM_RECORDS;
+    block[NUM_RECORDS].risk_level = 99;
+    records[NUM_RECORDS] = &block[NUM_RECORDS];
+    columnStoreAppend(store, records[NUM_RECORDS]);
+    struct whereClauseS high = condition("risk_level", "=", "99");
+    int num_matches = 0;
+    int *rows = columnStoreSelect(store, &high, &num_matches);
+    assert(num_matches == 1 && rows[0] == NUM_RECORDS);
+    free(rows);
+    checkScan(store, records, NUM_RECORDS + 1, &a);
+
+    // A new value lands mid-dictionary and later codes shift up
+    block[NUM_RECORDS + 1] = block[1];
+    block[NUM_RECORDS + 1].user_name = "bobby";
+    records[NUM_RECORDS + 1] = &block[NUM_RECORDS + 1];
+    columnStoreAppend(store, records[NUM_RECORDS + 1]);
+    assert(user->codes != NULL && user->dict_size == 5);
+    for (int i = 0; i < NUM_RECORDS + 2; i++)
+        assert(strcmp(columnStoreString(user, i), records[i]->user_name) == 0);
+    for (size_t o = 0; o < sizeof(ops) / sizeof(ops[0]); o++) {
+        struct whereClauseS wc = condition("user_name", ops[o], "bob");
+        checkScan(store, records, NUM_RECORDS + 2, &wc);
+        wc.value = "bobby";
+        checkScan(store, records, NUM_RECORDS + 2, &wc);
+    }
+    printf("  Append OK\n");
+
+    // Filtering an arbitrary row range writes one flag per row
+    uint8_t mask[300];
+    columnStoreFilter(store, &high, NUM_RECORDS - 299, NUM_RECORDS + 1, mask);
+    for (int i = 0; i < 300; i++) {
+        assert(mask[i] == (i == 299));
+    }
+
+    columnStoreDestroy(store);
+    free(records);
+    free(block);
+
+    // A column with more distinct values than codes stays plain; a full dictionary is
+    // decoded when one more value arrives. The sampled rows repeat so encoding starts.
+    int num_distinct = COLUMN_DICT_SAMPLE - 16 + COLUMN_DICT_MAX_CODES + 1;
+    block = calloc(num_distinct, sizeof(record));
+    records = malloc(num_distinct * sizeof(record *));
+    assert(block != NULL && records != NULL);
+    for (int i = 0; i < num_distinct; i++) {
+        int value = i < COLUMN_DICT_SAMPLE ? i % 16 : i - COLUMN_DICT_SAMPLE + 16;
+        block[i].raw_command = text("cmd %d", value);
+        block[i].shell_type = "bash";
+        block[i].timestamp = text("t%d", i);
+        fill_missing_record_strings(&block[i]);
+        records[i] = &block[i];
+    }
+    store = columnStoreBuild(records, num_distinct);
+    assert(columnStoreColumn(store, "raw_command")->codes == NULL);
+    assert(columnStoreColumn(store, "shell_type")->dict_size == 1);
+    assert(columnStoreColumn(store, "timestamp")->codes == NULL);  // Distinct from the start
+    columnStoreDestroy(store);
+
+    store = columnStoreBuild(records, num_distinct - 1);
+    const column *raw = columnStoreColumn(store, "raw_command");
+    assert(raw->codes != NULL && raw->dict_size == COLUMN_DICT_MAX_CODES);
+    columnStoreAppend(store, records[num_distinct - 1]);
+    assert(raw->codes == NULL);
+    for (int i = 0; i < num_distinct; i += 997)
+        assert(strcmp(columnStoreString(raw, i), records[i]->raw_command) == 0);
+    struct whereClauseS last = condition("raw_command", ">=", records[num_distinct - 1]->raw_command);
+    assert(checkScan(store, records, num_distinct, &last) > 0);
+    columnStoreDestroy(store);
+    free(records);
+    free(block);
+    printf("  Dictionary overflow OK\n");
+    stringHeapDestroy(strings);
+
+    printf("Column Store Test Passed!\n");
+    return 0;
+}
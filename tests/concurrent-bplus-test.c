@@ -0,0 +1,133 @@
+#include "../include/bplus.h"
+#include <assert.h>
+#include <omp.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_ROWS 40000
+#define NUM_SHARED 500     // Rows below this index share a handful of keys (posting lists)
+#define NUM_WRITERS 6
+#define NUM_READERS 2
+
+static int rows[NUM_ROWS];
+
+static KEY_T keyOf(int i) {
+    KEY_T key = { .type = KEY_INT, .v.i32 = i < NUM_SHARED ? i % 7 : i };
+    return key;
+}
+
+/* checkCounts: Verifies every internal count against its child; returns the rows under n. */
+static int checkCounts(const node *n) {
+    int total = 0;
+    if (n->is_leaf) {
+        for (int i = 0; i < n->num_keys; i++) {
+            void *slot = n->pointers[i];
+            total += ((uintptr_t)slot & 1) ? ((posting_list *)((uintptr_t)slot & ~(uintptr_t)1))->num_rows : 1;
+        }
+        return total;
+    }
+    for (int i = 0; i <= n->num_keys; i++) {
+        int child = checkCounts(n->pointers[i]);
+        assert(n->counts[i] == child);
+        total += child;
+    }
+    return total;
+}
+
+/* scanWhileWriting: Reader loop; every scan must come out in key order with rows matching keys. */
+static long scanWhileWriting(bptree *tree, atomic_int *writers_left, int seed) {
+    long scans = 0;
+    unsigned int state = (unsigned int)seed;
+    bplus_cursor cursor;
+    KEY_T key;
+    ROW_PTR row;
+
+    while (atomic_load(writers_left) > 0) {
+        state = state * 1103515245u + 12345u;
+        int lo = (int)((state >> 8) % NUM_ROWS);
+        KEY_T from = { .type = KEY_INT, .v.i32 = lo };
+        KEY_T to = { .type = KEY_INT, .v.i32 = lo + 2000 };
+        int last = -1;
+        bptreeCursorOpen(&cursor, tree, from, to);
+        while (bptreeCursorNext(&cursor, &key, &row)) {
+            assert(key.v.i32 >= last && key.v.i32 >= lo && key.v.i32 <= lo + 2000);
+            assert(keyOf((int)(((int *)row) - rows)).v.i32 == key.v.i32);
+            last = key.v.i32;
+        }
+        bptreeCursorClose(&cursor);
+
+        ROW_PTR *found = NULL;
+        int n = find_rows(tree, keyOf(lo), &found);
+        for (int i = 0; i < n; i++)
+            assert(keyOf((int)(((int *)found[i]) - rows)).v.i32 == keyOf(lo).v.i32);
+        free(found);
+
+        int counted = countRange(tree, from, to);
+        assert(counted >= 0 && counted <= NUM_ROWS);
+        scans++;
+    }
+    return scans;
+}
+
+/* runPhase: Writers apply op to their share of rows [first, NUM_ROWS) with the given stride while readers scan. */
+static long runPhase(bptree *tree, bool inserting, int first, int stride) {
+    atomic_int writers_left = NUM_WRITERS;
+    long scans = 0;
+
+    #pragma omp parallel num_threads(NUM_WRITERS + NUM_READERS) reduction(+:scans)
+    {
+        int t = omp_get_thread_num();
+        if (t < NUM_WRITERS) {
+            for (int i = first + t * stride; i < NUM_ROWS; i += NUM_WRITERS * stride) {
+                if (inserting) insert(tree, keyOf(i), &rows[i]);
+                else delete(tree, keyOf(i), &rows[i]);
+            }
+            atomic_fetch_sub(&writers_left, 1);
+        } else {
+            scans += scanWhileWriting(tree, &writers_left, t);
+        }
+    }
+    return scans;
+}
+
+static void runOrder(int order) {
+    bptree *tree = bptreeCreate(KEY_INT, order);
+
+    // Concurrent inserts build the same tree contents as a serial load
+    long scans = runPhase(tree, true, 0, 1);
+    assert(countRows(tree) == NUM_ROWS);
+    assert(checkCounts(tree->root) == NUM_ROWS);
+    for (int i = 0; i < NUM_ROWS; i += 97) {
+        ROW_PTR *found = NULL;
+        int n = find_rows(tree, keyOf(i), &found);
+        bool present = false;
+        for (int j = 0; j < n; j++) present |= found[j] == &rows[i];
+        assert(present);
+        free(found);
+    }
+
+    // Delete every other row: merges and redistributions race with scans
+    scans += runPhase(tree, false, 0, 2);
+    assert(countRows(tree) == NUM_ROWS / 2);
+    assert(checkCounts(tree->root) == NUM_ROWS / 2);
+    KEY_T lo = { .type = KEY_INT, .v.i32 = NUM_SHARED };
+    KEY_T hi = { .type = KEY_INT, .v.i32 = NUM_ROWS };
+    assert(countRange(tree, lo, hi) == (NUM_ROWS - NUM_SHARED) / 2);
+
+    // Delete the rest; the tree empties out completely
+    scans += runPhase(tree, false, 1, 2);
+    assert(tree->root == NULL && countRows(tree) == 0);
+    destroy_tree(tree);
+    printf("  Order %d OK (%ld concurrent scans)\n", order, scans);
+}
+
+int main() {
+    printf("Testing concurrent B+ Tree access...\n");
+    for (int i = 0; i < NUM_ROWS; i++) rows[i] = i;
+    runOrder(3);
+    runOrder(4);
+    runOrder(0);
+    printf("Concurrent B+ Tree Test Passed!\n");
+    return 0;
+}
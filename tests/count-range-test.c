@@ -0,0 +1,122 @@
+#include "../include/bplus.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_ROWS 3000
+#define KEY_SPACE 700
+
+static int rows[NUM_ROWS];
+static int key_of[NUM_ROWS];   // Key each row is stored under, or -1 when absent
+
+/* checkCounts: Verifies every internal count against its child; returns the rows under n. */
+static int checkCounts(const node *n) {
+    int total = 0;
+    if (n->is_leaf) {
+        for (int i = 0; i < n->num_keys; i++) {
+            void *slot = n->pointers[i];
+            total += ((uintptr_t)slot & 1) ? ((posting_list *)((uintptr_t)slot & ~(uintptr_t)1))->num_rows : 1;
+        }
+        return total;
+    }
+    for (int i = 0; i <= n->num_keys; i++) {
+        int child = checkCounts(n->pointers[i]);
+        assert(n->counts[i] == child);
+        total += child;
+    }
+    return total;
+}
+
+/* bruteCount: Rows currently stored with lo <= key <= hi. */
+static int bruteCount(int lo, int hi) {
+    int total = 0;
+    for (int i = 0; i < NUM_ROWS; i++)
+        if (key_of[i] >= 0 && key_of[i] >= lo && key_of[i] <= hi) total++;
+    return total;
+}
+
+static void checkRanges(bptree *tree) {
+    if (tree->root != NULL) checkCounts(tree->root);
+    for (int lo = -5; lo < KEY_SPACE + 5; lo += 37) {
+        for (int width = 0; width < KEY_SPACE; width += 113) {
+            KEY_T a = { .type = KEY_INT, .v.i32 = lo };
+            KEY_T b = { .type = KEY_INT, .v.i32 = lo + width };
+            assert(countRange(tree, a, b) == bruteCount(lo, lo + width));
+        }
+    }
+}
+
+static void runOrder(int order) {
+    bptree *tree = bptreeCreate(KEY_INT, order);
+    srand(42 + order);
+
+    // Inserts: new keys split leaves, repeated keys grow posting lists
+    for (int i = 0; i < NUM_ROWS; i++) {
+        key_of[i] = rand() % KEY_SPACE;
+        KEY_T key = { .type = KEY_INT, .v.i32 = key_of[i] };
+        insert(tree, key, &rows[i]);
+    }
+    insert(tree, (KEY_T){ .type = KEY_INT, .v.i32 = key_of[0] }, &rows[0]);  // Already present
+    assert(countRows(tree) == NUM_ROWS);
+    checkRanges(tree);
+
+    // Deletes in a scattered order: posting removals, then merges and redistributions
+    for (int step = 0; step < NUM_ROWS; step++) {
+        int i = (int)(((long)step * 1777) % NUM_ROWS);
+        KEY_T key = { .type = KEY_INT, .v.i32 = key_of[i] };
+        delete(tree, key, &rows[i]);
+        key_of[i] = -1;
+        if (step % 500 == 0) checkRanges(tree);
+        if (step == NUM_ROWS / 2) {
+            // Refill half the rows under fresh keys while the tree is half empty
+            for (int j = 0; j < NUM_ROWS; j += 3) {
+                if (key_of[j] >= 0) continue;
+                key_of[j] = rand() % KEY_SPACE;
+                insert(tree, (KEY_T){ .type = KEY_INT, .v.i32 = key_of[j] }, &rows[j]);
+            }
+            checkRanges(tree);
+        }
+    }
+    for (int i = 0; i < NUM_ROWS; i++) {
+        if (key_of[i] < 0) continue;
+        delete(tree, (KEY_T){ .type = KEY_INT, .v.i32 = key_of[i] }, &rows[i]);
+        key_of[i] = -1;
+    }
+    assert(tree->root == NULL && countRows(tree) == 0);
+    destroy_tree(tree);
+}
+
+int main() {
+    printf("Testing B+ Tree subtree counts...\n");
+    runOrder(3);
+    runOrder(4);
+    runOrder(7);
+    runOrder(0);
+    printf("  Insert / delete OK\n");
+
+    // Bulk loaded trees carry the same counts
+    bplus_entry *entries = malloc(NUM_ROWS * sizeof(bplus_entry));
+    assert(entries != NULL);
+    for (int i = 0; i < NUM_ROWS; i++) {
+        key_of[i] = (i * 7) % KEY_SPACE;
+        entries[i].key = (KEY_T){ .type = KEY_INT, .v.i32 = key_of[i] };
+        entries[i].row_ptr = &rows[i];
+    }
+    bptree *tree = bptreeCreate(KEY_INT, 5);
+    bulkLoad(tree, entries, NUM_ROWS, 0.7);
+    assert(countRows(tree) == NUM_ROWS);
+    checkRanges(tree);
+
+    // Inverted ranges and mistyped keys count nothing
+    KEY_T hi = { .type = KEY_INT, .v.i32 = 600 };
+    KEY_T lo = { .type = KEY_INT, .v.i32 = 10 };
+    KEY_T wrong = { .type = KEY_UINT64, .v.u64 = 10 };
+    assert(countRange(tree, hi, lo) == 0);
+    assert(countRange(tree, wrong, hi) == 0);
+    destroy_tree(tree);
+    free(entries);
+    printf("  Bulk load OK\n");
+
+    printf("Count Range Test Passed!\n");
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include "../include/csvParse.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_FIELDS 16
+
+/* The byte-at-a-time field parser the loaders used before csvSplitLine (the reference) */
+static char *referenceField(char **cursor) {
+    char *start = *cursor;
+    if (*start == '\0' || *start == '\n' || *start == '\r') return NULL;
+    char *field = start;
+    int i = 0;
+    int in_quotes = 0;
+    if (*start == '"') {
+        in_quotes = 1;
+        start++;
+    }
+    while (*start != '\0' && *start != '\n' && *start != '\r') {
+        if (in_quotes) {
+            if (*start == '"') {
+                if (*(start + 1) == '"') {
+                    field[i++] = '"';
+                    start += 2;
+                } else {
+                    in_quotes = 0;
+                    start++;
+                }
+            } else {
+                field[i++] = *start++;
+            }
+        } else {
+            if (*start == ',') {
+                start++;
+                break;
+            }
+            field[i++] = *start++;
+        }
+    }
+    field[i] = '\0';
+    *cursor = start;
+    return field;
+}
+
+/* Splits text with both parsers and checks they agree */
+static void checkAgainstReference(const char *text) {
+    size_t length = strlen(text);
+    char *ours = malloc(length + 1), *theirs = malloc(length + 1);
+    memcpy(ours, text, length + 1);
+    memcpy(theirs, text, length + 1);
+
+    const char *fields[MAX_FIELDS];
+    size_t lengths[MAX_FIELDS];
+    int count = csvSplitLine(ours, length, fields, lengths, MAX_FIELDS);
+
+    char *cursor = theirs;
+    int expected = 0;
+    char *field;
+    while (expected < MAX_FIELDS && (field = referenceField(&cursor)) != NULL) {
+        assert(expected < count);
+        assert(strcmp(fields[expected], field) == 0);
+        assert(lengths[expected] == strlen(field));
+        expected++;
+    }
+    assert(count == expected);
+    for (int i = count; i < MAX_FIELDS; i++) {
+        assert(fields[i][0] == '\0' && lengths[i] == 0);
+    }
+    free(ours);
+    free(theirs);
+}
+
+static void testSplitting(void) {
+    printf("  Splitting fields...\n");
+    checkAgainstReference("1,ls -la,ls,bash,0,2023-01-01,0,/home/user,1001,user1,host1,1");
+    checkAgainstReference("2,\"echo \"\"a,b\"\"\",echo,zsh,1,2023-01-02,true,/root,0,root,host2,5");
+    checkAgainstReference("a,,b,");
+    checkAgainstReference("\"unterminated, quote");
+    checkAgainstReference("mid\"quote,\"closed\"tail,x");
+    checkAgainstReference("crlf,line\r\n");
+    checkAgainstReference("");
+    checkAgainstReference(",");
+
+    // Fields and quoted runs spanning several 64-byte blocks
+    char long_line[600];
+    snprintf(long_line, sizeof(long_line),
+             "%s,\"%s,\"\"%s\"\"\",%s",
+             "0123456789012345678901234567890123456789012345678901234567890123456789",
+             "a quoted field that is long enough to cross a block boundary, with commas",
+             "and escaped quotes that also run past the sixty-four byte mark of the block",
+             "tail");
+    checkAgainstReference(long_line);
+
+    // Pseudo-random lines over the interesting bytes
+    const char alphabet[] = "ab,\"\",x\"yz,,\"q";
+    unsigned seed = 12345;
+    for (int n = 0; n < 5000; n++) {
+        char text[200];
+        int len = (int)(seed % 190);
+        for (int i = 0; i < len; i++) {
+            seed = seed * 1103515245u + 12345u;
+            text[i] = alphabet[(seed >> 16) % (sizeof(alphabet) - 1)];
+        }
+        text[len] = '\0';
+        seed = seed * 1103515245u + 12345u;
+        checkAgainstReference(text);
+    }
+    printf("  Splitting fields OK\n");
+}
+
+static void testRecord(void) {
+    printf("  Parsing records...\n");
+    char line[] = "42,\"echo \"\"hi\"\"\",echo,bash,-3,2023-01-01,TRUE,/tmp,1001,user1,host1,4\n";
+    record rec;
+    csvParseRecord(&rec, line, strlen(line) - 1);
+    assert(rec.command_id == 42 && rec.exit_code == -3 && rec.sudo_used);
+    assert(rec.user_id == 1001 && rec.risk_level == 4);
+    assert(strcmp(rec.raw_command, "echo \"hi\"") == 0 && strcmp(rec.host_name, "host1") == 0);
+
+    // Missing trailing fields are empty / zero
+    char short_line[] = "7,ls";
+    csvParseRecord(&rec, short_line, strlen(short_line));
+    assert(rec.command_id == 7 && strcmp(rec.raw_command, "ls") == 0);
+    assert(strcmp(rec.base_command, "") == 0 && strcmp(rec.host_name, "") == 0);
+    assert(rec.exit_code == 0 && !rec.sudo_used && rec.risk_level == 0);
+    printf("  Parsing records OK\n");
+}
+
+static void testNumbers(void) {
+    printf("  Parsing numbers...\n");
+    const char *values[] = {"0", "7", "123456789", "1234567890", "2147483647", "-2147483648",
+                            "-15", "+15", " 15", "15x", "", "abc", "-", "18446744073709551615",
+                            "18446744073709551616", "99999999999999999999999"};
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        assert(csvParseUint64(values[i]) == strtoull(values[i], NULL, 10));
+        if (strlen(values[i]) <= 11) {  // atoi is undefined past the int range
+            assert(csvParseInt(values[i]) == atoi(values[i]));
+        }
+    }
+    assert(csvParseBool("true") && csvParseBool("True") && csvParseBool("1"));
+    assert(!csvParseBool("false") && !csvParseBool("0") && !csvParseBool(""));
+    printf("  Parsing numbers OK\n");
+}
+
+int main() {
+    printf("Testing CSV parsing...\n");
+    testSplitting();
+    testRecord();
+    testNumbers();
+    printf("CSV Parse Test Passed!\n");
+    return 0;
+}
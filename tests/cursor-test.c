@@ -0,0 +1,122 @@
+#include "../include/bplus.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_ROWS 5000
+#define NUM_DISTINCT 50
+
+int main() {
+    printf("Testing B+ Tree cursors...\n");
+    static int rows[NUM_ROWS];
+    int expected[NUM_DISTINCT] = {0};
+
+    // Mix of shared keys (posting lists) and a unique tail so both slot kinds are scanned
+    bptree *tree = bptreeCreate(KEY_INT, 5);
+    for (int i = 0; i < NUM_ROWS; i++) {
+        rows[i] = (i < NUM_ROWS - NUM_DISTINCT) ? (i * 31) % (NUM_DISTINCT - 10) : NUM_DISTINCT - 10 + (i % 10);
+        KEY_T key = { .type = KEY_INT, .v.i32 = rows[i] };
+        insert(tree, key, &rows[i]);
+        expected[rows[i]]++;
+    }
+
+    // Row by row: keys come out in order and every row matches its key
+    KEY_T lo = { .type = KEY_INT, .v.i32 = 5 };
+    KEY_T hi = { .type = KEY_INT, .v.i32 = 44 };
+    int want = 0;
+    for (int k = 5; k <= 44; k++) want += expected[k];
+
+    bplus_cursor cursor;
+    KEY_T key;
+    ROW_PTR row;
+    int seen = 0, last = -1;
+    bptreeCursorOpen(&cursor, tree, lo, hi);
+    while (bptreeCursorNext(&cursor, &key, &row)) {
+        assert(key.v.i32 >= last);
+        assert(*(int *)row == key.v.i32);
+        last = key.v.i32;
+        seen++;
+    }
+    bptreeCursorClose(&cursor);
+    assert(seen == want);
+    printf("  Next OK (%d rows)\n", seen);
+
+    // Batches smaller than a posting block return the same rows
+    ROW_PTR batch[7];
+    int n, total = 0;
+    bptreeCursorOpen(&cursor, tree, lo, hi);
+    while ((n = bptreeCursorNextBatch(&cursor, batch, 7)) > 0) {
+        for (int i = 0; i < n; i++) {
+            int v = *(int *)batch[i];
+            assert(v >= 5 && v <= 44);
+        }
+        total += n;
+    }
+    assert(total == want);
+    assert(bptreeCursorNextBatch(&cursor, batch, 7) == 0);
+    bptreeCursorClose(&cursor);
+    printf("  NextBatch OK\n");
+
+    // Early stop (LIMIT-style) leaves nothing to clean up beyond close
+    bptreeCursorOpen(&cursor, tree, lo, hi);
+    assert(bptreeCursorNextBatch(&cursor, batch, 3) == 3);
+    bptreeCursorClose(&cursor);
+    assert(!bptreeCursorNext(&cursor, NULL, &row));
+
+    // Empty and inverted ranges
+    KEY_T none = { .type = KEY_INT, .v.i32 = 1000 };
+    bptreeCursorOpen(&cursor, tree, none, none);
+    assert(!bptreeCursorNext(&cursor, NULL, &row));
+    bptreeCursorOpen(&cursor, tree, hi, lo);
+    assert(!bptreeCursorNext(&cursor, NULL, &row));
+
+    // findRange is built on the cursor and must agree with it
+    KEY_T *keys = malloc(NUM_ROWS * sizeof(KEY_T));
+    ROW_PTR *ptrs = malloc(NUM_ROWS * sizeof(ROW_PTR));
+    assert(findRange(tree, lo, hi, false, keys, ptrs) == want);
+    free(keys);
+    free(ptrs);
+
+    destroy_tree(tree);
+
+    // Range splitting: the sub-ranges tile [lo, hi] exactly, in key order
+    tree = bptreeCreate(KEY_INT, 4);
+    for (int i = 0; i < NUM_ROWS; i++) {
+        rows[i] = i;
+        KEY_T k = { .type = KEY_INT, .v.i32 = i };
+        insert(tree, k, &rows[i]);
+    }
+    KEY_T from = { .type = KEY_INT, .v.i32 = 100 };
+    KEY_T to = { .type = KEY_INT, .v.i32 = 4321 };
+    KEY_T cuts[8];
+    int num_cuts = bptreeSplitRange(tree, from, to, 8, cuts);
+    assert(num_cuts == 7);
+    int next = 100;
+    for (int p = 0; p <= num_cuts; p++) {
+        KEY_T start = p == 0 ? from : cuts[p - 1];
+        if (p == num_cuts) {
+            bptreeCursorOpen(&cursor, tree, start, to);
+        } else {
+            assert(start.v.i32 < cuts[p].v.i32);
+            bptreeCursorOpenBefore(&cursor, tree, start, cuts[p]);
+        }
+        int part_rows = 0;
+        while (bptreeCursorNext(&cursor, NULL, &row)) {
+            assert(*(int *)row == next);
+            next++;
+            part_rows++;
+        }
+        assert(part_rows > 0);
+    }
+    assert(next == 4322);
+
+    // Too few separators in range: no split
+    KEY_T near = { .type = KEY_INT, .v.i32 = 101 };
+    assert(bptreeSplitRange(tree, from, near, 8, cuts) <= 1);
+    assert(bptreeSplitRange(tree, to, from, 8, cuts) == 0);
+    destroy_tree(tree);
+    printf("  Range split OK\n");
+
+    printf("Cursor Test Passed!\n");
+    return 0;
+}
@@ -65,6 +65,7 @@ void test_delete_persistence() {
     
     // Cleanup
     remove(temp_file);
+    remove("temp_delete_test.csv.command_id.idx");
 }
 
 void test_delete_index_runtime() {
@@ -107,6 +108,7 @@ void test_delete_index_runtime() {
 
     destroyEngineSerial(engine);
     remove(temp_file);
+    remove("temp_delete_index_test.csv.command_id.idx");
 }
 
 int main() {
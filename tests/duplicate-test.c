@@ -56,6 +56,7 @@ int main() {
 
     destroyEngineSerial(engine);
     remove(temp_file);
+    remove("temp_dup_test.csv.risk_level.idx");
     printf("Duplicate Test Passed!\n");
     return 0;
 }
@@ -14,16 +14,16 @@ void test_evaluateWhereClause() {
     r.command_id = 100;
     r.risk_level = 5;
     r.user_id = 10;
-    strcpy(r.user_name, "admin");
+    r.user_name = "admin";
     r.sudo_used = true;
     // Initialize other fields to avoid undefined behavior if accessed (though test won't access them)
     r.exit_code = 0;
-    strcpy(r.raw_command, "ls -la");
-    strcpy(r.base_command, "ls");
-    strcpy(r.shell_type, "bash");
-    strcpy(r.timestamp, "2023-01-01");
-    strcpy(r.working_directory, "/home/admin");
-    strcpy(r.host_name, "localhost");
+    r.raw_command = "ls -la";
+    r.base_command = "ls";
+    r.shell_type = "bash";
+    r.timestamp = "2023-01-01";
+    r.working_directory = "/home/admin";
+    r.host_name = "localhost";
 
 
     // Test 1: Simple condition (risk_level > 3)
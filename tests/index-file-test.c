@@ -0,0 +1,196 @@
+#include "../include/indexFile.h"
+#include "../include/nodeArena.h"
+#include "../include/recordSchema.h"
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_RECORDS 5000
+#define DATA_FILE "temp_index_file_test.csv"
+
+// Scans the whole tree and checks it returns exactly records[] in risk_level order.
+static void checkTree(bptree *tree, record **records) {
+    assert(tree != NULL);
+    assert(countRows(tree) == NUM_RECORDS);
+    bplus_cursor cursor;
+    KEY_T key;
+    ROW_PTR row;
+    int seen = 0, last = -1;
+    bptreeCursorOpenAll(&cursor, tree);
+    while (bptreeCursorNext(&cursor, &key, &row)) {
+        const record *r = row;
+        assert(key.v.i32 == r->risk_level && key.v.i32 >= last);
+        assert(r >= records[0] && r <= records[NUM_RECORDS - 1]);
+        last = key.v.i32;
+        seen++;
+    }
+    bptreeCursorClose(&cursor);
+    assert(seen == NUM_RECORDS);
+}
+
+/* Byte offsets of a node's keys and counts inside its block, laid out as in bplus.c:
+ * header, order - 1 keys and order pointers (each pointer aligned), then order counts.
+ */
+static long keysOffset(void) {
+    return (long)((sizeof(node) + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *));
+}
+
+static long countsOffset(const index_file_header *h, size_t key_size) {
+    size_t key_bytes = (h->order - 1) * key_size;
+    return keysOffset() + (long)((key_bytes + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *)) +
+           (long)(h->order * sizeof(void *));
+}
+
+// Writes len bytes at offset of the file, keeping what was there in saved.
+static void patchFile(const char *path, long offset, const void *bytes, void *saved, size_t len) {
+    FILE *file = fopen(path, "r+b");
+    assert(file != NULL);
+    assert(fseek(file, offset, SEEK_SET) == 0 && fread(saved, 1, len, file) == len);
+    assert(fseek(file, offset, SEEK_SET) == 0 && fwrite(bytes, 1, len, file) == len);
+    fclose(file);
+}
+
+// Damages the command_id index with bytes at offset, checks it is turned down, then repairs it.
+static void checkDamageRejected(const char *path, long offset, const void *bytes, size_t len, record **records) {
+    unsigned char saved[64], ignored[64];
+    assert(len <= sizeof(saved));
+    patchFile(path, offset, bytes, saved, len);
+    assert(indexFileLoad(DATA_FILE, "command_id", records, NUM_RECORDS) == NULL);
+    patchFile(path, offset, saved, ignored, len);
+    bptree *tree = indexFileLoad(DATA_FILE, "command_id", records, NUM_RECORDS);
+    assert(tree != NULL);
+    destroy_tree(tree);
+}
+
+int main() {
+    printf("Testing index files...\n");
+
+    // Only the identity of the data file matters to the index, not its contents
+    FILE *file = fopen(DATA_FILE, "w");
+    assert(file != NULL);
+    fprintf(file, "command_id,risk_level\n");
+    for (int i = 0; i < NUM_RECORDS; i++)
+        fprintf(file, "%d,%d\n", i, (i * 7) % 6);
+    fclose(file);
+
+    record *block = calloc(NUM_RECORDS, sizeof(record));
+    record **records = malloc(NUM_RECORDS * sizeof(record *));
+    bplus_entry *entries = malloc(NUM_RECORDS * sizeof(bplus_entry));
+    assert(block != NULL && records != NULL && entries != NULL);
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        records[i] = &block[i];
+        block[i].command_id = i;
+        block[i].risk_level = (i * 7) % 6;
+        entries[i].key = extract_key_from_record(records[i], "risk_level");
+        entries[i].row_ptr = records[i];
+    }
+    bptree *built = bptreeCreate(KEY_INT, 0);
+    bulkLoad(built, entries, NUM_RECORDS, BULK_FILL_FACTOR);
+    free(entries);
+
+    // Save, then rebuild from the file
+    char *path = indexFilePath(DATA_FILE, "risk_level");
+    assert(strcmp(path, DATA_FILE ".risk_level" INDEX_FILE_SUFFIX) == 0);
+    assert(indexFileSave(DATA_FILE, "risk_level", built, records, NUM_RECORDS));
+    bptree *loaded = indexFileLoad(DATA_FILE, "risk_level", records, NUM_RECORDS);
+    checkTree(loaded, records);
+    bplus_stats built_stats, loaded_stats;
+    bptreeGetStats(built, &built_stats);
+    bptreeGetStats(loaded, &loaded_stats);
+    assert(loaded_stats.nodes == built_stats.nodes && loaded->arena->live_blocks == loaded_stats.nodes);
+
+    // The mapped nodes are ordinary nodes: they split, merge and go back to the arena
+    record extra = { .command_id = NUM_RECORDS, .risk_level = 9 };
+    insert(loaded, extract_key_from_record(&extra, "risk_level"), &extra);
+    for (int i = 0; i < NUM_RECORDS; i += 2)
+        delete(loaded, extract_key_from_record(records[i], "risk_level"), records[i]);
+    assert(countRows(loaded) == NUM_RECORDS / 2 + 1);
+    destroy_tree(loaded);
+    printf("  Save / load OK\n");
+
+    // Mismatches are stale caches: wrong attribute or record count
+    assert(indexFileLoad(DATA_FILE, "exit_code", records, NUM_RECORDS) == NULL);
+    assert(indexFileLoad(DATA_FILE, "risk_level", records, NUM_RECORDS - 1) == NULL);
+
+    // Unique keys need several levels, so damage can be planted between nodes
+    entries = malloc(NUM_RECORDS * sizeof(bplus_entry));
+    assert(entries != NULL);
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        entries[i].key = extract_key_from_record(records[i], "command_id");
+        entries[i].row_ptr = records[i];
+    }
+    bptree *unique = bptreeCreate(KEY_UINT64, 0);
+    bulkLoad(unique, entries, NUM_RECORDS, BULK_FILL_FACTOR);
+    free(entries);
+    char *unique_path = indexFilePath(DATA_FILE, "command_id");
+    assert(indexFileSave(DATA_FILE, "command_id", unique, records, NUM_RECORDS));
+    loaded = indexFileLoad(DATA_FILE, "command_id", records, NUM_RECORDS);
+    assert(loaded != NULL && height(loaded) == height(unique));
+    for (int i = 0; i < NUM_RECORDS; i += 97) {
+        ROW_PTR *rows = NULL;
+        assert(find_rows(loaded, extract_key_from_record(records[i], "command_id"), &rows) == 1);
+        assert(rows[0] == records[i]);
+        free(rows);
+    }
+    destroy_tree(loaded);
+
+    // Node 1 is the root and nodes 2 and 3 are its first two leaves (keys 0, 1, 2, ...)
+    index_file_header h;
+    FILE *index = fopen(unique_path, "rb");
+    assert(index != NULL && fread(&h, sizeof(h), 1, index) == 1 && h.num_nodes > 2 && height(unique) == 1);
+    fclose(index);
+    long root = (long)h.nodes_offset;
+    long leaf = root + (long)h.node_bytes;
+    long next_leaf = leaf + (long)h.node_bytes;
+
+    // A broken link: the first leaf names itself as its parent
+    node *parent = (node *)(uintptr_t)2;
+    checkDamageRejected(unique_path, leaf + (long)offsetof(node, parent), &parent, sizeof(parent), records);
+
+    // Keys out of order inside a leaf
+    uint64_t swapped[2] = { 1, 0 };
+    checkDamageRejected(unique_path, leaf + keysOffset(), swapped, sizeof(swapped), records);
+
+    // Keys in order inside the leaf, but below the root separator in front of it
+    uint64_t low_key;
+    index = fopen(unique_path, "rb");
+    assert(index != NULL && fseek(index, next_leaf + keysOffset(), SEEK_SET) == 0 &&
+           fread(&low_key, sizeof(low_key), 1, index) == 1);
+    fclose(index);
+    low_key--;
+    checkDamageRejected(unique_path, next_leaf + keysOffset(), &low_key, sizeof(low_key), records);
+
+    // Root counts that still sum to every row but disagree with the leaves
+    int counts[2];
+    index = fopen(unique_path, "rb");
+    assert(index != NULL && fseek(index, root + countsOffset(&h, sizeof(uint64_t)), SEEK_SET) == 0 &&
+           fread(counts, sizeof(int), 2, index) == 2);
+    fclose(index);
+    counts[0]++;
+    counts[1]--;
+    checkDamageRejected(unique_path, root + countsOffset(&h, sizeof(uint64_t)), counts, sizeof(counts), records);
+    printf("  Damaged nodes rejected OK\n");
+    destroy_tree(unique);
+    remove(unique_path);
+    free(unique_path);
+
+    // A changed data file invalidates the index
+    file = fopen(DATA_FILE, "a");
+    assert(file != NULL);
+    fprintf(file, "%d,0\n", NUM_RECORDS);
+    fclose(file);
+    assert(indexFileLoad(DATA_FILE, "risk_level", records, NUM_RECORDS) == NULL);
+    printf("  Stale index rejected OK\n");
+
+    destroy_tree(built);
+    remove(path);
+    remove(DATA_FILE);
+    free(path);
+    free(records);
+    free(block);
+
+    printf("Index File Test Passed!\n");
+    return 0;
+}
@@ -0,0 +1,233 @@
+#include "../include/executeEngine-serial.h"
+#include "../include/indexPlan.h"
+#include "../include/predicate.h"
+#include <assert.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_RECORDS 800
+#define NUM_RANDOM_CLAUSES 2000
+#define MAX_NODES 12
+#define NUM_INDEXES 4
+
+static const char *users[] = { "alice", "bob", "carol", "dave" };
+static char *indexNames[NUM_INDEXES] = { "command_id", "exit_code", "risk_level", "sudo_used" };
+static FieldType indexTypes[NUM_INDEXES] = { FIELD_UINT64, FIELD_INT, FIELD_INT, FIELD_BOOL };
+static const KeyType keyTypes[NUM_INDEXES] = { KEY_UINT64, KEY_INT, KEY_INT, KEY_BOOL };
+
+// Plans wc, scans the used leaves as the engines do, and returns the candidate rows.
+// Returns NULL (and *count = -1) when the plan falls back to a table scan.
+static record **planCandidates(struct engineS *engine, struct whereClauseS *wc, int *count) {
+    index_plan plan;
+    indexPlanBuild(&plan, engine, wc);
+    indexPlanChoose(&plan);
+    if (plan.root == NULL) {
+        indexPlanFree(&plan);
+        *count = -1;
+        return NULL;
+    }
+    for (int l = 0; l < plan.num_leaves; l++) {
+        index_leaf *leaf = &plan.leaves[l];
+        if (!leaf->used || leaf->empty) continue;
+        leaf->capacity = NUM_RECORDS;
+        leaf->rows = malloc(NUM_RECORDS * sizeof(record *));
+        assert(leaf->rows != NULL);
+        bplus_cursor cursor;
+        KEY_T key;
+        ROW_PTR row;
+        bptreeCursorOpen(&cursor, engine->bplus_tree_roots[leaf->index], leaf->key_start, leaf->key_end);
+        while (bptreeCursorNext(&cursor, &key, &row))
+            leaf->rows[leaf->count++] = (record *)row;
+        bptreeCursorClose(&cursor);
+        assert(engine->index_stats == NULL || leaf->estimate == leaf->count);  // Counted, not guessed
+    }
+    int segmentEnds[MAX_NODES + 1];
+    record **candidates = indexPlanCandidates(&plan, count, segmentEnds);
+    for (int l = 0; l < plan.num_leaves; l++)
+        assert(segmentEnds[l] <= *count && (l == 0 || segmentEnds[l - 1] <= segmentEnds[l]));
+    assert(plan.num_leaves == 0 || segmentEnds[plan.num_leaves - 1] == *count);
+    indexPlanFree(&plan);
+    return candidates;
+}
+
+// Checks that the candidates list each row once and that filtering them finds every match.
+// Returns the number of candidates, or -1 for a table scan.
+static int checkClause(struct engineS *engine, record *block, struct whereClauseS *wc) {
+    int count;
+    record **candidates = planCandidates(engine, wc, &count);
+    if (candidates == NULL) return -1;
+
+    char *seen = calloc(NUM_RECORDS, 1);
+    int filtered = 0, expected = 0;
+    for (int k = 0; k < count; k++) {
+        long i = candidates[k] - block;
+        assert(i >= 0 && i < NUM_RECORDS && !seen[i]);
+        seen[i] = 1;
+        filtered += evaluateWhereClause(candidates[k], wc);
+    }
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        bool match = evaluateWhereClause(&block[i], wc);
+        assert(!match || seen[i]);
+        expected += match;
+    }
+    assert(filtered == expected);
+    free(seen);
+    free(candidates);
+    return count;
+}
+
+static struct whereClauseS condition(const char *attribute, const char *op, const char *value) {
+    struct whereClauseS wc = { attribute, op, value, 0, NULL, NULL, NULL };
+    return wc;
+}
+
+static unsigned int seed = 4242;
+static int next_random(int bound) {
+    seed = seed * 1103515245u + 12345u;
+    return (int)((seed >> 16) % (unsigned int)bound);
+}
+
+static const char *ops[] = { "=", "!=", ">", "<", ">=", "<=" };
+static const char *probes[][2] = {
+    { "command_id", "300" }, { "command_id", "0" }, { "exit_code", "2" }, { "risk_level", "3" },
+    { "risk_level", "5" }, { "sudo_used", "true" }, { "sudo_used", "FALSE" }, { "user_name", "bob" }
+};
+#define NUM_PROBES ((int)(sizeof(probes) / sizeof(probes[0])))
+
+// Builds a random chain of conditions and parenthesised sub-chains out of nodes[].
+static struct whereClauseS *randomChain(struct whereClauseS nodes[], int *used, int depth) {
+    static const char *links[] = { "AND", "OR", "AND" };
+    int length = 1 + next_random(4);
+    struct whereClauseS *first = NULL, *prev = NULL;
+    for (int i = 0; i < length && *used < MAX_NODES; i++) {
+        struct whereClauseS *node = &nodes[(*used)++];
+        if (depth < 2 && next_random(4) == 0 && *used < MAX_NODES) {
+            *node = condition(NULL, NULL, NULL);
+            node->sub = randomChain(nodes, used, depth + 1);
+        } else {
+            int p = next_random(NUM_PROBES);
+            *node = condition(probes[p][0], ops[next_random(6)], probes[p][1]);
+        }
+        if (prev != NULL) {
+            prev->next = node;
+            prev->logical_op = links[next_random(3)];
+        } else {
+            first = node;
+        }
+        prev = node;
+    }
+    return first;
+}
+
+int main() {
+    printf("Testing index plans...\n");
+
+    record *block = calloc(NUM_RECORDS, sizeof(record));
+    assert(block != NULL);
+    bptree *trees[NUM_INDEXES];
+    for (int j = 0; j < NUM_INDEXES; j++)
+        trees[j] = bptreeCreate(keyTypes[j], bptreeDefaultOrder(keyTypes[j]));
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        record *r = &block[i];
+        fill_missing_record_strings(r);
+        r->command_id = i;
+        r->exit_code = i % 4;
+        r->risk_level = i % 6;
+        r->sudo_used = i % 5 == 0;
+        r->user_name = users[i % 4];
+        for (int j = 0; j < NUM_INDEXES; j++)
+            insert(trees[j], extract_key_from_record(r, indexNames[j]), (ROW_PTR)r);
+    }
+
+    struct engineS engine;
+    memset(&engine, 0, sizeof(engine));
+    engine.bplus_tree_roots = trees;
+    engine.num_indexes = NUM_INDEXES;
+    engine.indexed_attributes = indexNames;
+    engine.attribute_types = indexTypes;
+
+    // Key ranges: ordering on a bool and > the largest key select nothing; != is not a range
+    KEY_T start, end;
+    bool empty;
+    assert(indexKeyRange(FIELD_INT, ">=", "4", &start, &end, &empty) && !empty);
+    assert(start.v.i32 == 4 && end.v.i32 == INT_MAX);
+    assert(indexKeyRange(FIELD_UINT64, "<", "0", &start, &end, &empty) && empty);
+    assert(indexKeyRange(FIELD_BOOL, "!=", "true", &start, &end, &empty) && !empty && !start.v.b);
+    assert(indexKeyRange(FIELD_BOOL, ">", "true", &start, &end, &empty) && empty);
+    assert(!indexKeyRange(FIELD_INT, "!=", "4", &start, &end, &empty));
+    assert(!indexKeyRange(FIELD_STRING, "=", "bob", &start, &end, &empty));
+
+    // AND of two indexed conditions: exactly the intersection, each row once
+    struct whereClauseS a = condition("exit_code", "=", "2");
+    struct whereClauseS b = condition("risk_level", ">=", "4");
+    a.next = &b; a.logical_op = "AND";
+    int both = 0;
+    for (int i = 0; i < NUM_RECORDS; i++)
+        both += block[i].exit_code == 2 && block[i].risk_level >= 4;
+    assert(checkClause(&engine, block, &a) == both && both > 0);
+
+    // OR of two indexed conditions: exactly the union
+    a.logical_op = "OR";
+    int either = 0;
+    for (int i = 0; i < NUM_RECORDS; i++)
+        either += block[i].exit_code == 2 || block[i].risk_level >= 4;
+    assert(checkClause(&engine, block, &a) == either);
+
+    // AND with an unindexed operand narrows by the indexed one; OR with one falls back to a scan
+    struct whereClauseS name = condition("user_name", "=", "bob");
+    struct whereClauseS sudo = condition("sudo_used", "=", "true");
+    name.next = &sudo; name.logical_op = "AND";
+    assert(checkClause(&engine, block, &name) == NUM_RECORDS / 5);
+    name.logical_op = "OR";
+    assert(checkClause(&engine, block, &name) == -1);
+
+    // Indexed OR inside parentheses, ANDed with a bool that no key can satisfy
+    struct whereClauseS r5 = condition("risk_level", "=", "5");
+    struct whereClauseS c9 = condition("command_id", "<", "9");
+    r5.next = &c9; r5.logical_op = "OR";
+    struct whereClauseS group = { NULL, NULL, NULL, 0, NULL, NULL, &r5 };
+    struct whereClauseS ordered = condition("sudo_used", ">", "0");
+    group.next = &ordered; group.logical_op = "AND";
+    assert(checkClause(&engine, block, &group) == 0);
+    printf("  AND / OR row sets OK (%d, %d rows)\n", both, either);
+
+    // Random nestings: candidates are duplicate-free supersets of the matches
+    int scans = 0;
+    for (int k = 0; k < NUM_RANDOM_CLAUSES; k++) {
+        struct whereClauseS nodes[MAX_NODES];
+        int used = 0;
+        scans += checkClause(&engine, block, randomChain(nodes, &used, 0)) < 0;
+    }
+    assert(scans > 0 && scans < NUM_RANDOM_CLAUSES);
+    printf("  %d random clauses OK (%d table scans)\n", NUM_RANDOM_CLAUSES, scans);
+
+    // With statistics: wide conditions scan the table, and an AND reads only its narrow side
+    column_stats stats[NUM_INDEXES];
+    for (int j = 0; j < NUM_INDEXES; j++)
+        columnStatsBuild(&stats[j], trees[j]);
+    engine.index_stats = stats;
+    engine.num_records = NUM_RECORDS;
+    struct whereClauseS wide = condition("sudo_used", "=", "false");
+    assert(checkClause(&engine, block, &wide) == -1);
+    struct whereClauseS point = condition("command_id", "=", "5");
+    assert(checkClause(&engine, block, &point) == 1);
+    struct whereClauseS narrow = condition("command_id", "<", "9");
+    struct whereClauseS risky = condition("risk_level", ">=", "1");
+    narrow.next = &risky; narrow.logical_op = "AND";
+    assert(checkClause(&engine, block, &narrow) == 9);
+    int chosen = 0;
+    for (int k = 0; k < NUM_RANDOM_CLAUSES; k++) {
+        struct whereClauseS nodes[MAX_NODES];
+        int used = 0;
+        chosen += checkClause(&engine, block, randomChain(nodes, &used, 0)) >= 0;
+    }
+    printf("  Costed plans OK (%d of %d random clauses use indexes)\n", chosen, NUM_RANDOM_CLAUSES);
+
+    for (int j = 0; j < NUM_INDEXES; j++)
+        destroy_tree(trees[j]);
+    free(block);
+    printf("Index Plan Test Passed!\n");
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include "../include/nodeArena.h"
+#include "../include/bplus.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_ROWS 20000
+
+int main() {
+    printf("Testing node arena...\n");
+
+    // Blocks are aligned, carved in address order, and recycled before the slab grows
+    node_arena *arena = nodeArenaCreate(192, 64);
+    char *a = nodeArenaAlloc(arena);
+    char *b = nodeArenaAlloc(arena);
+    assert(((uintptr_t)a & 63) == 0 && b == a + 192);
+    memset(a, 0xAB, 192);
+    nodeArenaFree(arena, a);
+    assert(nodeArenaAlloc(arena) == a);
+    assert(arena->live_blocks == 2 && arena->num_slabs == 1);
+
+    // Filling past one slab chains another
+    int per_slab = arena->blocks_per_slab;
+    for (int i = 0; i < per_slab; i++)
+        nodeArenaAlloc(arena);
+    assert(arena->num_slabs == 2);
+    assert(nodeArenaBytes(arena) >= 2 * (size_t)per_slab * 192);
+    nodeArenaDestroy(arena);
+
+    // Blocks larger than a slab still get one per slab
+    arena = nodeArenaCreate(NODE_ARENA_SLAB_BYTES * 2, 64);
+    assert(arena->blocks_per_slab == 1);
+    nodeArenaAlloc(arena);
+    nodeArenaAlloc(arena);
+    assert(arena->num_slabs == 2);
+    nodeArenaDestroy(arena);
+    printf("  Alloc / free OK\n");
+
+    // Trees use their own arena by default; merged-away nodes are reused by later splits
+    static int rows[NUM_ROWS];
+    bptree *tree = bptreeCreate(KEY_INT, 4);
+    assert(tree->arena != NULL);
+    for (int i = 0; i < NUM_ROWS; i++) {
+        rows[i] = i;
+        insert(tree, (KEY_T){ .type = KEY_INT, .v.i32 = i % 5000 }, &rows[i]);  // Posting lists too
+    }
+    bplus_stats stats;
+    bptreeGetStats(tree, &stats);
+    assert(stats.nodes == tree->arena->live_blocks);
+    long slabs = tree->arena->num_slabs;
+
+    for (int i = 0; i < NUM_ROWS; i++)
+        if (i % 5000 < 2500)
+            delete(tree, (KEY_T){ .type = KEY_INT, .v.i32 = i % 5000 }, &rows[i]);
+    for (int i = 0; i < NUM_ROWS; i++)
+        if (i % 5000 < 2500)
+            insert(tree, (KEY_T){ .type = KEY_INT, .v.i32 = i % 5000 }, &rows[i]);
+    bptreeGetStats(tree, &stats);
+    assert(stats.nodes == tree->arena->live_blocks);
+    assert(tree->arena->num_slabs == slabs);
+    assert(countRows(tree) == NUM_ROWS);
+    destroy_tree(tree);  // Posting lists freed, slabs released in one pass
+    printf("  Tree arena OK (%ld slabs)\n", slabs);
+
+    printf("Node Arena Test Passed!\n");
+    return 0;
+}
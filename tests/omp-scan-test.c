@@ -0,0 +1,85 @@
+#include "../include/executeEngine-omp.h"
+#include <assert.h>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_RECORDS 100000
+#define NUM_THREADS 4
+#define BATCH_QUERIES 2
+
+static record block[NUM_RECORDS];
+static record *records[NUM_RECORDS];
+
+/* checkScan: The linear search finds every fifth record, in array order. */
+static void checkScan(struct whereClauseS *wc) {
+    int count;
+    record **matches = linearSearchRecords(records, NUM_RECORDS, wc, &count);
+    assert(count == NUM_RECORDS / 5);
+    for (int k = 0; k < count; k++)
+        assert(matches[k] == &block[k * 5]);
+    free(matches);
+}
+
+/* runBatch: Runs BATCH_QUERIES scans side by side the way QPEOMP runs a batch of SELECTs,
+ * and returns the smallest team a query's scan formed.
+ */
+static int runBatch(struct whereClauseS *wc, int *outer) {
+    int scan_threads;
+    int smallest = NUM_THREADS;
+    *outer = queryBatchTeamOMP(BATCH_QUERIES, NUM_THREADS, &scan_threads);
+
+    #pragma omp parallel for schedule(dynamic) num_threads(*outer) reduction(min : smallest)
+    for (int q = 0; q < BATCH_QUERIES; q++) {
+        omp_set_num_threads(scan_threads);
+        checkScan(wc);
+
+        // The team the scan asked for is the team the runtime gives a region started here
+        int team = scanTeamSizeOMP();
+        #pragma omp parallel num_threads(team)
+        {
+            #pragma omp single
+            team = omp_get_num_threads();
+        }
+        if (team < smallest) smallest = team;
+    }
+    return smallest;
+}
+
+int main() {
+    printf("Testing OpenMP scans inside a query batch...\n");
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        fill_missing_record_strings(&block[i]);
+        block[i].command_id = i;
+        block[i].exit_code = i % 5;
+        records[i] = &block[i];
+    }
+    struct whereClauseS wc = { "exit_code", "=", "0", 0, NULL, NULL, NULL };
+
+    // Each of the batch's queries gets its share of the threads for its own scan
+    int outer;
+    int team = runBatch(&wc, &outer);
+    assert(outer == BATCH_QUERIES);
+    assert(team == NUM_THREADS / BATCH_QUERIES);
+    printf("  %d queries side by side, %d scan threads each OK\n", outer, team);
+
+    // A lone query scans on every thread
+    int scan_threads;
+    assert(queryBatchTeamOMP(1, NUM_THREADS, &scan_threads) == 1 && scan_threads == NUM_THREADS);
+    omp_set_num_threads(scan_threads);
+    assert(scanTeamSizeOMP() == NUM_THREADS);
+    checkScan(&wc);
+
+    // Without a second active level the nested scan cannot form a team, and says so
+    omp_set_max_active_levels(1);
+    #pragma omp parallel num_threads(2)
+    {
+        assert(scanTeamSizeOMP() == 1);
+        checkScan(&wc);
+    }
+    printf("  Lone and serialised scans OK\n");
+
+    printf("OMP Scan Test Passed!\n");
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include "../include/postingList.h"
+#include "../include/bplus.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_ROWS 2000
+
+int main() {
+    printf("Testing posting lists...\n");
+    static int rows[NUM_ROWS];
+    void **out = malloc(NUM_ROWS * sizeof(void *));
+    assert(out != NULL);
+
+    // Add in a scrambled order so blocks split in the middle
+    posting_list *pl = postingCreate();
+    for (int i = 0; i < NUM_ROWS; i++) {
+        assert(postingAdd(pl, &rows[(i * 7919) % NUM_ROWS]));
+    }
+    assert(!postingAdd(pl, &rows[10]));  // Already present
+    assert(pl->num_rows == NUM_ROWS);
+    assert(pl->num_blocks > 1);
+    assert(postingDecode(pl, out) == NUM_ROWS);
+    for (int i = 0; i < NUM_ROWS; i++) {
+        assert(out[i] == &rows[i]);
+    }
+    assert(postingFirst(pl) == &rows[0]);
+    printf("  Add OK (%d blocks)\n", pl->num_blocks);
+
+    // Remove every odd row, then the rest; blocks are merged and freed as they empty
+    for (int i = 1; i < NUM_ROWS; i += 2) {
+        assert(postingRemove(pl, &rows[i]));
+    }
+    assert(!postingRemove(pl, &rows[1]));
+    assert(postingDecode(pl, out) == NUM_ROWS / 2);
+    for (int i = 0; i < NUM_ROWS / 2; i++) {
+        assert(out[i] == &rows[2 * i]);
+    }
+    for (int i = 0; i < NUM_ROWS; i += 2) {
+        assert(postingRemove(pl, &rows[i]));
+    }
+    assert(pl->num_rows == 0 && pl->num_blocks == 0);
+    assert(postingFirst(pl) == NULL);
+    postingDestroy(pl);
+    printf("  Remove OK\n");
+
+    // Sorted build packs nearby rows into a few bytes each
+    for (int i = 0; i < NUM_ROWS; i++) out[i] = &rows[i];
+    pl = postingFromSorted(out, NUM_ROWS);
+    assert(pl->num_rows == NUM_ROWS);
+    assert(postingBytes(pl) < NUM_ROWS * sizeof(void *) / 4);
+    postingDestroy(pl);
+
+    // Through the tree: one key shared by every row, then drained back to a single row
+    bptree *tree = bptreeCreate(KEY_BOOL, 4);
+    KEY_T yes = { .type = KEY_BOOL, .v.b = true };
+    for (int i = 0; i < NUM_ROWS; i++) insert(tree, yes, &rows[i]);
+    assert(tree->root->is_leaf && tree->root->num_keys == 1);
+    ROW_PTR *results = NULL;
+    assert(find_rows(tree, yes, &results) == NUM_ROWS);
+    free(results);
+    for (int i = 1; i < NUM_ROWS; i++) delete(tree, yes, &rows[i]);
+    assert(find_rows(tree, yes, &results) == 1 && results[0] == &rows[0]);
+    free(results);
+    delete(tree, yes, &rows[0]);
+    assert(tree->root == NULL);
+    destroy_tree(tree);
+
+    free(out);
+    printf("Posting List Test Passed!\n");
+    return 0;
+}
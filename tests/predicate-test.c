@@ -0,0 +1,199 @@
+#include "../include/executeEngine-serial.h"
+#include "../include/predicate.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define NUM_RECORDS 600
+#define NUM_RANDOM_CLAUSES 3000
+#define MAX_NODES 16
+
+static const char *users[] = { "alice", "bob", "carol", "dave" };
+static const char *shells[] = { "bash", "zsh", "fish" };
+
+// Reference: one condition as the engines evaluated it before compilation (value parsed by
+// attribute name, unknown attributes and operators match nothing, bools only = / !=).
+static bool referenceCondition(const record *r, const struct whereClauseS *wc) {
+    const char *a = wc->attribute, *op = wc->operator, *v = wc->value;
+    int c;
+    if (strcmp(a, "command_id") == 0) {
+        unsigned long long x = strtoull(v, NULL, 10);
+        c = (r->command_id > x) - (r->command_id < x);
+    } else if (strcmp(a, "exit_code") == 0 || strcmp(a, "risk_level") == 0 || strcmp(a, "user_id") == 0) {
+        int field = a[0] == 'e' ? r->exit_code : a[0] == 'r' ? r->risk_level : r->user_id;
+        int x = atoi(v);
+        c = (field > x) - (field < x);
+    } else if (strcmp(a, "sudo_used") == 0) {
+        bool x = strcasecmp(v, "true") == 0 || strcmp(v, "1") == 0;
+        if (strcmp(op, "=") == 0) return r->sudo_used == x;
+        if (strcmp(op, "!=") == 0) return r->sudo_used != x;
+        return false;
+    } else if (strcmp(a, "user_name") == 0) {
+        c = strcmp(r->user_name, v);
+    } else if (strcmp(a, "shell_type") == 0) {
+        c = strcmp(r->shell_type, v);
+    } else if (strcmp(a, "timestamp") == 0) {
+        c = strcmp(r->timestamp, v);
+    } else {
+        return false;
+    }
+    if (strcmp(op, "=") == 0) return c == 0;
+    if (strcmp(op, "!=") == 0) return c != 0;
+    if (strcmp(op, ">") == 0) return c > 0;
+    if (strcmp(op, "<") == 0) return c < 0;
+    if (strcmp(op, ">=") == 0) return c >= 0;
+    if (strcmp(op, "<=") == 0) return c <= 0;
+    return false;
+}
+
+static bool reference(const record *r, const struct whereClauseS *wc) {
+    if (wc == NULL) return true;
+    bool current = wc->sub != NULL ? reference(r, wc->sub) : referenceCondition(r, wc);
+    if (wc->next == NULL) return current;
+    if (wc->logical_op != NULL && strcmp(wc->logical_op, "OR") == 0)
+        return current || reference(r, wc->next);
+    return current && reference(r, wc->next);
+}
+
+// Checks the compiled program and evaluateWhereClause against the reference on every row.
+static int checkClause(record **records, struct whereClauseS *wc) {
+    where_program program;
+    whereCompile(&program, wc);
+    int num_matches = 0;
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        bool expected = reference(records[i], wc);
+        assert(whereMatches(&program, records[i]) == expected);
+        assert(evaluateWhereClause(records[i], wc) == expected);
+        num_matches += expected;
+    }
+    whereProgramFree(&program);
+    return num_matches;
+}
+
+static struct whereClauseS condition(const char *attribute, const char *op, const char *value) {
+    struct whereClauseS wc = { attribute, op, value, 0, NULL, NULL, NULL };
+    return wc;
+}
+
+static unsigned int seed = 12345;
+static int next_random(int bound) {
+    seed = seed * 1103515245u + 12345u;
+    return (int)((seed >> 16) % (unsigned int)bound);
+}
+
+static const char *ops[] = { "=", "!=", ">", "<", ">=", "<=", "LIKE" };
+static const char *probes[][2] = {
+    { "command_id", "300" }, { "exit_code", "2" }, { "risk_level", "3" }, { "user_id", "1150" },
+    { "sudo_used", "true" }, { "sudo_used", "0" }, { "sudo_used", "TRUE" }, { "user_name", "bob" },
+    { "shell_type", "zsh" }, { "timestamp", "2026-01-15" }, { "no_such_column", "1" }
+};
+#define NUM_PROBES ((int)(sizeof(probes) / sizeof(probes[0])))
+
+// Builds a random chain of conditions and parenthesised sub-chains out of nodes[].
+static struct whereClauseS *randomChain(struct whereClauseS nodes[], int *used, int depth) {
+    static const char *links[] = { "AND", "OR", NULL };
+    int length = 1 + next_random(4);
+    struct whereClauseS *first = NULL, *prev = NULL;
+    for (int i = 0; i < length && *used < MAX_NODES; i++) {
+        struct whereClauseS *node = &nodes[(*used)++];
+        if (depth < 2 && next_random(4) == 0 && *used < MAX_NODES) {
+            *node = condition(NULL, NULL, NULL);
+            node->sub = randomChain(nodes, used, depth + 1);
+        } else {
+            int p = next_random(NUM_PROBES);
+            *node = condition(probes[p][0], ops[next_random(6)], probes[p][1]);
+        }
+        if (prev != NULL) {
+            prev->next = node;
+            prev->logical_op = links[next_random(3)];
+        } else {
+            first = node;
+        }
+        prev = node;
+    }
+    return first;
+}
+
+int main() {
+    printf("Testing WHERE programs...\n");
+
+    record *block = calloc(NUM_RECORDS, sizeof(record));
+    record **records = malloc(NUM_RECORDS * sizeof(record *));
+    char (*stamps)[32] = malloc(NUM_RECORDS * sizeof(*stamps));
+    assert(block != NULL && records != NULL && stamps != NULL);
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        record *r = &block[i];
+        fill_missing_record_strings(r);
+        r->command_id = i;
+        r->exit_code = i % 4;
+        r->risk_level = i % 6;
+        r->user_id = 1000 + i % 300;
+        r->sudo_used = i % 5 == 0;
+        r->user_name = users[i % 4];
+        r->shell_type = shells[i % 3];
+        snprintf(stamps[i], sizeof(stamps[i]), "2026-01-%02d", 1 + i % 28);
+        r->timestamp = stamps[i];
+        records[i] = r;
+    }
+
+    // No clause compiles to an empty program that keeps every row
+    where_program program;
+    whereCompile(&program, NULL);
+    assert(program.num_instrs == 0 && whereMatches(&program, records[0]));
+    whereProgramFree(&program);
+    assert(checkClause(records, NULL) == NUM_RECORDS);
+
+    // Every attribute / operator pair on its own
+    for (int p = 0; p < NUM_PROBES; p++) {
+        for (size_t o = 0; o < sizeof(ops) / sizeof(ops[0]); o++) {
+            struct whereClauseS wc = condition(probes[p][0], ops[o], probes[p][1]);
+            checkClause(records, &wc);
+        }
+    }
+    struct whereClauseS unknown = condition("no_such_column", "=", "1");
+    struct whereClauseS ordered = condition("sudo_used", ">", "0");
+    assert(checkClause(records, &unknown) == 0);
+    assert(checkClause(records, &ordered) == 0);
+    printf("  Single conditions OK\n");
+
+    // Chains combine right to left: a AND b OR c == a AND (b OR c)
+    struct whereClauseS a = condition("risk_level", ">=", "4");
+    struct whereClauseS b = condition("user_name", "=", "alice");
+    struct whereClauseS c = condition("sudo_used", "=", "true");
+    a.next = &b; a.logical_op = "AND";
+    b.next = &c; b.logical_op = "OR";
+    int chained = checkClause(records, &a);
+    int expected = 0;
+    for (int i = 0; i < NUM_RECORDS; i++)
+        expected += records[i]->risk_level >= 4 && (records[i]->user_name == users[0] || records[i]->sudo_used);
+    assert(chained == expected && chained > 0);
+
+    // Parenthesised sub-clause followed by more conditions
+    struct whereClauseS e1 = condition("exit_code", "=", "1");
+    struct whereClauseS e3 = condition("exit_code", "=", "3");
+    e1.next = &e3; e1.logical_op = "OR";
+    struct whereClauseS group = { NULL, NULL, NULL, 0, NULL, NULL, &e1 };
+    struct whereClauseS shell = condition("shell_type", "!=", "fish");
+    group.next = &shell; group.logical_op = "AND";
+    assert(checkClause(records, &group) > 0);
+    whereCompile(&program, &group);
+    assert(program.num_instrs == 3);
+    whereProgramFree(&program);
+    printf("  Chains and sub-clauses OK (%d rows)\n", chained);
+
+    // Random nestings of AND / OR / missing operators
+    for (int k = 0; k < NUM_RANDOM_CLAUSES; k++) {
+        struct whereClauseS nodes[MAX_NODES];
+        int used = 0;
+        checkClause(records, randomChain(nodes, &used, 0));
+    }
+    printf("  %d random clauses OK\n", NUM_RANDOM_CLAUSES);
+
+    free(stamps);
+    free(records);
+    free(block);
+    printf("WHERE Program Test Passed!\n");
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "../include/executeEngine-serial.h"
+#include "../include/snapshot.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#define DATA_FILE "temp_snapshot_test.csv"
+
+/* Creating a temporary test csv */
+static void create_snapshot_csv(const char *filename) {
+    FILE *f = fopen(filename, "w");
+    fprintf(f, "command_id,raw_command,base_command,shell_type,exit_code,timestamp,sudo_used,working_directory,user_id,user_name,host_name,risk_level\n");
+    fprintf(f, "1,ls -la,ls,bash,0,2023-01-01,0,/home/user,1001,user1,host1,1\n");
+    fprintf(f, "2,\"echo \"\"a,b\"\"\",echo,zsh,1,2023-01-02,true,/root,0,root,host2,5\n");
+    fprintf(f, "3,echo hello,echo,bash,0,2023-01-03,0,/home/user,1001,user1,host1,1\n");
+    fclose(f);
+}
+
+int main() {
+    printf("Testing engine snapshots...\n");
+    create_snapshot_csv(DATA_FILE);
+    const char *indexed_attrs[] = {"command_id", "risk_level"};
+    int attr_types[] = {0, 1};
+
+    // First start parses the CSV; the snapshot is written from those records
+    struct engineS *parsed = initializeEngineSerial(2, indexed_attrs, attr_types, DATA_FILE, "test_table");
+    assert(parsed->record_map == NULL && parsed->num_records == 3);
+    assert(snapshotSave(DATA_FILE, parsed->all_records, parsed->num_records));
+
+    // Next start maps it: same records, in file order, inside the mapping
+    struct engineS *mapped = initializeEngineSerial(2, indexed_attrs, attr_types, DATA_FILE, "test_table");
+    assert(mapped->record_map != NULL && mapped->num_records == 3);
+    for (int i = 0; i < 3; i++) {
+        assert(snapshotContains(mapped->record_map, mapped->record_map_bytes, mapped->all_records[i]));
+        const record *m = mapped->all_records[i], *p = parsed->all_records[i];
+        assert(m->command_id == p->command_id && m->exit_code == p->exit_code && m->sudo_used == p->sudo_used);
+        assert(m->user_id == p->user_id && m->risk_level == p->risk_level);
+        assert(strcmp(m->raw_command, p->raw_command) == 0 && strcmp(m->base_command, p->base_command) == 0);
+        assert(strcmp(m->shell_type, p->shell_type) == 0 && strcmp(m->timestamp, p->timestamp) == 0);
+        assert(strcmp(m->working_directory, p->working_directory) == 0 && strcmp(m->user_name, p->user_name) == 0);
+        assert(strcmp(m->host_name, p->host_name) == 0);
+        // Strings were relocated into the mapping
+        assert(snapshotContains(mapped->record_map, mapped->record_map_bytes, m->raw_command));
+    }
+    assert(strcmp(mapped->all_records[1]->raw_command, "echo \"a,b\"") == 0);
+    assert(mapped->all_records[1]->sudo_used && mapped->all_records[1]->risk_level == 5);
+    assert(countRows(mapped->bplus_tree_roots[1]) == 3);
+    destroyEngineSerial(parsed);
+    printf("  Save / map OK\n");
+
+    // Mapped and heap records mix: INSERT appends to the heap, DELETE must not free mapped rows
+    record extra = *mapped->all_records[0];
+    extra.command_id = 4;
+    assert(executeQueryInsertSerial(mapped, "test_table", &extra));
+    struct whereClauseS wc = { "risk_level", "=", "1", 0, NULL, NULL, NULL };
+    struct resultSetS *res = executeQueryDeleteSerial(mapped, "test_table", &wc);
+    assert(res->success && res->numRecords == 3 && mapped->num_records == 1);
+    freeResultSet(res);
+    destroyEngineSerial(mapped);
+    printf("  Mixed delete OK\n");
+
+    // The DELETE rewrote the data file, so the snapshot no longer applies
+    int num_records = 0;
+    void *map = NULL;
+    size_t map_bytes = 0;
+    assert(snapshotLoad(DATA_FILE, &num_records, &map, &map_bytes) == NULL);
+    printf("  Stale snapshot rejected OK\n");
+
+    char *path = snapshotPath(DATA_FILE);
+    remove(path);
+    free(path);
+    remove(DATA_FILE);
+    remove(DATA_FILE ".command_id.idx");
+    remove(DATA_FILE ".risk_level.idx");
+
+    printf("Snapshot Test Passed!\n");
+    return 0;
+}
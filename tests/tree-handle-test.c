@@ -0,0 +1,77 @@
+#include "../include/bplus.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_ROWS 2000
+
+// Allocator that counts the blocks it has handed out
+typedef struct {
+    long live;
+    long total;
+} counting_pool;
+
+static void *countingAlloc(void *ctx, size_t bytes) {
+    counting_pool *pool = ctx;
+    pool->live++;
+    pool->total++;
+    return aligned_alloc(BPLUS_CACHE_LINE, bytes);
+}
+
+static void countingRelease(void *ctx, void *block) {
+    counting_pool *pool = ctx;
+    pool->live--;
+    free(block);
+}
+
+int main() {
+    printf("Testing B+ Tree handles...\n");
+    static int rows[NUM_ROWS];
+    counting_pool pool = { 0, 0 };
+    bplus_allocator allocator = { countingAlloc, countingRelease, &pool };
+
+    // Two independently configured trees built side by side
+    bptree *narrow = bptreeCreateWith(KEY_INT, 3, &allocator);
+    bptree *wide = bptreeCreate(KEY_UINT64, 0);
+    assert(narrow->order == 3 && wide->order == bptreeDefaultOrder(KEY_UINT64));
+    for (int i = 0; i < NUM_ROWS; i++) {
+        rows[i] = i;
+        insert(narrow, (KEY_T){ .type = KEY_INT, .v.i32 = i }, &rows[i]);
+        insert(wide, (KEY_T){ .type = KEY_UINT64, .v.u64 = (uint64_t)(NUM_ROWS - i) }, &rows[i]);
+    }
+    assert(countRows(narrow) == NUM_ROWS && countRows(wide) == NUM_ROWS);
+    assert(height(narrow) > height(wide));
+
+    // Node allocations go through the tree's allocator and show up in its counters
+    bplus_stats stats;
+    bptreeGetStats(narrow, &stats);
+    assert(stats.nodes == pool.live && pool.total > 1);
+    assert(stats.splits > 0 && stats.merges == 0 && stats.redistributions == 0);
+    bplus_stats wide_stats;
+    bptreeGetStats(wide, &wide_stats);
+    assert(wide_stats.nodes < stats.nodes);
+    printf("  Allocator / stats OK (%ld nodes, %ld splits)\n", stats.nodes, stats.splits);
+
+    // Deletes merge and borrow; freed nodes go back to the same allocator
+    for (int i = 0; i < NUM_ROWS; i += 2)
+        delete(narrow, (KEY_T){ .type = KEY_INT, .v.i32 = i }, &rows[i]);
+    bptreeGetStats(narrow, &stats);
+    assert(stats.merges > 0 && stats.redistributions > 0);
+    assert(stats.nodes == pool.live);
+    printf("  Merge counters OK (%ld merges, %ld redistributions)\n", stats.merges, stats.redistributions);
+
+    // Printing state lives in the call, so printing one tree never touches the other
+    bptree *small = bptreeCreateWith(KEY_INT, 3, &allocator);
+    for (int i = 0; i < 6; i++)
+        insert(small, (KEY_T){ .type = KEY_INT, .v.i32 = i }, &rows[i]);
+    printTree(small);
+    small->verbose_output = true;
+    printLeaves(small);
+    destroy_tree(small);
+
+    destroy_tree(narrow);
+    destroy_tree(wide);
+    assert(pool.live == 0);
+    printf("Tree Handle Test Passed!\n");
+    return 0;
+}
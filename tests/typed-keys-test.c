@@ -0,0 +1,143 @@
+#include "../include/bplus.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_ROWS 500
+
+static const char *names[] = {"alice", "bob", "carol", "dave", "erin", "frank", "grace"};
+#define NUM_NAMES 7
+
+int main() {
+    printf("Testing typed B+ Tree keys...\n");
+    static int rows[NUM_ROWS];
+    KEY_T *keys = malloc(NUM_ROWS * sizeof(KEY_T));
+    ROW_PTR *ptrs = malloc(NUM_ROWS * sizeof(ROW_PTR));
+    assert(keys != NULL && ptrs != NULL);
+
+    // String keys: inserted one by one so leaves and internal nodes split
+    bptree *tree = bptreeCreate(KEY_STRING, 3);
+    assert(tree->key_size == sizeof(const char *));
+    for (int i = 0; i < NUM_ROWS; i++) {
+        rows[i] = i;
+        KEY_T key = { .type = KEY_STRING, .v.str = names[(i * 5) % NUM_NAMES] };
+        insert(tree, key, &rows[i]);
+    }
+    KEY_T lo = { .type = KEY_STRING, .v.str = "bob" };
+    KEY_T hi = { .type = KEY_STRING, .v.str = "dave" };
+    int total = findRange(tree, lo, hi, false, keys, ptrs);
+    int expected = 0;
+    for (int i = 0; i < NUM_ROWS; i++) {
+        const char *name = names[(i * 5) % NUM_NAMES];
+        if (strcmp(name, "bob") >= 0 && strcmp(name, "dave") <= 0) expected++;
+    }
+    assert(total == expected);
+    for (int i = 1; i < total; i++) {
+        assert(strcmp(keys[i - 1].v.str, keys[i].v.str) <= 0);
+    }
+
+    // Removing every "carol" leaves the other names untouched
+    KEY_T carol = { .type = KEY_STRING, .v.str = "carol" };
+    for (int i = 0; i < NUM_ROWS; i++) {
+        if (strcmp(names[(i * 5) % NUM_NAMES], "carol") == 0) {
+            delete(tree, carol, &rows[i]);
+            expected--;
+        }
+    }
+    ROW_PTR *results = NULL;
+    assert(find_rows(tree, carol, &results) == 0);
+    free(results);
+    assert(findRange(tree, lo, hi, false, keys, ptrs) == expected);
+
+    // A key of the wrong type finds nothing instead of being misread
+    KEY_T wrong = { .type = KEY_INT, .v.i32 = 1 };
+    results = NULL;
+    assert(find_rows(tree, wrong, &results) == 0);
+    destroy_tree(tree);
+    printf("  String keys OK\n");
+
+    // Bool keys: only two distinct values, so duplicates span many leaves
+    tree = bptreeCreate(KEY_BOOL, 4);
+    assert(tree->key_size == sizeof(bool));
+    int num_true = 0;
+    for (int i = 0; i < NUM_ROWS; i++) {
+        KEY_T key = { .type = KEY_BOOL, .v.b = (i % 3 == 0) };
+        num_true += key.v.b;
+        insert(tree, key, &rows[i]);
+    }
+    KEY_T t = { .type = KEY_BOOL, .v.b = true };
+    KEY_T f = { .type = KEY_BOOL, .v.b = false };
+    results = NULL;
+    assert(find_rows(tree, t, &results) == num_true);
+    free(results);
+    results = NULL;
+    assert(find_rows(tree, f, &results) == NUM_ROWS - num_true);
+    free(results);
+    for (int i = 0; i < NUM_ROWS; i += 3) {
+        delete(tree, t, &rows[i]);
+    }
+    results = NULL;
+    assert(find_rows(tree, t, &results) == 0);
+    assert(findRange(tree, f, t, false, keys, ptrs) == NUM_ROWS - num_true);
+    destroy_tree(tree);
+    printf("  Bool keys OK\n");
+
+    // uint64 keys beyond the int range keep their full width
+    tree = bptreeCreate(KEY_UINT64, 5);
+    for (int i = 0; i < NUM_ROWS; i++) {
+        KEY_T key = { .type = KEY_UINT64, .v.u64 = (1ULL << 40) + (uint64_t)(NUM_ROWS - i) };
+        insert(tree, key, &rows[i]);
+    }
+    KEY_T ulo = { .type = KEY_UINT64, .v.u64 = (1ULL << 40) + 1 };
+    KEY_T uhi = { .type = KEY_UINT64, .v.u64 = (1ULL << 40) + 100 };
+    total = findRange(tree, ulo, uhi, false, keys, ptrs);
+    assert(total == 100);
+    for (int i = 0; i < total; i++) {
+        assert(keys[i].v.u64 == ulo.v.u64 + (uint64_t)i);
+    }
+    destroy_tree(tree);
+    printf("  uint64 keys OK\n");
+
+    // Wide default-order nodes exercise the vector search windows: negative ints and
+    // uint64 keys on both sides of the sign bit must still order correctly
+    tree = bptreeCreate(KEY_INT, 0);
+    for (int i = 0; i < NUM_ROWS; i++) {
+        KEY_T key = { .type = KEY_INT, .v.i32 = (i % 250) - 125 };
+        insert(tree, key, &rows[i]);
+    }
+    for (int k = -130; k <= 130; k += 7) {
+        KEY_T key = { .type = KEY_INT, .v.i32 = k };
+        results = NULL;
+        assert(find_rows(tree, key, &results) == ((k >= -125 && k < 125) ? 2 : 0));
+        free(results);
+        KEY_T end = { .type = KEY_INT, .v.i32 = k + 9 };
+        int want = 0;
+        for (int j = k; j <= k + 9; j++) want += (j >= -125 && j < 125) ? 2 : 0;
+        assert(findRange(tree, key, end, false, keys, ptrs) == want);
+    }
+    destroy_tree(tree);
+
+    tree = bptreeCreate(KEY_UINT64, 0);
+    for (int i = 0; i < NUM_ROWS; i++) {
+        KEY_T key = { .type = KEY_UINT64, .v.u64 = 0x7FFFFFFFFFFFFF00ULL + (uint64_t)i };
+        insert(tree, key, &rows[i]);
+    }
+    KEY_T below = { .type = KEY_UINT64, .v.u64 = 0x7FFFFFFFFFFFFFF0ULL };
+    KEY_T above = { .type = KEY_UINT64, .v.u64 = 0x8000000000000010ULL };
+    assert(findRange(tree, below, above, false, keys, ptrs) == 0x20 + 1);
+    for (int i = 1; i < 0x21; i++) {
+        assert(keys[i - 1].v.u64 < keys[i].v.u64);
+    }
+    destroy_tree(tree);
+    printf("  Wide node search OK\n");
+
+    // Default orders grow as the key type narrows
+    assert(bptreeDefaultOrder(KEY_BOOL) > bptreeDefaultOrder(KEY_INT));
+    assert(bptreeDefaultOrder(KEY_INT) > bptreeDefaultOrder(KEY_UINT64));
+
+    free(keys);
+    free(ptrs);
+    printf("Typed Keys Test Passed!\n");
+    return 0;
+}
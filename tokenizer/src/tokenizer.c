@@ -1,5 +1,6 @@
 #include <ctype.h>
 #include <string.h>
+#include <strings.h> // For strcasecmp
 #include <stdio.h>
 #include <stdlib.h>
 #include "sql.h"
@@ -209,9 +210,18 @@ ParsedSQL parse_tokens(Token tokens[]) {
                 if (strcmp(tokens[i].value, "*") == 0) {
                     sql.select_all = true;
                     i++;
+                } else if (tokens[i].type == TOKEN_IDENTIFIER && strcasecmp(tokens[i].value, "COUNT") == 0 &&
+                           tokens[i + 1].type == TOKEN_SYMBOL && strcmp(tokens[i + 1].value, "(") == 0 &&
+                           tokens[i + 2].type == TOKEN_SYMBOL && strcmp(tokens[i + 2].value, "*") == 0 &&
+                           tokens[i + 3].type == TOKEN_SYMBOL && strcmp(tokens[i + 3].value, ")") == 0) {
+                    // COUNT(*) travels to the engines as a single select item
+                    strcpy(sql.columns[sql.num_columns++], "COUNT(*)");
+                    i += 4;
                 } else if (tokens[i].type == TOKEN_IDENTIFIER) {
                     strcpy(sql.columns[sql.num_columns++], tokens[i].value);
                     i++;
+                } else if (strcmp(tokens[i].value, ",") != 0 && strcmp(tokens[i].value, "FROM") != 0) {
+                    i++;  // Skip anything else so the loop always advances
                 }
                 
                 if (strcmp(tokens[i].value, ",") == 0) {